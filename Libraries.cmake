@@ -142,6 +142,18 @@ if(ENABLE_TESTS)
   set(TEST_LIBRARIES "" CACHE INTERNAL "" FORCE)
 endif()
 
+# Find Google Benchmark, used by lizardfs-microbench
+if(ENABLE_TESTS)
+  find_library(BENCHMARK_LIBRARY benchmark)
+  find_path(BENCHMARK_INCLUDE_DIR benchmark/benchmark.h)
+  if(BENCHMARK_LIBRARY AND BENCHMARK_INCLUDE_DIR)
+    message(STATUS "Found Google Benchmark")
+  else()
+    message(STATUS "Could NOT find Google Benchmark (but it's not required)")
+    message(STATUS "   lizardfs-microbench will not be built")
+  endif()
+endif()
+
 # Find Judy
 find_package(Judy)
 if(JUDY_FOUND)
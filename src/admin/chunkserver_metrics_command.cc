@@ -0,0 +1,46 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "admin/chunkserver_metrics_command.h"
+
+#include <iostream>
+
+#include "common/server_connection.h"
+#include "protocol/cltocs.h"
+#include "protocol/cstocl.h"
+
+std::string ChunkserverMetricsCommand::name() const {
+	return "chunkserver-metrics";
+}
+
+void ChunkserverMetricsCommand::usage() const {
+	std::cerr << name() << " <chunkserver ip> <chunkserver port>\n";
+	std::cerr << "    Prints latency histograms of disk operations of a chunkserver\n";
+	std::cerr << "    in the Prometheus text format.\n";
+}
+
+void ChunkserverMetricsCommand::run(const Options& options) const {
+	if (options.arguments().size() != 2) {
+		throw WrongUsageException("Expected exactly two arguments for " + name());
+	}
+	ServerConnection connection(options.argument(0), options.argument(1));
+	auto response = connection.sendAndReceive(cltocs::metrics::build(), LIZ_CSTOCL_METRICS);
+	std::string metrics;
+	cstocl::metrics::deserialize(response, metrics);
+	std::cout << metrics;
+}
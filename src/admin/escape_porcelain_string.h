@@ -22,7 +22,7 @@
 
 #include <string>
 
-std::string escapePorcelainString(std::string string) {
+inline std::string escapePorcelainString(std::string string) {
 	auto replaceAll = [](std::string& str, const std::string& oldText, const std::string& newText) {
 		int replaced = 0;
 		size_t pos = 0;
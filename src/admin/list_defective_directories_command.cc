@@ -0,0 +1,101 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "admin/list_defective_directories_command.h"
+
+#include <iostream>
+#include <vector>
+
+#include "admin/escape_porcelain_string.h"
+#include "common/mfserr.h"
+#include "common/server_connection.h"
+#include "common/special_inode_defs.h"
+#include "protocol/cltoma.h"
+#include "protocol/matocl.h"
+
+std::string ListDefectiveDirectoriesCommand::name() const {
+	return "list-defective-directories";
+}
+
+LizardFsProbeCommand::SupportedOptions ListDefectiveDirectoriesCommand::supportedOptions() const {
+	return {
+		{kPorcelainMode, kPorcelainModeDescription},
+	};
+}
+
+void ListDefectiveDirectoriesCommand::usage() const {
+	std::cerr << name() << " <master ip> <master port> [<directory inode>]\n";
+	std::cerr << "    Lists directories containing unavailable or undergoal files, as found by\n";
+	std::cerr << "    the last complete loop checking all files. Counts of a directory include\n";
+	std::cerr << "    files in its subdirectories. Only the subtree of the given directory (root\n";
+	std::cerr << "    by default) is listed. Files in trash and reserved files are left out.\n";
+}
+
+void ListDefectiveDirectoriesCommand::run(const Options& options) const {
+	if (options.arguments().size() != 2 && options.arguments().size() != 3) {
+		throw WrongUsageException("Expected <master ip>, <master port> and optionally "
+				"<directory inode> for " + name());
+	}
+	uint32_t inode = SPECIAL_INODE_ROOT;
+	if (options.arguments().size() == 3) {
+		try {
+			inode = std::stoul(options.argument(2));
+		} catch (std::exception&) {
+			throw WrongUsageException("Invalid directory inode: " + options.argument(2));
+		}
+	}
+
+	ServerConnection connection(options.argument(0), options.argument(1));
+	auto response = connection.sendAndReceive(cltoma::listDefectiveDirectories::build(inode),
+			LIZ_MATOCL_LIST_DEFECTIVE_DIRECTORIES);
+	uint8_t status;
+	std::vector<DefectiveDirectoryEntry> directories;
+	matocl::listDefectiveDirectories::deserialize(response, status, directories);
+	if (status != LIZARDFS_STATUS_OK) {
+		std::cerr << mfsstrerr(status) << std::endl;
+		exit(1);
+	}
+
+	if (options.isSet(kPorcelainMode)) {
+		for (const DefectiveDirectoryEntry& directory : directories) {
+			std::cout << directory.inode << ' '
+					<< directory.unavailableFiles << ' '
+					<< directory.undergoalFiles << ' '
+					<< escapePorcelainString(directory.path) << std::endl;
+		}
+	} else {
+		uint64_t unavailableFiles = 0, undergoalFiles = 0;
+		std::cout << "Directories with defective files:\nInode\tUnavailable\tUndergoal\tPath"
+				<< std::endl;
+		for (const DefectiveDirectoryEntry& directory : directories) {
+			std::cout << directory.inode << '\t'
+					<< directory.unavailableFiles << '\t'
+					<< directory.undergoalFiles << '\t'
+					<< directory.path << std::endl;
+			if (directory.inode == inode) {
+				// The whole subtree is counted in its root
+				unavailableFiles = directory.unavailableFiles;
+				undergoalFiles = directory.undergoalFiles;
+			}
+		}
+		std::cout << "Total: " << directories.size() << " directories, "
+				<< unavailableFiles << " unavailable files, "
+				<< undergoalFiles << " undergoal files" << std::endl;
+	}
+}
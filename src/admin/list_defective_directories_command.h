@@ -0,0 +1,31 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include "admin/lizardfs_admin_command.h"
+
+class ListDefectiveDirectoriesCommand : public LizardFsProbeCommand {
+public:
+	virtual std::string name() const;
+	virtual SupportedOptions supportedOptions() const;
+	virtual void usage() const;
+	virtual void run(const Options& options) const;
+};
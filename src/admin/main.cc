@@ -22,9 +22,11 @@
 #include <iostream>
 
 #include "admin/chunk_health_command.h"
+#include "admin/chunkserver_metrics_command.h"
 #include "admin/info_command.h"
 #include "admin/io_limits_status_command.h"
 #include "admin/list_chunkservers_command.h"
+#include "admin/list_defective_directories_command.h"
 #include "admin/list_disks_command.h"
 #include "admin/list_goals_command.h"
 #include "admin/list_metadataservers_command.h"
@@ -33,6 +35,7 @@
 #include "admin/magic_recalculate_metadata_checksum_command.h"
 #include "admin/manage_locks_command.h"
 #include "admin/metadataserver_status_command.h"
+#include "admin/metrics_command.h"
 #include "admin/promote_shadow_command.h"
 #include "admin/ready_chunkservers_count_command.h"
 #include "admin/reload_config_command.h"
@@ -46,9 +49,11 @@ int main(int argc, const char** argv) {
 	strerr_init();
 	std::vector<const LizardFsProbeCommand*> allCommands = {
 			new ChunksHealthCommand(),
+			new ChunkserverMetricsCommand(),
 			new InfoCommand(),
 			new IoLimitsStatusCommand(),
 			new ListChunkserversCommand(),
+			new ListDefectiveDirectoriesCommand(),
 			new ListDisksCommand(),
 			new ListGoalsCommand(),
 			new ListMountsCommand(),
@@ -56,6 +61,7 @@ int main(int argc, const char** argv) {
 			new ListTapeserversCommand(),
 			new ManageLocksCommand(),
 			new MetadataserverStatusCommand(),
+			new MetricsCommand(),
 			new ReadyChunkserversCountCommand(),
 			new PromoteShadowCommand(),
 			new MetadataserverStopWithoutSavingMetadataCommand(),
@@ -53,9 +53,57 @@ void MetadataserverStatusCommand::run(const Options& options) const {
 		std::cout << "     personality: " << s.personality << std::endl;
 		std::cout << "   server status: " << s.serverStatus << std::endl;
 		std::cout << "metadata version: " << s.metadataVersion << std::endl;
+		if (s.personality == "shadow" && s.serverStatus == "connected") {
+			try {
+				auto lag = getReplicationLag(connection);
+				std::cout << " replication lag: " << lag.first << " versions, "
+						<< lag.second << " seconds" << std::endl;
+			} catch (Exception&) {
+				// older servers don't report it
+				std::cout << " replication lag: unknown" << std::endl;
+			}
+		}
+		if (s.personality == "master") {
+			try {
+				auto progress = getRegistrationProgress(connection);
+				if (progress.first > 0) {
+					std::cout << "    registering: " << progress.first << " chunkservers, "
+							<< progress.second << " chunks pending" << std::endl;
+				}
+			} catch (Exception&) {
+				// older servers don't report it
+			}
+		}
 	}
 }
 
+std::pair<uint64_t, uint32_t> MetadataserverStatusCommand::getReplicationLag(
+		ServerConnection& connection) {
+	auto request = cltoma::metadataserverReplicationLag::build(1);
+	auto response = connection.sendAndReceive(request,
+			LIZ_MATOCL_METADATASERVER_REPLICATION_LAG);
+
+	uint32_t messageId;
+	uint64_t lagVersions;
+	uint32_t lagSeconds;
+	matocl::metadataserverReplicationLag::deserialize(response, messageId, lagVersions, lagSeconds);
+	return {lagVersions, lagSeconds};
+}
+
+std::pair<uint32_t, uint64_t> MetadataserverStatusCommand::getRegistrationProgress(
+		ServerConnection& connection) {
+	auto request = cltoma::metadataserverRegistrationProgress::build(1);
+	auto response = connection.sendAndReceive(request,
+			LIZ_MATOCL_METADATASERVER_REGISTRATION_PROGRESS);
+
+	uint32_t messageId;
+	uint32_t registeringServers;
+	uint64_t pendingChunks;
+	matocl::metadataserverRegistrationProgress::deserialize(response, messageId,
+			registeringServers, pendingChunks);
+	return {registeringServers, pendingChunks};
+}
+
 MetadataserverStatus MetadataserverStatusCommand::getStatus(ServerConnection& connection) {
 	std::vector<uint8_t> request;
 	request = cltoma::metadataserverStatus::build(1);
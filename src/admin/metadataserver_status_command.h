@@ -20,6 +20,8 @@
 
 #include "common/platform.h"
 
+#include <utility>
+
 #include "common/server_connection.h"
 #include "admin/lizardfs_admin_command.h"
 
@@ -36,4 +38,11 @@ public:
 	SupportedOptions supportedOptions() const override;
 	void run(const Options& options) const override;
 	static MetadataserverStatus getStatus(ServerConnection& connection);
+
+	/// Returns replication lag of a shadow master (number of versions and seconds)
+	static std::pair<uint64_t, uint32_t> getReplicationLag(ServerConnection& connection);
+
+	/// Returns number of chunkservers which are being registered and number of their chunks
+	/// which are not yet processed by the master
+	static std::pair<uint32_t, uint64_t> getRegistrationProgress(ServerConnection& connection);
 };
@@ -38,6 +38,7 @@
 #include "common/datapack.h"
 #include "common/massert.h"
 #include "common/pcqueue.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
 #include "devtools/TracePrinter.h"
 
@@ -89,6 +90,7 @@ struct chunk_read_args {
 	uint32_t blocksToBeReadAhead;
 	OutputBuffer* outputBuffer;
 	bool performHddOpen;
+	uint64_t traceId;
 };
 
 // for OP_PREFETCH
@@ -109,6 +111,7 @@ struct chunk_prefetch_args {
 	uint32_t offset, size;
 	uint32_t crc;
 	const uint8_t *buffer;
+	uint64_t traceId;
 };
 
 struct chunk_get_blocks_args {
@@ -249,6 +252,8 @@ void* job_worker(void *th_arg) {
 					break;
 				}
 				LOG_AVG_TILL_END_OF_SCOPE0("job_read");
+				tracing::TraceScope trace(rdargs->traceId);
+				tracing::ScopedSpan span("chunkserver.hdd_read", rdargs->chunkid);
 				if (rdargs->performHddOpen) {
 					status = hdd_open(rdargs->chunkid, rdargs->chunkType);
 					if (status != LIZARDFS_STATUS_OK) {
@@ -284,6 +289,8 @@ void* job_worker(void *th_arg) {
 				if (jstate==JSTATE_DISABLED) {
 					status = LIZARDFS_ERROR_NOTDONE;
 				} else {
+					tracing::TraceScope trace(wrargs->traceId);
+					tracing::ScopedSpan span("chunkserver.hdd_write", wrargs->chunkId);
 					status = hdd_write(wrargs->chunkId, wrargs->chunkVersion, wrargs->chunkType,
 							wrargs->blocknum, wrargs->offset, wrargs->size, wrargs->crc,
 							wrargs->buffer);
@@ -560,7 +567,7 @@ uint32_t job_close(void *jpool, void (*callback)(uint8_t status,void *extra), vo
 uint32_t job_read(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
 		uint64_t chunkid, uint32_t version, ChunkPartType chunkType, uint32_t offset, uint32_t size,
 		uint32_t maxBlocksToBeReadBehind, uint32_t blocksToBeReadAhead,
-		OutputBuffer* outputBuffer, bool performHddOpen) {
+		OutputBuffer* outputBuffer, bool performHddOpen, uint64_t traceId) {
 	TRACETHIS();
 	jobpool* jp = (jobpool*)jpool;
 	chunk_read_args *args;
@@ -575,6 +582,7 @@ uint32_t job_read(void *jpool, void (*callback)(uint8_t status, void *extra), vo
 	args->blocksToBeReadAhead = blocksToBeReadAhead;
 	args->outputBuffer = outputBuffer;
 	args->performHddOpen = performHddOpen;
+	args->traceId = traceId;
 	return job_new(jp,OP_READ,args,callback,extra);
 }
 
@@ -596,7 +604,8 @@ uint32_t job_prefetch(void *jpool, uint64_t chunkid, uint32_t version, ChunkPart
 
 uint32_t job_write(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
 		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
-		uint16_t blocknum, uint32_t offset, uint32_t size, uint32_t crc, const uint8_t *buffer) {
+		uint16_t blocknum, uint32_t offset, uint32_t size, uint32_t crc, const uint8_t *buffer,
+		uint64_t traceId) {
 	TRACETHIS();
 	jobpool* jp = (jobpool*)jpool;
 	chunk_write_args *args;
@@ -610,6 +619,7 @@ uint32_t job_write(void *jpool, void (*callback)(uint8_t status, void *extra), v
 	args->size = size;
 	args->crc = crc;
 	args->buffer = buffer;
+	args->traceId = traceId;
 	return job_new(jp, OP_WRITE, args, callback, extra);
 }
 
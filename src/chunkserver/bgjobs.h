@@ -83,12 +83,14 @@ uint32_t job_close(void *jpool, void (*callback)(uint8_t status, void *extra), v
 uint32_t job_read(void *jpool, void (*callback)(uint8_t status,void *extra), void *extra,
 		uint64_t chunkid, uint32_t chunkVersion, ChunkPartType chunkType,
 		uint32_t offset, uint32_t size, uint32_t maxBlocksToBeReadBehind,
-		uint32_t blocksToBeReadAhead, OutputBuffer *outputBuffer, bool performHddOpen);
+		uint32_t blocksToBeReadAhead, OutputBuffer *outputBuffer, bool performHddOpen,
+		uint64_t traceId = 0);
 uint32_t job_prefetch(void *jpool, uint64_t chunkid, uint32_t version, ChunkPartType chunkType,
 		uint32_t firstBlockToBePrefetched, uint32_t nrOfBlocksToBePrefetched) ;
 uint32_t job_write(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
 		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
-		uint16_t blocknum, uint32_t offset, uint32_t size, uint32_t crc, const uint8_t *buffer);
+		uint16_t blocknum, uint32_t offset, uint32_t size, uint32_t crc, const uint8_t *buffer,
+		uint64_t traceId = 0);
 uint32_t job_get_blocks(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
 		uint64_t chunkId, uint32_t version, ChunkPartType chunkType, uint16_t* blocks);
 uint32_t job_replicate(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
@@ -70,8 +70,11 @@
 #define CHARTS_TEST 27
 #define CHARTS_CHUNKIOJOBS 28
 #define CHARTS_CHUNKOPJOBS 29
+#define CHARTS_RLATENCY99 30
+#define CHARTS_WLATENCY99 31
+#define CHARTS_FSYNCLATENCY99 32
 
-#define CHARTS 30
+#define CHARTS 33
 
 /* name , join mode , percent , scale , multiplier , divisor */
 #define STATDEFS { \
@@ -105,6 +108,9 @@
 	{"test"         ,CHARTS_MODE_ADD,0,CHARTS_SCALE_NONE ,   1, 1}, \
 	{"chunkiojobs"  ,CHARTS_MODE_MAX,0,CHARTS_SCALE_NONE ,   1, 1}, \
 	{"chunkopjobs"  ,CHARTS_MODE_MAX,0,CHARTS_SCALE_NONE ,   1, 1}, \
+	{"rlatency99"   ,CHARTS_MODE_MAX,0,CHARTS_SCALE_MICRO,   1, 1}, \
+	{"wlatency99"   ,CHARTS_MODE_MAX,0,CHARTS_SCALE_MICRO,   1, 1}, \
+	{"fsynclatency99",CHARTS_MODE_MAX,0,CHARTS_SCALE_MICRO,  1, 1}, \
 	{NULL           ,0              ,0,0                 ,   0, 0}  \
 };
 
@@ -204,6 +210,7 @@ void chartsdata_refresh(void) {
 	data[CHARTS_TRUNCATE]=op_tr;
 	data[CHARTS_DUPTRUNC]=op_dt;
 	data[CHARTS_TEST]=op_te;
+	hdd_latency_percentiles(0.99,data+CHARTS_RLATENCY99,data+CHARTS_WLATENCY99,data+CHARTS_FSYNCLATENCY99);
 
 	charts_add(data,main_time()-60);
 }
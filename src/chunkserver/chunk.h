@@ -25,12 +25,14 @@
 #include <string>
 #include <sys/types.h>
 
+#include <array>
 #include <condition_variable>
 #include <thread>
 
 #include "chunkserver/chunk_format.h"
 #include "common/chunk_part_type.h"
 #include "common/disk_info.h"
+#include "common/metrics.h"
 #include "protocol/MFSCommunication.h"
 
 #define STATSHISTORY (24*60)
@@ -46,6 +48,16 @@ enum ChunkState {
 	CH_TOBEDELETED
 };
 
+/// Operations on chunk files whose latency is measured separately for every folder
+enum DiskOperation {
+	kDiskRead,
+	kDiskWrite,
+	kDiskFsync,
+	kDiskOpen,
+	kDiskCreate,
+	kDiskOperationCount
+};
+
 class Chunk;
 
 struct cntcond {
@@ -87,6 +99,8 @@ struct folder {
 	HddAtomicStatistics cstat;
 	HddStatistics stats[STATSHISTORY];
 	uint32_t statspos;
+	std::array<metrics::Histogram*, kDiskOperationCount> latency;
+	std::array<metrics::Histogram::Counts, kDiskOperationCount> lastLatencyCounts;
 	ioerror lasterrtab[LASTERRSIZE];
 	uint32_t chunkcount;
 	uint32_t lasterrindx;
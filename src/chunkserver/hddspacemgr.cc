@@ -78,6 +78,7 @@
 #include "common/list.h"
 #include "common/main.h"
 #include "common/massert.h"
+#include "common/metrics.h"
 #include "common/moosefs_vector.h"
 #include "common/random.h"
 #include "common/serialization.h"
@@ -302,6 +303,7 @@ static inline void hdd_stats_dataread(folder *f,uint32_t size,int64_t rtime) {
 	f->cstat.rbytes += size;
 	f->cstat.usecreadsum += rtime;
 	atomic_max<uint32_t>(f->cstat.usecreadmax, rtime);
+	f->latency[kDiskRead]->record(rtime);
 }
 
 static inline void hdd_stats_datawrite(folder *f,uint32_t size,int64_t wtime) {
@@ -317,6 +319,7 @@ static inline void hdd_stats_datawrite(folder *f,uint32_t size,int64_t wtime) {
 	f->cstat.wbytes += size;
 	f->cstat.usecwritesum += wtime;
 	atomic_max<uint32_t>(f->cstat.usecwritemax, wtime);
+	f->latency[kDiskWrite]->record(wtime);
 }
 
 static inline void hdd_stats_datafsync(folder *f,int64_t fsynctime) {
@@ -329,6 +332,40 @@ static inline void hdd_stats_datafsync(folder *f,int64_t fsynctime) {
 	f->cstat.fsyncops++;
 	f->cstat.usecfsyncsum += fsynctime;
 	atomic_max<uint32_t>(f->cstat.usecfsyncmax, fsynctime);
+	f->latency[kDiskFsync]->record(fsynctime);
+}
+
+static const char *kDiskOperationNames[kDiskOperationCount] = {
+	"read", "write", "fsync", "open", "create"
+};
+
+static inline void hdd_stats_open(folder *f, bool create, int64_t opentime) {
+	if (opentime < 0) {
+		return;
+	}
+	f->latency[create ? kDiskCreate : kDiskOpen]->record(opentime);
+}
+
+void hdd_latency_percentiles(double fraction, uint64_t *rtime, uint64_t *wtime,
+		uint64_t *fsynctime) {
+	TRACETHIS();
+	std::array<uint64_t, kDiskOperationCount> result;
+	result.fill(0);
+	std::unique_lock<std::mutex> folderlock_guard(folderlock);
+	for (folder *f = folderhead; f; f = f->next) {
+		for (int op = 0; op < kDiskOperationCount; ++op) {
+			metrics::Histogram::Counts counts = f->latency[op]->counts();
+			metrics::Histogram::Counts delta;
+			for (size_t i = 0; i < counts.size(); ++i) {
+				delta[i] = counts[i] - f->lastLatencyCounts[op][i];
+			}
+			f->lastLatencyCounts[op] = counts;
+			result[op] = std::max(result[op], metrics::Histogram::percentile(delta, fraction));
+		}
+	}
+	*rtime = result[kDiskRead];
+	*wtime = result[kDiskWrite];
+	*fsynctime = result[kDiskFsync];
 }
 
 uint32_t hdd_diskinfo_v1_size() {
@@ -1247,6 +1284,7 @@ static int hdd_io_begin(Chunk *c,int newflag, uint32_t chunk_version = std::nume
 			// Try to free some long unused descriptors
 			gOpenChunks.freeUnused(main_time(), hashlock);
 			for (int i = 0; i < kOpenRetryCount; ++i) {
+				uint64_t ts = get_usectime();
 				if (newflag) {
 					c->fd = open(c->filename().c_str(), O_RDWR | O_TRUNC | O_CREAT, 0666);
 				} else {
@@ -1256,6 +1294,7 @@ static int hdd_io_begin(Chunk *c,int newflag, uint32_t chunk_version = std::nume
 						c->fd = open(c->filename().c_str(), O_RDONLY);
 					}
 				}
+				hdd_stats_open(c->owner, newflag, get_usectime() - ts);
 				if (c->fd < 0 && errno != ENFILE) {
 					lzfs_silent_errlog(LOG_WARNING,"hdd_io_begin: file:%s - open error", c->filename().c_str());
 					return LIZARDFS_ERROR_IO;
@@ -3731,6 +3770,14 @@ int hdd_parseline(char *hddcfgline) {
 		f->stats[l].clear();
 	}
 	f->statspos = 0;
+	for (int op = 0; op < kDiskOperationCount; ++op) {
+		f->latency[op] = &metrics::registry().histogram(
+				"lizardfs_chunkserver_disk_operation_duration_microseconds",
+				"Durations of operations on chunk files",
+				metrics::label("path", f->path) + "," +
+				metrics::label("operation", kDiskOperationNames[op]));
+		f->lastLatencyCounts[op] = f->latency[op]->counts();
+	}
 	for (l=0 ; l<LASTERRSIZE ; l++) {
 		f->lasterrtab[l].chunkid = 0ULL;
 		f->lasterrtab[l].timestamp = 0;
@@ -32,6 +32,9 @@
 
 void hdd_stats(uint64_t *br,uint64_t *bw,uint32_t *opr,uint32_t *opw,uint64_t *dbr,uint64_t *dbw,uint32_t *dopr,uint32_t *dopw,uint64_t *rtime,uint64_t *wtime);
 void hdd_op_stats(uint32_t *op_create,uint32_t *op_delete,uint32_t *op_version,uint32_t *op_duplicate,uint32_t *op_truncate,uint32_t *op_duptrunc,uint32_t *op_test);
+/// Maximum over folders of a percentile of operation durations since the previous call
+void hdd_latency_percentiles(double fraction, uint64_t *rtime, uint64_t *wtime,
+		uint64_t *fsynctime);
 uint32_t hdd_errorcounter(void);
 
 void hdd_get_damaged_chunks(std::vector<ChunkWithType>& chunks, std::size_t limit);
@@ -512,6 +512,12 @@ void masterconn_structure_log_rotate(masterconn *eptr,const uint8_t *data,uint32
 }
 */
 
+void masterconn_getload(masterconn *eptr, const std::vector<uint8_t>& data) {
+	matocs::getLoad::deserialize(data);
+	uint32_t load = mainNetworkThreadGetLoad() + job_pool_jobs_count(jpool);
+	masterconn_create_attached_packet(eptr, cstoma::getLoad::build(load));
+}
+
 void masterconn_gotpacket(masterconn *eptr, PacketHeader header, const MessageBuffer& message) try {
 	switch (header.type) {
 		case ANTOAN_NOP:
@@ -547,6 +553,9 @@ void masterconn_gotpacket(masterconn *eptr, PacketHeader header, const MessageBu
 		case LIZ_MATOCS_DUPTRUNC_CHUNK:
 			masterconn_duptrunc(eptr, message);
 			break;
+		case LIZ_MATOCS_GET_LOAD:
+			masterconn_getload(eptr, message);
+			break;
 //              case MATOCS_STRUCTURE_LOG:
 //                      masterconn_structure_log(eptr, message.data(), message.size());
 //                      break;
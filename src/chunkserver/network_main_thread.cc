@@ -56,8 +56,12 @@
 #include "protocol/packet.h"
 #include "common/slogger.h"
 #include "common/sockets.h"
+#include "common/tracing.h"
 #include "devtools/TracePrinter.h"
 
+// spans of requests traced by clients, appended in the data directory
+#define TRACES_FILENAME "traces.log"
+
 static int lsock;
 static int32_t lsockpdescpos;
 
@@ -75,6 +79,17 @@ static uint32_t gNrOfNetworkWorkers;
 static uint32_t gNrOfHddWorkersPerNetworkWorker;
 static uint32_t gBgjobsCountPerNetworkWorker;
 
+/// Writes spans of traced requests to TRACES_FILENAME if DUMP_TRACES is set
+static std::unique_ptr<tracing::Dumper> gTraceDumper;
+
+static void mainNetworkThreadDumpTracesReload() {
+	if (!cfg_getuint8("DUMP_TRACES", 0)) {
+		gTraceDumper.reset();
+	} else if (!gTraceDumper) {
+		gTraceDumper.reset(new tracing::Dumper(TRACES_FILENAME));
+	}
+}
+
 void replicationBandwidthLimitReload() {
 	if (cfg_isdefined("REPLICATION_BANDWIDTH_LIMIT_KBPS")) {
 		replicationBandwidthLimiter().setLimit(cfg_getuint32("REPLICATION_BANDWIDTH_LIMIT_KBPS", 0));
@@ -105,6 +120,7 @@ void mainNetworkThreadReload(void) {
 			cfg_get_maxvalue<uint32_t>("READ_AHEAD_KB", 0, MFSCHUNKSIZE / 1024));
 	gHDDReadAhead.setMaxReadBehind_kB(
 			cfg_get_maxvalue<uint32_t>("MAX_READ_BEHIND_KB", 0, MFSCHUNKSIZE / 1024));
+	mainNetworkThreadDumpTracesReload();
 
 	char *oldListenHost, *oldListenPort;
 	int newlsock;
@@ -177,6 +193,7 @@ void mainNetworkThreadTerm(void) {
 	for (auto& thread : networkThreads) {
 		thread.join();
 	}
+	gTraceDumper.reset();
 }
 
 void mainNetworkThreadServe(const std::vector<pollfd> &pdesc) {
@@ -218,6 +235,7 @@ int mainNetworkThreadInit(void) {
 			cfg_get_maxvalue<uint32_t>("READ_AHEAD_KB", 0, MFSCHUNKSIZE / 1024));
 	gHDDReadAhead.setMaxReadBehind_kB(
 			cfg_get_maxvalue<uint32_t>("MAX_READ_BEHIND_KB", 0, MFSCHUNKSIZE / 1024));
+	mainNetworkThreadDumpTracesReload();
 
 	lsock = tcpsocket();
 	if (lsock < 0) {
@@ -272,3 +290,12 @@ uint16_t mainNetworkThreadGetListenPort() {
 	TRACETHIS();
 	return mylistenport;
 }
+
+uint32_t mainNetworkThreadGetLoad() {
+	TRACETHIS();
+	uint32_t load = 0;
+	for (auto& threadObject : networkThreadObjects) {
+		load += job_pool_jobs_count(threadObject.bgJobPool());
+	}
+	return load;
+}
@@ -27,3 +27,6 @@ int mainNetworkThreadInitThreads(void);
 
 uint32_t mainNetworkThreadGetListenIp();
 uint16_t mainNetworkThreadGetListenPort();
+
+/// Number of client operations waiting in queues of network workers
+uint32_t mainNetworkThreadGetLoad();
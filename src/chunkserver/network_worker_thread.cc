@@ -49,11 +49,13 @@
 #include "common/lizardfs_version.h"
 #include "common/main.h"
 #include "common/massert.h"
+#include "common/metrics.h"
 #include "protocol/MFSCommunication.h"
 #include "common/moosefs_vector.h"
 #include "protocol/packet.h"
 #include "common/slogger.h"
 #include "common/sockets.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
 #include "devtools/TracePrinter.h"
 
@@ -319,6 +321,7 @@ void worker_read_finished(uint8_t status, void *e) {
 		eptr->state = IDLE; // after sending status even if there was an error it's possible to
 		// receive new requests on the same connection
 		LOG_AVG_STOP(eptr->readOperationTimer);
+		tracing::record(eptr->traceId, "chunkserver.read", eptr->traceStart, eptr->chunkid);
 	}
 }
 
@@ -347,6 +350,7 @@ void worker_read_continue(csserventry *eptr) {
 		eptr->chunkisopen = 0;
 		eptr->state = IDLE; // no error - do not disconnect - go direct to the IDLE state, ready for requests on the same connection
 		LOG_AVG_STOP(eptr->readOperationTimer);
+		tracing::record(eptr->traceId, "chunkserver.read", eptr->traceStart, eptr->chunkid);
 	} else {
 		const uint32_t totalRequestSize = eptr->size;
 		const uint32_t thisPartOffset = eptr->offset % MFSBLOCKSIZE;
@@ -377,7 +381,7 @@ void worker_read_continue(csserventry *eptr) {
 				eptr->version, eptr->chunkType, eptr->offset, thisPartSize,
 				maxReadBehindBlocks,
 				readAheadBlocks,
-				packet->outputBuffer.get(), !eptr->chunkisopen);
+				packet->outputBuffer.get(), !eptr->chunkisopen, eptr->traceId);
 		if (eptr->rjobid == 0) {
 			eptr->state = CLOSE;
 			return;
@@ -405,11 +409,20 @@ void worker_read_init(csserventry *eptr, const uint8_t *data,
 
 	// Deserialize request
 	sassert(type == LIZ_CLTOCS_READ || type == CLTOCS_READ);
+	eptr->traceId = 0;
 	try {
 		if (type == LIZ_CLTOCS_READ) {
 			PacketVersion v;
 			deserializePacketVersionNoHeader(data, length, v);
-			if (v == cltocs::read::kECChunks) {
+			if (v == cltocs::read::kTracedECChunks) {
+				cltocs::read::deserialize(data, length,
+						eptr->chunkid,
+						eptr->version,
+						eptr->chunkType,
+						eptr->offset,
+						eptr->size,
+						eptr->traceId);
+			} else if (v == cltocs::read::kECChunks) {
 				cltocs::read::deserialize(data, length,
 						eptr->chunkid,
 						eptr->version,
@@ -463,6 +476,7 @@ void worker_read_init(csserventry *eptr, const uint8_t *data,
 	eptr->todocnt = 0;
 	eptr->rjobid = 0;
 	LOG_AVG_START0(eptr->readOperationTimer, "csserv_read");
+	eptr->traceStart = tracing::now();
 	worker_read_continue(eptr);
 }
 
@@ -547,9 +561,12 @@ void worker_write_finished(uint8_t status, void *e) {
 
 void serializeCltocsWriteInit(std::vector<uint8_t>& buffer,
 		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
-		const std::vector<ChunkTypeWithAddress>& chain, uint32_t target_version) {
+		const std::vector<ChunkTypeWithAddress>& chain, uint32_t target_version,
+		uint64_t traceId) {
 
-	if (target_version >= kFirstECVersion) {
+	if (traceId != 0 && target_version >= kFirstTracingVersion) {
+		cltocs::writeInit::serialize(buffer, chunkId, chunkVersion, chunkType, chain, traceId);
+	} else if (target_version >= kFirstECVersion) {
 		cltocs::writeInit::serialize(buffer, chunkId, chunkVersion, chunkType, chain);
 	} else if (target_version >= kFirstXorVersion) {
 		assert((int)chunkType.getSliceType() < Goal::Slice::Type::kECFirst);
@@ -577,11 +594,16 @@ void worker_write_init(csserventry *eptr,
 	std::vector<ChunkTypeWithAddress> chain;
 
 	sassert(type == LIZ_CLTOCS_WRITE_INIT || type == CLTOCS_WRITE);
+	eptr->traceId = 0;
+	eptr->traceStart = tracing::now();
 	try {
 		if (type == LIZ_CLTOCS_WRITE_INIT) {
 			PacketVersion v;
 			deserializePacketVersionNoHeader(data, length, v);
-			if (v == cltocs::writeInit::kECChunks) {
+			if (v == cltocs::writeInit::kTracedECChunks) {
+				cltocs::writeInit::deserialize(data, length,
+					eptr->chunkid, eptr->version, eptr->chunkType, chain, eptr->traceId);
+			} else if (v == cltocs::writeInit::kECChunks) {
 				cltocs::writeInit::deserialize(data, length,
 					eptr->chunkid, eptr->version, eptr->chunkType, chain);
 			} else {
@@ -616,7 +638,8 @@ void worker_write_init(csserventry *eptr,
 		uint32_t target_version = chain[0].chunkserver_version;
 		chain.erase(chain.begin());
 		serializeCltocsWriteInit(eptr->fwdinitpacket,
-				eptr->chunkid, eptr->version, eptr->chunkType, chain, target_version);
+				eptr->chunkid, eptr->version, eptr->chunkType, chain, target_version,
+				eptr->traceId);
 		eptr->fwdstartptr = eptr->fwdinitpacket.data();
 		eptr->fwdbytesleft = eptr->fwdinitpacket.size();
 		eptr->connretrycnt = 0;
@@ -695,7 +718,7 @@ void worker_write_data(csserventry *eptr,
 	eptr->wjobwriteid = writeId;
 	eptr->wjobid = job_write(eptr->workerJobPool, worker_write_finished, eptr,
 			chunkId, eptr->version, eptr->chunkType,
-			blocknum, offset, size, crc, dataToWrite);
+			blocknum, offset, size, crc, dataToWrite, eptr->traceId);
 }
 
 void worker_write_status(csserventry *eptr,
@@ -792,6 +815,7 @@ void worker_write_end(csserventry *eptr, const uint8_t* data, uint32_t length) {
 		tcpclose(eptr->fwdsock);
 		eptr->fwdsock = -1;
 	}
+	tracing::record(eptr->traceId, "chunkserver.write", eptr->traceStart, eptr->chunkid);
 	eptr->state = IDLE;
 }
 
@@ -898,6 +922,21 @@ void worker_hdd_list_v2(csserventry *eptr, const uint8_t *data,
 	hdd_diskinfo_v2_data(ptr); // unlock
 }
 
+void worker_metrics(csserventry *eptr, const uint8_t *data, uint32_t length) {
+	TRACETHIS();
+	try {
+		cltocs::metrics::deserialize(data, length);
+	} catch (IncorrectDeserializationException &e) {
+		syslog(LOG_NOTICE, "LIZ_CLTOCS_METRICS - bad packet: %s (length: %" PRIu32 ")",
+				e.what(), length);
+		eptr->state = CLOSE;
+		return;
+	}
+	std::vector<uint8_t> buffer;
+	cstocl::metrics::serialize(buffer, metrics::registry().exportText());
+	worker_create_attached_packet(eptr, buffer);
+}
+
 void worker_chart(csserventry *eptr, const uint8_t *data, uint32_t length) {
 	TRACETHIS();
 	uint32_t chartid;
@@ -1036,6 +1075,9 @@ void worker_gotpacket(csserventry *eptr, uint32_t type, const uint8_t *data, uin
 		case CLTOCS_HDD_LIST_V2:
 			worker_hdd_list_v2(eptr, data, length);
 			break;
+		case LIZ_CLTOCS_METRICS:
+			worker_metrics(eptr, data, length);
+			break;
 		case CLTOAN_CHART:
 			worker_chart(eptr, data, length);
 			break;
@@ -118,6 +118,8 @@ struct csserventry {
 	uint32_t offset; // R
 	uint32_t size; // R
 	MessageSerializer* messageSerializer; // R+W
+	uint64_t traceId; // R+W, 0 if the request is not traced
+	uint64_t traceStart; // R+W
 
 	LOG_AVG_TYPE readOperationTimer;
 
@@ -154,6 +156,8 @@ struct csserventry {
 			  offset(0),
 			  size(0),
 			  messageSerializer(nullptr),
+			  traceId(0),
+			  traceStart(0),
 			  next(nullptr) {
 		inputpacket.bytesleft = 8;
 		inputpacket.startptr = hdrbuff;
@@ -0,0 +1,100 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/batch_executor.h"
+
+BatchExecutor::BatchExecutor(unsigned workers)
+		: job_(nullptr),
+		  jobCount_(0),
+		  nextJob_(0),
+		  batchId_(0),
+		  busyWorkers_(0),
+		  terminate_(false) {
+	threads_.reserve(workers);
+	for (unsigned i = 0; i < workers; ++i) {
+		threads_.emplace_back(&BatchExecutor::workerLoop, this);
+	}
+}
+
+BatchExecutor::~BatchExecutor() {
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		terminate_ = true;
+	}
+	batchStarted_.notify_all();
+	for (auto& thread : threads_) {
+		thread.join();
+	}
+}
+
+void BatchExecutor::run(std::size_t count, const Job& job) {
+	if (count == 0) {
+		return;
+	}
+	if (threads_.empty() || count == 1) {
+		for (std::size_t i = 0; i < count; ++i) {
+			job(i);
+		}
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		job_ = &job;
+		jobCount_ = count;
+		nextJob_ = 0;
+		busyWorkers_ = threads_.size();
+		++batchId_;
+	}
+	batchStarted_.notify_all();
+	executeJobs();
+	std::unique_lock<std::mutex> lock(mutex_);
+	batchFinished_.wait(lock, [this]() { return busyWorkers_ == 0; });
+	job_ = nullptr;
+}
+
+void BatchExecutor::executeJobs() {
+	for (;;) {
+		std::size_t index = nextJob_.fetch_add(1);
+		if (index >= jobCount_) {
+			return;
+		}
+		(*job_)(index);
+	}
+}
+
+void BatchExecutor::workerLoop() {
+	uint64_t lastBatchId = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			batchStarted_.wait(lock, [&]() { return terminate_ || batchId_ != lastBatchId; });
+			if (terminate_) {
+				return;
+			}
+			lastBatchId = batchId_;
+		}
+		executeJobs();
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (--busyWorkers_ == 0) {
+				batchFinished_.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Executes batches of independent jobs on a fixed set of worker threads.
+ *
+ * The calling thread takes part in the execution and run() returns only after every job
+ * of the batch has finished, so the caller may rely on nothing being executed in the
+ * background between two batches. Jobs of one batch must not depend on each other.
+ */
+class BatchExecutor {
+public:
+	typedef std::function<void(std::size_t)> Job;
+
+	/// \param workers number of additional threads, 0 means that run() executes jobs inline
+	explicit BatchExecutor(unsigned workers);
+	~BatchExecutor();
+
+	BatchExecutor(const BatchExecutor&) = delete;
+	BatchExecutor& operator=(const BatchExecutor&) = delete;
+
+	/// Calls job(0), ..., job(count - 1) concurrently and waits for all of them.
+	void run(std::size_t count, const Job& job);
+
+	unsigned workers() const {
+		return threads_.size();
+	}
+
+private:
+	void workerLoop();
+	void executeJobs();
+
+	std::vector<std::thread> threads_;
+	std::mutex mutex_;
+	std::condition_variable batchStarted_;
+	std::condition_variable batchFinished_;
+
+	const Job* job_;
+	std::size_t jobCount_;
+	std::atomic<std::size_t> nextJob_;
+	uint64_t batchId_;
+	unsigned busyWorkers_;
+	bool terminate_;
+};
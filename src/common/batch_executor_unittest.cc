@@ -0,0 +1,49 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/batch_executor.h"
+
+#include <atomic>
+#include <vector>
+#include <gtest/gtest.h>
+
+TEST(BatchExecutorTests, ExecutesEveryJobOnce) {
+	for (unsigned workers : {0U, 1U, 4U}) {
+		BatchExecutor executor(workers);
+		for (std::size_t count : {0U, 1U, 7U, 1000U}) {
+			std::vector<std::atomic<int>> calls(count);
+			for (auto& c : calls) {
+				c = 0;
+			}
+			executor.run(count, [&](std::size_t i) { ++calls[i]; });
+			for (std::size_t i = 0; i < count; ++i) {
+				EXPECT_EQ(1, calls[i]) << "workers=" << workers << " job=" << i;
+			}
+		}
+	}
+}
+
+TEST(BatchExecutorTests, ManyConsecutiveBatches) {
+	BatchExecutor executor(3);
+	std::atomic<uint64_t> sum(0);
+	for (int batch = 0; batch < 500; ++batch) {
+		executor.run(10, [&](std::size_t i) { sum += i; });
+		ASSERT_EQ(45U * (batch + 1), sum);
+	}
+}
@@ -19,70 +19,149 @@
 #include "common/platform.h"
 #include "common/block_xor.h"
 
-#include <algorithm>
-#include <cstdlib>
+#include <cstring>
 
-#include "common/massert.h"
-
-#if defined(__GNUC__) && defined(__GNUC_MINOR__)
-#  if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)
-#    define LIZARDFS_HAVE_BUILTIN_ASSUME_ALIGNED
+#if defined(LIZARDFS_HAVE_CPU_CHECK) && (defined(__x86_64__) || defined(__i386__))
+#  define LIZARDFS_HAVE_XOR_KERNELS
+#  if __GNUC__ >= 5
+#    define LIZARDFS_HAVE_XOR_KERNELS_AVX
 #  endif
 #endif
 
-// We check whether dest and source are well-aligned and hope that compiler will perform XORs using
-// vector instructions. Some architectures don't support unaligned vector loads and stores, others
-// (e.g. x86) support them but aligned versions still are faster.
-#define ALIGNMENT size_t(16)
+// XORs bytes of sources from offset to size, used for tails shorter than a vector.
+static inline void xorBytes(uint8_t* dest, const uint8_t* const* sources, size_t count,
+		size_t offset, size_t size) {
+	for (size_t i = offset; i < size; ++i) {
+		uint8_t value = sources[0][i];
+		for (size_t j = 1; j < count; ++j) {
+			value ^= sources[j][i];
+		}
+		dest[i] = value;
+	}
+}
 
+// Used when no vector instructions are known to be supported, XORs 64-bit words.
+static void blockXorGeneric(uint8_t* dest, const uint8_t* const* sources, size_t count,
+		size_t size) {
+	size_t offset = 0;
+	for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+		uint64_t value, word;
+		memcpy(&value, sources[0] + offset, sizeof(value));
+		for (size_t j = 1; j < count; ++j) {
+			memcpy(&word, sources[j] + offset, sizeof(word));
+			value ^= word;
+		}
+		memcpy(dest + offset, &value, sizeof(value));
+	}
+	xorBytes(dest, sources, count, offset, size);
+}
 
-// Assumes that dest and source are properly aligned:
-static inline void blockXorAligned(uint8_t* dest, const uint8_t* source, size_t size);
+#ifdef LIZARDFS_HAVE_XOR_KERNELS
+
+// XORs whole vectors of sources starting from offset, which is advanced past processed bytes.
+// Four vectors are processed at once to hide latency of loads. Vectors are loaded with
+// unaligned loads, which on current x86 CPUs are as fast as aligned ones for aligned data.
+// Inlined into functions compiled for a specific instruction set.
+template <int kWidth>
+static inline __attribute__((always_inline)) void xorVectors(uint8_t* dest,
+		const uint8_t* const* sources, size_t count, size_t& offset, size_t size) {
+	typedef uint8_t Vector __attribute__((vector_size(kWidth), aligned(1)));
+
+	for (; offset + 4 * kWidth <= size; offset += 4 * kWidth) {
+		const uint8_t* source = sources[0] + offset;
+		Vector a = *(const Vector*)(source);
+		Vector b = *(const Vector*)(source + kWidth);
+		Vector c = *(const Vector*)(source + 2 * kWidth);
+		Vector d = *(const Vector*)(source + 3 * kWidth);
+		for (size_t j = 1; j < count; ++j) {
+			source = sources[j] + offset;
+			a ^= *(const Vector*)(source);
+			b ^= *(const Vector*)(source + kWidth);
+			c ^= *(const Vector*)(source + 2 * kWidth);
+			d ^= *(const Vector*)(source + 3 * kWidth);
+		}
+		*(Vector*)(dest + offset) = a;
+		*(Vector*)(dest + offset + kWidth) = b;
+		*(Vector*)(dest + offset + 2 * kWidth) = c;
+		*(Vector*)(dest + offset + 3 * kWidth) = d;
+	}
+	for (; offset + kWidth <= size; offset += kWidth) {
+		Vector a = *(const Vector*)(sources[0] + offset);
+		for (size_t j = 1; j < count; ++j) {
+			a ^= *(const Vector*)(sources[j] + offset);
+		}
+		*(Vector*)(dest + offset) = a;
+	}
+}
 
-// Works for any alignment of dest and source:
-static inline void blockXorUnaligned(uint8_t* dest, const uint8_t* source, size_t size);
+__attribute__((target("sse2")))
+static void blockXorSse2(uint8_t* dest, const uint8_t* const* sources, size_t count,
+		size_t size) {
+	size_t offset = 0;
+	xorVectors<16>(dest, sources, count, offset, size);
+	xorBytes(dest, sources, count, offset, size);
+}
 
+#ifdef LIZARDFS_HAVE_XOR_KERNELS_AVX
 
-// Public interface, tries to do it as well as possible.
-void blockXor(uint8_t* dest, const uint8_t* source, size_t size) {
-	intptr_t d = reinterpret_cast<intptr_t>(dest);
-	intptr_t s = reinterpret_cast<intptr_t>(source);
-	if (d % ALIGNMENT == s % ALIGNMENT) {
-		size_t unalignedPrefixSize = (ALIGNMENT - d % ALIGNMENT) % ALIGNMENT;
-		if (size < unalignedPrefixSize) {
-			blockXorUnaligned(dest, source, size);
-		} else {
-			blockXorUnaligned(dest, source, unalignedPrefixSize);
-			blockXorAligned(dest + unalignedPrefixSize, source + unalignedPrefixSize,
-					size - unalignedPrefixSize);
+__attribute__((target("avx2")))
+static void blockXorAvx2(uint8_t* dest, const uint8_t* const* sources, size_t count,
+		size_t size) {
+	size_t offset = 0;
+	xorVectors<32>(dest, sources, count, offset, size);
+	xorVectors<16>(dest, sources, count, offset, size);
+	xorBytes(dest, sources, count, offset, size);
+}
+
+__attribute__((target("avx512f")))
+static void blockXorAvx512(uint8_t* dest, const uint8_t* const* sources, size_t count,
+		size_t size) {
+	size_t offset = 0;
+	xorVectors<64>(dest, sources, count, offset, size);
+	xorVectors<16>(dest, sources, count, offset, size);
+	xorBytes(dest, sources, count, offset, size);
+}
+
+#endif // LIZARDFS_HAVE_XOR_KERNELS_AVX
+#endif // LIZARDFS_HAVE_XOR_KERNELS
+
+const std::vector<BlockXorKernel>& blockXorKernels() {
+	static const std::vector<BlockXorKernel> kernels = []() {
+		std::vector<BlockXorKernel> result = {{"generic", blockXorGeneric}};
+#ifdef LIZARDFS_HAVE_XOR_KERNELS
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse2")) {
+			result.push_back({"sse2", blockXorSse2});
 		}
-	} else {
-		blockXorUnaligned(dest, source, size);
-	}
+#ifdef LIZARDFS_HAVE_XOR_KERNELS_AVX
+		if (__builtin_cpu_supports("avx2")) {
+			result.push_back({"avx2", blockXorAvx2});
+		}
+		if (__builtin_cpu_supports("avx512f")) {
+			result.push_back({"avx512", blockXorAvx512});
+		}
+#endif
+#endif
+		return result;
+	}();
+	return kernels;
 }
 
-static inline void blockXorUnaligned(uint8_t* dest, const uint8_t* source, size_t size) {
-	// This code compiled with gcc uses unaligned vector loads/stores (movdqu) and pxor on x86.
-	for (size_t i = 0; i < size; ++i) {
-		dest[i] ^= source[i];
-	}
+/// The fastest kernel, resolved on first use so that XOR works in static initializers too
+static BlockXorFunction blockXorFunction() {
+	static const BlockXorFunction function = blockXorKernels().back().function;
+	return function;
 }
 
-static inline void blockXorAligned(uint8_t* dest, const uint8_t* source, size_t size) {
-	intptr_t d = reinterpret_cast<intptr_t>(dest);
-	intptr_t s = reinterpret_cast<intptr_t>(source);
-	sassert(d % ALIGNMENT == 0 && s % ALIGNMENT == 0);
-#ifdef LIZARDFS_HAVE_BUILTIN_ASSUME_ALIGNED
-	uint8_t* alignedDest =
-		static_cast<uint8_t*>(__builtin_assume_aligned(dest, ALIGNMENT));
-	const uint8_t* alignedSource =
-		static_cast<const uint8_t*>(__builtin_assume_aligned(source, ALIGNMENT));
-	// This code compiled with gcc use aligned vector loads/stores (movdqa) and pxor on x86.
-	for (size_t i = 0; i < size; ++i) {
-		alignedDest[i] ^= alignedSource[i];
+void blockXorMany(uint8_t* dest, const uint8_t* const* sources, size_t count, size_t size) {
+	if (count == 0) {
+		memset(dest, 0, size);
+		return;
 	}
-#else
-	// :(
-	blockXorUnaligned(dest, source, size);
-#endif
+	blockXorFunction()(dest, sources, count, size);
+}
+
+void blockXor(uint8_t* dest, const uint8_t* source, size_t size) {
+	const uint8_t* sources[2] = {dest, source};
+	blockXorFunction()(dest, sources, 2, size);
 }
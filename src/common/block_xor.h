@@ -22,12 +22,34 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 /*
  * XOR dest in-place with source.
  *
- * Implementation will try to use vector instructions if dest and source
- * are well-aligned or, at least, the difference between them is divisible
- * by vector width.
+ * Implementation uses the widest vector instructions supported by the CPU,
+ * any alignment of dest and source is fine.
  */
 void blockXor(uint8_t* dest, const uint8_t* source, size_t size);
+
+/*
+ * Store XOR of count sources in dest, reading every byte of sources once.
+ *
+ * dest may be the same as sources[0], otherwise it must not overlap any of sources.
+ * If count is 0, dest is zeroed.
+ */
+void blockXorMany(uint8_t* dest, const uint8_t* const* sources, size_t count, size_t size);
+
+typedef void (*BlockXorFunction)(uint8_t* dest, const uint8_t* const* sources, size_t count,
+		size_t size);
+
+struct BlockXorKernel {
+	const char* name;
+	BlockXorFunction function;
+};
+
+/*
+ * Implementations of blockXorMany supported by this CPU, the fastest one last.
+ * The last one is used by blockXor and blockXorMany.
+ */
+const std::vector<BlockXorKernel>& blockXorKernels();
@@ -19,8 +19,23 @@
 #include "common/platform.h"
 #include "common/block_xor.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
 #include <gtest/gtest.h>
 
+#include "common/time_utils.h"
+#include "protocol/MFSCommunication.h"
+
+static std::vector<uint8_t> randomData(size_t size) {
+	std::vector<uint8_t> result(size);
+	for (auto& byte : result) {
+		byte = std::rand();
+	}
+	return result;
+}
+
 TEST(BlockXorTests, BlockXor) {
 	std::vector<uint8_t> v1(7000);
 	std::vector<uint8_t> v2(v1.size());
@@ -33,3 +48,90 @@ TEST(BlockXorTests, BlockXor) {
 		}
 	}
 }
+
+TEST(BlockXorTests, KernelsMatchReference) {
+	std::vector<std::vector<uint8_t>> data;
+	for (int i = 0; i < 10; ++i) {
+		data.push_back(randomData(70000));
+	}
+
+	for (const BlockXorKernel& kernel : blockXorKernels()) {
+		SCOPED_TRACE(kernel.name);
+		for (size_t count = 1; count <= data.size(); count += 3) {
+			for (size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 255, 256, 257, 4000, 65536}) {
+				for (size_t offset = 0; offset < 3; ++offset) {
+					std::vector<const uint8_t*> sources;
+					std::vector<uint8_t> expected(size);
+					for (size_t i = 0; i < count; ++i) {
+						// Sources with different alignments
+						sources.push_back(data[i].data() + offset * i);
+						for (size_t j = 0; j < size; ++j) {
+							expected[j] ^= sources[i][j];
+						}
+					}
+					std::vector<uint8_t> dest(size + 1);
+					kernel.function(dest.data() + 1, sources.data(), count, size);
+					ASSERT_EQ(expected, std::vector<uint8_t>(dest.begin() + 1, dest.end()))
+							<< "count " << count << ", size " << size << ", offset " << offset;
+				}
+			}
+		}
+	}
+}
+
+TEST(BlockXorTests, BlockXorMany) {
+	std::vector<uint8_t> a = randomData(5000);
+	std::vector<uint8_t> b = randomData(5000);
+	std::vector<uint8_t> c = randomData(5000);
+	std::vector<uint8_t> expected = a;
+	blockXor(expected.data(), b.data(), expected.size());
+	blockXor(expected.data(), c.data(), expected.size());
+
+	std::vector<uint8_t> dest(5000, 1);
+	const uint8_t* sources[] = {a.data(), b.data(), c.data()};
+	blockXorMany(dest.data(), sources, 3, dest.size());
+	EXPECT_EQ(expected, dest);
+
+	// In place
+	blockXorMany(a.data(), sources, 3, a.size());
+	EXPECT_EQ(expected, a);
+
+	blockXorMany(dest.data(), sources, 0, dest.size());
+	EXPECT_EQ(std::vector<uint8_t>(dest.size(), 0), dest);
+}
+
+// Throughput of computing a parity block of a xor9 stripe, as done by the mount
+TEST(BlockXorTests, XorParityBenchmark) {
+	const int kLevel = 9;
+	const int kRepeatCount = 2000;
+	std::vector<std::vector<uint8_t>> blocks;
+	std::vector<const uint8_t*> sources;
+	for (int i = 0; i < kLevel; ++i) {
+		blocks.push_back(randomData(MFSBLOCKSIZE));
+		sources.push_back(blocks.back().data());
+	}
+	std::vector<uint8_t> parity(MFSBLOCKSIZE);
+
+	for (const BlockXorKernel& kernel : blockXorKernels()) {
+		Timer timer;
+		for (int i = 0; i < kRepeatCount; ++i) {
+			kernel.function(parity.data(), sources.data(), kLevel, MFSBLOCKSIZE);
+		}
+		int64_t speed = int64_t(kLevel) * MFSBLOCKSIZE * kRepeatCount
+				/ std::max<int64_t>(timer.elapsed_us(), 1);
+		std::cout << "Xor parity (" << kernel.name << ", " << kLevel << " blocks) = "
+				<< speed << "MB/s\n";
+	}
+
+	Timer timer;
+	for (int i = 0; i < kRepeatCount; ++i) {
+		std::copy(blocks[0].begin(), blocks[0].end(), parity.begin());
+		for (int j = 1; j < kLevel; ++j) {
+			blockXor(parity.data(), sources[j], MFSBLOCKSIZE);
+		}
+	}
+	int64_t speed = int64_t(kLevel) * MFSBLOCKSIZE * kRepeatCount
+			/ std::max<int64_t>(timer.elapsed_us(), 1);
+	std::cout << "Xor parity (pairwise blockXor, " << kLevel << " blocks) = "
+			<< speed << "MB/s\n";
+}
@@ -78,13 +78,46 @@ int ChunkConnector::startUsingConnection(const NetworkAddress& server,
 	return fd;
 }
 
+int ChunkConnector::startConnecting(const NetworkAddress& server) const {
+	int fd = tcpsocket();
+	if (fd < 0) {
+		lzfs_pretty_syslog(LOG_WARNING, "can't create tcp socket: %s", strerr(tcpgetlasterror()));
+		return -1;
+	}
+	if (sourceIp_ && tcpnumbind(fd, sourceIp_, 0) < 0) {
+		lzfs_pretty_syslog(LOG_WARNING, "can't bind to given ip: %s", strerr(tcpgetlasterror()));
+		tcpclose(fd);
+		return -1;
+	}
+	if (tcpnonblock(fd) < 0 || tcpnumconnect(fd, server.ip, server.port) < 0) {
+		tcpclose(fd);
+		return -1;
+	}
+	return fd;
+}
+
 void ChunkConnector::endUsingConnection(int fd, const NetworkAddress& /* server */) const {
 	tcpclose(fd);
 }
 
-ChunkConnectorUsingPool::ChunkConnectorUsingPool(ConnectionPool& connectionPool, uint32_t sourceIp)
+ChunkConnectorUsingPool::ChunkConnectorUsingPool(ConnectionPool& connectionPool, uint32_t sourceIp,
+		ChunkserverStats* chunkserverStats)
 		: ChunkConnector(sourceIp),
-		  connectionPool_(connectionPool) {
+		  connectionPool_(connectionPool),
+		  chunkserverStats_(chunkserverStats) {
+}
+
+int ChunkConnectorUsingPool::connect(const NetworkAddress& server, const Timeout& timeout) const {
+	Timer timer;
+	int fd;
+	try {
+		fd = ChunkConnector::startUsingConnection(server, timeout);
+	} catch (ChunkserverConnectionException&) {
+		reportFailedConnect(server);
+		throw;
+	}
+	connectionPool_.reportConnect(server, true, timer.elapsed_us());
+	return fd;
 }
 
 int ChunkConnectorUsingPool::startUsingConnection(const NetworkAddress& server,
@@ -93,7 +126,73 @@ int ChunkConnectorUsingPool::startUsingConnection(const NetworkAddress& server,
 	if (fd >= 0) {
 		return fd;
 	} else {
-		return ChunkConnector::startUsingConnection(server, timeout);
+		return connect(server, timeout);
+	}
+}
+
+void ChunkConnectorUsingPool::prewarm(uint32_t connectTimeout_ms) const {
+	// Connections are started without waiting and awaited together, so that unreachable
+	// servers don't hold the calling thread for a timeout each
+	Timer timer;
+	std::vector<pollfd> pending;
+	std::vector<NetworkAddress> pendingServers;
+	uint32_t connectionsLeft = kMaxPrewarmedConnections;
+	for (const auto& serverAndCount : connectionPool_.getServersToPrewarm()) {
+		for (uint32_t i = 0; i < serverAndCount.second && connectionsLeft > 0; ++i) {
+			int fd = startConnecting(serverAndCount.first);
+			if (fd < 0) {
+				reportFailedConnect(serverAndCount.first);
+				break;
+			}
+			--connectionsLeft;
+			pollfd pfd;
+			pfd.fd = fd;
+			pfd.events = POLLOUT;
+			pfd.revents = 0;
+			pending.push_back(pfd);
+			pendingServers.push_back(serverAndCount.first);
+		}
+	}
+
+	Timeout timeout{std::chrono::milliseconds(connectTimeout_ms)};
+	while (!pending.empty() && !timeout.expired()) {
+		if (tcppoll(pending, std::max<int64_t>(1, timeout.remaining_ms())) < 0) {
+			break;
+		}
+		for (size_t i = 0; i < pending.size();) {
+			if (pending[i].revents == 0) {
+				++i;
+				continue;
+			}
+			int fd = pending[i].fd;
+			NetworkAddress server = pendingServers[i];
+			if (tcpgetstatus(fd) == 0) {
+				if (tcpnodelay(fd) < 0) {
+					lzfs_pretty_syslog(LOG_WARNING, "can't set TCP_NODELAY: %s",
+							strerr(tcpgetlasterror()));
+				}
+				connectionPool_.reportConnect(server, true, timer.elapsed_us());
+				connectionPool_.putConnection(fd, server, kConnectionPoolTimeout_s);
+			} else {
+				tcpclose(fd);
+				reportFailedConnect(server);
+			}
+			pending[i] = pending.back();
+			pending.pop_back();
+			pendingServers[i] = pendingServers.back();
+			pendingServers.pop_back();
+		}
+	}
+	for (size_t i = 0; i < pending.size(); ++i) {
+		tcpclose(pending[i].fd);
+		reportFailedConnect(pendingServers[i]);
+	}
+}
+
+void ChunkConnectorUsingPool::reportFailedConnect(const NetworkAddress& server) const {
+	connectionPool_.reportConnect(server, false, 0);
+	if (chunkserverStats_ != nullptr) {
+		chunkserverStats_->markDefective(server);
 	}
 }
 
@@ -20,6 +20,7 @@
 
 #include "common/platform.h"
 
+#include "common/chunkserver_stats.h"
 #include "common/connection_pool.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
@@ -41,6 +42,13 @@ public:
 		sourceIp_ = sourceIp;
 	}
 
+protected:
+	/**
+	 * Creates a non-blocking socket and starts connecting it to a server.
+	 * \return the socket, which becomes writable when connecting finishes, or -1 on error
+	 */
+	int startConnecting(const NetworkAddress& server) const;
+
 private:
 	/// Time after which SYN packet will be considered lost during the first retry of tcptoconnect.
 	uint32_t roundTripTime_ms_;
@@ -97,10 +105,31 @@ class ChunkConnectorUsingPool : public ChunkConnector {
 public:
 	static const uint32_t kConnectionPoolTimeout_s = 3;
 
-	ChunkConnectorUsingPool(ConnectionPool& connectionPool, uint32_t sourceIp = 0);
+	/// Maximum number of connections opened by a single call to prewarm
+	static const uint32_t kMaxPrewarmedConnections = 16;
+
+	/**
+	 * \param chunkserverStats - if not null, servers which can't be connected to are marked
+	 *        as defective there
+	 */
+	ChunkConnectorUsingPool(ConnectionPool& connectionPool, uint32_t sourceIp = 0,
+			ChunkserverStats* chunkserverStats = nullptr);
 	virtual int startUsingConnection(const NetworkAddress& server, const Timeout& timeout) const;
 	virtual void endUsingConnection(int fd, const NetworkAddress& server) const;
 
+	/**
+	 * Opens connections to servers which recently had no idle connections in the pool,
+	 * so that next requests to these servers don't wait for connecting.
+	 * Servers whose pools are full are skipped. All connections are opened in parallel,
+	 * so the call takes at most \p connectTimeout_ms.
+	 * \param connectTimeout_ms - timeout of connecting
+	 */
+	void prewarm(uint32_t connectTimeout_ms) const;
+
 private:
+	int connect(const NetworkAddress& server, const Timeout& timeout) const;
+	void reportFailedConnect(const NetworkAddress& server) const;
+
 	ConnectionPool& connectionPool_;
+	ChunkserverStats* chunkserverStats_;
 };
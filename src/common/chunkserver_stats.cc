@@ -25,9 +25,13 @@
 // ChunkserverEntry implementation
 
 constexpr int ChunkserverStats::ChunkserverEntry::defectiveTimeout_ms;
+constexpr int ChunkserverStats::ChunkserverEntry::latencyMemory_ms;
+constexpr float ChunkserverStats::ChunkserverEntry::referenceLatency_us;
+constexpr float ChunkserverStats::ChunkserverEntry::latencySmoothing;
 
 ChunkserverStats::ChunkserverEntry::ChunkserverEntry(): pendingReads_(0), pendingWrites_(0),
-		defects_(0), defectiveTimeout_(std::chrono::milliseconds(defectiveTimeout_ms)) {
+		defects_(0), defectiveTimeout_(std::chrono::milliseconds(defectiveTimeout_ms)),
+		readLatency_us_(0), latencyTimeout_(std::chrono::milliseconds(latencyMemory_ms)) {
 }
 
 // ChunkserverStats implementation
@@ -72,12 +76,29 @@ void ChunkserverStats::markDefective(const NetworkAddress& address) {
 	chunkserver.defectiveTimeout_.reset();
 }
 
+void ChunkserverStats::recordReadLatency(const NetworkAddress& address, uint32_t latency_us) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	ChunkserverEntry &chunkserver = chunkserverEntries_[address];
+	if (chunkserver.readLatency_us() == 0) {
+		chunkserver.readLatency_us_ = latency_us;
+	} else {
+		chunkserver.readLatency_us_ += ChunkserverEntry::latencySmoothing
+				* (latency_us - chunkserver.readLatency_us_);
+	}
+	chunkserver.latencyTimeout_.reset();
+}
+
+uint32_t ChunkserverStats::ChunkserverEntry::readLatency_us() const {
+	return latencyTimeout_.expired() ? 0 : readLatency_us_;
+}
+
 float ChunkserverStats::ChunkserverEntry::score() const {
+	float expectedWait_us = float(readLatency_us()) * (getOperationCount() + 1);
+	float score = 1. / (1. + expectedWait_us / referenceLatency_us);
 	if (defects_ > 0 && !defectiveTimeout_.expired()) {
-		return 1. / (defects_ + 1);
-	} else {
-		return 1;
+		score /= defects_ + 1;
 	}
+	return score;
 }
 
 // ChunkserverStatsProxy implementation
@@ -123,6 +144,11 @@ void ChunkserverStatsProxy::markWorking(const NetworkAddress& address) {
 	stats_.markWorking(address);
 }
 
+void ChunkserverStatsProxy::recordReadLatency(const NetworkAddress& address,
+		uint32_t latency_us) {
+	stats_.recordReadLatency(address, latency_us);
+}
+
 void ChunkserverStatsProxy::allPendingDefective() {
 	for (auto entry : readOperations_) {
 		if (entry.second > 0) {
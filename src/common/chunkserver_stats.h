@@ -33,8 +33,12 @@
 // Code which uses chunkservers to perform read/write operations should register and unregister
 // these operations with the global ChunkserverStats instance.
 //
+// Code which reads from chunkservers should also report how long the reads took. Recent latency
+// multiplied by the number of pending operations estimates how long a new operation would wait.
+//
 // If there is a choice between multiple chunkservers capable of performing some operation, the
-// chunkserver with lowest pending operation count should be chosen.
+// chunkserver with the highest score, i.e. not defective and with the lowest expected wait,
+// should be chosen.
 //
 // Code that determines a chunkserver to be defective should call markDefective(). Others should
 // prefer to use chunkservers not marked as defective, if possible. The defective flag is cleared
@@ -62,15 +66,26 @@ public:
 			return pendingWrites_;
 		}
 
+		// Average latency of recent reads, 0 if there were no reads recently
+		uint32_t readLatency_us() const;
+
 		float score() const;
 
 	private:
 		static constexpr int defectiveTimeout_ms = 2000;
+		// latency older than this is forgotten, so that slow servers are tried again
+		static constexpr int latencyMemory_ms = 10000;
+		// expected wait which halves the score
+		static constexpr float referenceLatency_us = 10000;
+		// weight of the newest sample in the average
+		static constexpr float latencySmoothing = 0.2;
 
 		uint32_t pendingReads_;
 		uint32_t pendingWrites_;
 		uint32_t defects_;
 		Timeout defectiveTimeout_;
+		float readLatency_us_;
+		Timeout latencyTimeout_;
 
 		friend class ChunkserverStats;
 	};
@@ -88,6 +103,8 @@ public:
 	void markDefective(const NetworkAddress& address);
 	void markWorking(const NetworkAddress& address);
 
+	void recordReadLatency(const NetworkAddress& address, uint32_t latency_us);
+
 private:
 	std::mutex mutex_;
 	std::unordered_map<NetworkAddress, ChunkserverEntry> chunkserverEntries_;
@@ -122,6 +139,8 @@ public:
 	void markDefective(const NetworkAddress& address);
 	void markWorking(const NetworkAddress& address);
 
+	void recordReadLatency(const NetworkAddress& address, uint32_t latency_us);
+
 	void allPendingDefective();
 
 private:
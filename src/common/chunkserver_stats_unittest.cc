@@ -76,6 +76,36 @@ TEST(ChunkserverStatsTests, ChunkserverStatsDefectTracking) {
 	EXPECT_EQ(stats.getStatisticsFor(server1).score(), 1.);
 }
 
+TEST(ChunkserverStatsTests, ChunkserverStatsLatency) {
+	ChunkserverStats stats;
+	NetworkAddress server1(1111, 11);
+	NetworkAddress server2(2222, 22);
+
+	stats.recordReadLatency(server1, 1000);
+	stats.recordReadLatency(server2, 20000);
+	EXPECT_EQ(1000u, stats.getStatisticsFor(server1).readLatency_us());
+	EXPECT_LT(stats.getStatisticsFor(server1).score(), 1.);
+	EXPECT_GT(stats.getStatisticsFor(server1).score(), stats.getStatisticsFor(server2).score());
+
+	// Recent samples move the average
+	stats.recordReadLatency(server1, 2000);
+	EXPECT_GT(stats.getStatisticsFor(server1).readLatency_us(), 1000u);
+	EXPECT_LT(stats.getStatisticsFor(server1).readLatency_us(), 2000u);
+
+	// Pending operations make a fast server worse than a slower but idle one
+	float idleScore = stats.getStatisticsFor(server1).score();
+	for (int i = 0; i < 30; ++i) {
+		stats.registerReadOperation(server1);
+	}
+	EXPECT_LT(stats.getStatisticsFor(server1).score(), idleScore);
+	EXPECT_LT(stats.getStatisticsFor(server1).score(), stats.getStatisticsFor(server2).score());
+
+	// Defects still lower the score
+	float busyScore = stats.getStatisticsFor(server1).score();
+	stats.markDefective(server1);
+	EXPECT_LT(stats.getStatisticsFor(server1).score(), busyScore);
+}
+
 TEST(ChunkserverStatsTests, ChunkserverStatsProxy) {
 	ChunkserverStats stats;
 	NetworkAddress server1(1111, 11);
@@ -0,0 +1,415 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/compressed_metadata.h"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "common/datapack.h"
+#include "protocol/MFSCommunication.h"
+
+#if defined(LIZARDFS_HAVE_ZLIB_H) && defined(LIZARDFS_HAVE_FOPENCOOKIE)
+#  define LIZARDFS_COMPRESSED_METADATA 1
+#  include <zlib.h>
+#endif
+
+/* Note LIZARDFSSIGNATURE instead of MFSSIGNATURE! */
+const char kCompressedMetadataSignature[] = LIZARDFSSIGNATURE "M Z1.";
+
+#ifdef LIZARDFS_COMPRESSED_METADATA
+
+namespace {
+
+enum RecordType : uint8_t {
+	kDataRecord = 'D',   // compressed block
+	kStoredRecord = 'S', // block which didn't compress
+	kPatchRecord = 'P',
+	kEndRecord = 'E'
+};
+
+const uint32_t kRecordHeaderSize = 1 + 4 + 4 + 4;
+const uint32_t kBlockSize = 1 << 20;
+const char kEofMarker[] = "[MFS EOF MARKER]";
+
+struct Patch {
+	uint64_t offset;
+	std::vector<uint8_t> data;
+};
+
+bool writeRecord(FILE *file, uint8_t type, uint32_t rawSize,
+		const uint8_t *payload, uint32_t payloadSize) {
+	uint8_t header[kRecordHeaderSize];
+	uint8_t *ptr = header;
+	put8bit(&ptr, type);
+	put32bit(&ptr, rawSize);
+	put32bit(&ptr, payloadSize);
+	put32bit(&ptr, crc32(0, payload, payloadSize));
+	return fwrite(header, 1, kRecordHeaderSize, file) == kRecordHeaderSize
+			&& fwrite(payload, 1, payloadSize, file) == payloadSize;
+}
+
+class Writer {
+public:
+	Writer(FILE *file, int level) : file_(file), level_(level), bufferStart_(0), pos_(0) {
+		buffer_.reserve(kBlockSize);
+	}
+
+	ssize_t write(const char *data, size_t size) {
+		if (pos_ > end() && !append(nullptr, pos_ - end())) {
+			return -1;
+		}
+		size_t done = 0;
+		if (pos_ < bufferStart_) {
+			// Bytes from blocks which are already written
+			size_t length = std::min<uint64_t>(size, bufferStart_ - pos_);
+			std::vector<uint8_t> payload(8 + length);
+			uint8_t *ptr = payload.data();
+			put64bit(&ptr, pos_);
+			memcpy(ptr, data, length);
+			if (!writeRecord(file_, kPatchRecord, length, payload.data(), payload.size())) {
+				return -1;
+			}
+			done += length;
+		}
+		if (done < size && pos_ + done < end()) {
+			size_t length = std::min<uint64_t>(size - done, end() - (pos_ + done));
+			memcpy(buffer_.data() + (pos_ + done - bufferStart_), data + done, length);
+			done += length;
+		}
+		if (done < size && !append(reinterpret_cast<const uint8_t*>(data) + done, size - done)) {
+			return -1;
+		}
+		pos_ += size;
+		return size;
+	}
+
+	int seek(off64_t *offset, int whence) {
+		int64_t base = (whence == SEEK_SET) ? 0 : (whence == SEEK_CUR) ? pos_ : end();
+		if (base + *offset < 0) {
+			errno = EINVAL;
+			return -1;
+		}
+		pos_ = base + *offset;
+		*offset = pos_;
+		return 0;
+	}
+
+	int close() {
+		bool ok = flushBuffer() && writeRecord(file_, kEndRecord, 0, nullptr, 0)
+				&& fwrite(kEofMarker, 1, 16, file_) == 16;
+		return ok ? 0 : EOF;
+	}
+
+private:
+	uint64_t end() const {
+		return bufferStart_ + buffer_.size();
+	}
+
+	/// Appends data at the end of the image, zeros if \a data is null
+	bool append(const uint8_t *data, uint64_t size) {
+		while (size > 0) {
+			uint32_t length = std::min<uint64_t>(size, kBlockSize - buffer_.size());
+			if (data) {
+				buffer_.insert(buffer_.end(), data, data + length);
+				data += length;
+			} else {
+				buffer_.resize(buffer_.size() + length, 0);
+			}
+			size -= length;
+			if (buffer_.size() == kBlockSize && !flushBuffer()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool flushBuffer() {
+		if (buffer_.empty()) {
+			return true;
+		}
+		uLongf compressedSize = compressBound(buffer_.size());
+		compressed_.resize(compressedSize);
+		bool ok;
+		if (compress2(compressed_.data(), &compressedSize, buffer_.data(), buffer_.size(), level_)
+				== Z_OK && compressedSize < buffer_.size()) {
+			ok = writeRecord(file_, kDataRecord, buffer_.size(), compressed_.data(), compressedSize);
+		} else {
+			ok = writeRecord(file_, kStoredRecord, buffer_.size(), buffer_.data(), buffer_.size());
+		}
+		bufferStart_ += buffer_.size();
+		buffer_.clear();
+		return ok;
+	}
+
+	FILE *file_;
+	int level_;
+	std::vector<uint8_t> buffer_;
+	std::vector<uint8_t> compressed_;
+	uint64_t bufferStart_;
+	uint64_t pos_;
+};
+
+class Reader {
+public:
+	explicit Reader(FILE *file)
+			: file_(file), size_(0), blockStart_(0), pos_(0) {
+	}
+
+	/// Reads all record headers to index blocks, find patches and check if the image is complete
+	bool init() {
+		off_t recordOffset = kCompressedMetadataHeaderSize;
+		if (fseeko(file_, recordOffset, SEEK_SET) != 0) {
+			return false;
+		}
+		for (;;) {
+			uint8_t type;
+			uint32_t rawSize, payloadSize, crc;
+			if (!readRecordHeader(type, rawSize, payloadSize, crc)) {
+				return false;
+			}
+			if (type == kEndRecord) {
+				char marker[16];
+				return fread(marker, 1, 16, file_) == 16 && memcmp(marker, kEofMarker, 16) == 0;
+			} else if (type == kPatchRecord) {
+				std::vector<uint8_t> payload(payloadSize);
+				if (payloadSize != 8 + rawSize
+						|| fread(payload.data(), 1, payloadSize, file_) != payloadSize
+						|| crc32(0, payload.data(), payloadSize) != crc) {
+					return false;
+				}
+				const uint8_t *ptr = payload.data();
+				Patch patch;
+				patch.offset = get64bit(&ptr);
+				patch.data.assign(ptr, ptr + rawSize);
+				patches_.push_back(std::move(patch));
+			} else if (type == kDataRecord || type == kStoredRecord) {
+				if (rawSize == 0 || fseeko(file_, payloadSize, SEEK_CUR) != 0) {
+					return false;
+				}
+				blocks_.push_back(BlockLocation{size_, recordOffset});
+				size_ += rawSize;
+			} else {
+				return false;
+			}
+			recordOffset += kRecordHeaderSize + payloadSize;
+		}
+	}
+
+	ssize_t read(char *data, size_t size) {
+		size_t done = 0;
+		while (done < size && pos_ < size_) {
+			if (pos_ < blockStart_ || pos_ >= blockStart_ + block_.size()) {
+				if (!loadBlock()) {
+					errno = EIO;
+					return -1;
+				}
+			}
+			size_t length = std::min<uint64_t>(size - done, blockStart_ + block_.size() - pos_);
+			memcpy(data + done, block_.data() + (pos_ - blockStart_), length);
+			done += length;
+			pos_ += length;
+		}
+		return done;
+	}
+
+	int seek(off64_t *offset, int whence) {
+		int64_t base = (whence == SEEK_SET) ? 0 : (whence == SEEK_CUR) ? pos_ : size_;
+		if (base + *offset < 0) {
+			errno = EINVAL;
+			return -1;
+		}
+		pos_ = base + *offset;
+		*offset = pos_;
+		return 0;
+	}
+
+private:
+	/// Where a block of the image is stored in the file
+	struct BlockLocation {
+		uint64_t start; // offset of the first byte of the block in the image
+		off_t recordOffset;
+	};
+
+	bool readRecordHeader(uint8_t &type, uint32_t &rawSize, uint32_t &payloadSize, uint32_t &crc) {
+		uint8_t header[kRecordHeaderSize];
+		if (fread(header, 1, kRecordHeaderSize, file_) != kRecordHeaderSize) {
+			return false;
+		}
+		const uint8_t *ptr = header;
+		type = get8bit(&ptr);
+		rawSize = get32bit(&ptr);
+		payloadSize = get32bit(&ptr);
+		crc = get32bit(&ptr);
+		return true;
+	}
+
+	/// Loads the block containing pos_, which has to be before the end of the image
+	bool loadBlock() {
+		auto it = std::upper_bound(blocks_.begin(), blocks_.end(), pos_,
+				[](uint64_t pos, const BlockLocation &block) { return pos < block.start; });
+		--it; // the first block starts at 0
+		uint8_t type;
+		uint32_t rawSize, payloadSize, crc;
+		if (fseeko(file_, it->recordOffset, SEEK_SET) != 0
+				|| !readRecordHeader(type, rawSize, payloadSize, crc)) {
+			return false;
+		}
+		payload_.resize(payloadSize);
+		if (fread(payload_.data(), 1, payloadSize, file_) != payloadSize
+				|| crc32(0, payload_.data(), payloadSize) != crc) {
+			return false;
+		}
+		block_.resize(rawSize);
+		if (type == kStoredRecord) {
+			if (payloadSize != rawSize) {
+				return false;
+			}
+			block_.swap(payload_);
+		} else {
+			uLongf size = rawSize;
+			if (uncompress(block_.data(), &size, payload_.data(), payloadSize) != Z_OK
+					|| size != rawSize) {
+				return false;
+			}
+		}
+		blockStart_ = it->start;
+		applyPatches();
+		return true;
+	}
+
+	void applyPatches() {
+		uint64_t blockEnd = blockStart_ + block_.size();
+		for (const Patch &patch : patches_) {
+			uint64_t begin = std::max(patch.offset, blockStart_);
+			uint64_t end = std::min(patch.offset + patch.data.size(), blockEnd);
+			if (begin < end) {
+				memcpy(block_.data() + (begin - blockStart_),
+						patch.data.data() + (begin - patch.offset), end - begin);
+			}
+		}
+	}
+
+	FILE *file_;
+	std::vector<BlockLocation> blocks_;
+	std::vector<Patch> patches_;
+	std::vector<uint8_t> block_;
+	std::vector<uint8_t> payload_;
+	uint64_t size_;
+	uint64_t blockStart_;
+	uint64_t pos_;
+};
+
+template <class T>
+ssize_t cookieWrite(void *cookie, const char *data, size_t size) {
+	return static_cast<T*>(cookie)->write(data, size);
+}
+
+template <class T>
+ssize_t cookieRead(void *cookie, char *data, size_t size) {
+	return static_cast<T*>(cookie)->read(data, size);
+}
+
+template <class T>
+int cookieSeek(void *cookie, off64_t *offset, int whence) {
+	return static_cast<T*>(cookie)->seek(offset, whence);
+}
+
+int writerClose(void *cookie) {
+	Writer *writer = static_cast<Writer*>(cookie);
+	int ret = writer->close();
+	delete writer;
+	return ret;
+}
+
+int readerClose(void *cookie) {
+	delete static_cast<Reader*>(cookie);
+	return 0;
+}
+
+} // anonymous namespace
+
+bool compressedMetadataSupported() {
+	return true;
+}
+
+FILE *compressedMetadataOpenWriter(FILE *file, uint64_t version, int level) {
+	uint8_t header[kCompressedMetadataHeaderSize];
+	uint8_t *ptr = header;
+	memcpy(ptr, kCompressedMetadataSignature, 8);
+	ptr += 8;
+	put32bit(&ptr, kBlockSize);
+	put64bit(&ptr, version);
+	if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+		return nullptr;
+	}
+	cookie_io_functions_t functions;
+	functions.read = nullptr;
+	functions.write = cookieWrite<Writer>;
+	functions.seek = cookieSeek<Writer>;
+	functions.close = writerClose;
+	Writer *writer = new Writer(file, level);
+	FILE *stream = fopencookie(writer, "w", functions);
+	if (stream == nullptr) {
+		delete writer;
+	}
+	return stream;
+}
+
+FILE *compressedMetadataOpenReader(FILE *file) {
+	uint8_t header[kCompressedMetadataHeaderSize];
+	if (fseeko(file, 0, SEEK_SET) != 0
+			|| fread(header, 1, sizeof(header), file) != sizeof(header)
+			|| memcmp(header, kCompressedMetadataSignature, 8) != 0) {
+		return nullptr;
+	}
+	Reader *reader = new Reader(file);
+	if (!reader->init()) {
+		delete reader;
+		return nullptr;
+	}
+	cookie_io_functions_t functions;
+	functions.read = cookieRead<Reader>;
+	functions.write = nullptr;
+	functions.seek = cookieSeek<Reader>;
+	functions.close = readerClose;
+	FILE *stream = fopencookie(reader, "r", functions);
+	if (stream == nullptr) {
+		delete reader;
+	}
+	return stream;
+}
+
+#else // LIZARDFS_COMPRESSED_METADATA
+
+bool compressedMetadataSupported() {
+	return false;
+}
+
+FILE *compressedMetadataOpenWriter(FILE *, uint64_t, int) {
+	return nullptr;
+}
+
+FILE *compressedMetadataOpenReader(FILE *) {
+	return nullptr;
+}
+
+#endif // LIZARDFS_COMPRESSED_METADATA
@@ -0,0 +1,66 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Compressed metadata image is a container for an ordinary metadata image:
+ *
+ *   header:  signature (8 bytes), block size (32 bits), metadata version (64 bits)
+ *   records: type (8 bits), raw size (32 bits), payload size (32 bits), payload crc32 (32 bits),
+ *            payload
+ *   trailer: end record followed by "[MFS EOF MARKER]"
+ *
+ * Data records hold consecutive blocks of the image, each compressed separately and
+ * verified with its own checksum. Patch records (64-bit offset followed by raw bytes) describe
+ * bytes overwritten after their block had already been written, which happens when section
+ * headers are filled in, so the image can be streamed without seeking in the output file.
+ * Metadata version is stored at the same offset as in an ordinary image.
+ */
+
+/// Signature of compressed metadata images
+extern const char kCompressedMetadataSignature[];
+
+/// Size of the header of compressed metadata images
+constexpr uint32_t kCompressedMetadataHeaderSize = 8 + 4 + 8;
+
+/// True if this build is able to read and write compressed metadata images
+bool compressedMetadataSupported();
+
+/*! \brief Creates stream which writes a compressed image into \a file.
+ *
+ * Closing the returned stream finishes the image, but does not close \a file.
+ * The stream supports seeking, also backwards.
+ * \param version metadata version stored in the header
+ * \param level zlib compression level (1-9)
+ * \return stream or nullptr if compression is not supported or \a file can't be written
+ */
+FILE *compressedMetadataOpenWriter(FILE *file, uint64_t version, int level);
+
+/*! \brief Creates stream which reads an image stored in compressed \a file.
+ *
+ * Closing the returned stream does not close \a file. Checksums of blocks are verified when
+ * they are read, a damaged block is reported as a read error.
+ * \return stream or nullptr if \a file is not a complete compressed image
+ */
+FILE *compressedMetadataOpenReader(FILE *file);
@@ -0,0 +1,148 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/compressed_metadata.h"
+
+#include <string.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "common/datapack.h"
+
+namespace {
+
+std::vector<uint8_t> makeImage(size_t size) {
+	std::vector<uint8_t> image(size);
+	uint32_t seed = 12345;
+	for (size_t i = 0; i < size; ++i) {
+		// compressible, but not trivially
+		seed = seed * 1103515245 + 12345;
+		image[i] = (i % 7 == 0) ? (seed >> 24) : (i % 251);
+	}
+	return image;
+}
+
+std::vector<uint8_t> readAll(FILE *stream) {
+	std::vector<uint8_t> result;
+	uint8_t buffer[4096];
+	size_t size;
+	while ((size = fread(buffer, 1, sizeof(buffer), stream)) > 0) {
+		result.insert(result.end(), buffer, buffer + size);
+	}
+	return result;
+}
+
+} // anonymous namespace
+
+TEST(CompressedMetadataTests, RoundTripWithBackpatchedHeaders) {
+	if (!compressedMetadataSupported()) {
+		return;
+	}
+	std::vector<uint8_t> image = makeImage(3 * 1024 * 1024 + 123);
+	FILE *file = tmpfile();
+	ASSERT_NE(nullptr, file);
+	FILE *writer = compressedMetadataOpenWriter(file, 0x123456789ULL, 1);
+	ASSERT_NE(nullptr, writer);
+
+	// Write it the way fs_store does: leave room for a header and fill it after the section
+	const size_t sections[] = {100, 2 * 1024 * 1024, 2 * 1024 * 1024 + 500000, image.size()};
+	size_t begin = 0;
+	for (size_t end : sections) {
+		ASSERT_EQ(0, fseeko(writer, begin + 16, SEEK_SET));
+		ASSERT_EQ(end - begin - 16, fwrite(image.data() + begin + 16, 1, end - begin - 16, writer));
+		ASSERT_EQ((off_t)end, ftello(writer));
+		ASSERT_EQ(0, fseeko(writer, begin, SEEK_SET));
+		ASSERT_EQ(16U, fwrite(image.data() + begin, 1, 16, writer));
+		ASSERT_EQ(0, fseeko(writer, end, SEEK_SET));
+		begin = end;
+	}
+	ASSERT_EQ(0, fclose(writer));
+	fflush(file);
+	EXPECT_LT(ftello(file), (off_t)image.size());
+
+	FILE *reader = compressedMetadataOpenReader(file);
+	ASSERT_NE(nullptr, reader);
+	EXPECT_EQ(image, readAll(reader));
+
+	// Skipping forward and going back
+	ASSERT_EQ(0, fseeko(reader, 2 * 1024 * 1024 + 5, SEEK_SET));
+	uint8_t buffer[100];
+	ASSERT_EQ(sizeof(buffer), fread(buffer, 1, sizeof(buffer), reader));
+	EXPECT_EQ(0, memcmp(buffer, image.data() + 2 * 1024 * 1024 + 5, sizeof(buffer)));
+	ASSERT_EQ(0, fseeko(reader, 3, SEEK_SET));
+	ASSERT_EQ(sizeof(buffer), fread(buffer, 1, sizeof(buffer), reader));
+	EXPECT_EQ(0, memcmp(buffer, image.data() + 3, sizeof(buffer)));
+	ASSERT_EQ(0, fseeko(reader, -(off_t)sizeof(buffer), SEEK_END));
+	ASSERT_EQ(sizeof(buffer), fread(buffer, 1, sizeof(buffer), reader));
+	EXPECT_EQ(0, memcmp(buffer, image.data() + image.size() - sizeof(buffer), sizeof(buffer)));
+	EXPECT_EQ(0U, fread(buffer, 1, sizeof(buffer), reader));
+	fclose(reader);
+
+	// Version is kept where ordinary images have it
+	uint8_t header[kCompressedMetadataHeaderSize];
+	ASSERT_EQ(0, fseeko(file, 0, SEEK_SET));
+	ASSERT_EQ(sizeof(header), fread(header, 1, sizeof(header), file));
+	const uint8_t *ptr = header + 12;
+	EXPECT_EQ(0x123456789ULL, get64bit(&ptr));
+	fclose(file);
+}
+
+TEST(CompressedMetadataTests, DamagedBlockIsReadError) {
+	if (!compressedMetadataSupported()) {
+		return;
+	}
+	std::vector<uint8_t> image = makeImage(2 * 1024 * 1024);
+	FILE *file = tmpfile();
+	ASSERT_NE(nullptr, file);
+	FILE *writer = compressedMetadataOpenWriter(file, 1, 1);
+	ASSERT_NE(nullptr, writer);
+	ASSERT_EQ(image.size(), fwrite(image.data(), 1, image.size(), writer));
+	ASSERT_EQ(0, fclose(writer));
+
+	// Flip one byte in the payload of the second block
+	ASSERT_EQ(0, fseeko(file, -100, SEEK_END));
+	int c = fgetc(file);
+	ASSERT_EQ(0, fseeko(file, -100, SEEK_END));
+	fputc(c ^ 0xFF, file);
+	fflush(file);
+
+	FILE *reader = compressedMetadataOpenReader(file);
+	ASSERT_NE(nullptr, reader);
+	EXPECT_GT(image.size(), readAll(reader).size());
+	EXPECT_NE(0, ferror(reader));
+	fclose(reader);
+	fclose(file);
+}
+
+TEST(CompressedMetadataTests, TruncatedImageIsRejected) {
+	if (!compressedMetadataSupported()) {
+		return;
+	}
+	std::vector<uint8_t> image = makeImage(100000);
+	FILE *file = tmpfile();
+	ASSERT_NE(nullptr, file);
+	FILE *writer = compressedMetadataOpenWriter(file, 1, 1);
+	ASSERT_NE(nullptr, writer);
+	ASSERT_EQ(image.size(), fwrite(image.data(), 1, image.size(), writer));
+	ASSERT_EQ(0, fclose(writer));
+	fflush(file);
+	ASSERT_EQ(0, ftruncate(fileno(file), ftello(file) - 20));
+	EXPECT_EQ(nullptr, compressedMetadataOpenReader(file));
+	fclose(file);
+}
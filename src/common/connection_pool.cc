@@ -19,25 +19,48 @@
 #include "common/platform.h"
 #include "common/connection_pool.h"
 
+#include <algorithm>
+
 #include "common/massert.h"
 #include "common/sockets.h"
 
+constexpr uint32_t ConnectionPool::kDefaultMaxIdleConnectionsPerServer;
+constexpr int ConnectionPool::kShardCount;
+
+ConnectionPool::ConnectionPool(uint32_t maxIdleConnectionsPerServer)
+		: maxIdleConnectionsPerServer_(maxIdleConnectionsPerServer) {
+}
+
+ConnectionPool::Shard& ConnectionPool::shardFor(const NetworkAddress& address) {
+	return shards_[std::hash<NetworkAddress>()(address) % kShardCount];
+}
+
 void ConnectionPool::putConnection(int fd, const NetworkAddress& address, int timeout) {
 	sassert(fd > 0);
 	sassert(timeout > 0);
-	std::unique_lock<std::mutex> lock(mutex_);
-	connections_[address].push_back(Connection(fd, timeout));
+	Shard& shard = shardFor(address);
+	std::unique_lock<std::mutex> lock(shard.mutex);
+	std::list<Connection>& connections = shard.servers[address].connections;
+	if (connections.size() >= maxIdleConnectionsPerServer_) {
+		lock.unlock();
+		tcpclose(fd);
+		return;
+	}
+	connections.push_back(Connection(fd, timeout));
 }
 
 int ConnectionPool::getConnection(const NetworkAddress& address) {
+	Shard& shard = shardFor(address);
 	while (true) {
-		std::unique_lock<std::mutex> lock(mutex_);
-		auto connectionsIterator = connections_.find(address);
-		if (connectionsIterator == connections_.end()) {
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		auto serverIterator = shard.servers.find(address);
+		if (serverIterator == shard.servers.end()) {
+			shard.servers[address].misses++;
 			return -1;
 		}
-		std::list<Connection>& openConnections = connectionsIterator->second;
+		std::list<Connection>& openConnections = serverIterator->second.connections;
 		if (openConnections.empty()) {
+			serverIterator->second.misses++;
 			return -1;
 		}
 		Connection connection = openConnections.front();
@@ -52,32 +75,72 @@ int ConnectionPool::getConnection(const NetworkAddress& address) {
 }
 
 void ConnectionPool::cleanup() {
-	std::unique_lock<std::mutex> lock(mutex_);
 	std::vector<int> descriptorsToClose;
-	ConnectionsContainer::iterator keyAndConnectionListIt = connections_.begin();
-	while (keyAndConnectionListIt != connections_.end()) {
-		std::list<Connection>& connectionList = keyAndConnectionListIt->second;
-		std::list<Connection>::iterator connectionIt = connectionList.begin();
-		while (connectionIt != connectionList.end()) {
-			if (!connectionIt->isValid()) {
-				descriptorsToClose.push_back(connectionIt->fd());
-				std::list<Connection>::iterator it = connectionIt;
-				++connectionIt;
-				connectionList.erase(it);
-			} else {
-				++connectionIt;
+	for (Shard& shard : shards_) {
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		for (auto& addressAndServer : shard.servers) {
+			std::list<Connection>& connectionList = addressAndServer.second.connections;
+			std::list<Connection>::iterator connectionIt = connectionList.begin();
+			while (connectionIt != connectionList.end()) {
+				if (!connectionIt->isValid()) {
+					descriptorsToClose.push_back(connectionIt->fd());
+					connectionIt = connectionList.erase(connectionIt);
+				} else {
+					++connectionIt;
+				}
 			}
 		}
-		if (connectionList.empty()) {
-			ConnectionsContainer::iterator it = keyAndConnectionListIt;
-			++keyAndConnectionListIt;
-			connections_.erase(it);
-		} else {
-			++keyAndConnectionListIt;
-		}
+		// Health of servers is kept, so entries are not removed here
 	}
-	lock.unlock();
 	for (int fd : descriptorsToClose) {
 		tcpclose(fd);
 	}
 }
+
+void ConnectionPool::reportConnect(const NetworkAddress& address, bool succeeded,
+		uint32_t connectTime_us) {
+	Shard& shard = shardFor(address);
+	std::unique_lock<std::mutex> lock(shard.mutex);
+	ServerHealth& health = shard.servers[address].health;
+	if (succeeded) {
+		if (health.connects == 0) {
+			health.averageConnectTime_us = connectTime_us;
+		} else {
+			health.averageConnectTime_us =
+					(uint64_t(health.averageConnectTime_us) * 7 + connectTime_us) / 8;
+		}
+		health.connects++;
+		health.consecutiveFailures = 0;
+	} else {
+		health.failures++;
+		health.consecutiveFailures++;
+	}
+}
+
+ConnectionPool::ServerHealth ConnectionPool::getHealth(const NetworkAddress& address) {
+	Shard& shard = shardFor(address);
+	std::unique_lock<std::mutex> lock(shard.mutex);
+	auto serverIterator = shard.servers.find(address);
+	if (serverIterator == shard.servers.end()) {
+		return ServerHealth();
+	}
+	return serverIterator->second.health;
+}
+
+std::vector<std::pair<NetworkAddress, uint32_t>> ConnectionPool::getServersToPrewarm() {
+	std::vector<std::pair<NetworkAddress, uint32_t>> result;
+	for (Shard& shard : shards_) {
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		for (auto& addressAndServer : shard.servers) {
+			Server& server = addressAndServer.second;
+			uint32_t idle = server.connections.size();
+			if (server.misses > 0 && server.health.consecutiveFailures == 0
+					&& idle < maxIdleConnectionsPerServer_) {
+				result.emplace_back(addressAndServer.first,
+						std::min(server.misses, maxIdleConnectionsPerServer_ - idle));
+			}
+			server.misses = 0;
+		}
+	}
+	return result;
+}
@@ -20,16 +20,47 @@
 
 #include "common/platform.h"
 
+#include <array>
 #include <chrono>
 #include <list>
 #include <map>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 #include "common/network_address.h"
 #include "common/time_utils.h"
 
+/**
+ * A pool of idle connections to chunkservers.
+ *
+ * Servers are spread over a few independently locked shards, so that threads using
+ * different chunkservers don't wait for each other. Apart from connections, the pool
+ * remembers how connecting to each server went.
+ */
 class ConnectionPool {
 public:
+	/// Maximum number of idle connections kept for a single server by default
+	static constexpr uint32_t kDefaultMaxIdleConnectionsPerServer = 32;
+
+	/// Statistics of connecting to a server
+	struct ServerHealth {
+		ServerHealth()
+				: connects(0),
+				  failures(0),
+				  consecutiveFailures(0),
+				  averageConnectTime_us(0) {
+		}
+
+		uint64_t connects;             ///< successful connects
+		uint64_t failures;             ///< failed connects
+		uint32_t consecutiveFailures;  ///< failed connects since the last successful one
+		uint32_t averageConnectTime_us; ///< moving average of successful connects' duration
+	};
+
+	ConnectionPool(uint32_t maxIdleConnectionsPerServer = kDefaultMaxIdleConnectionsPerServer);
+	ConnectionPool(const ConnectionPool&) = delete;
+	ConnectionPool& operator=(const ConnectionPool&) = delete;
 
 	/**
 	 * Returns descriptor if connection found in the pool, -1 otherwise
@@ -39,6 +70,7 @@ public:
 	/**
 	 * Puts connection in the pool for future use.
 	 * This connection will not be returned after the timeout has expired.
+	 * If there are too many idle connections to \p address, the connection is closed.
 	 */
 	void putConnection(int fd, const NetworkAddress& address, int timeout);
 
@@ -47,6 +79,20 @@ public:
 	 */
 	void cleanup();
 
+	/**
+	 * Records a result of an attempt to connect to a server
+	 */
+	void reportConnect(const NetworkAddress& address, bool succeeded, uint32_t connectTime_us);
+
+	ServerHealth getHealth(const NetworkAddress& address);
+
+	/**
+	 * Returns servers for which connections had to be created since the previous call,
+	 * together with the number of connections worth opening in advance for each of them.
+	 * Servers which failed to accept the last connection are omitted.
+	 */
+	std::vector<std::pair<NetworkAddress, uint32_t>> getServersToPrewarm();
+
 private:
 	class Connection {
 	public:
@@ -68,8 +114,25 @@ private:
 		Timeout validUntil_;
 	};
 
-	typedef std::map<NetworkAddress, std::list<Connection>> ConnectionsContainer;
+	struct Server {
+		Server() : misses(0) {}
+
+		std::list<Connection> connections;
+		uint32_t misses; ///< calls of getConnection which found no connection
+		ServerHealth health;
+	};
+
+	typedef std::map<NetworkAddress, Server> ServersContainer;
+
+	struct Shard {
+		std::mutex mutex;
+		ServersContainer servers;
+	};
+
+	static constexpr int kShardCount = 16;
+
+	Shard& shardFor(const NetworkAddress& address);
 
-	std::mutex mutex_;
-	ConnectionsContainer connections_;
+	const uint32_t maxIdleConnectionsPerServer_;
+	std::array<Shard, kShardCount> shards_;
 };
@@ -0,0 +1,90 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/connection_pool.h"
+
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+/// Returns a descriptor which can be put into a pool
+int newDescriptor() {
+	return dup(STDERR_FILENO);
+}
+
+} // anonymous namespace
+
+TEST(ConnectionPoolTests, ReturnsPutConnections) {
+	ConnectionPool pool;
+	NetworkAddress server1(0x7F000001, 9422);
+	NetworkAddress server2(0x7F000002, 9422);
+	int fd = newDescriptor();
+	ASSERT_GT(fd, 0);
+	EXPECT_EQ(-1, pool.getConnection(server1));
+	pool.putConnection(fd, server1, 10);
+	EXPECT_EQ(-1, pool.getConnection(server2));
+	EXPECT_EQ(fd, pool.getConnection(server1));
+	EXPECT_EQ(-1, pool.getConnection(server1));
+	close(fd);
+}
+
+TEST(ConnectionPoolTests, LimitsIdleConnections) {
+	ConnectionPool pool(2);
+	NetworkAddress server(0x7F000001, 9422);
+	std::vector<int> fds;
+	for (int i = 0; i < 3; ++i) {
+		pool.putConnection(newDescriptor(), server, 10);
+	}
+	for (int fd; (fd = pool.getConnection(server)) >= 0;) {
+		fds.push_back(fd);
+	}
+	EXPECT_EQ(2U, fds.size());
+	for (int fd : fds) {
+		close(fd);
+	}
+}
+
+TEST(ConnectionPoolTests, TracksHealthAndServersToPrewarm) {
+	ConnectionPool pool(4);
+	NetworkAddress good(0x7F000001, 9422);
+	NetworkAddress bad(0x7F000002, 9422);
+
+	pool.reportConnect(good, true, 1000);
+	pool.reportConnect(good, true, 1800);
+	EXPECT_EQ(2U, pool.getHealth(good).connects);
+	EXPECT_EQ(1100U, pool.getHealth(good).averageConnectTime_us);
+	pool.reportConnect(bad, false, 0);
+	pool.reportConnect(bad, false, 0);
+	EXPECT_EQ(2U, pool.getHealth(bad).failures);
+	EXPECT_EQ(2U, pool.getHealth(bad).consecutiveFailures);
+
+	for (int i = 0; i < 6; ++i) {
+		EXPECT_EQ(-1, pool.getConnection(good));
+		EXPECT_EQ(-1, pool.getConnection(bad));
+	}
+	auto servers = pool.getServersToPrewarm();
+	ASSERT_EQ(1U, servers.size());
+	EXPECT_EQ(good, servers[0].first);
+	EXPECT_EQ(4U, servers[0].second);
+	EXPECT_TRUE(pool.getServersToPrewarm().empty());
+
+	pool.reportConnect(bad, true, 500);
+	EXPECT_EQ(0U, pool.getHealth(bad).consecutiveFailures);
+}
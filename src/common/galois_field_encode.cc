@@ -61,8 +61,8 @@ void ec_encode_data_ssse3(int len, int srcs, int dests, uint8_t *v, uint8_t **sr
 			v16u s = {0};
 			for (int j = 0; j < srcs; j++) {
 				v8ui a = *(v8ui_unaligned *)(src[j] + i);
-				v16u tbl_lo = *(v16u *)tbl;
-				v16u tbl_hi = *(v16u *)(tbl + 16);
+				v16u tbl_lo = *(v16u_unaligned *)tbl;
+				v16u tbl_hi = *(v16u_unaligned *)(tbl + 16);
 
 				v16u mask_lo = (v16u)(a & 0xF0F);
 				v16u mask_hi = (v16u)((a >> 4) & 0xF0F);
@@ -109,8 +109,8 @@ void ec_encode_data_avx(int len, int srcs, int dests, uint8_t *v, uint8_t **src,
 			v16u s = {0};
 			for (int j = 0; j < srcs; j++) {
 				v8ui a = *(v8ui_unaligned *)(src[j] + i);
-				v16u tbl_lo = *(v16u *)tbl;
-				v16u tbl_hi = *(v16u *)(tbl + 16);
+				v16u tbl_lo = *(v16u_unaligned *)tbl;
+				v16u tbl_hi = *(v16u_unaligned *)(tbl + 16);
 
 				v16u mask_lo = (v16u)(a & 0xF0F);
 				v16u mask_hi = (v16u)((a >> 4) & 0xF0F);
@@ -163,7 +163,7 @@ void ec_encode_data_avx2(int len, int srcs, int dests, uint8_t *v, uint8_t **src
 			for (int j = 0; j < srcs; j++) {
 				v16ui a = *(v16ui_unaligned *)(src[j] + i);
 
-				v32u tbl_lo = *(v32u *)tbl;
+				v32u tbl_lo = *(v32u_unaligned *)tbl;
 
 				v32u tbl_hi =
 				    (v32u)_mm256_permute2x128_si256((__m256i)tbl_lo, (__m256i)tbl_lo, 0x11);
@@ -244,8 +244,8 @@ void ec_encode_data(int len, int srcs, int dests, uint8_t *v, uint8_t **src, uin
 			v16u s = {0};
 			for (int j = 0; j < srcs; j++) {
 				v8ui a = *(v8ui_unaligned *)(src[j] + i);
-				v16u tbl_lo = *(v16u *)tbl;
-				v16u tbl_hi = *(v16u *)(tbl + 16);
+				v16u tbl_lo = *(v16u_unaligned *)tbl;
+				v16u tbl_hi = *(v16u_unaligned *)(tbl + 16);
 
 				v16u mask_lo = (v16u)(a & 0xF0F);
 				v16u mask_hi = (v16u)((a >> 4) & 0xF0F);
@@ -42,3 +42,11 @@ constexpr uint32_t kDisconnectedChunkserverVersion = lizardfsVersion(256, 0, 0);
 constexpr uint32_t kStdVersion = lizardfsVersion(2, 6, 0);
 constexpr uint32_t kFirstXorVersion = lizardfsVersion(2, 9, 0);
 constexpr uint32_t kFirstECVersion = lizardfsVersion(3, 9, 5);
+constexpr uint32_t kFirstLoadReportingVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstTracingVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstChangelogBatchVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstReadChunksVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstPurgeBatchVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstCloneBatchVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstCacheLeaseVersion = lizardfsVersion(3, 10, 5);
+constexpr uint32_t kFirstCompoundVersion = lizardfsVersion(3, 10, 5);
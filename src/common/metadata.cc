@@ -30,6 +30,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "common/compressed_metadata.h"
 #include "common/cwrap.h"
 #include "common/datapack.h"
 #include "common/mfserr.h"
@@ -95,6 +96,9 @@ uint64_t metadataGetVersion(const std::string& file) {
 	/* Note LIZARDFSSIGNATURE instead of MFSSIGNATURE! */
 	} else if (memcmp(chkbuff, LIZARDFSSIGNATURE "M 2.9", 8) == 0) {
 		memcpy(eofmark,"[MFS EOF MARKER]",16);
+	} else if (memcmp(chkbuff, kCompressedMetadataSignature, 8) == 0) {
+		// version is stored at the same offset as in uncompressed files
+		memcpy(eofmark,"[MFS EOF MARKER]",16);
 	} else {
 		close(fd);
 		throw MetadataCheckException("Bad format of the metadata file");
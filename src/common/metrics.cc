@@ -0,0 +1,207 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "common/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metrics {
+
+constexpr int Histogram::kBucketCount;
+
+Histogram::Histogram() : sum_(0) {
+	for (auto &bucket : buckets_) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+}
+
+int Histogram::bucket(uint64_t value) {
+	if (value <= 2) {
+		return value <= 1 ? 0 : 1;
+	}
+	// value - 1 is in [2^e, 2^(e+1)), so value is in (2^e, 3*2^(e-1)] or (3*2^(e-1), 2^(e+1)]
+	int e = 63 - __builtin_clzll(value - 1);
+	int index = value <= (UINT64_C(3) << (e - 1)) ? 2 * e : 2 * e + 1;
+	return std::min(index, kBucketCount);
+}
+
+uint64_t Histogram::upperBound(int bucket) {
+	if (bucket < 2) {
+		return bucket + 1;
+	}
+	int e = bucket / 2;
+	return bucket % 2 == 0 ? UINT64_C(3) << (e - 1) : UINT64_C(1) << (e + 1);
+}
+
+uint64_t Histogram::totalCount() const {
+	uint64_t result = 0;
+	for (const auto &bucket : buckets_) {
+		result += bucket.load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+Histogram::Counts Histogram::counts() const {
+	Counts result;
+	for (int i = 0; i <= kBucketCount; ++i) {
+		result[i] = buckets_[i].load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+uint64_t Histogram::percentile(const Counts &counts, double fraction) {
+	uint64_t total = 0;
+	for (uint64_t count : counts) {
+		total += count;
+	}
+	if (total == 0) {
+		return 0;
+	}
+	// Rank of the value, 1-based, e.g. 99 for the 99th percentile of 100 values
+	uint64_t rank = std::max<uint64_t>(1, std::ceil(fraction * total));
+	uint64_t cumulative = 0;
+	for (int i = 0; i < kBucketCount; ++i) {
+		cumulative += counts[i];
+		if (cumulative >= rank) {
+			return upperBound(i);
+		}
+	}
+	return upperBound(kBucketCount - 1);
+}
+
+Counter &Registry::counter(const std::string &name, const std::string &help,
+		const std::string &labels) {
+	return series(name, help, labels, Type::kCounter).counter;
+}
+
+Gauge &Registry::gauge(const std::string &name, const std::string &help,
+		const std::string &labels) {
+	return series(name, help, labels, Type::kGauge).gauge;
+}
+
+Histogram &Registry::histogram(const std::string &name, const std::string &help,
+		const std::string &labels) {
+	return *series(name, help, labels, Type::kHistogram).histogram;
+}
+
+void Registry::gauge(const std::string &name, const std::string &help, const std::string &labels,
+		std::function<int64_t()> function) {
+	Series &s = series(name, help, labels, Type::kGauge);
+	std::unique_lock<std::mutex> lock(mutex_);
+	s.function = std::move(function);
+}
+
+Registry::Series &Registry::series(const std::string &name, const std::string &help,
+		const std::string &labels, Type type) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	auto inserted = families_.insert({name, Family()});
+	Family &family = inserted.first->second;
+	if (inserted.second) {
+		family.type = type;
+		family.help = help;
+	}
+	std::unique_ptr<Series> &s = family.series[labels];
+	if (!s) {
+		s.reset(new Series());
+		if (type == Type::kHistogram) {
+			s->histogram.reset(new Histogram());
+		}
+	}
+	return *s;
+}
+
+static std::string seriesName(const std::string &name, const std::string &labels,
+		const std::string &extraLabel = std::string()) {
+	std::string result = name;
+	if (!labels.empty() || !extraLabel.empty()) {
+		result += "{" + labels;
+		if (!labels.empty() && !extraLabel.empty()) {
+			result += ",";
+		}
+		result += extraLabel + "}";
+	}
+	return result;
+}
+
+std::string Registry::exportText() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	std::string result;
+	for (const auto &entry : families_) {
+		const std::string &name = entry.first;
+		const Family &family = entry.second;
+		const char *type = family.type == Type::kCounter ? "counter"
+				: family.type == Type::kGauge ? "gauge" : "histogram";
+		result += "# HELP " + name + " " + family.help + "\n";
+		result += "# TYPE " + name + " " + type + "\n";
+		for (const auto &s : family.series) {
+			const std::string &labels = s.first;
+			switch (family.type) {
+			case Type::kCounter:
+				result += seriesName(name, labels) + " " +
+						std::to_string(s.second->counter.value()) + "\n";
+				break;
+			case Type::kGauge:
+				result += seriesName(name, labels) + " " + std::to_string(s.second->function
+						? s.second->function() : s.second->gauge.value()) + "\n";
+				break;
+			case Type::kHistogram: {
+				const Histogram &histogram = *s.second->histogram;
+				uint64_t cumulative = 0;
+				for (int i = 0; i < Histogram::kBucketCount; ++i) {
+					cumulative += histogram.count(i);
+					result += seriesName(name + "_bucket", labels,
+							"le=\"" + std::to_string(Histogram::upperBound(i)) + "\"") +
+							" " + std::to_string(cumulative) + "\n";
+				}
+				cumulative += histogram.count(Histogram::kBucketCount);
+				result += seriesName(name + "_bucket", labels, "le=\"+Inf\"") + " " +
+						std::to_string(cumulative) + "\n";
+				result += seriesName(name + "_sum", labels) + " " +
+						std::to_string(histogram.sum()) + "\n";
+				result += seriesName(name + "_count", labels) + " " +
+						std::to_string(cumulative) + "\n";
+				break;
+			}
+			}
+		}
+	}
+	return result;
+}
+
+Registry &registry() {
+	static Registry instance;
+	return instance;
+}
+
+std::string label(const std::string &name, const std::string &value) {
+	std::string result = name + "=\"";
+	for (char c : value) {
+		if (c == '\\' || c == '"') {
+			result += '\\';
+			result += c;
+		} else if (c == '\n') {
+			result += "\\n";
+		} else {
+			result += c;
+		}
+	}
+	return result + "\"";
+}
+
+} // namespace metrics
@@ -0,0 +1,180 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*! \brief Counters, gauges and latency histograms exported in the Prometheus text format.
+ *
+ * Metrics are created once by name and labels in a Registry, which returns a reference valid
+ * for the lifetime of the registry. Updating a metric is a single relaxed atomic operation,
+ * so it is cheap on the hot path and safe in any thread.
+ */
+namespace metrics {
+
+class Counter {
+public:
+	Counter() : value_(0) {
+	}
+
+	void increment(uint64_t delta = 1) {
+		value_.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	uint64_t value() const {
+		return value_.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> value_;
+};
+
+class Gauge {
+public:
+	Gauge() : value_(0) {
+	}
+
+	void set(int64_t value) {
+		value_.store(value, std::memory_order_relaxed);
+	}
+
+	void add(int64_t delta) {
+		value_.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	int64_t value() const {
+		return value_.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t> value_;
+};
+
+/*! \brief Histogram with log-linear buckets.
+ *
+ * Each power of two is split into two buckets, so upper bounds of buckets are
+ * 1, 2, 3, 4, 6, 8, 12, 16, 24, ... and the relative error of a percentile is at most 50%.
+ * Values above the last bound are counted only in the total count and sum.
+ */
+class Histogram {
+public:
+	static constexpr int kBucketCount = 64;
+
+	/// Numbers of values in buckets, the last one counts values above all bounds
+	typedef std::array<uint64_t, kBucketCount + 1> Counts;
+
+	Histogram();
+
+	void record(uint64_t value) {
+		buckets_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	/// Index of a bucket for a value, kBucketCount for values above all bounds
+	static int bucket(uint64_t value);
+
+	/// Inclusive upper bound of a bucket
+	static uint64_t upperBound(int bucket);
+
+	uint64_t count(int bucket) const {
+		return buckets_[bucket].load(std::memory_order_relaxed);
+	}
+
+	uint64_t totalCount() const;
+
+	uint64_t sum() const {
+		return sum_.load(std::memory_order_relaxed);
+	}
+
+	/// Copies counts of all buckets, differences of copies describe values from a period
+	Counts counts() const;
+
+	/*! \brief Returns an upper bound of a percentile of values counted in \p counts.
+	 *
+	 * \param fraction e.g. 0.99 for the 99th percentile.
+	 * \return upper bound of the bucket containing the percentile, 0 if nothing was counted
+	 * and the bound of the last bucket if the percentile is above all bounds.
+	 */
+	static uint64_t percentile(const Counts &counts, double fraction);
+
+private:
+	std::array<std::atomic<uint64_t>, kBucketCount + 1> buckets_;
+	std::atomic<uint64_t> sum_;
+};
+
+class Registry {
+public:
+	/*! \brief Returns a metric with given name and labels, creates it if needed.
+	 *
+	 * \param name name of the metric, e.g. lizardfs_master_requests_total.
+	 * \param help description of the metric, used when the metric is created.
+	 * \param labels labels in the Prometheus format, e.g. type="lookup", may be empty.
+	 */
+	Counter &counter(const std::string &name, const std::string &help,
+			const std::string &labels = std::string());
+	Gauge &gauge(const std::string &name, const std::string &help,
+			const std::string &labels = std::string());
+	Histogram &histogram(const std::string &name, const std::string &help,
+			const std::string &labels = std::string());
+
+	/// Registers a gauge whose value is computed by a function when metrics are exported
+	void gauge(const std::string &name, const std::string &help, const std::string &labels,
+			std::function<int64_t()> function);
+
+	/// Returns all metrics in the Prometheus text exposition format
+	std::string exportText() const;
+
+private:
+	enum class Type { kCounter, kGauge, kHistogram };
+
+	struct Series {
+		Counter counter;
+		Gauge gauge;
+		std::unique_ptr<Histogram> histogram;
+		std::function<int64_t()> function;
+	};
+
+	struct Family {
+		Type type;
+		std::string help;
+		std::map<std::string, std::unique_ptr<Series>> series;
+	};
+
+	Series &series(const std::string &name, const std::string &help, const std::string &labels,
+			Type type);
+
+	mutable std::mutex mutex_;
+	std::map<std::string, Family> families_;
+};
+
+/// Registry of the process
+Registry &registry();
+
+/// Returns a label in the Prometheus format, e.g. path="/mnt/hdd", with the value escaped
+std::string label(const std::string &name, const std::string &value);
+
+} // namespace metrics
@@ -0,0 +1,97 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "common/metrics.h"
+
+#include <gtest/gtest.h>
+
+TEST(MetricsTests, HistogramBuckets) {
+	EXPECT_EQ(0, metrics::Histogram::bucket(0));
+	EXPECT_EQ(0, metrics::Histogram::bucket(1));
+	EXPECT_EQ(1, metrics::Histogram::bucket(2));
+	EXPECT_EQ(2, metrics::Histogram::bucket(3));
+	EXPECT_EQ(3, metrics::Histogram::bucket(4));
+	EXPECT_EQ(4, metrics::Histogram::bucket(5));
+	EXPECT_EQ(4, metrics::Histogram::bucket(6));
+	EXPECT_EQ(5, metrics::Histogram::bucket(7));
+	EXPECT_EQ(5, metrics::Histogram::bucket(8));
+	EXPECT_EQ(metrics::Histogram::kBucketCount, metrics::Histogram::bucket(UINT64_MAX));
+
+	// Every value falls into the first bucket with a bound not smaller than the value
+	for (uint64_t value = 1; value < 100000; ++value) {
+		int bucket = metrics::Histogram::bucket(value);
+		ASSERT_LE(value, metrics::Histogram::upperBound(bucket)) << value;
+		ASSERT_GT(value, metrics::Histogram::upperBound(bucket - 1)) << value;
+	}
+	int last = metrics::Histogram::kBucketCount - 1;
+	EXPECT_EQ(last, metrics::Histogram::bucket(metrics::Histogram::upperBound(last)));
+	EXPECT_EQ(last + 1, metrics::Histogram::bucket(metrics::Histogram::upperBound(last) + 1));
+}
+
+TEST(MetricsTests, Percentiles) {
+	metrics::Histogram histogram;
+	EXPECT_EQ(0U, metrics::Histogram::percentile(histogram.counts(), 0.99));
+	for (int i = 0; i < 98; ++i) {
+		histogram.record(10);
+	}
+	histogram.record(100);
+	histogram.record(1000);
+	metrics::Histogram::Counts counts = histogram.counts();
+	EXPECT_EQ(12U, metrics::Histogram::percentile(counts, 0.5));
+	EXPECT_EQ(12U, metrics::Histogram::percentile(counts, 0.98));
+	EXPECT_EQ(128U, metrics::Histogram::percentile(counts, 0.99));
+	EXPECT_EQ(1024U, metrics::Histogram::percentile(counts, 1.0));
+
+	// Differences of copies describe only values recorded in between
+	histogram.record(5000);
+	metrics::Histogram::Counts delta = histogram.counts();
+	for (int i = 0; i <= metrics::Histogram::kBucketCount; ++i) {
+		delta[i] -= counts[i];
+	}
+	EXPECT_EQ(6144U, metrics::Histogram::percentile(delta, 0.5));
+}
+
+TEST(MetricsTests, ExportText) {
+	metrics::Registry registry;
+	registry.counter("requests_total", "Requests", "type=\"read\"").increment(3);
+	registry.counter("requests_total", "Requests", "type=\"read\"").increment();
+	registry.gauge("sessions", "Sessions").set(7);
+	registry.gauge("chunks", "Chunks", "", []() -> int64_t { return 42; });
+	metrics::Histogram &latency = registry.histogram("latency_us", "Latency");
+	latency.record(1);
+	latency.record(5);
+	latency.record(5);
+
+	std::string text = registry.exportText();
+	EXPECT_NE(std::string::npos, text.find("# TYPE requests_total counter\n"));
+	EXPECT_NE(std::string::npos, text.find("requests_total{type=\"read\"} 4\n"));
+	EXPECT_NE(std::string::npos, text.find("\nsessions 7\n"));
+	EXPECT_NE(std::string::npos, text.find("\nchunks 42\n"));
+	EXPECT_NE(std::string::npos, text.find("# TYPE latency_us histogram\n"));
+	EXPECT_NE(std::string::npos, text.find("latency_us_bucket{le=\"1\"} 1\n"));
+	EXPECT_NE(std::string::npos, text.find("latency_us_bucket{le=\"4\"} 1\n"));
+	EXPECT_NE(std::string::npos, text.find("latency_us_bucket{le=\"6\"} 3\n"));
+	EXPECT_NE(std::string::npos, text.find("latency_us_bucket{le=\"+Inf\"} 3\n"));
+	EXPECT_NE(std::string::npos, text.find("latency_us_sum 11\n"));
+	EXPECT_NE(std::string::npos, text.find("latency_us_count 3\n"));
+}
+
+TEST(MetricsTests, Label) {
+	EXPECT_EQ("path=\"/mnt/hdd\"", metrics::label("path", "/mnt/hdd"));
+	EXPECT_EQ("path=\"a\\\"b\\\\c\\n\"", metrics::label("path", "a\"b\\c\n"));
+}
@@ -24,6 +24,7 @@
 #include "common/massert.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
 #include "mount/exceptions.h"
 #include "protocol/cltocs.h"
@@ -59,7 +60,11 @@ ReadOperationExecutor::ReadOperationExecutor(
 
 void ReadOperationExecutor::sendReadRequest(const Timeout& timeout) {
 	std::vector<uint8_t> message;
-	if (server_version_ >= kFirstECVersion) {
+	tracing::TraceId traceId = tracing::currentTraceId();
+	if (traceId != 0 && server_version_ >= kFirstTracingVersion) {
+		cltocs::read::serialize(message, chunkId_, chunkVersion_, chunkType_,
+			readOperation_.request_offset, readOperation_.request_size, traceId);
+	} else if (server_version_ >= kFirstECVersion) {
 		cltocs::read::serialize(message, chunkId_, chunkVersion_, chunkType_,
 			readOperation_.request_offset, readOperation_.request_size);
 	} else if (server_version_ >= kFirstXorVersion) {
@@ -81,6 +86,7 @@ void ReadOperationExecutor::sendReadRequest(const Timeout& timeout) {
 				+ std::string(strerr(tcpgetlasterror())),
 				server_);
 	}
+	requestTimer_.reset();
 	setState(kReceivingHeader);
 }
 
@@ -88,6 +88,13 @@ public:
 		return readOperation_.wave;
 	}
 
+	/**
+	 * Time since the request was sent to the chunkserver.
+	 */
+	int64_t elapsed_us() const {
+		return requestTimer_.elapsed_us();
+	}
+
 private:
 	enum ReadOperationState {
 		kSendingRequest,
@@ -123,6 +130,9 @@ private:
 	/* Current state of the operation */
 	ReadOperationState state_;
 
+	/* Measures latency of the operation */
+	Timer requestTimer_;
+
 	/* The address when the next data read from the socket should be placed */
 	uint8_t *destination_;
 
@@ -33,6 +33,7 @@
 #include "common/read_operation_executor.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
 #include "protocol/cltocs.h"
 
@@ -259,6 +260,7 @@ bool ReadPlanExecutor::readSomeData(ExecuteParams &params, const pollfd &poll_fd
 	}
 
 	if (executor.isFinished()) {
+		stats_.recordReadLatency(server, executor.elapsed_us());
 		stats_.unregisterReadOperation(server);
 		stats_.markWorking(server);
 		params.connector.endUsingConnection(poll_fd.fd, server);
@@ -418,6 +420,7 @@ void ReadPlanExecutor::executePlan(std::vector<uint8_t> &buffer,
 	                     connector, connect_timeout, level_timeout, total_timeout};
 
 	try {
+		tracing::ScopedSpan span("read_plan.execute", chunk_id_);
 		executeReadOperations(params);
 		int result_size =
 		    plan_->postProcessData(buffer.data() + initial_size_of_buffer, available_parts_);
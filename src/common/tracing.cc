@@ -0,0 +1,224 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "common/tracing.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <random>
+
+#include "common/rotate_files.h"
+#include "common/slogger.h"
+
+namespace tracing {
+
+static const uint32_t kRingCapacity = 64 * 1024;
+
+static std::atomic<uint32_t> gSamplingPeriod(0);
+static std::atomic<uint64_t> gRequestCounter(0);
+static thread_local TraceId gCurrentTraceId = 0;
+
+SpanRing::SpanRing(uint32_t capacity) : next_(0) {
+	uint64_t size = 1;
+	while (size < capacity) {
+		size *= 2;
+	}
+	slots_.reset(new Slot[size]);
+	mask_ = size - 1;
+	for (uint64_t i = 0; i < size; ++i) {
+		slots_[i].sequence.store(0, std::memory_order_relaxed);
+	}
+}
+
+void SpanRing::record(const Span &span) {
+	uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+	Slot &slot = slots_[index & mask_];
+	slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.traceId.store(span.traceId, std::memory_order_relaxed);
+	slot.name.store(span.name, std::memory_order_relaxed);
+	slot.start.store(span.start, std::memory_order_relaxed);
+	slot.duration.store(span.duration, std::memory_order_relaxed);
+	slot.argument.store(span.argument, std::memory_order_relaxed);
+	slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+std::vector<Span> SpanRing::collect(uint64_t &position) const {
+	std::vector<Span> result;
+	uint64_t end = next_.load(std::memory_order_relaxed);
+	uint64_t index = std::max(position, end > mask_ + 1 ? end - (mask_ + 1) : 0);
+	for (; index < end; ++index) {
+		const Slot &slot = slots_[index & mask_];
+		uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence < 2 * index + 2) {
+			break; // still written
+		}
+		Span span;
+		span.traceId = slot.traceId.load(std::memory_order_relaxed);
+		span.name = slot.name.load(std::memory_order_relaxed);
+		span.start = slot.start.load(std::memory_order_relaxed);
+		span.duration = slot.duration.load(std::memory_order_relaxed);
+		span.argument = slot.argument.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == 2 * index + 2) {
+			result.push_back(span);
+		}
+	}
+	position = index;
+	return result;
+}
+
+void setSamplingPeriod(uint32_t period) {
+	gSamplingPeriod.store(period, std::memory_order_relaxed);
+}
+
+uint32_t samplingPeriod() {
+	return gSamplingPeriod.load(std::memory_order_relaxed);
+}
+
+TraceId newTraceId() {
+	uint32_t period = gSamplingPeriod.load(std::memory_order_relaxed);
+	if (period == 0) {
+		return 0;
+	}
+	uint64_t counter = gRequestCounter.fetch_add(1, std::memory_order_relaxed);
+	if (counter % period != 0) {
+		return 0;
+	}
+	// Ids of different processes differ thanks to a random salt, the mixing function
+	// (finalizer of splitmix64) is a bijection, so ids in a process are unique
+	static const uint64_t salt = (uint64_t(std::random_device()()) << 32) ^ std::random_device()();
+	uint64_t id = salt + counter * UINT64_C(0x9E3779B97F4A7C15);
+	id = (id ^ (id >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	id = (id ^ (id >> 27)) * UINT64_C(0x94D049BB133111EB);
+	id ^= id >> 31;
+	return id != 0 ? id : 1;
+}
+
+TraceId currentTraceId() {
+	return gCurrentTraceId;
+}
+
+TraceScope::TraceScope(TraceId traceId) : previous_(gCurrentTraceId) {
+	gCurrentTraceId = traceId;
+}
+
+TraceScope::~TraceScope() {
+	gCurrentTraceId = previous_;
+}
+
+uint64_t now() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return uint64_t(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void record(TraceId traceId, const char *name, uint64_t start, uint64_t argument) {
+	if (traceId == 0) {
+		return;
+	}
+	uint64_t end = now();
+	spans().record(Span{traceId, name, start, end > start ? end - start : 0, argument});
+}
+
+SpanRing &spans() {
+	static SpanRing instance(kRingCapacity);
+	return instance;
+}
+
+bool dump(const std::string &path) {
+	static std::mutex mutex;
+	static uint64_t position = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	std::vector<Span> collected = spans().collect(position);
+	if (collected.empty()) {
+		return true;
+	}
+	// A symlink planted in place of the file must not redirect writes of a privileged process
+	int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0640);
+	if (fd < 0) {
+		return false;
+	}
+	FILE *file = fdopen(fd, "a");
+	if (file == nullptr) {
+		close(fd);
+		return false;
+	}
+	for (const Span &span : collected) {
+		fprintf(file, "%016" PRIx64 " %" PRIu64 " %" PRIu64 " %s %" PRIu64 "\n",
+				span.traceId, span.start, span.duration, span.name, span.argument);
+	}
+	return fclose(file) == 0;
+}
+
+Dumper::Dumper(std::string path, uint64_t maxFileSize, int storedPreviousCopies)
+		: path_(std::move(path)),
+		  maxFileSize_(maxFileSize),
+		  storedPreviousCopies_(storedPreviousCopies),
+		  failed_(false),
+		  terminate_(false),
+		  thread_(&Dumper::run, this) {
+}
+
+Dumper::~Dumper() {
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		terminate_ = true;
+	}
+	terminateCond_.notify_one();
+	thread_.join();
+}
+
+void Dumper::run() {
+	bool terminate = false;
+	while (!terminate) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (!terminate_) {
+				terminateCond_.wait_for(lock, std::chrono::seconds(1));
+			}
+			terminate = terminate_;
+		}
+		dumpAndRotate();
+	}
+}
+
+void Dumper::dumpAndRotate() {
+	bool ok = dump(path_);
+	if (!ok && !failed_) {
+		lzfs_silent_errlog(LOG_WARNING, "can't write traces to %s", path_.c_str());
+	}
+	failed_ = !ok;
+	struct stat st;
+	if (ok && stat(path_.c_str(), &st) == 0 && uint64_t(st.st_size) > maxFileSize_) {
+		if (storedPreviousCopies_ > 0) {
+			rotateFiles(path_, storedPreviousCopies_);
+		} else {
+			unlink(path_.c_str());
+		}
+	}
+}
+
+} // namespace tracing
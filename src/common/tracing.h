@@ -0,0 +1,185 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! \brief Sampled tracing of requests across the mount, master and chunkservers.
+ *
+ * A client gives a sampled request a random trace id and sends it to the servers in traced
+ * versions of request packets. Every process records spans of the request (a name, start,
+ * duration and an argument, e.g. inode or chunk id) into a lock-free ring buffer, which is
+ * periodically appended to a file. Spans with the same trace id in files of all processes
+ * describe the whole request. Untraced requests (with id 0) cost only a thread local load.
+ */
+namespace tracing {
+
+/// Identifier of a traced request, 0 if the request is not traced
+typedef uint64_t TraceId;
+
+struct Span {
+	TraceId traceId;
+	const char *name; // string literal
+	uint64_t start; // microseconds since the epoch
+	uint64_t duration; // microseconds
+	uint64_t argument;
+};
+
+/*! \brief Buffer of last spans recorded by many threads.
+ *
+ * Writers don't wait for each other nor for readers. Every slot has a sequence number
+ * which is odd while the slot is written, so a reader skips spans overwritten during a read.
+ */
+class SpanRing {
+public:
+	/// \param capacity number of spans kept, rounded up to a power of two
+	explicit SpanRing(uint32_t capacity);
+
+	void record(const Span &span);
+
+	/*! \brief Returns spans recorded since \p position and advances it.
+	 *
+	 * Spans which were overwritten since the previous call are lost.
+	 * A span which is being written stops the collection, it will be returned next time.
+	 */
+	std::vector<Span> collect(uint64_t &position) const;
+
+private:
+	struct Slot {
+		std::atomic<uint64_t> sequence; // 2*index+1 while written, 2*index+2 when complete
+		std::atomic<TraceId> traceId;
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> start;
+		std::atomic<uint64_t> duration;
+		std::atomic<uint64_t> argument;
+	};
+
+	std::unique_ptr<Slot[]> slots_;
+	uint64_t mask_;
+	std::atomic<uint64_t> next_;
+};
+
+/// Sets how many requests out of every \p period get a trace id, 0 disables sampling
+void setSamplingPeriod(uint32_t period);
+uint32_t samplingPeriod();
+
+/// Returns an id for a new request, 0 if the request isn't sampled
+TraceId newTraceId();
+
+/// Trace id of a request handled by the calling thread
+TraceId currentTraceId();
+
+/// Makes a trace id current in the calling thread until the end of a scope
+class TraceScope {
+public:
+	explicit TraceScope(TraceId traceId);
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope &operator=(const TraceScope&) = delete;
+
+private:
+	TraceId previous_;
+};
+
+/// Microseconds since the epoch, comparable between hosts with synchronized clocks
+uint64_t now();
+
+/// Records a span which started at \p start and ends now, if \p traceId is not 0
+void record(TraceId traceId, const char *name, uint64_t start, uint64_t argument = 0);
+
+/// Records a span of the current request lasting until the end of a scope
+class ScopedSpan {
+public:
+	explicit ScopedSpan(const char *name, uint64_t argument = 0)
+			: traceId_(currentTraceId()),
+			  name_(name),
+			  start_(traceId_ ? now() : 0),
+			  argument_(argument) {
+	}
+
+	~ScopedSpan() {
+		record(traceId_, name_, start_, argument_);
+	}
+
+	ScopedSpan(const ScopedSpan&) = delete;
+	ScopedSpan &operator=(const ScopedSpan&) = delete;
+
+private:
+	TraceId traceId_;
+	const char *name_;
+	uint64_t start_;
+	uint64_t argument_;
+};
+
+/// Ring of the process
+SpanRing &spans();
+
+/*! \brief Appends spans recorded since the previous call to a file.
+ *
+ * Every span is a line "trace_id start duration name argument", the id is hexadecimal.
+ * The file isn't touched if there are no new spans. It's created if needed, but it's never
+ * opened through a symbolic link.
+ * \return false if the file can't be written.
+ */
+bool dump(const std::string &path);
+
+/*! \brief Dumps spans to a file once per second in a thread of its own.
+ *
+ * Keeps writes to the file out of event loops of the servers. When the file grows bigger
+ * than a limit, it's rotated like changelogs: the oldest of \p storedPreviousCopies
+ * copies (path.1, path.2, ...) is removed.
+ */
+class Dumper {
+public:
+	static const uint64_t kDefaultMaxFileSize = 64 * 1024 * 1024;
+	static const int kDefaultStoredPreviousCopies = 1;
+
+	explicit Dumper(std::string path, uint64_t maxFileSize = kDefaultMaxFileSize,
+			int storedPreviousCopies = kDefaultStoredPreviousCopies);
+
+	/// Dumps spans recorded so far and stops the thread
+	~Dumper();
+
+	Dumper(const Dumper&) = delete;
+	Dumper &operator=(const Dumper&) = delete;
+
+private:
+	void run();
+	void dumpAndRotate();
+
+	const std::string path_;
+	const uint64_t maxFileSize_;
+	const int storedPreviousCopies_;
+	bool failed_;
+	bool terminate_;
+	std::mutex mutex_;
+	std::condition_variable terminateCond_;
+	std::thread thread_;
+};
+
+} // namespace tracing
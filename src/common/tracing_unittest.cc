@@ -0,0 +1,111 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "common/tracing.h"
+
+#include <fstream>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "unittests/TemporaryDirectory.h"
+
+TEST(TracingTests, RingKeepsLastSpans) {
+	tracing::SpanRing ring(3); // rounded up to 4
+	uint64_t position = 0;
+	EXPECT_TRUE(ring.collect(position).empty());
+	for (uint64_t i = 0; i < 6; ++i) {
+		ring.record(tracing::Span{1, "span", i, 10, i});
+	}
+	std::vector<tracing::Span> spans = ring.collect(position);
+	ASSERT_EQ(4U, spans.size());
+	EXPECT_EQ(2U, spans[0].argument);
+	EXPECT_EQ(5U, spans[3].argument);
+	EXPECT_EQ(6U, position);
+
+	ring.record(tracing::Span{2, "other", 7, 10, 7});
+	spans = ring.collect(position);
+	ASSERT_EQ(1U, spans.size());
+	EXPECT_EQ(2U, spans[0].traceId);
+	EXPECT_STREQ("other", spans[0].name);
+}
+
+TEST(TracingTests, ConcurrentWriters) {
+	tracing::SpanRing ring(1024);
+	std::vector<std::thread> threads;
+	for (uint64_t t = 0; t < 4; ++t) {
+		threads.emplace_back([&ring, t]() {
+			for (uint64_t i = 0; i < 200; ++i) {
+				ring.record(tracing::Span{t + 1, "span", i, i, t});
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	uint64_t position = 0;
+	std::vector<tracing::Span> spans = ring.collect(position);
+	ASSERT_EQ(800U, spans.size());
+	for (const tracing::Span &span : spans) {
+		EXPECT_EQ(span.traceId, span.argument + 1);
+		EXPECT_EQ(span.start, span.duration);
+	}
+}
+
+TEST(TracingTests, SamplingAndScopes) {
+	tracing::setSamplingPeriod(0);
+	EXPECT_EQ(0U, tracing::newTraceId());
+
+	tracing::setSamplingPeriod(4);
+	int sampled = 0;
+	for (int i = 0; i < 100; ++i) {
+		sampled += tracing::newTraceId() != 0 ? 1 : 0;
+	}
+	EXPECT_EQ(25, sampled);
+	tracing::setSamplingPeriod(1);
+	EXPECT_NE(tracing::newTraceId(), tracing::newTraceId());
+	tracing::setSamplingPeriod(0);
+
+	EXPECT_EQ(0U, tracing::currentTraceId());
+	{
+		tracing::TraceScope outer(5);
+		EXPECT_EQ(5U, tracing::currentTraceId());
+		{
+			tracing::TraceScope inner(6);
+			EXPECT_EQ(6U, tracing::currentTraceId());
+		}
+		EXPECT_EQ(5U, tracing::currentTraceId());
+	}
+	EXPECT_EQ(0U, tracing::currentTraceId());
+}
+
+TEST(TracingTests, DumperRotatesFile) {
+	TemporaryDirectory temp("/tmp", this->test_info_->name());
+	std::string path = temp.name() + "/traces.log";
+	for (uint64_t traceId = 0xA1; traceId <= 0xA2; ++traceId) {
+		tracing::Dumper dumper(path, 1, 1);
+		tracing::record(traceId, "span", tracing::now());
+	} // the destructor dumps the last spans
+
+	// Every dump exceeded the limit, so only the last one is kept as a previous copy
+	EXPECT_FALSE(std::ifstream(path).good());
+	EXPECT_FALSE(std::ifstream(path + ".2").good());
+	std::ifstream file(path + ".1");
+	std::string line;
+	ASSERT_TRUE(std::getline(file, line).good());
+	EXPECT_EQ(0U, line.find("00000000000000a2 "));
+}
@@ -20,12 +20,14 @@
 
 #include "common/platform.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
 #include "common/block_xor.h"
 #include "common/read_plan.h"
 #include "common/slice_read_plan.h"
+#include "common/small_vector.h"
 
 /*!
  * Class handling read operations on a single xor slice.
@@ -34,21 +36,20 @@ class XorReadPlan : public SliceReadPlan {
 public:
 
 	/*!
-	 * Computes parity from given blocks by accumulating xored blocks in memory pointed by dst
+	 * Computes parity from given blocks by xoring all of them into memory pointed by dst
 	 */
 	struct RecoverParity {
 		void operator()(uint8_t *dst, int, const uint8_t *src, int) const {
 			assert(plan);
+			small_vector<const uint8_t *, Goal::Slice::kMaxPartsCount> sources(data_part_count);
 			for (int block = 0; block < part_block_count; ++block) {
 				assert(dst >= plan->buffer_start && (dst + MFSBLOCKSIZE) <= plan->buffer_read);
-				std::memcpy(dst, src, MFSBLOCKSIZE);
-				src += MFSBLOCKSIZE;
-				for (int i = 1; i < data_part_count; ++i) {
-					assert(dst >= plan->buffer_start && (dst + MFSBLOCKSIZE) <= plan->buffer_read);
+				for (int i = 0; i < data_part_count; ++i) {
 					assert(src >= plan->buffer_start && (src + MFSBLOCKSIZE) <= plan->buffer_end);
-					blockXor(dst, src, MFSBLOCKSIZE);
+					sources[i] = src;
 					src += MFSBLOCKSIZE;
 				}
+				blockXorMany(dst, sources.data(), data_part_count, MFSBLOCKSIZE);
 				dst += MFSBLOCKSIZE;
 			}
 		}
@@ -96,29 +97,33 @@ public:
 
 		int missing_offset = std::distance(requested_parts.begin(), missing_it) * buffer_part_size;
 		int missing_size = missing_it->size;
-		bool first = true;
+		uint8_t *missing = buffer + missing_offset;
+		assert(missing >= buffer_read && (missing + missing_size) <= buffer_end);
 
+		// Parts shorter than the missing one are padded with zeros, so all parts are xored
+		// in a single pass up to the length of the shortest one
+		small_vector<const uint8_t *, Goal::Slice::kMaxPartsCount> sources;
+		int common_size = missing_size;
+		for (const auto &op : read_operations) {
+			if (part_bitset.test(op.first.getSlicePart()) == 0) {
+				continue;
+			}
+			assert((buffer + op.second.buffer_offset) >= buffer_read &&
+			       (buffer + op.second.buffer_offset + std::min(op.second.request_size,
+			                                                     missing_size)) <= buffer_end);
+			sources.push_back(buffer + op.second.buffer_offset);
+			common_size = std::min(common_size, op.second.request_size);
+		}
+		blockXorMany(missing, sources.data(), sources.size(), common_size);
+		std::memset(missing + common_size, 0, missing_size - common_size);
 		for (const auto &op : read_operations) {
 			if (part_bitset.test(op.first.getSlicePart()) == 0) {
 				continue;
 			}
 			int size = std::min(op.second.request_size, missing_size);
-			if (first) {
-				assert((buffer + missing_offset) >= buffer_read &&
-				       (buffer + missing_offset + size) <= buffer_end);
-				assert((buffer + op.second.buffer_offset) >= buffer_read &&
-				       (buffer + op.second.buffer_offset + size) <= buffer_end);
-				assert((buffer + missing_offset + size) >= buffer_read &&
-				       (buffer + missing_offset + missing_size) <= buffer_end);
-				std::memcpy(buffer + missing_offset, buffer + op.second.buffer_offset, size);
-				std::memset(buffer + missing_offset + size, 0, missing_size - size);
-				first = false;
-			} else {
-				assert((buffer + missing_offset) >= buffer_read &&
-				       (buffer + missing_offset + size) <= buffer_end);
-				assert((buffer + op.second.buffer_offset) >= buffer_read &&
-				       (buffer + op.second.buffer_offset + size) <= buffer_end);
-				blockXor(buffer + missing_offset, buffer + op.second.buffer_offset, size);
+			if (size > common_size) {
+				blockXor(missing + common_size, buffer + op.second.buffer_offset + common_size,
+				         size - common_size);
 			}
 		}
 
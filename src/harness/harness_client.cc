@@ -0,0 +1,127 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "harness/harness_client.h"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "common/mfserr.h"
+#include "common/special_inode_defs.h"
+#include "mount/g_io_limiters.h"
+#include "mount/mastercomm.h"
+#include "mount/readdata.h"
+#include "mount/symlinkcache.h"
+#include "mount/writedata.h"
+#include "protocol/MFSCommunication.h"
+
+static const uint32_t kRetries = 30;
+
+HarnessClient::HarnessClient(const std::string &host, const std::string &port) {
+	if (fs_init_master_connection(nullptr, host.c_str(), port.c_str(), 0, "harness", "/",
+			nullptr, 0, 0, kRetries, 0) < 0) {
+		throw LocalClusterException("Can't connect to the master " + host + ":" + port);
+	}
+	symlink_cache_init();
+	gGlobalIoLimiter();
+	fs_init_threads(kRetries, 1);
+	IoLimitsConfigLoader loader;
+	gLocalIoLimiter();
+	gMountLimiter().loadConfiguration(loader);
+	// Same as defaults of mfsmount, except for the cache of locations of chunks, which
+	// would hide changes made by master during scenarios with failures of chunkservers
+	read_data_init(kRetries, 200, 2000, 500, 2000, 500, 4096, false, 1.25, 0, 0);
+	write_data_init(128, kRetries, 10, 15, 5000, 25);
+	LizardClient::init(0, 0, 0.0, 0.0, 0.0, 0, SugidClearMode::kNever, false, false, 0.0, 0);
+}
+
+HarnessClient::~HarnessClient() {
+	write_data_term();
+	read_data_term();
+	fs_term();
+	symlink_cache_term();
+}
+
+LizardClient::Context HarnessClient::context() const {
+	return LizardClient::Context(getuid(), getgid(), getpid(), 0);
+}
+
+HarnessClient::File HarnessClient::create(const std::string &name) {
+	File file;
+	file.info.flags = O_RDWR;
+	LizardClient::EntryParam entry = LizardClient::create(context(), SPECIAL_INODE_ROOT,
+			name.c_str(), S_IFREG | 0644, &file.info);
+	file.inode = entry.ino;
+	return file;
+}
+
+HarnessClient::File HarnessClient::open(const std::string &name, int flags) {
+	File file;
+	file.inode = lookup(name);
+	file.info.flags = flags;
+	LizardClient::open(context(), file.inode, &file.info);
+	return file;
+}
+
+LizardClient::Inode HarnessClient::lookup(const std::string &name) {
+	return LizardClient::lookup(context(), SPECIAL_INODE_ROOT, name.c_str()).ino;
+}
+
+void HarnessClient::write(File &file, const uint8_t *buffer, uint32_t size, uint64_t offset) {
+	uint32_t written = 0;
+	while (written < size) {
+		written += LizardClient::write(context(), file.inode, (const char *)buffer + written,
+				size - written, offset + written, &file.info);
+	}
+}
+
+uint32_t HarnessClient::read(File &file, uint8_t *buffer, uint32_t size, uint64_t offset) {
+	ReadCache::Result result = LizardClient::read(context(), file.inode, size, offset,
+			&file.info);
+	std::vector<struct iovec> parts;
+	uint32_t bytes = result.toIoVec(parts, offset, size);
+	for (const struct iovec &part : parts) {
+		memcpy(buffer, part.iov_base, part.iov_len);
+		buffer += part.iov_len;
+	}
+	return bytes;
+}
+
+void HarnessClient::fsync(File &file) {
+	LizardClient::fsync(context(), file.inode, 0, &file.info);
+}
+
+void HarnessClient::close(File &file) {
+	LizardClient::flush(context(), file.inode, &file.info);
+	LizardClient::release(context(), file.inode, &file.info);
+	file.inode = 0;
+}
+
+std::vector<ChunkTypeWithAddress> HarnessClient::chunkLocations(LizardClient::Inode inode,
+		uint32_t index) {
+	std::vector<ChunkTypeWithAddress> locations;
+	uint64_t chunkId, fileLength;
+	uint32_t version;
+	uint8_t status = fs_lizreadchunk(locations, chunkId, version, fileLength, inode, index);
+	if (status != LIZARDFS_STATUS_OK) {
+		throw LizardClient::RequestException(mfs_errorconv(status));
+	}
+	return locations;
+}
@@ -0,0 +1,73 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <fcntl.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/chunk_type_with_address.h"
+#include "harness/local_cluster.h"
+#include "mount/lizard_client.h"
+
+/*! \brief A client of a cluster using the mount library directly, without FUSE.
+ *
+ * Global state of the mount library can be initialized only once, so there may be only one
+ * client in a process and it has to be the last user of the library in this process.
+ * The process has to call strerr_init() and mycrc32_init() first.
+ * Errors of requests are reported with LizardClient::RequestException.
+ */
+class HarnessClient {
+public:
+	struct File {
+		File() : inode(0), info(0, 0, 0, 0, 0) {
+		}
+
+		LizardClient::Inode inode;
+		LizardClient::FileInfo info;
+	};
+
+	HarnessClient(const std::string &host, const std::string &port);
+	~HarnessClient();
+
+	HarnessClient(const HarnessClient&) = delete;
+	HarnessClient &operator=(const HarnessClient&) = delete;
+
+	/// Creates a file in the root directory and opens it for reading and writing
+	File create(const std::string &name);
+	File open(const std::string &name, int flags = O_RDWR);
+	/// Finds an inode of a file in the root directory
+	LizardClient::Inode lookup(const std::string &name);
+
+	void write(File &file, const uint8_t *buffer, uint32_t size, uint64_t offset);
+	/// Returns the number of bytes copied to \p buffer
+	uint32_t read(File &file, uint8_t *buffer, uint32_t size, uint64_t offset);
+	void fsync(File &file);
+	/// Flushes and releases the file
+	void close(File &file);
+
+	/// Asks master where parts of a chunk are, without using any cache of locations
+	std::vector<ChunkTypeWithAddress> chunkLocations(LizardClient::Inode inode,
+			uint32_t index);
+
+private:
+	LizardClient::Context context() const;
+};
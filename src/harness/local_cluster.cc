@@ -0,0 +1,317 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "harness/local_cluster.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <pwd.h>
+#include <signal.h>
+#ifdef __linux__
+#  include <sys/prctl.h>
+#endif
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+#include "common/lizardfs_version.h"
+#include "common/server_connection.h"
+#include "common/time_utils.h"
+#include "protocol/cltoma.h"
+#include "protocol/matocl.h"
+
+static std::string firstNetworkAddress() {
+	struct ifaddrs *interfaces;
+	if (getifaddrs(&interfaces) != 0) {
+		throw LocalClusterException("Can't list network interfaces");
+	}
+	std::string result;
+	for (struct ifaddrs *it = interfaces; it != nullptr; it = it->ifa_next) {
+		if (it->ifa_addr == nullptr || it->ifa_addr->sa_family != AF_INET
+				|| (it->ifa_flags & IFF_LOOPBACK) || !(it->ifa_flags & IFF_UP)) {
+			continue;
+		}
+		char buffer[INET_ADDRSTRLEN];
+		const struct sockaddr_in *address = (const struct sockaddr_in *)it->ifa_addr;
+		if (inet_ntop(AF_INET, &address->sin_addr, buffer, sizeof(buffer))) {
+			result = buffer;
+			break;
+		}
+	}
+	freeifaddrs(interfaces);
+	if (result.empty()) {
+		throw LocalClusterException("No network interface other than loopback is up");
+	}
+	return result;
+}
+
+// A port which was free a moment ago, daemons of the cluster bind to it a bit later
+static uint16_t freePort() {
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		throw LocalClusterException("Can't create a socket");
+	}
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = 0;
+	if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0
+			|| getsockname(fd, (struct sockaddr *)&address, &length) != 0) {
+		close(fd);
+		throw LocalClusterException("Can't find a free port");
+	}
+	close(fd);
+	return ntohs(address.sin_port);
+}
+
+LocalCluster::Options::Options()
+		: masterBinary("mfsmaster"),
+		  chunkserverBinary("mfschunkserver"),
+		  baseDirectory(access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp"),
+		  ip(),
+		  chunkservers(3),
+		  keepDirectory(false),
+		  goal("_"),
+		  masterConfig(),
+		  chunkserverConfig() {
+}
+
+LocalCluster::LocalCluster(Options options)
+		: options_(std::move(options)),
+		  directory_(),
+		  matoclPort_(0),
+		  master_(),
+		  chunkservers_(options_.chunkservers),
+		  chunkserverPorts_(options_.chunkservers) {
+	if (options_.ip.empty()) {
+		options_.ip = firstNetworkAddress();
+	}
+	std::string pattern = options_.baseDirectory + "/lizardfs-cluster.XXXXXX";
+	std::vector<char> name(pattern.begin(), pattern.end());
+	name.push_back('\0');
+	if (mkdtemp(name.data()) == nullptr) {
+		throw LocalClusterException("Can't create a directory in " + options_.baseDirectory);
+	}
+	directory_ = name.data();
+	boost::filesystem::create_directory(directory_ + "/etc");
+}
+
+LocalCluster::~LocalCluster() {
+	for (Daemon &chunkserver : chunkservers_) {
+		stop(chunkserver, SIGTERM);
+	}
+	stop(master_, SIGTERM);
+	if (!options_.keepDirectory) {
+		boost::system::error_code error;
+		boost::filesystem::remove_all(directory_, error);
+	}
+}
+
+void LocalCluster::start(uint32_t timeout_ms) {
+	prepareMaster();
+	spawn(master_);
+	for (uint32_t i = 0; i < chunkservers_.size(); ++i) {
+		prepareChunkserver(i);
+		spawn(chunkservers_[i]);
+	}
+	waitForChunkservers(chunkservers_.size(), timeout_ms);
+}
+
+void LocalCluster::startChunkserver(uint32_t index) {
+	spawn(chunkservers_.at(index));
+}
+
+void LocalCluster::stopChunkserver(uint32_t index) {
+	stop(chunkservers_.at(index), SIGTERM);
+}
+
+void LocalCluster::killChunkserver(uint32_t index) {
+	stop(chunkservers_.at(index), SIGKILL);
+}
+
+void LocalCluster::waitForChunkservers(uint32_t count, uint32_t timeout_ms) {
+	Timeout timeout{std::chrono::milliseconds(timeout_ms)};
+	while (!timeout.expired()) {
+		try {
+			ServerConnection connection(masterHost(), masterPort());
+			auto response = connection.sendAndReceive(cltoma::cservList::build(true),
+					LIZ_MATOCL_CSERV_LIST);
+			std::vector<ChunkserverListEntry> servers;
+			matocl::cservList::deserialize(response, servers);
+			uint32_t ready = 0;
+			for (const ChunkserverListEntry &server : servers) {
+				if (server.version != kDisconnectedChunkserverVersion && server.totalspace > 0) {
+					++ready;
+				}
+			}
+			if (ready == count) {
+				return;
+			}
+		} catch (Exception &) {
+			// master is not listening yet
+		}
+		usleep(100000);
+	}
+	throw LocalClusterException("Chunkservers didn't connect to the master, see logs in "
+			+ directory_);
+}
+
+NetworkAddress LocalCluster::chunkserverAddress(uint32_t index) const {
+	struct in_addr address;
+	inet_pton(AF_INET, options_.ip.c_str(), &address);
+	return NetworkAddress(ntohl(address.s_addr), chunkserverPorts_.at(index));
+}
+
+void LocalCluster::writeFile(const std::string &path, const std::vector<std::string> &lines) {
+	std::ofstream file(path);
+	for (const std::string &line : lines) {
+		file << line << '\n';
+	}
+	if (!file) {
+		throw LocalClusterException("Can't write " + path);
+	}
+}
+
+static std::vector<std::string> credentials() {
+	struct passwd *user = getpwuid(getuid());
+	struct group *group = getgrgid(getgid());
+	if (user == nullptr || group == nullptr) {
+		throw LocalClusterException("Can't find names of the user and the group");
+	}
+	return {
+		std::string("WORKING_USER = ") + user->pw_name,
+		std::string("WORKING_GROUP = ") + group->gr_name,
+	};
+}
+
+void LocalCluster::prepareMaster() {
+	std::string etc = directory_ + "/etc";
+	std::string data = directory_ + "/master";
+	boost::filesystem::create_directory(data);
+	writeFile(data + "/metadata.mfs", {"MFSM NEW"});
+	writeFile(etc + "/mfsexports.cfg", {"* / rw,alldirs,maproot=0"});
+	writeFile(etc + "/mfstopology.cfg", {"# empty topology"});
+	writeFile(etc + "/mfsgoals.cfg", {"1 harness: " + options_.goal});
+
+	matoclPort_ = freePort();
+	std::vector<std::string> config = credentials();
+	config.insert(config.end(), {
+		"PERSONALITY = master",
+		"SYSLOG_IDENT = harness_master",
+		"DATA_PATH = " + data,
+		"EXPORTS_FILENAME = " + etc + "/mfsexports.cfg",
+		"TOPOLOGY_FILENAME = " + etc + "/mfstopology.cfg",
+		"CUSTOM_GOALS_FILENAME = " + etc + "/mfsgoals.cfg",
+		"MATOML_LISTEN_PORT = " + std::to_string(freePort()),
+		"MATOCS_LISTEN_PORT = " + std::to_string(freePort()),
+		"MATOCL_LISTEN_PORT = " + std::to_string(matoclPort_),
+		"MATOTS_LISTEN_PORT = " + std::to_string(freePort()),
+		// React to changes of the cluster at once, scenarios measure daemons, not delays
+		"CHUNKS_LOOP_MIN_TIME = 1",
+		"OPERATIONS_DELAY_INIT = 0",
+		"OPERATIONS_DELAY_DISCONNECT = 0",
+	});
+	config.insert(config.end(), options_.masterConfig.begin(), options_.masterConfig.end());
+	writeFile(etc + "/mfsmaster.cfg", config);
+
+	master_.binary = options_.masterBinary;
+	master_.config = etc + "/mfsmaster.cfg";
+	master_.log = directory_ + "/master.log";
+}
+
+void LocalCluster::prepareChunkserver(uint32_t index) {
+	std::string name = "chunkserver_" + std::to_string(index);
+	std::string etc = directory_ + "/etc";
+	std::string data = directory_ + "/" + name;
+	std::string disk = directory_ + "/hdd_" + std::to_string(index);
+	boost::filesystem::create_directory(data);
+	boost::filesystem::create_directory(disk);
+	writeFile(etc + "/mfshdd_" + std::to_string(index) + ".cfg", {disk});
+
+	// MATOCS_LISTEN_PORT is read back from the configuration of the master
+	std::string masterPortLine;
+	std::ifstream masterConfig(master_.config);
+	for (std::string line; std::getline(masterConfig, line);) {
+		if (line.compare(0, 18, "MATOCS_LISTEN_PORT") == 0) {
+			masterPortLine = "MASTER_PORT" + line.substr(18);
+		}
+	}
+
+	chunkserverPorts_[index] = freePort();
+	std::vector<std::string> config = credentials();
+	config.insert(config.end(), {
+		"SYSLOG_IDENT = harness_" + name,
+		"DATA_PATH = " + data,
+		"HDD_CONF_FILENAME = " + etc + "/mfshdd_" + std::to_string(index) + ".cfg",
+		"HDD_LEAVE_SPACE_DEFAULT = 128MiB",
+		"MASTER_HOST = " + options_.ip,
+		masterPortLine,
+		"CSSERV_LISTEN_PORT = " + std::to_string(chunkserverPorts_[index]),
+	});
+	config.insert(config.end(), options_.chunkserverConfig.begin(),
+			options_.chunkserverConfig.end());
+	writeFile(etc + "/mfschunkserver_" + std::to_string(index) + ".cfg", config);
+
+	Daemon &chunkserver = chunkservers_[index];
+	chunkserver.binary = options_.chunkserverBinary;
+	chunkserver.config = etc + "/mfschunkserver_" + std::to_string(index) + ".cfg";
+	chunkserver.log = directory_ + "/" + name + ".log";
+}
+
+void LocalCluster::spawn(Daemon &daemon) {
+	if (daemon.pid > 0) {
+		return;
+	}
+	pid_t pid = fork();
+	if (pid < 0) {
+		throw LocalClusterException("Can't fork");
+	}
+	if (pid == 0) {
+#ifdef __linux__
+		// Daemons shouldn't outlive a crashed or interrupted process which started them
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+		int fd = open(daemon.log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		if (fd >= 0) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+		execlp(daemon.binary.c_str(), daemon.binary.c_str(), "-d", "-c", daemon.config.c_str(),
+				"start", (char *)nullptr);
+		_exit(127);
+	}
+	daemon.pid = pid;
+}
+
+void LocalCluster::stop(Daemon &daemon, int signal) {
+	if (daemon.pid <= 0) {
+		return;
+	}
+	kill(daemon.pid, signal);
+	waitpid(daemon.pid, nullptr, 0);
+	daemon.pid = 0;
+}
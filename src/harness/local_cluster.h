@@ -0,0 +1,117 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/exceptions.h"
+#include "common/network_address.h"
+
+LIZARDFS_CREATE_EXCEPTION_CLASS(LocalClusterException, Exception);
+
+/*! \brief A master and chunkservers running as child processes of the calling process.
+ *
+ * All files of the cluster (configuration, metadata, chunks and logs of daemons) are kept
+ * in a temporary directory, preferably on tmpfs, which is removed with the cluster unless
+ * Options::keepDirectory is set.
+ * Master refuses chunkservers connecting from 127.0.0.0/8, so daemons talk to each other
+ * through an address of a network interface of this host.
+ */
+class LocalCluster {
+public:
+	struct Options {
+		Options();
+
+		std::string masterBinary;
+		std::string chunkserverBinary;
+		/// A directory in which a directory of the cluster is created
+		std::string baseDirectory;
+		/// Address used by all daemons, the first non-loopback IPv4 address if empty
+		std::string ip;
+		uint32_t chunkservers;
+		/// Keeps the directory of the cluster, e.g. to look at logs of daemons
+		bool keepDirectory;
+		/// Labels of the default goal (id 1), used for all files created in the cluster
+		std::string goal;
+		/// Additional lines of configuration files
+		std::vector<std::string> masterConfig;
+		std::vector<std::string> chunkserverConfig;
+	};
+
+	explicit LocalCluster(Options options);
+	~LocalCluster();
+
+	LocalCluster(const LocalCluster&) = delete;
+	LocalCluster &operator=(const LocalCluster&) = delete;
+
+	/// Starts the master and all chunkservers, returns when chunkservers are registered
+	void start(uint32_t timeout_ms = 30000);
+
+	void startChunkserver(uint32_t index);
+	/// Stops a chunkserver with SIGTERM and waits until it exits
+	void stopChunkserver(uint32_t index);
+	/// Kills a chunkserver with SIGKILL, like a crash of its machine
+	void killChunkserver(uint32_t index);
+
+	/// Waits until \p count chunkservers are connected to the master and report their disks
+	void waitForChunkservers(uint32_t count, uint32_t timeout_ms);
+
+	const std::string &masterHost() const {
+		return options_.ip;
+	}
+
+	/// Port for clients
+	std::string masterPort() const {
+		return std::to_string(matoclPort_);
+	}
+
+	NetworkAddress chunkserverAddress(uint32_t index) const;
+
+	const std::string &directory() const {
+		return directory_;
+	}
+
+private:
+	struct Daemon {
+		Daemon() : pid(0) {
+		}
+
+		std::string binary;
+		std::string config;
+		std::string log;
+		pid_t pid;
+	};
+
+	void writeFile(const std::string &path, const std::vector<std::string> &lines);
+	void prepareMaster();
+	void prepareChunkserver(uint32_t index);
+	void spawn(Daemon &daemon);
+	void stop(Daemon &daemon, int signal);
+
+	Options options_;
+	std::string directory_;
+	uint16_t matoclPort_;
+	Daemon master_;
+	std::vector<Daemon> chunkservers_;
+	std::vector<uint16_t> chunkserverPorts_;
+};
@@ -0,0 +1,196 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "common/crc.h"
+#include "common/mfserr.h"
+#include "common/sockets.h"
+#include "harness/scenarios.h"
+
+#ifndef MFSMASTER_PATH
+#	error "You have to define MFSMASTER_PATH to compile this file"
+#endif
+#ifndef MFSCHUNKSERVER_PATH
+#	error "You have to define MFSCHUNKSERVER_PATH to compile this file"
+#endif
+
+#define TO_STRING_AUX(x) #x
+#define TO_STRING(x) TO_STRING_AUX(x)
+
+static void usage(const char *name) {
+	fprintf(stderr,
+			"usage: %s [options] [scenario...]\n"
+			"\n"
+			"Starts a cluster of a master and chunkservers for every scenario and prints\n"
+			"numbers measured by the scenario as a JSON object in a single line.\n"
+			"All scenarios are run if none is given.\n"
+			"\n"
+			"options:\n"
+			" -n COUNT     number of chunkservers (default: 3)\n"
+			" -s MiB       size of files of sequential and random scenarios (default: 128)\n"
+			" -b KiB       size of requests of sequential scenarios (default: 1024)\n"
+			" -o COUNT     number of operations of random scenarios (default: 2000)\n"
+			" -f COUNT     number of created small files (default: 1000)\n"
+			" -d DIRECTORY directory for files of clusters (default: /dev/shm or /tmp)\n"
+			" -i ADDRESS   address of daemons, not from 127.0.0.0/8 (default: first found)\n"
+			" -m PATH      mfsmaster binary (default: %s)\n"
+			" -c PATH      mfschunkserver binary (default: %s)\n"
+			" -t SECONDS   limit of waiting for the cluster (default: 120)\n"
+			" -k           keep directories of clusters\n"
+			"\n"
+			"scenarios:\n",
+			name, TO_STRING(MFSMASTER_PATH), TO_STRING(MFSCHUNKSERVER_PATH));
+	for (const Scenario &scenario : allScenarios()) {
+		fprintf(stderr, " %-12s %s\n", scenario.name.c_str(), scenario.description.c_str());
+	}
+}
+
+static std::string jsonString(const std::string &value) {
+	std::string result = "\"";
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+		}
+		result += (c == '\n' ? ' ' : c);
+	}
+	return result + "\"";
+}
+
+// Runs in a child process, because the client can't be initialized twice in one process
+static int runScenario(const Scenario &scenario, const ScenarioConfig &config) {
+	ScenarioReport report;
+	std::string line = "{\"scenario\": " + jsonString(scenario.name);
+	int status = 0;
+	try {
+		scenario.run(config, report);
+		line += ", \"status\": \"ok\"";
+	} catch (std::exception &e) {
+		line += ", \"status\": \"failed\", \"error\": " + jsonString(e.what());
+		status = 1;
+	}
+	for (const auto &value : report) {
+		char number[32];
+		snprintf(number, sizeof(number), "%.6g", value.second);
+		line += ", " + jsonString(value.first) + ": " + number;
+	}
+	printf("%s}\n", line.c_str());
+	fflush(stdout);
+	return status;
+}
+
+int main(int argc, char **argv) {
+	socketinit();
+	strerr_init();
+	mycrc32_init();
+
+	ScenarioConfig config;
+	config.cluster.masterBinary = TO_STRING(MFSMASTER_PATH);
+	config.cluster.chunkserverBinary = TO_STRING(MFSCHUNKSERVER_PATH);
+	int option;
+	while ((option = getopt(argc, argv, "n:s:b:o:f:d:i:m:c:t:kh")) != -1) {
+		switch (option) {
+		case 'n':
+			config.cluster.chunkservers = strtoul(optarg, nullptr, 10);
+			break;
+		case 's':
+			config.fileSize = strtoull(optarg, nullptr, 10) << 20;
+			break;
+		case 'b':
+			config.blockSize = strtoul(optarg, nullptr, 10) << 10;
+			break;
+		case 'o':
+			config.randomOperations = strtoul(optarg, nullptr, 10);
+			break;
+		case 'f':
+			config.smallFiles = strtoul(optarg, nullptr, 10);
+			break;
+		case 'd':
+			config.cluster.baseDirectory = optarg;
+			break;
+		case 'i':
+			config.cluster.ip = optarg;
+			break;
+		case 'm':
+			config.cluster.masterBinary = optarg;
+			break;
+		case 'c':
+			config.cluster.chunkserverBinary = optarg;
+			break;
+		case 't':
+			config.timeout_ms = strtoul(optarg, nullptr, 10) * 1000;
+			break;
+		case 'k':
+			config.cluster.keepDirectory = true;
+			break;
+		default:
+			usage(argv[0]);
+			return option == 'h' ? 0 : 1;
+		}
+	}
+	if (config.cluster.chunkservers == 0 || config.fileSize < (1 << 20)
+			|| config.blockSize == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	std::vector<const Scenario *> selected;
+	for (const Scenario &scenario : allScenarios()) {
+		if (optind == argc) {
+			selected.push_back(&scenario);
+		}
+	}
+	for (int i = optind; i < argc; ++i) {
+		for (const Scenario &scenario : allScenarios()) {
+			if (scenario.name == argv[i]) {
+				selected.push_back(&scenario);
+			}
+		}
+		if (selected.size() != size_t(i - optind + 1)) {
+			fprintf(stderr, "unknown scenario: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	int failures = 0;
+	for (const Scenario *scenario : selected) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			return 1;
+		}
+		if (pid == 0) {
+			_exit(runScenario(*scenario, config));
+		}
+		int status;
+		waitpid(pid, &status, 0);
+		if (WIFSIGNALED(status)) {
+			printf("{\"scenario\": %s, \"status\": \"failed\", \"error\": \"killed by signal %d\"}\n",
+					jsonString(scenario->name).c_str(), WTERMSIG(status));
+			fflush(stdout);
+		}
+		failures += !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+	return failures == 0 ? 0 : 1;
+}
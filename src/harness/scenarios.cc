@@ -0,0 +1,305 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "harness/scenarios.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <random>
+
+#include "common/time_utils.h"
+#include "harness/harness_client.h"
+#include "protocol/MFSCommunication.h"
+
+static const uint32_t kRandomBlockSize = 4096;
+static const uint32_t kSmallFileSize = 4096;
+
+// Contents of files depend only on offsets, so every read can be checked
+static void fillBlock(uint8_t *buffer, uint32_t size, uint64_t offset) {
+	for (uint32_t i = 0; i < size; ++i) {
+		uint64_t position = offset + i;
+		buffer[i] = position * 31 + (position >> 12);
+	}
+}
+
+static void checkBlock(const uint8_t *buffer, uint32_t size, uint64_t offset) {
+	std::vector<uint8_t> expected(size);
+	fillBlock(expected.data(), size, offset);
+	if (!std::equal(expected.begin(), expected.end(), buffer)) {
+		throw LocalClusterException("Wrong data read at offset " + std::to_string(offset));
+	}
+}
+
+static double mebibytesPerSecond(uint64_t bytes, int64_t elapsed_us) {
+	return (bytes / double(1 << 20)) / (std::max<int64_t>(elapsed_us, 1) / 1e6);
+}
+
+static double operationsPerSecond(uint64_t operations, int64_t elapsed_us) {
+	return operations / (std::max<int64_t>(elapsed_us, 1) / 1e6);
+}
+
+static void reportLatencies(const std::string &prefix, std::vector<int64_t> latencies_us,
+		ScenarioReport &report) {
+	if (latencies_us.empty()) {
+		return;
+	}
+	std::sort(latencies_us.begin(), latencies_us.end());
+	auto percentile = [&latencies_us](double p) {
+		return double(latencies_us[std::min<size_t>(latencies_us.size() * p,
+				latencies_us.size() - 1)]);
+	};
+	report.emplace_back(prefix + "_latency_p50_us", percentile(0.5));
+	report.emplace_back(prefix + "_latency_p99_us", percentile(0.99));
+	report.emplace_back(prefix + "_latency_max_us", double(latencies_us.back()));
+}
+
+static uint32_t chunkCount(uint64_t fileSize) {
+	return (fileSize + MFSCHUNKSIZE - 1) / MFSCHUNKSIZE;
+}
+
+/// Writes a file sequentially, returns time in microseconds including fsync and close
+static int64_t writeFile(HarnessClient &client, const std::string &name,
+		const ScenarioConfig &config) {
+	std::vector<uint8_t> buffer(config.blockSize);
+	Timer timer;
+	HarnessClient::File file = client.create(name);
+	for (uint64_t offset = 0; offset < config.fileSize; offset += config.blockSize) {
+		uint32_t size = std::min<uint64_t>(config.blockSize, config.fileSize - offset);
+		fillBlock(buffer.data(), size, offset);
+		client.write(file, buffer.data(), size, offset);
+	}
+	client.fsync(file);
+	client.close(file);
+	return timer.elapsed_us();
+}
+
+/// Reads and checks a whole file sequentially, returns time in microseconds
+static int64_t readFile(HarnessClient &client, const std::string &name,
+		const ScenarioConfig &config) {
+	std::vector<uint8_t> buffer(config.blockSize);
+	Timer timer;
+	HarnessClient::File file = client.open(name, O_RDONLY);
+	for (uint64_t offset = 0; offset < config.fileSize; offset += config.blockSize) {
+		uint32_t size = std::min<uint64_t>(config.blockSize, config.fileSize - offset);
+		if (client.read(file, buffer.data(), size, offset) != size) {
+			throw LocalClusterException("Short read at offset " + std::to_string(offset));
+		}
+		checkBlock(buffer.data(), size, offset);
+	}
+	client.close(file);
+	return timer.elapsed_us();
+}
+
+/*! \brief Waits until every chunk of a file has at least \p parts parts outside of a server.
+ *
+ * Returns time of waiting in microseconds.
+ */
+static int64_t waitForParts(HarnessClient &client, const std::string &name,
+		const ScenarioConfig &config, uint32_t parts, NetworkAddress excluded) {
+	LizardClient::Inode inode = client.lookup(name);
+	Timer timer;
+	Timeout timeout{std::chrono::milliseconds(config.timeout_ms)};
+	for (uint32_t index = 0; index < chunkCount(config.fileSize);) {
+		auto locations = client.chunkLocations(inode, index);
+		uint32_t count = std::count_if(locations.begin(), locations.end(),
+				[&excluded](const ChunkTypeWithAddress &location) {
+					return !(location.address == excluded);
+				});
+		if (count >= parts) {
+			++index;
+			continue;
+		}
+		if (timeout.expired()) {
+			throw LocalClusterException("Chunk " + std::to_string(index) + " of " + name
+					+ " has only " + std::to_string(count) + " parts");
+		}
+		usleep(50000);
+	}
+	return timer.elapsed_us();
+}
+
+static uint32_t chunksOnServer(HarnessClient &client, const std::string &name,
+		const ScenarioConfig &config, NetworkAddress server) {
+	LizardClient::Inode inode = client.lookup(name);
+	uint32_t result = 0;
+	for (uint32_t index = 0; index < chunkCount(config.fileSize); ++index) {
+		auto locations = client.chunkLocations(inode, index);
+		result += std::any_of(locations.begin(), locations.end(),
+				[&server](const ChunkTypeWithAddress &location) {
+					return location.address == server;
+				});
+	}
+	return result;
+}
+
+/// Chooses a chunkserver with a part of the first chunk of a file, so that its crash matters
+static uint32_t chunkserverToKill(HarnessClient &client, const LocalCluster &cluster,
+		const std::string &name, const ScenarioConfig &config) {
+	auto locations = client.chunkLocations(client.lookup(name), 0);
+	for (uint32_t i = 0; i < config.cluster.chunkservers; ++i) {
+		for (const ChunkTypeWithAddress &location : locations) {
+			if (location.address == cluster.chunkserverAddress(i)) {
+				return i;
+			}
+		}
+	}
+	throw LocalClusterException("No chunkserver has the first chunk of " + name);
+}
+
+static void sequential(const ScenarioConfig &config, ScenarioReport &report) {
+	LocalCluster cluster(config.cluster);
+	cluster.start();
+	HarnessClient client(cluster.masterHost(), cluster.masterPort());
+	int64_t written_us = writeFile(client, "sequential", config);
+	report.emplace_back("write_MiB_per_s", mebibytesPerSecond(config.fileSize, written_us));
+	int64_t read_us = readFile(client, "sequential", config);
+	report.emplace_back("read_MiB_per_s", mebibytesPerSecond(config.fileSize, read_us));
+}
+
+static void randomAccess(const ScenarioConfig &config, ScenarioReport &report) {
+	LocalCluster cluster(config.cluster);
+	cluster.start();
+	HarnessClient client(cluster.masterHost(), cluster.masterPort());
+	writeFile(client, "random", config);
+
+	std::mt19937 generator(1234);
+	std::uniform_int_distribution<uint64_t> distribution(0,
+			config.fileSize / kRandomBlockSize - 1);
+	std::vector<uint8_t> buffer(kRandomBlockSize);
+	std::vector<int64_t> latencies_us;
+	latencies_us.reserve(config.randomOperations);
+
+	HarnessClient::File file = client.open("random", O_RDWR);
+	Timer timer;
+	for (uint32_t i = 0; i < config.randomOperations; ++i) {
+		uint64_t offset = distribution(generator) * kRandomBlockSize;
+		Timer latency;
+		fillBlock(buffer.data(), kRandomBlockSize, offset);
+		client.write(file, buffer.data(), kRandomBlockSize, offset);
+		latencies_us.push_back(latency.elapsed_us());
+	}
+	client.fsync(file);
+	report.emplace_back("write_ops_per_s",
+			operationsPerSecond(config.randomOperations, timer.elapsed_us()));
+	reportLatencies("write", std::move(latencies_us), report);
+
+	latencies_us.clear();
+	timer.reset();
+	for (uint32_t i = 0; i < config.randomOperations; ++i) {
+		uint64_t offset = distribution(generator) * kRandomBlockSize;
+		Timer latency;
+		if (client.read(file, buffer.data(), kRandomBlockSize, offset) != kRandomBlockSize) {
+			throw LocalClusterException("Short read at offset " + std::to_string(offset));
+		}
+		latencies_us.push_back(latency.elapsed_us());
+		checkBlock(buffer.data(), kRandomBlockSize, offset);
+	}
+	report.emplace_back("read_ops_per_s",
+			operationsPerSecond(config.randomOperations, timer.elapsed_us()));
+	reportLatencies("read", std::move(latencies_us), report);
+	client.close(file);
+}
+
+static void smallFiles(const ScenarioConfig &config, ScenarioReport &report) {
+	LocalCluster cluster(config.cluster);
+	cluster.start();
+	HarnessClient client(cluster.masterHost(), cluster.masterPort());
+	std::vector<uint8_t> buffer(kSmallFileSize);
+	fillBlock(buffer.data(), kSmallFileSize, 0);
+	std::vector<int64_t> latencies_us;
+	latencies_us.reserve(config.smallFiles);
+
+	Timer timer;
+	for (uint32_t i = 0; i < config.smallFiles; ++i) {
+		Timer latency;
+		HarnessClient::File file = client.create("small_" + std::to_string(i));
+		client.write(file, buffer.data(), kSmallFileSize, 0);
+		client.close(file);
+		latencies_us.push_back(latency.elapsed_us());
+	}
+	report.emplace_back("files_per_s", operationsPerSecond(config.smallFiles, timer.elapsed_us()));
+	reportLatencies("create", std::move(latencies_us), report);
+}
+
+static void ecRecovery(const ScenarioConfig &base, ScenarioReport &report) {
+	// One chunkserver more than parts, so that lost parts can be recovered somewhere
+	ScenarioConfig config = base;
+	config.cluster.goal = "$ec(2,1)";
+	config.cluster.chunkservers = std::max<uint32_t>(config.cluster.chunkservers, 4);
+	LocalCluster cluster(config.cluster);
+	cluster.start();
+	HarnessClient client(cluster.masterHost(), cluster.masterPort());
+	int64_t written_us = writeFile(client, "ec", config);
+	report.emplace_back("write_MiB_per_s", mebibytesPerSecond(config.fileSize, written_us));
+	waitForParts(client, "ec", config, 3, NetworkAddress());
+	int64_t read_us = readFile(client, "ec", config);
+	report.emplace_back("read_MiB_per_s", mebibytesPerSecond(config.fileSize, read_us));
+
+	uint32_t victim = chunkserverToKill(client, cluster, "ec", config);
+	NetworkAddress killed = cluster.chunkserverAddress(victim);
+	uint32_t lostParts = chunksOnServer(client, "ec", config, killed);
+	cluster.killChunkserver(victim);
+	cluster.waitForChunkservers(config.cluster.chunkservers - 1, config.timeout_ms);
+	int64_t degraded_us = readFile(client, "ec", config);
+	report.emplace_back("degraded_read_MiB_per_s",
+			mebibytesPerSecond(config.fileSize, degraded_us));
+	int64_t recovery_us = waitForParts(client, "ec", config, 3, killed);
+	report.emplace_back("lost_parts", lostParts);
+	report.emplace_back("recovery_s", recovery_us / 1e6);
+}
+
+static void rebuild(const ScenarioConfig &base, ScenarioReport &report) {
+	ScenarioConfig config = base;
+	config.cluster.goal = "_ _";
+	config.cluster.chunkservers = std::max<uint32_t>(config.cluster.chunkservers, 3);
+	LocalCluster cluster(config.cluster);
+	cluster.start();
+	HarnessClient client(cluster.masterHost(), cluster.masterPort());
+	writeFile(client, "rebuild", config);
+	waitForParts(client, "rebuild", config, 2, NetworkAddress());
+
+	uint32_t victim = chunkserverToKill(client, cluster, "rebuild", config);
+	NetworkAddress killed = cluster.chunkserverAddress(victim);
+	uint32_t lostCopies = chunksOnServer(client, "rebuild", config, killed);
+	cluster.killChunkserver(victim);
+	int64_t rebuild_us = waitForParts(client, "rebuild", config, 2, killed);
+	report.emplace_back("lost_copies", lostCopies);
+	report.emplace_back("rebuild_s", rebuild_us / 1e6);
+	// Chunks of the file are full except for the last one, so this is an approximation
+	report.emplace_back("rebuild_MiB_per_s", mebibytesPerSecond(
+			std::min<uint64_t>(uint64_t(lostCopies) * MFSCHUNKSIZE, config.fileSize),
+			rebuild_us));
+
+	cluster.startChunkserver(victim);
+	cluster.waitForChunkservers(config.cluster.chunkservers, config.timeout_ms);
+	int64_t read_us = readFile(client, "rebuild", config);
+	report.emplace_back("read_after_rebuild_MiB_per_s",
+			mebibytesPerSecond(config.fileSize, read_us));
+}
+
+const std::vector<Scenario> &allScenarios() {
+	static const std::vector<Scenario> scenarios = {
+		{"sequential", "sequential write and read of a file", sequential},
+		{"random", "random 4 KiB writes and reads of a file", randomAccess},
+		{"small_files", "creation of 4 KiB files", smallFiles},
+		{"ec_recovery", "reads of a $ec(2,1) file before and after a crash of a chunkserver,"
+				" recovery of lost parts", ecRecovery},
+		{"rebuild", "replication of a '_ _' file after a crash of a chunkserver", rebuild},
+	};
+	return scenarios;
+}
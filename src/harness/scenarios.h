@@ -0,0 +1,66 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "harness/local_cluster.h"
+
+struct ScenarioConfig {
+	ScenarioConfig()
+			: cluster(),
+			  fileSize(128 << 20),
+			  blockSize(1 << 20),
+			  randomOperations(2000),
+			  smallFiles(1000),
+			  timeout_ms(120000) {
+	}
+
+	/// Goal and number of chunkservers are overridden by scenarios which need specific ones
+	LocalCluster::Options cluster;
+	uint64_t fileSize;
+	/// Size of a single request of sequential scenarios
+	uint32_t blockSize;
+	uint32_t randomOperations;
+	uint32_t smallFiles;
+	/// Limit of time of waiting for the cluster, e.g. for chunks to be replicated
+	uint32_t timeout_ms;
+};
+
+/// Named numbers measured by a scenario, in the order in which they were measured
+typedef std::vector<std::pair<std::string, double>> ScenarioReport;
+
+struct Scenario {
+	std::string name;
+	std::string description;
+	std::function<void(const ScenarioConfig&, ScenarioReport&)> run;
+};
+
+/*! \brief All scenarios, each one starts its own cluster and its own client.
+ *
+ * Scenarios check data which they read and throw an exception if it is wrong or if the
+ * cluster misbehaves. A client can be created only once in a process (see HarnessClient),
+ * so every scenario has to be run in a separate process.
+ */
+const std::vector<Scenario> &allScenarios();
@@ -0,0 +1,91 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/cache_leases.h"
+
+#include <algorithm>
+#include <utility>
+
+void CacheLeases::grant(uint32_t inode, uint32_t sessionid, uint32_t expires) {
+	LeaseList &list = leases_[inode];
+	auto it = std::find_if(list.begin(), list.end(), [sessionid](const Lease &lease) {
+		return lease.sessionid == sessionid;
+	});
+	if (it == list.end()) {
+		list.push_back(Lease{sessionid, expires});
+		++size_;
+	} else if (it->expires < expires) {
+		it->expires = expires;
+	} else {
+		return;
+	}
+	expirations_[expires].push_back(inode);
+}
+
+void CacheLeases::changed(uint32_t inode, uint32_t now) {
+	auto it = leases_.find(inode);
+	if (it == leases_.end()) {
+		return;
+	}
+	for (const Lease &lease : it->second) {
+		if (lease.expires >= now) {
+			invalidations_[lease.sessionid].push_back(inode);
+		}
+	}
+	size_ -= it->second.size();
+	leases_.erase(it);
+}
+
+CacheLeases::Invalidations CacheLeases::takeInvalidations() {
+	Invalidations result;
+	std::swap(result, invalidations_);
+	return result;
+}
+
+bool CacheLeases::takeSessionInvalidations(Invalidations &invalidations, uint32_t sessionid,
+		std::vector<uint32_t> &inodes) {
+	auto it = invalidations.find(sessionid);
+	if (it == invalidations.end()) {
+		return false;
+	}
+	inodes = std::move(it->second);
+	invalidations.erase(it);
+	return true;
+}
+
+void CacheLeases::removeExpired(uint32_t now) {
+	while (!expirations_.empty() && expirations_.begin()->first < now) {
+		for (uint32_t inode : expirations_.begin()->second) {
+			auto it = leases_.find(inode);
+			if (it == leases_.end()) {
+				continue;
+			}
+			LeaseList &list = it->second;
+			auto end = std::remove_if(list.begin(), list.end(), [now](const Lease &lease) {
+				return lease.expires < now;
+			});
+			size_ -= list.end() - end;
+			list.erase(end, list.end());
+			if (list.empty()) {
+				leases_.erase(it);
+			}
+		}
+		expirations_.erase(expirations_.begin());
+	}
+}
@@ -0,0 +1,92 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "common/small_vector.h"
+
+/*! \brief Registry of inodes cached by clients.
+ *
+ * A session which got attributes of an inode (or looked up a name in a directory) holds
+ * a lease on this inode until it expires. When the inode changes, all valid leases are
+ * dropped and holders are collected, so that they can be told to forget what they cached.
+ * Time is measured in seconds, as returned by main_time().
+ */
+class CacheLeases {
+public:
+	/// Inodes which should be invalidated, per session id.
+	typedef std::unordered_map<uint32_t, std::vector<uint32_t>> Invalidations;
+
+	CacheLeases() : size_(0) {}
+
+	/*! \brief Grants (or extends) a lease.
+	 * \param inode Inode cached by the session.
+	 * \param sessionid Session holding the lease.
+	 * \param expires Time when the lease ends.
+	 */
+	void grant(uint32_t inode, uint32_t sessionid, uint32_t expires);
+
+	/*! \brief Drops all leases on a changed inode.
+	 * Sessions with valid leases are remembered and returned by takeInvalidations().
+	 */
+	void changed(uint32_t inode, uint32_t now);
+
+	/// Returns and forgets invalidations collected since the previous call.
+	Invalidations takeInvalidations();
+
+	/*! \brief Moves inodes to be invalidated by a session out of \param invalidations.
+	 * A client may use many connections in one session, only the first connection asking
+	 * for its session gets the inodes.
+	 * \return true if there was anything to invalidate.
+	 */
+	static bool takeSessionInvalidations(Invalidations &invalidations, uint32_t sessionid,
+			std::vector<uint32_t> &inodes);
+
+	/// Drops leases which expired before \param now.
+	void removeExpired(uint32_t now);
+
+	/// Returns true if nobody holds a lease, so there is nothing to invalidate.
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	/// Returns number of leases.
+	std::size_t size() const {
+		return size_;
+	}
+
+private:
+	struct Lease {
+		uint32_t sessionid;
+		uint32_t expires;
+	};
+	typedef small_vector<Lease, 2> LeaseList;
+
+	std::unordered_map<uint32_t, LeaseList> leases_;
+	/// Inodes with a lease ending at a given time (may be outdated by extensions)
+	std::map<uint32_t, std::vector<uint32_t>> expirations_;
+	Invalidations invalidations_;
+	std::size_t size_;
+};
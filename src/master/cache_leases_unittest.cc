@@ -0,0 +1,89 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/cache_leases.h"
+
+#include <gtest/gtest.h>
+
+TEST(CacheLeasesTests, ChangeInvalidatesHolders) {
+	CacheLeases leases;
+	EXPECT_TRUE(leases.empty());
+	leases.grant(10, 1, 100);
+	leases.grant(10, 2, 100);
+	leases.grant(11, 1, 100);
+	leases.grant(10, 1, 110);  // extension, not a new lease
+	EXPECT_EQ(3U, leases.size());
+
+	leases.changed(10, 50);
+	leases.changed(12, 50);
+	EXPECT_EQ(1U, leases.size());
+	auto invalidations = leases.takeInvalidations();
+	ASSERT_EQ(2U, invalidations.size());
+	EXPECT_EQ(std::vector<uint32_t>({10}), invalidations[1]);
+	EXPECT_EQ(std::vector<uint32_t>({10}), invalidations[2]);
+	EXPECT_TRUE(leases.takeInvalidations().empty());
+
+	// Leases were dropped, another change is not reported
+	leases.changed(10, 51);
+	EXPECT_TRUE(leases.takeInvalidations().empty());
+}
+
+TEST(CacheLeasesTests, ExpiredLeases) {
+	CacheLeases leases;
+	leases.grant(10, 1, 100);
+	leases.grant(10, 2, 200);
+	leases.grant(11, 1, 100);
+	leases.grant(11, 1, 300);
+
+	// Expired lease is not reported even if it was not removed yet
+	leases.changed(10, 150);
+	auto invalidations = leases.takeInvalidations();
+	ASSERT_EQ(1U, invalidations.size());
+	EXPECT_EQ(std::vector<uint32_t>({10}), invalidations[2]);
+
+	leases.removeExpired(250);
+	EXPECT_EQ(1U, leases.size());
+	leases.removeExpired(301);
+	EXPECT_TRUE(leases.empty());
+	leases.changed(11, 301);
+	EXPECT_TRUE(leases.takeInvalidations().empty());
+}
+
+TEST(CacheLeasesTests, InvalidationsAreTakenOncePerSession) {
+	CacheLeases leases;
+	leases.grant(10, 1, 100);
+	leases.grant(11, 1, 100);
+	leases.grant(10, 2, 100);
+	leases.changed(10, 50);
+	leases.changed(11, 50);
+	auto invalidations = leases.takeInvalidations();
+
+	// Session 1 uses two connections, session 2 one and session 3 holds no leases
+	std::vector<std::pair<uint32_t, uint32_t>> connections{{1, 1}, {1, 2}, {2, 3}, {3, 4}};
+	std::map<uint32_t, std::vector<uint32_t>> sent;
+	for (const auto &connection : connections) {
+		std::vector<uint32_t> inodes;
+		if (CacheLeases::takeSessionInvalidations(invalidations, connection.first, inodes)) {
+			EXPECT_TRUE(sent.insert({connection.second, inodes}).second);
+		}
+	}
+	std::map<uint32_t, std::vector<uint32_t>> expected{{1, {10, 11}}, {3, {10}}};
+	EXPECT_EQ(expected, sent);
+	EXPECT_TRUE(invalidations.empty());
+}
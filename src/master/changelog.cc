@@ -27,8 +27,10 @@
 #include "common/cfg.h"
 #include "common/main.h"
 #include "common/metadata.h"
+#include "common/metrics.h"
 #include "common/rotate_files.h"
 #include "common/slogger.h"
+#include "common/time_utils.h"
 
 /// Base name of a changelog file.
 /// Sometthing like "changelog.mfs" or "changelog_ml.mfs"
@@ -57,6 +59,10 @@ void changelog_rotate() {
 }
 
 void changelog(uint64_t version, const char* entry) {
+	static metrics::Histogram &writeTime = metrics::registry().histogram(
+			"lizardfs_master_changelog_write_duration_microseconds",
+			"Time of writing an entry to the changelog");
+	Timer timer;
 	if (fd==NULL) {
 		fd = fopen(gChangelogFilename.c_str(), "a");
 		if (!fd) {
@@ -70,6 +76,7 @@ void changelog(uint64_t version, const char* entry) {
 			fflush(fd);
 		}
 	}
+	writeTime.record(timer.elapsed_us());
 }
 
 static void changelog_reload(void) {
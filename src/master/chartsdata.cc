@@ -33,6 +33,7 @@
 #include "master/chunks.h"
 #include "master/filesystem.h"
 #include "master/filesystem_operations.h"
+#include "master/filesystem_periodic.h"
 #include "master/matoclserv.h"
 
 #if defined(LIZARDFS_HAVE_GETRUSAGE) && defined(LIZARDFS_HAVE_STRUCT_RUSAGE_RU_MAXRSS)
@@ -90,8 +91,9 @@
 #define CHARTS_PACKETSSENT 22
 #define CHARTS_BYTESRCVD 23
 #define CHARTS_BYTESSENT 24
+#define CHARTS_PURGE 25
 
-#define CHARTS 25
+#define CHARTS 26
 
 /* name , join mode , percent , scale , multiplier , divisor */
 #define STATDEFS { \
@@ -120,6 +122,7 @@
 	{"psent"        ,CHARTS_MODE_ADD,0,CHARTS_SCALE_MILI ,1000,60}, \
 	{"brcvd"        ,CHARTS_MODE_ADD,0,CHARTS_SCALE_MILI ,8000,60}, \
 	{"bsent"        ,CHARTS_MODE_ADD,0,CHARTS_SCALE_MILI ,8000,60}, \
+	{"purge"        ,CHARTS_MODE_ADD,0,CHARTS_SCALE_NONE ,   1, 1}, \
 	{NULL           ,0              ,0,0                 ,   0, 0}  \
 };
 
@@ -155,7 +158,7 @@ uint64_t chartsdata_memusage(void) {
 void chartsdata_refresh(void) {
 	uint64_t data[CHARTS];
 	std::array<uint32_t, FsStats::Size> fsdata;
-	uint32_t i,del,repl; //,bin,bout,opr,opw,dbr,dbw,dopr,dopw,repl;
+	uint32_t i,del,repl,purged; //,bin,bout,opr,opw,dbr,dbw,dopr,dopw,repl;
 #ifdef CPU_USAGE
 	struct itimerval uc,pc;
 	uint32_t ucusec,pcusec;
@@ -236,6 +239,8 @@ void chartsdata_refresh(void) {
 		data[CHARTS_STATFS + i] = fsdata[i];
 	}
 	matoclserv_stats(data+CHARTS_PACKETSRCVD);
+	fs_trash_purge_stats(&purged);
+	data[CHARTS_PURGE] = purged;
 
 	charts_add(data,main_time()-60);
 }
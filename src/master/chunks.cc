@@ -28,6 +28,8 @@
 #include <sys/types.h>
 #include <syslog.h>
 #include <unistd.h>
+#include <numeric>
+#include <tuple>
 #include <unordered_map>
 #include <algorithm>
 #include <deque>
@@ -45,6 +47,7 @@
 #include "common/loop_watchdog.h"
 #include "common/main.h"
 #include "common/massert.h"
+#include "common/metrics.h"
 #include "common/slice_traits.h"
 #include "common/small_vector.h"
 #include "master/chunkserver_db.h"
@@ -52,6 +55,8 @@
 #include "master/chunk_goal_counters.h"
 #include "master/filesystem.h"
 #include "master/goal_cache.h"
+#include "master/rebalance_planner.h"
+#include "master/replication_queue.h"
 #include "protocol/MFSCommunication.h"
 
 #ifdef METARESTORE
@@ -198,6 +203,7 @@ static uint32_t ChunksLoopPeriod;
 static uint32_t ChunksLoopTimeout;
 static double   AcceptableDifference;
 static bool     RebalancingBetweenLabels = false;
+static uint32_t RebalancingBandwidthLimit_KBps = 0;
 
 static uint32_t jobsnorepbefore;
 
@@ -233,7 +239,7 @@ public:
 	uint32_t lockid;
 	uint32_t lockedto;
 #ifndef METARESTORE
-	uint8_t inEndangeredQueue:1;
+	uint8_t replicationQueueLevel:3; // level in replicationQueue + 1, 0 if not queued
 	uint8_t needverincrease:1;
 	uint8_t interrupted:1;
 	uint8_t operation:3;
@@ -251,7 +257,7 @@ public:
 	static ChunksReplicationState allChunksReplicationState;
 	static uint64_t count;
 	static uint64_t allFullChunkCopies[CHUNK_MATRIX_SIZE][CHUNK_MATRIX_SIZE];
-	static std::deque<Chunk *> endangeredChunks;
+	static ReplicationQueue<Chunk *> replicationQueue;
 	static GoalCache goalCache;
 #endif
 
@@ -264,7 +270,7 @@ public:
 		lockedto = 0;
 		checksum = 0;
 #ifndef METARESTORE
-		inEndangeredQueue = 0;
+		replicationQueueLevel = 0;
 		needverincrease = 1;
 		interrupted = 0;
 		operation = Chunk::NONE;
@@ -359,6 +365,7 @@ public:
 	// Updates statistics of all chunks
 	void updateStats(bool remove_from_stats = true) {
 		int oldAllMissingParts = allMissingParts_;
+		bool wasEndangered = isEndangered();
 
 		if (remove_from_stats) {
 			removeFromStats();
@@ -383,25 +390,40 @@ public:
 		allRedundantParts_ = std::min(kMaxStatCount, all.countPartsToRemove());
 		copiesInStats_ = std::min(kMaxStatCount, ChunkCopiesCalculator::getFullCopiesCount(g));
 
-		/* Enqueue a chunk as endangered only if:
-		 * 1. Endangered chunks prioritization is on (limit > 0)
-		 * 2. Limit of endangered chunks in queue is not reached
-		 * 3. Chunk has more missing parts than it used to
-		 * 4. Chunk is endangered
-		 * 5. It is not already in queue
-		 * By checking conditions below we assert no repetitions in endangered queue. */
-		if (gEndangeredChunksServingLimit > 0
-				&& endangeredChunks.size() < gEndangeredChunksMaxCapacity
-				&& allMissingParts_ > oldAllMissingParts
-				&& allAvailabilityState_ == ChunksAvailabilityState::kEndangered
-				&& !inEndangeredQueue) {
-			inEndangeredQueue = 1;
-			endangeredChunks.push_back(this);
+		// Lost parts (disconnected or damaged servers, lost chunks) are repaired with priority,
+		// a queued chunk which got worse is moved to a higher level
+		if (allMissingParts_ > oldAllMissingParts || (isEndangered() && !wasEndangered)) {
+			enqueueForReplication();
 		}
 
 		addToStats();
 	}
 
+	/* Enqueue a chunk for replication with priority only if:
+	 * 1. Prioritization is on (limit > 0)
+	 * 2. Limit of chunks in queue is not reached
+	 * 3. Chunk has missing parts and can be recovered
+	 * 4. It is not already in queue on the same or a higher level
+	 * A chunk queued again on a higher level leaves an entry on the lower one, which is
+	 * recognized as stale by isQueuedForReplication and skipped when popped. */
+	void enqueueForReplication() {
+		if (gEndangeredChunksServingLimit > 0
+				&& replicationQueue.size() < gEndangeredChunksMaxCapacity
+				&& allMissingParts_ > 0
+				&& allAvailabilityState_ != ChunksAvailabilityState::kLost) {
+			int level = replicationPriority(isEndangered(), allMissingParts_, copiesInStats_);
+			if (replicationQueueLevel == 0 || level + 1 < replicationQueueLevel) {
+				replicationQueueLevel = level + 1;
+				replicationQueue.push(this, level);
+			}
+		}
+	}
+
+	/// Checks if an entry popped from the given level of replicationQueue is up to date
+	bool isQueuedForReplication(int level) const {
+		return replicationQueueLevel == level + 1;
+	}
+
 	bool isSafe() const {
 		return allAvailabilityState_ == ChunksAvailabilityState::kSafe;
 	}
@@ -489,7 +511,9 @@ constexpr int Chunk::kMaxStatCount;
 
 #ifndef METARESTORE
 
-std::deque<Chunk *> Chunk::endangeredChunks;
+ReplicationQueue<Chunk *> Chunk::replicationQueue;
+static_assert(ReplicationQueue<Chunk *>::kLevelCount < 8,
+		"Chunk::replicationQueueLevel is too narrow");
 GoalCache Chunk::goalCache(10000);
 ChunksAvailabilityState Chunk::allChunksAvailability;
 ChunksReplicationState Chunk::allChunksReplicationState;
@@ -744,7 +768,7 @@ static inline Chunk *chunk_malloc() {
 static inline void chunk_free(Chunk *p) {
 	p->next = gChunksMetadata->chfreehead;
 	gChunksMetadata->chfreehead = p;
-	p->inEndangeredQueue = 0;
+	p->replicationQueueLevel = 0;
 }
 #endif /* METARESTORE */
 
@@ -1037,15 +1061,37 @@ int chunk_get_partstomodify(uint64_t chunkid, int &recover, int &remove) {
 	return LIZARDFS_STATUS_OK;
 }
 
+int chunk_get_availability_concurrently(uint64_t chunkid, uint8_t &vcopies, int &recover) {
+	vcopies = 0;
+	recover = 0;
+	// chunk_find can't be used, it modifies its cache
+	Chunk *c = gChunksMetadata->chunkhash[HASHPOS(chunkid)];
+	while (c != nullptr && c->chunkid != chunkid) {
+		c = c->next;
+	}
+	if (c == nullptr) {
+		return LIZARDFS_ERROR_NOCHUNK;
+	}
+	for (const ChunkPart &part : c->parts) {
+		if (csdb_find(part.csid)->eptr == nullptr) {
+			return LIZARDFS_ERROR_TEMP_NOTPOSSIBLE;
+		}
+	}
+	vcopies = c->getFullCopiesCount();
+	recover = c->countMissingParts();
+	return LIZARDFS_STATUS_OK;
+}
+
 uint8_t chunk_multi_modify(uint64_t ochunkid, uint32_t *lockid, uint8_t goal,
 		bool usedummylockid, bool quota_exceeded, uint8_t *opflag, uint64_t *nchunkid,
-		uint32_t min_server_version = 0) {
+		uint32_t min_server_version, uint32_t client_ip) {
 	Chunk *c = NULL;
 	if (ochunkid == 0) { // new chunk
 		if (quota_exceeded) {
 			return LIZARDFS_ERROR_QUOTA;
 		}
-		auto serversWithChunkTypes = matocsserv_getservers_for_new_chunk(goal, min_server_version);
+		auto serversWithChunkTypes = matocsserv_getservers_for_new_chunk(goal,
+				min_server_version, client_ip);
 		if (serversWithChunkTypes.empty()) {
 			uint16_t uscount,tscount;
 			double minusage,maxusage;
@@ -1399,25 +1445,36 @@ const ChunksAvailabilityState& chunk_get_availability_state() {
 	return Chunk::allChunksAvailability;
 }
 
+/*! \brief Location of a chunk part, ordered by preference for the client.
+ *
+ * Servers in the same topology distance are ordered by their load. Load is compared in
+ * powers of two, so that reads of a hot chunk are still spread randomly between servers with
+ * similar load instead of all going to the one which was the least loaded a second ago.
+ */
 struct ChunkLocation {
 	ChunkLocation() : chunkType(slice_traits::standard::ChunkPartType()),
-			chunkserver_version(0), distance(0), random(0) {
+			chunkserver_version(0), distance(0), loadClass(0), random(0) {
 	}
 	NetworkAddress address;
 	ChunkPartType chunkType;
 	uint32_t chunkserver_version;
 	uint32_t distance;
+	uint32_t loadClass;
 	uint32_t random;
 	MediaLabel label;
-	bool operator<(const ChunkLocation& other) const {
-		if (distance < other.distance) {
-			return true;
-		} else if (distance > other.distance) {
-			return false;
-		} else {
-			return random < other.random;
+
+	void setLoad(uint32_t load) {
+		loadClass = 0;
+		while (load > 0) {
+			++loadClass;
+			load >>= 1;
 		}
 	}
+
+	bool operator<(const ChunkLocation& other) const {
+		return std::make_tuple(distance, loadClass, random)
+				< std::make_tuple(other.distance, other.loadClass, other.random);
+	}
 };
 
 // TODO deduplicate
@@ -1447,6 +1504,7 @@ int chunk_getversionandlocations(uint64_t chunkid, uint32_t currentIp, uint32_t&
 				chunkserverLocation.distance =
 						topology_distance(chunkserverLocation.address.ip, currentIp);
 						// in the future prepare more sophisticated distance function
+				chunkserverLocation.setLoad(matocsserv_get_load(part.server()));
 				chunkserverLocation.random = rnd<uint32_t>();
 				chunkLocation.push_back(chunkserverLocation);
 				cnt++;
@@ -1486,6 +1544,7 @@ int chunk_getversionandlocations(uint64_t chunkid, uint32_t currentIp, uint32_t&
 				chunkserverLocation.distance =
 						topology_distance(chunkserverLocation.address.ip, currentIp);
 						// in the future prepare more sophisticated distance function
+				chunkserverLocation.setLoad(matocsserv_get_load(part.server()));
 				chunkserverLocation.random = rnd<uint32_t>();
 				chunkLocation.push_back(chunkserverLocation);
 				cnt++;
@@ -1684,10 +1743,20 @@ void chunk_got_delete_status(matocsserventry *ptr, uint64_t chunkId, ChunkPartTy
 	}
 }
 
+static void chunk_rebalance_replication_status(uint64_t chunkId, uint16_t csid,
+		ChunkPartType chunkType, bool success);
+
 void chunk_got_replicate_status(matocsserventry *ptr, uint64_t chunkId, uint32_t chunkVersion,
 		ChunkPartType chunkType, uint8_t status) {
+	chunk_rebalance_replication_status(chunkId, matocsserv_get_csdb(ptr)->csid, chunkType,
+			status == 0);
 	Chunk *c = chunk_find(chunkId);
-	if (c == NULL || status != 0) {
+	if (c == NULL) {
+		return;
+	}
+	if (status != 0) {
+		// The chunk was taken off the replication queue when the replication started
+		c->enqueueForReplication();
 		return;
 	}
 
@@ -1707,6 +1776,8 @@ void chunk_got_replicate_status(matocsserventry *ptr, uint64_t chunkId, uint32_t
 	const uint8_t state = (c->isLocked() || chunkVersion != c->version) ? ChunkPart::INVALID : ChunkPart::VALID;
 	c->parts.push_back(ChunkPart(server_csid, state, chunkVersion, chunkType));
 	c->updateStats();
+	// Missing parts drop here, so updateStats doesn't queue the chunk for the remaining ones
+	c->enqueueForReplication();
 }
 
 void chunk_operation_status(Chunk *c, ChunkPartType chunkType, uint8_t status,matocsserventry *ptr) {
@@ -1816,6 +1887,10 @@ public:
 	void doChunkJobs(Chunk *c, uint16_t serverCount);
 	void mainLoop();
 
+	/// Counts progress of the rebalancing plan when its replication is finished.
+	void rebalanceReplicationStatus(uint64_t chunkId, uint16_t csid, ChunkPartType type,
+			bool success);
+
 private:
 	typedef std::vector<ServerWithUsage> ServersWithUsage;
 
@@ -1841,6 +1916,13 @@ private:
 	bool replicateChunkPart(Chunk *c, Goal::Slice::Type slice_type, int slice_part, ChunkCopiesCalculator& calc);
 	bool removeUnneededChunkPart(Chunk *c, Goal::Slice::Type slice_type, int slice_part, ChunkCopiesCalculator& calc);
 	bool rebalanceChunkParts(Chunk *c, ChunkCopiesCalculator& calc, bool only_todel);
+	bool moveChunkPartByPlan(Chunk *c, ChunkCopiesCalculator& calc);
+	void updateRebalancePlan();
+
+	/// Plan is computed again after this many seconds even if it wasn't completed.
+	static constexpr uint32_t kRebalancePlanLifetime = 3600;
+	/// Progress of rebalancing is logged with this period (in seconds).
+	static constexpr uint32_t kRebalanceReportPeriod = 60;
 
 	loop_info inforec_;
 	uint32_t deleteNotDone_;
@@ -1854,6 +1936,35 @@ private:
 	/// For each label, all servers with this label sorted by disk usage.
 	std::map<MediaLabel, ServersWithUsage> labeledSortedServers_;
 
+	/// All chunkservers by their csid.
+	std::map<uint16_t, matocsserventry *> serversById_;
+
+	/// Copy of a chunk part moved from one server to another according to rebalancePlan_.
+	struct RebalancedPart {
+		uint16_t source;
+		uint16_t destination;
+		ChunkPartType type;
+	};
+
+	/// Moves planned by RebalancePlanner for each source server.
+	std::map<uint16_t, std::vector<RebalancePlanner::Move>> rebalancePlan_;
+	/// Ids of servers for which rebalancePlan_ was computed, sorted.
+	std::vector<uint16_t> rebalancePlanServers_;
+	uint32_t rebalancePlanTime_;
+	/// Replications started by moveChunkPartByPlan, by chunk id.
+	std::unordered_map<uint64_t, RebalancedPart> rebalanceReplications_;
+	/// Replicated parts which are to be removed from their source servers, by chunk id.
+	std::unordered_map<uint64_t, RebalancedPart> rebalanceRemovals_;
+	uint64_t rebalancePlannedBytes_;
+	uint64_t rebalanceMovedBytes_;
+	uint64_t rebalanceReportedBytes_;
+	uint32_t rebalanceReportTime_;
+	/// Average size of a chunk, used to estimate amount of moved data.
+	uint64_t chunkSizeEstimate_;
+	/// Number of bytes which can be moved now if bandwidth is limited.
+	int64_t rebalanceBudget_;
+	uint32_t rebalanceBudgetTime_;
+
 	MainLoopStack stack_;
 };
 
@@ -1861,7 +1972,15 @@ ChunkWorker::ChunkWorker()
 		: deleteNotDone_(0),
 		  deleteDone_(0),
 		  prevToDeleteCount_(0),
-		  deleteLoopCount_(0) {
+		  deleteLoopCount_(0),
+		  rebalancePlanTime_(0),
+		  rebalancePlannedBytes_(0),
+		  rebalanceMovedBytes_(0),
+		  rebalanceReportedBytes_(0),
+		  rebalanceReportTime_(0),
+		  chunkSizeEstimate_(MFSCHUNKSIZE),
+		  rebalanceBudget_(0),
+		  rebalanceBudgetTime_(0) {
 	memset(&inforec_,0,sizeof(loop_info));
 	stack_.current_bucket = 0;
 }
@@ -1900,11 +2019,108 @@ void ChunkWorker::doEveryLoopTasks() {
 }
 
 void ChunkWorker::doEverySecondTasks() {
+	static metrics::Histogram &serversTime = metrics::registry().histogram(
+			"lizardfs_master_chunk_loop_duration_microseconds",
+			"Time of phases of the loop which checks and repairs chunks", "phase=\"servers\"");
+	Timer timer;
 	sortedServers_ = matocsserv_getservers_sorted();
 	labeledSortedServers_.clear();
+	serversById_.clear();
 	for (const ServerWithUsage& sw : sortedServers_) {
 		labeledSortedServers_[sw.label].push_back(sw);
+		serversById_[matocsserv_get_csdb(sw.server)->csid] = sw.server;
+	}
+	updateRebalancePlan();
+	serversTime.record(timer.elapsed_us());
+}
+
+void ChunkWorker::updateRebalancePlan() {
+	uint32_t now = main_time();
+	if (RebalancingBandwidthLimit_KBps > 0 && now != rebalanceBudgetTime_) {
+		// Unused bandwidth is accumulated for at most one second
+		int64_t limit = int64_t(RebalancingBandwidthLimit_KBps) * 1024;
+		rebalanceBudget_ = std::min(rebalanceBudget_ + limit * (now - rebalanceBudgetTime_), limit);
+		rebalanceBudgetTime_ = now;
+	}
+
+	bool finished = rebalanceMovedBytes_ >= rebalancePlannedBytes_;
+	if (!finished && now >= rebalanceReportTime_ + kRebalanceReportPeriod) {
+		double speed = double(rebalanceMovedBytes_ - rebalanceReportedBytes_) /
+		               (now - rebalanceReportTime_);
+		uint64_t remaining = rebalancePlannedBytes_ - rebalanceMovedBytes_;
+		syslog(LOG_NOTICE, "rebalancing: moved %" PRIu64 " MiB, %" PRIu64 " MiB remaining, "
+		       "%.1f MiB/s, estimated time left: %s",
+		       rebalanceMovedBytes_ >> 20, remaining >> 20, speed / (1 << 20),
+		       speed > 0 ? (std::to_string(uint64_t(remaining / speed)) + " s").c_str() : "unknown");
+		rebalanceReportTime_ = now;
+		rebalanceReportedBytes_ = rebalanceMovedBytes_;
+	}
+
+	std::vector<uint16_t> serverIds;
+	for (const auto &server : serversById_) {
+		serverIds.push_back(server.first); // sorted, as keys of a map
+	}
+	if (!finished && now < rebalancePlanTime_ + kRebalancePlanLifetime
+			&& serverIds == rebalancePlanServers_) {
+		return;
+	}
+
+	std::vector<RebalancePlanner::Server> servers;
+	uint64_t usedSpace = 0, chunkCount = 0;
+	for (const ServerWithUsage& sw : sortedServers_) {
+		servers.push_back(RebalancePlanner::Server{matocsserv_get_csdb(sw.server)->csid,
+				sw.label, matocsserv_get_ip(sw.server), sw.usedSpace, sw.totalSpace});
+		usedSpace += sw.usedSpace;
+		chunkCount += sw.chunkCount;
+	}
+	chunkSizeEstimate_ = chunkCount > 0 ? std::max<uint64_t>(usedSpace / chunkCount, 1)
+	                                    : MFSCHUNKSIZE;
+	auto moves = RebalancePlanner::plan(servers, AcceptableDifference, RebalancingBetweenLabels,
+			chunkSizeEstimate_, topology_distance);
+
+	rebalancePlan_.clear();
+	rebalanceReplications_.clear();
+	rebalanceRemovals_.clear();
+	rebalancePlannedBytes_ = 0;
+	rebalanceMovedBytes_ = 0;
+	for (const auto &move : moves) {
+		rebalancePlan_[move.source].push_back(move);
+		rebalancePlannedBytes_ += move.bytes;
+	}
+	rebalancePlanTime_ = now;
+	rebalancePlanServers_ = std::move(serverIds);
+	rebalanceReportTime_ = now;
+	rebalanceReportedBytes_ = 0;
+	if (!moves.empty()) {
+		syslog(LOG_NOTICE, "rebalancing: planned %zu moves of %" PRIu64 " MiB between %zu servers",
+		       moves.size(), rebalancePlannedBytes_ >> 20, servers.size());
+	}
+}
+
+void ChunkWorker::rebalanceReplicationStatus(uint64_t chunkId, uint16_t csid,
+		ChunkPartType type, bool success) {
+	auto replication = rebalanceReplications_.find(chunkId);
+	if (replication == rebalanceReplications_.end()
+			|| replication->second.destination != csid || replication->second.type != type) {
+		return;
+	}
+	RebalancedPart part = replication->second;
+	rebalanceReplications_.erase(replication);
+	if (!success) {
+		return;
+	}
+	auto plan = rebalancePlan_.find(part.source);
+	if (plan != rebalancePlan_.end()) {
+		for (auto &move : plan->second) {
+			if (move.destination == part.destination) {
+				uint64_t bytes = std::min(move.bytes, chunkSizeEstimate_);
+				move.bytes -= bytes;
+				rebalanceMovedBytes_ += bytes;
+				break;
+			}
+		}
 	}
+	rebalanceRemovals_[chunkId] = part;
 }
 
 static bool chunkPresentOnServer(Chunk *c, matocsserventry *server) {
@@ -1964,6 +2180,28 @@ bool ChunkWorker::tryReplication(Chunk *c, ChunkPartType part_to_recover,
 		return false;
 	}
 
+	// Destination reads each part from the first server on the list which has it, so the
+	// closest servers go first to keep replication traffic in the lowest level of the network.
+	uint32_t destination_ip = matocsserv_get_ip(destination_server);
+	auto closer = [destination_ip](matocsserventry *a, matocsserventry *b) {
+		return topology_distance(matocsserv_get_ip(a), destination_ip)
+				< topology_distance(matocsserv_get_ip(b), destination_ip);
+	};
+	std::vector<uint32_t> order(all_servers.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::random_shuffle(order.begin(), order.end());
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return closer(all_servers[a], all_servers[b]);
+	});
+	std::vector<matocsserventry *> sorted_servers;
+	std::vector<ChunkPartType> sorted_parts;
+	for (uint32_t i : order) {
+		sorted_servers.push_back(all_servers[i]);
+		sorted_parts.push_back(all_parts[i]);
+	}
+	all_servers.swap(sorted_servers);
+	all_parts.swap(sorted_parts);
+
 	if (destination_version >= kFirstECVersion ||
 	    (destination_version >= kFirstXorVersion && slice_traits::isXor(part_to_recover))) {
 		matocsserv_send_liz_replicatechunk(destination_server, c->chunkid, c->version,
@@ -1981,8 +2219,10 @@ bool ChunkWorker::tryReplication(Chunk *c, ChunkPartType part_to_recover,
 		return false;
 	}
 
+	std::random_shuffle(standard_servers.begin(), standard_servers.end());
 	matocsserv_send_replicatechunk(destination_server, c->chunkid, c->version,
-	                               standard_servers[rnd_ranged<uint32_t>(standard_servers.size())]);
+	                               *std::min_element(standard_servers.begin(),
+	                                                 standard_servers.end(), closer));
 
 	stats_replications++;
 	c->needverincrease = 1;
@@ -2136,14 +2376,10 @@ bool ChunkWorker::replicateChunkPart(Chunk *c, Goal::Slice::Type slice_type, int
 	}
 	if (tried_to_replicate) {
 		inforec_.notdone.copy_undergoal++;
-		// Enqueue chunk again only if it was taken directly from endangered chunks queue
-		// to avoid repetitions. If it was taken from chunk hashmap, inEndangeredQueue bit
-		// would be still up.
-		if (gEndangeredChunksServingLimit > 0 && Chunk::endangeredChunks.size() < gEndangeredChunksMaxCapacity
-			&& !c->inEndangeredQueue && calc.getState() == ChunksAvailabilityState::kEndangered) {
-			c->inEndangeredQueue = 1;
-			Chunk::endangeredChunks.push_back(c);
-		}
+		// Enqueue chunk again only if it was taken directly from replication queue
+		// to avoid repetitions. If it was taken from chunk hashmap, its queue level
+		// would be still set.
+		c->enqueueForReplication();
 	}
 
 	return false;
@@ -2156,8 +2392,17 @@ bool ChunkWorker::removeUnneededChunkPart(Chunk *c, Goal::Slice::Type slice_type
 		return false;
 	}
 
+	// A part copied according to the rebalancing plan is removed from its source server
+	auto removal = rebalanceRemovals_.find(c->chunkid);
+	const RebalancedPart *rebalanced = nullptr;
+	if (removal != rebalanceRemovals_.end()
+			&& removal->second.type == ChunkPartType(slice_type, slice_part)) {
+		rebalanced = &removal->second;
+	}
+
 	ChunkPart *candidate = nullptr;
 	bool candidate_todel = false;
+	bool candidate_rebalanced = false;
 	double candidate_usage = std::numeric_limits<double>::lowest();
 	for (auto &part : c->parts) {
 		if (!part.is_valid() || part.type != ChunkPartType(slice_type, slice_part)) {
@@ -2173,16 +2418,22 @@ bool ChunkWorker::removeUnneededChunkPart(Chunk *c, Goal::Slice::Type slice_type
 		}
 
 		bool is_todel = part.is_todel();
+		bool is_rebalanced = rebalanced && part.csid == rebalanced->source;
 		double usage = matocsserv_get_usage(part.server());
-		if (std::make_pair(is_todel, usage) > std::make_pair(candidate_todel, candidate_usage)) {
+		if (std::make_tuple(is_todel, is_rebalanced, usage)
+				> std::make_tuple(candidate_todel, candidate_rebalanced, candidate_usage)) {
 			candidate = &part;
 			candidate_usage = usage;
 			candidate_todel = is_todel;
+			candidate_rebalanced = is_rebalanced;
 		}
 	}
 
 	if (candidate &&
 	    calc.canRemovePart(slice_type, slice_part, matocsserv_get_label(candidate->server()))) {
+		if (candidate_rebalanced) {
+			rebalanceRemovals_.erase(removal);
+		}
 		c->deleteCopy(*candidate);
 		c->needverincrease = 1;
 		stats_deletions++;
@@ -2201,31 +2452,87 @@ bool ChunkWorker::removeUnneededChunkPart(Chunk *c, Goal::Slice::Type slice_type
 	return false;
 }
 
-bool ChunkWorker::rebalanceChunkParts(Chunk *c, ChunkCopiesCalculator &calc, bool only_todel) {
-	if(!only_todel) {
-		double min_usage = sortedServers_.front().diskUsage;
-		double max_usage = sortedServers_.back().diskUsage;
-		if ((max_usage - min_usage) <= AcceptableDifference) {
-			return false;
-		}
+bool ChunkWorker::moveChunkPartByPlan(Chunk *c, ChunkCopiesCalculator &calc) {
+	if (rebalancePlan_.empty()) {
+		return false;
+	}
+	if (RebalancingBandwidthLimit_KBps > 0 && rebalanceBudget_ <= 0) {
+		return false;
+	}
+
+	if (rebalanceReplications_.count(c->chunkid) > 0
+			|| rebalanceRemovals_.count(c->chunkid) > 0) {
+		return false; // The previous move of this chunk isn't finished yet
 	}
 
-	// Consider each copy to be moved to a server with disk usage much less than actual.
-	// There are at least two servers with a disk usage difference grater than
-	// AcceptableDifference, so it's worth checking.
+	// Copy a part from a server which has to give away data to a server planned for it.
+	// When the replication succeeds, the part on the source server becomes the first
+	// candidate for removal as an unneeded copy.
 	for (const auto &part : c->parts) {
 		if (!part.is_valid()) {
 			continue;
 		}
+		auto plan = rebalancePlan_.find(part.csid);
+		if (plan == rebalancePlan_.end()) {
+			continue;
+		}
+
+		MediaLabel current_copy_label = matocsserv_get_label(part.server());
+		bool multi_label_rebalance =
+		        RebalancingBetweenLabels &&
+		        (current_copy_label == MediaLabel::kWildcard ||
+		         calc.canMovePartToDifferentLabel(part.type.getSliceType(),
+		                                          part.type.getSlicePart(),
+		                                          current_copy_label));
+		uint32_t min_chunkserver_version = getMinChunkserverVersion(c, part.type);
+
+		for (auto &move : plan->second) {
+			if (move.bytes == 0) {
+				continue;
+			}
+			auto destination = serversById_.find(move.destination);
+			if (destination == serversById_.end()) {
+				continue;  // Server disconnected
+			}
+			matocsserventry *server = destination->second;
+			if (!multi_label_rebalance && matocsserv_get_label(server) != current_copy_label) {
+				continue;
+			}
+			if (matocsserv_get_version(server) < min_chunkserver_version) {
+				continue;
+			}
+			if (chunkPresentOnServer(c, part.type.getSliceType(), server)) {
+				continue;  // A copy is already here
+			}
+			if (matocsserv_replication_write_counter(server) >= MaxWriteRepl) {
+				continue;  // We can't create a new copy here
+			}
+			if (tryReplication(c, part.type, server)) {
+				// Progress of the plan is counted when the replication succeeds
+				rebalanceReplications_[c->chunkid] =
+						RebalancedPart{part.csid, move.destination, part.type};
+				rebalanceBudget_ -= chunkSizeEstimate_;
+				inforec_.copy_rebalance++;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool ChunkWorker::rebalanceChunkParts(Chunk *c, ChunkCopiesCalculator &calc, bool only_todel) {
+	if (!only_todel) {
+		return moveChunkPartByPlan(c, calc);
+	}
 
-		if(only_todel && !part.is_todel()) {
+	// Consider each copy marked for removal to be moved to a server with the lowest disk usage.
+	for (const auto &part : c->parts) {
+		if (!part.is_valid() || !part.is_todel()) {
 			continue;
 		}
 
 		MediaLabel current_copy_label = matocsserv_get_label(part.server());
-		double current_copy_disk_usage = matocsserv_get_usage(part.server());
-		// Look for a server that has disk usage much less than currentCopyDiskUsage.
-		// If such a server exists consider creating a new copy of this chunk there.
 		// First, choose all possible candidates for the destination server: we consider
 		// only
 		// servers with the same label is rebalancing between labels if turned off or the
@@ -2244,11 +2551,6 @@ bool ChunkWorker::rebalanceChunkParts(Chunk *c, ChunkCopiesCalculator &calc, boo
 		        multi_label_rebalance ? sortedServers_
 		                              : labeledSortedServers_[current_copy_label];
 		for (const auto &empty_server : sorted_servers) {
-			if (!only_todel && empty_server.diskUsage >
-			    current_copy_disk_usage - AcceptableDifference) {
-				break;  // No more suitable destination servers (next servers have
-				        // higher usage)
-			}
 			if (matocsserv_get_version(empty_server.server) < min_chunkserver_version) {
 				continue;
 			}
@@ -2381,7 +2683,7 @@ void ChunkWorker::doChunkJobs(Chunk *c, uint16_t serverCount) {
 	}
 
 	// step 10. if there is too big difference between chunkservers then make copy of chunk from
-	// a server with a high disk usage on a server with low disk usage
+	// a server with a high disk usage on a server with low disk usage, as planned for all servers
 	rebalanceChunkParts(c, calc, false);
 }
 
@@ -2452,16 +2754,16 @@ void ChunkWorker::mainLoop() {
 
 		if (jobsnorepbefore < main_time()) {
 			stack_.endangered_to_serve = gEndangeredChunksServingLimit;
-			while (stack_.endangered_to_serve > 0 && !Chunk::endangeredChunks.empty()) {
-				c = Chunk::endangeredChunks.front();
-				Chunk::endangeredChunks.pop_front();
-				// If queued chunk is obsolete (e.g. was freed while in queue),
-				// do not proceed with chunk jobs.
-				if (c->inEndangeredQueue == 1) {
-					c->inEndangeredQueue = 0;
+			while (stack_.endangered_to_serve > 0 && !Chunk::replicationQueue.empty()) {
+				int level;
+				c = Chunk::replicationQueue.pop(level);
+				// If queued chunk is obsolete (e.g. was freed while in queue or was queued
+				// again on a higher level), do not proceed with chunk jobs.
+				if (c->isQueuedForReplication(level)) {
+					c->replicationQueueLevel = 0;
 					doChunkJobs(c, stack_.usable_server_count);
+					--stack_.endangered_to_serve;
 				}
-				--stack_.endangered_to_serve;
 
 				if (stack_.watchdog.expired()) {
 					yield;
@@ -2523,6 +2825,13 @@ void ChunkWorker::mainLoop() {
 
 static std::unique_ptr<ChunkWorker> gChunkWorker;
 
+static void chunk_rebalance_replication_status(uint64_t chunkId, uint16_t csid,
+		ChunkPartType chunkType, bool success) {
+	if (gChunkWorker) {
+		gChunkWorker->rebalanceReplicationStatus(chunkId, csid, chunkType, success);
+	}
+}
+
 void chunk_jobs_main(void) {
 	if (gChunkWorker->is_complete()) {
 		gChunkWorker->reset();
@@ -2530,8 +2839,13 @@ void chunk_jobs_main(void) {
 }
 
 void chunk_jobs_process_bit(void) {
+	static metrics::Histogram &stepTime = metrics::registry().histogram(
+			"lizardfs_master_chunk_loop_duration_microseconds",
+			"Time of phases of the loop which checks and repairs chunks", "phase=\"step\"");
 	if (!gChunkWorker->is_complete()) {
+		Timer timer;
 		gChunkWorker->mainLoop();
+		stepTime.record(timer.elapsed_us());
 		if (!gChunkWorker->is_complete()) {
 			main_make_next_poll_nonblocking();
 		}
@@ -2671,6 +2985,11 @@ void chunk_become_master() {
 	gChunkWorker = std::unique_ptr<ChunkWorker>(new ChunkWorker());
 	gChunkLoopEventHandle = main_timeregister_ms(ChunksLoopPeriod, chunk_jobs_main);
 	main_eachloopregister(chunk_jobs_process_bit);
+	metrics::registry().gauge("lizardfs_master_chunks", "Number of chunks", "",
+			[]() -> int64_t { return Chunk::count; });
+	metrics::registry().gauge("lizardfs_master_replication_queue_chunks",
+			"Number of chunks waiting for replication with priority", "",
+			[]() -> int64_t { return Chunk::replicationQueue.size(); });
 	return;
 }
 
@@ -2749,11 +3068,12 @@ void chunk_reload(void) {
 		HashSteps = 1 + ((HASHSIZE) / scaled_looptime);
 		HashCPS   = (uint64_t)ChunksLoopPeriod * HashCPS / 1000;
 	}
-	double endangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.0, 0.0, 1.0);
+	double endangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.2, 0.0, 1.0);
 	gEndangeredChunksServingLimit = HashSteps * endangeredChunksPriority;
 	gEndangeredChunksMaxCapacity = cfg_get("ENDANGERED_CHUNKS_MAX_CAPACITY", static_cast<uint64_t>(1024*1024UL));
 	AcceptableDifference = cfg_ranged_get("ACCEPTABLE_DIFFERENCE",0.1, 0.001, 10.0);
 	RebalancingBetweenLabels = cfg_getuint32("CHUNKS_REBALANCING_BETWEEN_LABELS", 0) == 1;
+	RebalancingBandwidthLimit_KBps = cfg_getuint32("CHUNKS_REBALANCING_BANDWIDTH_LIMIT_KBPS", 0);
 }
 #endif
 
@@ -2826,11 +3146,12 @@ int chunk_strinit(void) {
 		HashSteps = 1 + ((HASHSIZE) / scaled_looptime);
 		HashCPS   = (uint64_t)ChunksLoopPeriod * HashCPS / 1000;
 	}
-	double endangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.0, 0.0, 1.0);
+	double endangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.2, 0.0, 1.0);
 	gEndangeredChunksServingLimit = HashSteps * endangeredChunksPriority;
 	gEndangeredChunksMaxCapacity = cfg_get("ENDANGERED_CHUNKS_MAX_CAPACITY", static_cast<uint64_t>(1024*1024UL));
 	AcceptableDifference = cfg_ranged_get("ACCEPTABLE_DIFFERENCE", 0.1, 0.001, 10.0);
 	RebalancingBetweenLabels = cfg_getuint32("CHUNKS_REBALANCING_BETWEEN_LABELS", 0) == 1;
+	RebalancingBandwidthLimit_KBps = cfg_getuint32("CHUNKS_REBALANCING_BANDWIDTH_LIMIT_KBPS", 0);
 	main_reloadregister(chunk_reload);
 	metadataserver::registerFunctionCalledOnPromotion(chunk_become_master);
 	main_eachloopregister(chunk_clean_zombie_servers_a_bit);
@@ -49,7 +49,7 @@ void chunk_dump(void);
 #else
 uint8_t chunk_multi_modify(uint64_t ochunkid, uint32_t *lockid, uint8_t goal,
 		bool usedummylockid, bool quota_exceeded, uint8_t *opflag, uint64_t *nchunkid,
-		uint32_t min_server_version);
+		uint32_t min_server_version, uint32_t client_ip);
 uint8_t chunk_multi_truncate(uint64_t ochunkid, uint32_t lockid, uint32_t length,
 		uint8_t goal, bool denyTruncatingParityParts, bool quota_exceeded, uint64_t *nchunkid);
 void chunk_stats(uint32_t *del,uint32_t *repl);
@@ -66,6 +66,14 @@ bool chunk_has_only_invalid_copies(uint64_t chunkid);
 
 int chunk_get_fullcopies(uint64_t chunkid,uint8_t *vcopies);
 int chunk_get_partstomodify(uint64_t chunkid, int &recover, int &remove);
+
+/*! \brief Variant of chunk_get_fullcopies and chunk_get_partstomodify for worker threads.
+ *
+ * Many threads may call it at the same time, as long as no chunk is modified meanwhile.
+ * \return LIZARDFS_ERROR_TEMP_NOTPOSSIBLE if the chunk has parts on disconnected chunkservers,
+ *         which have to be removed by the main thread first (e.g. by chunk_get_fullcopies).
+ */
+int chunk_get_availability_concurrently(uint64_t chunkid, uint8_t &vcopies, int &recover);
 int chunk_repair(uint8_t goal,uint64_t ochunkid,uint32_t *nversion);
 
 int chunk_getversionandlocations(uint64_t chunkid, uint32_t currentIp, uint32_t& version,
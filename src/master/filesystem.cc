@@ -20,6 +20,7 @@
 #include "master/filesystem.h"
 
 #include "common/cfg.h"
+#include "common/compressed_metadata.h"
 #include "common/lockfile.h"
 #include "common/main.h"
 #include "common/metadata.h"
@@ -61,6 +62,9 @@ std::map<int, Goal> gGoalDefinitions;
 // Number of changelog file versions
 uint32_t gStoredPreviousBackMetaCopies;
 
+// Compression level of metadata files, 0 means no compression
+uint32_t gMetadataDumpCompressionLevel = 0;
+
 // Checksum validation
 bool gDisableChecksumVerification = false;
 
@@ -110,7 +114,7 @@ void fs_periodic_storeall() {
 	fs_storeall(MetadataDumper::kBackgroundDump); // ignore error
 }
 
-void fs_term(void) {
+static void fs_term(void) {
 	if (metadataDumper.inProgress()) {
 		metadataDumper.waitUntilFinished();
 	}
@@ -145,6 +149,7 @@ void fs_term(void) {
 			gMetadataLockfile->writeMessage("no_metadata: 0\n");
 		}
 	}
+	fs_test_files_set_workers(0);
 	delete gMetadata;
 }
 
@@ -160,9 +165,7 @@ void fs_storeall(const char *fname) {
 		lzfs_pretty_syslog(LOG_ERR, "can't open metadata file");
 		return;
 	}
-	fs_store_fd(fd);
-
-	if (ferror(fd)!=0) {
+	if (!fs_store_file(fd)) {
 		lzfs_pretty_syslog(LOG_ERR, "can't write metadata");
 	} else if (fflush(fd) == EOF) {
 		lzfs_pretty_syslog(LOG_ERR, "can't fflush metadata");
@@ -248,6 +251,7 @@ void fs_become_master() {
 	main_eachloopregister(fs_background_checksum_recalculation_a_bit);
 	main_eachloopregister(fs_background_task_manager_work);
 	main_timeregister_ms(100, fs_periodic_emptytrash);
+	main_eachloopregister(fs_background_emptytrash_a_bit);
 	return;
 }
 
@@ -302,6 +306,13 @@ static void fs_read_config_file() {
 			"BACK_META_KEEP_PREVIOUS",
 			kDefaultStoredPreviousBackMetaCopies,
 			kMaxStoredPreviousBackMetaCopies);
+	gMetadataDumpCompressionLevel = cfg_get_maxvalue<uint32_t>("METADATA_DUMP_COMPRESSION_LEVEL", 0,
+			kMaxMetadataDumpCompressionLevel);
+	if (gMetadataDumpCompressionLevel > 0 && !compressedMetadataSupported()) {
+		lzfs_pretty_syslog(LOG_WARNING, "METADATA_DUMP_COMPRESSION_LEVEL is set, but this build "
+				"doesn't support compressed metadata files, storing them uncompressed");
+		gMetadataDumpCompressionLevel = 0;
+	}
 
 	ChecksumUpdater::setPeriod(cfg_getint32("METADATA_CHECKSUM_INTERVAL", 50));
 	gChecksumBackgroundUpdater.setSpeedLimit(
@@ -320,6 +331,9 @@ static void fs_read_config_file() {
 		" entries are deprecated. Use OPERATIONS_DELAY_INIT and OPERATIONS_DELAY_DISCONNECT instead.");
 	}
 
+	fs_test_files_set_workers(cfg_get_maxvalue<uint32_t>("FILE_TEST_LOOP_WORKERS", 0, 64));
+	fs_test_files_set_loop_min_time(cfg_getuint32("FILE_TEST_LOOP_MIN_TIME", 14400));
+
 	chunk_invalidate_goal_cache();
 	fs_read_goal_config_file(); // may throw
 }
@@ -366,6 +380,7 @@ int fs_init(bool doLoad) {
 		fs_loadall();
 	}
 	main_reloadregister(fs_reload);
+	main_timeregister_ms(100, fs_periodic_flush_stats);
 	metadataserver::registerFunctionCalledOnPromotion(fs_become_master);
 	if (!cfg_isdefined("MAGIC_DISABLE_METADATA_DUMPS")) {
 		// Secret option disabling periodic metadata dumps
@@ -39,6 +39,7 @@
 #include "master/metadata_dumper.h"
 #include "master/setgoal_task.h"
 #include "master/settrashtime_task.h"
+#include "protocol/defective_directory_entry.h"
 #include "protocol/quota.h"
 
 LIZARDFS_CREATE_EXCEPTION_CLASS_MSG(NoMetadataException, Exception, "no metadata");
@@ -107,7 +108,8 @@ uint8_t fs_symlink(const FsContext& context,
 uint8_t fs_undel(const FsContext& context, uint32_t inode);
 uint8_t fs_writechunk(const FsContext& context, uint32_t inode, uint32_t indx,
 		bool usedummylockid, /* inout */ uint32_t *lockid,
-		uint64_t *chunkid, uint8_t *opflag, uint64_t *length, uint32_t min_server_version = 0);
+		uint64_t *chunkid, uint8_t *opflag, uint64_t *length, uint32_t min_server_version = 0,
+		uint32_t client_ip = 0);
 uint8_t fs_set_nextchunkid(const FsContext& context, uint64_t nextChunkId);
 
 // Functions which apply changes from changelog, only for shadow master and metarestore
@@ -117,6 +119,7 @@ uint8_t fs_apply_access(uint32_t ts,uint32_t inode);
 uint8_t fs_apply_attr(uint32_t ts,uint32_t inode,uint32_t mode,uint32_t uid,uint32_t gid,uint32_t atime,uint32_t mtime);
 uint8_t fs_apply_session(uint32_t sessionid);
 uint8_t fs_apply_emptytrash_deprecated(uint32_t ts,uint32_t freeinodes,uint32_t reservedinodes);
+uint8_t fs_apply_purge(uint32_t ts, const std::vector<uint32_t>& inodes);
 uint8_t fs_apply_emptyreserved_deprecated(uint32_t ts,uint32_t freeinodes);
 uint8_t fs_apply_freeinodes(uint32_t ts,uint32_t freeinodes);
 uint8_t fs_apply_incversion(uint64_t chunkid);
@@ -134,6 +137,9 @@ uint8_t fs_apply_trunc(uint32_t ts,uint32_t inode,uint32_t indx,uint64_t chunkid
 /// metadata file from the active metadata server again.
 void fs_unload();
 
+/// Allocates empty metadata structures, which have to be loaded or filled by fs_new
+void fs_strinit(void);
+
 /// Removes metadata lock leaving working directory in a clean state
 void fs_unlock();
 
@@ -143,6 +149,11 @@ const uint32_t kMaxStoredPreviousBackMetaCopies = 99;
 
 extern uint32_t gStoredPreviousBackMetaCopies;
 
+// Compression level of metadata files (0 - uncompressed, 1-9 - zlib levels)
+const uint32_t kMaxMetadataDumpCompressionLevel = 9;
+
+extern uint32_t gMetadataDumpCompressionLevel;
+
 #ifdef METARESTORE
 
 void fs_dump(void);
@@ -156,6 +167,15 @@ void fs_disable_checksum_verification(bool value);
 // To be used by the master server with personality == kMaster
 void fs_info(uint64_t *totalspace,uint64_t *availspace,uint64_t *trspace,uint32_t *trnodes,uint64_t *respace,uint32_t *renodes,uint32_t *inodes,uint32_t *dnodes,uint32_t *fnodes);
 void fs_test_getdata(uint32_t *loopstart,uint32_t *loopend,uint32_t *files,uint32_t *ugfiles,uint32_t *mfiles,uint32_t *chunks,uint32_t *ugchunks,uint32_t *mchunks,char **msgbuff,uint32_t *msgbuffleng);
+
+/*! \brief Lists directories in subtree of \a rootinode which contained defective files.
+ *
+ * Directories are reported as found by the last complete loop checking all files, i.e. only
+ * directories which still exist are listed and only files directly in them are counted.
+ * \return LIZARDFS_ERROR_ENOENT if \a rootinode is not a directory
+ */
+uint8_t fs_list_defective_directories(uint32_t rootinode,
+		std::vector<DefectiveDirectoryEntry> &entries);
 uint32_t fs_getdirpath_size(uint32_t inode);
 void fs_getdirpath_data(uint32_t inode,uint8_t *buff,uint32_t size);
 uint8_t fs_getrootinode(uint32_t *rootinode,const uint8_t *path);
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "common/tape_copies.h"
 #include "common/special_inode_defs.h"
@@ -67,6 +68,11 @@ public:
 
 	QuotaDatabase quota_database;
 
+	/// Statistics changes applied to a directory, but not yet to its ancestors
+	std::unordered_map<uint32_t, statsrecord> pending_stats;
+	/// Directories mapped to their subdirectories which have changes pending in their subtrees
+	std::unordered_map<uint32_t, std::unordered_set<uint32_t>> pending_stats_children;
+
 	uint64_t fsNodesChecksum;
 	uint64_t xattrChecksum;
 	uint64_t quota_checksum;
@@ -96,6 +102,8 @@ public:
 	      filenodes{},
 	      dirnodes{},
 	      quota_database{},
+	      pending_stats{},
+	      pending_stats_children{},
 	      fsNodesChecksum{},
 	      xattrChecksum{},
 	      quota_checksum{quota_database.checksum()} {
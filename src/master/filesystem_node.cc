@@ -37,6 +37,9 @@
 #include "master/filesystem_quota.h"
 #include "master/fs_context.h"
 
+#ifndef METARESTORE
+  #include "master/matoclserv.h"
+#endif
 #ifndef NDEBUG
   #include "master/personality.h"
 #endif
@@ -260,6 +263,7 @@ bool fsnodes_isancestor_or_node_reserved_or_trash(FSNodeDirectory *ancestor, FSN
 void fsnodes_get_stats(FSNode *node, statsrecord *sr) {
 	switch (node->type) {
 	case FSNode::kDirectory:
+		fsnodes_flush_stats(static_cast<FSNodeDirectory*>(node));
 		*sr = static_cast<FSNodeDirectory*>(node)->stats;
 		sr->inodes++;
 		sr->dirs++;
@@ -301,46 +305,138 @@ int64_t fsnodes_get_size(FSNode *node) {
 	return sr.size;
 }
 
+static inline void fsnodes_stats_add(statsrecord *psr, const statsrecord *sr) {
+	psr->inodes += sr->inodes;
+	psr->dirs += sr->dirs;
+	psr->files += sr->files;
+	psr->chunks += sr->chunks;
+	psr->length += sr->length;
+	psr->size += sr->size;
+	psr->realsize += sr->realsize;
+}
+
 static inline void fsnodes_sub_stats(FSNodeDirectory *parent, statsrecord *sr) {
-	statsrecord *psr;
-	if (parent) {
-		psr = &parent->stats;
-		psr->inodes -= sr->inodes;
-		psr->dirs -= sr->dirs;
-		psr->files -= sr->files;
-		psr->chunks -= sr->chunks;
-		psr->length -= sr->length;
-		psr->size -= sr->size;
-		psr->realsize -= sr->realsize;
-		if (parent != gMetadata->root) {
-			for (auto inode : parent->parent) {
-				FSNodeDirectory *node = fsnodes_id_to_node_verify<FSNodeDirectory>(inode);
-				fsnodes_sub_stats(node, sr);
-			}
+	statsrecord nsr;
+	nsr.inodes = -sr->inodes;
+	nsr.dirs = -sr->dirs;
+	nsr.files = -sr->files;
+	nsr.chunks = -sr->chunks;
+	nsr.length = -sr->length;
+	nsr.size = -sr->size;
+	nsr.realsize = -sr->realsize;
+	fsnodes_add_stats(parent, &nsr);
+}
+
+static bool fsnodes_has_pending_stats(uint32_t id) {
+	return gMetadata->pending_stats.count(id) > 0 || gMetadata->pending_stats_children.count(id) > 0;
+}
+
+/*
+ * A directory is listed in pending_stats_children of its parent as long as it
+ * or any of its subdirectories has changes pending, so that exact statistics
+ * of a directory need only its own subtree to be flushed. Marking stops at the
+ * first ancestor which is already marked.
+ */
+static void fsnodes_mark_pending_stats(FSNodeDirectory *dir) {
+	while (!dir->parent.empty()) {
+		// directories have exactly one parent
+		uint32_t parent_id = dir->parent.front();
+		bool parent_marked = fsnodes_has_pending_stats(parent_id);
+		gMetadata->pending_stats_children[parent_id].insert(dir->id);
+		if (parent_marked) {
+			return;
 		}
+		dir = fsnodes_id_to_node_verify<FSNodeDirectory>(parent_id);
 	}
 }
 
+/*
+ * Statistics of the directory are updated immediately, while its ancestors
+ * are updated in bulk by fsnodes_flush_stats, so that a file which changes
+ * often doesn't cost a walk to the root on every change.
+ */
 void fsnodes_add_stats(FSNodeDirectory *parent, statsrecord *sr) {
-	statsrecord *psr;
 	if (parent) {
-		psr = &parent->stats;
-		psr->inodes += sr->inodes;
-		psr->dirs += sr->dirs;
-		psr->files += sr->files;
-		psr->chunks += sr->chunks;
-		psr->length += sr->length;
-		psr->size += sr->size;
-		psr->realsize += sr->realsize;
-		if (parent != gMetadata->root) {
-			for (auto inode : parent->parent) {
-				FSNodeDirectory *node = fsnodes_id_to_node_verify<FSNodeDirectory>(inode);
-				fsnodes_add_stats(node, sr);
+		fsnodes_stats_add(&parent->stats, sr);
+		if (parent != gMetadata->root && !parent->parent.empty()) {
+			bool marked = fsnodes_has_pending_stats(parent->id);
+			fsnodes_stats_add(&gMetadata->pending_stats[parent->id], sr);
+			if (!marked) {
+				fsnodes_mark_pending_stats(parent);
 			}
 		}
 	}
 }
 
+/*
+ * Moves changes pending in the directory to its parent. Subdirectories have
+ * to be flushed before, so that the directory can be unmarked.
+ */
+static void fsnodes_flush_pending_stats(uint32_t id, uint32_t parent_id) {
+	auto it = gMetadata->pending_stats.find(id);
+	if (it != gMetadata->pending_stats.end()) {
+		statsrecord sr = it->second;
+		gMetadata->pending_stats.erase(it);
+		FSNodeDirectory *parent = fsnodes_id_to_node<FSNodeDirectory>(parent_id);
+		if (parent) {
+#ifndef METARESTORE
+			uint64_t length = parent->stats.length;
+#endif
+			fsnodes_add_stats(parent, &sr);
+#ifndef METARESTORE
+			// Attributes of a directory contain its length in GiB, which changes
+			// here without passing through fsnodes_update_checksum
+			if ((length >> 30) != (parent->stats.length >> 30)) {
+				matoclserv_node_changed(parent_id);
+			}
+#endif
+		}
+	}
+	auto children_it = gMetadata->pending_stats_children.find(parent_id);
+	if (children_it != gMetadata->pending_stats_children.end()) {
+		children_it->second.erase(id);
+		if (children_it->second.empty()) {
+			gMetadata->pending_stats_children.erase(children_it);
+		}
+	}
+}
+
+void fsnodes_flush_stats(FSNodeDirectory *dir) {
+	// Marked subdirectories are flushed bottom-up, so changes coming from sibling
+	// subtrees are merged before they are passed further
+	std::vector<uint32_t> path{dir->id};
+	while (!path.empty()) {
+		auto it = gMetadata->pending_stats_children.find(path.back());
+		if (it != gMetadata->pending_stats_children.end()) {
+			path.push_back(*it->second.begin());
+			continue;
+		}
+		uint32_t id = path.back();
+		path.pop_back();
+		if (!path.empty()) {
+			fsnodes_flush_pending_stats(id, path.back());
+		} else if (!dir->parent.empty()) {
+			fsnodes_flush_pending_stats(id, dir->parent.front());
+		} else {
+			gMetadata->pending_stats.erase(id);
+		}
+	}
+}
+
+void fsnodes_flush_stats() {
+	// The root is not known yet while edges are loaded, so each marked directory
+	// is flushed; its changes reach the next one on the way up
+	while (!gMetadata->pending_stats_children.empty()) {
+		uint32_t id = gMetadata->pending_stats_children.begin()->first;
+		FSNodeDirectory *dir = fsnodes_id_to_node<FSNodeDirectory>(id);
+		if (dir) {
+			fsnodes_flush_stats(dir);
+		} else {
+			gMetadata->pending_stats_children.erase(id);
+		}
+	}
+}
+
 void fsnodes_add_sub_stats(FSNodeDirectory *parent, statsrecord *newsr, statsrecord *prevsr) {
 	statsrecord sr;
 	sr.inodes = newsr->inodes - prevsr->inodes;
@@ -419,6 +515,8 @@ void fsnodes_fill_attr(FSNode *node, FSNode *parent, uint32_t uid, uint32_t gid,
 		put64bit(&ptr, static_cast<FSNodeFile*>(node)->length);
 		break;
 	case FSNode::kDirectory:
+		// Changes from deeper subdirectories which are not flushed yet are omitted here,
+		// they are visible after the next call to fs_periodic_flush_stats
 		put32bit(&ptr, static_cast<FSNodeDirectory*>(node)->nlink);
 		put64bit(&ptr, static_cast<FSNodeDirectory*>(node)->stats.length >>
 		                       30);  // Rescale length to GB (reduces size to 32-bit length)
@@ -495,6 +593,11 @@ void fsnodes_remove_edge(uint32_t ts, FSNodeDirectory *parent, const HString &na
 }
 
 void fsnodes_link(uint32_t ts, FSNodeDirectory *parent, FSNode *child, const HString &name) {
+	// Stats are taken before the child gets its parent, so that changes pending
+	// in the child's subtree are not counted twice
+	statsrecord sr;
+	fsnodes_get_stats(child, &sr);
+
 	parent->entries.insert({hstorage::Handle(name), child});
 	parent->entries_hash ^= name.hash();
 
@@ -504,8 +607,6 @@ void fsnodes_link(uint32_t ts, FSNodeDirectory *parent, FSNode *child, const HSt
 		parent->nlink++;
 	}
 
-	statsrecord sr;
-	fsnodes_get_stats(child, &sr);
 	fsnodes_add_stats(parent, &sr);
 	if (ts > 0) {
 		parent->mtime = parent->ctime = ts;
@@ -146,6 +146,9 @@ FSNode *fsnodes_create_node(uint32_t ts, FSNodeDirectory *node, const HString &n
 			uint8_t copysgid, AclInheritance inheritacl, uint32_t req_inode=0);
 
 void fsnodes_add_stats(FSNodeDirectory *parent, statsrecord *sr);
+void fsnodes_flush_stats();
+/// Makes statistics of the directory exact, applying only changes pending in its subtree
+void fsnodes_flush_stats(FSNodeDirectory *dir);
 int fsnodes_sticky_access(FSNode *parent, FSNode *node, uint32_t uid);
 void fsnodes_unlink(uint32_t ts, FSNodeDirectory *parent, const HString &node_name, FSNode *node);
 bool fsnodes_isancestor(FSNodeDirectory *f, FSNode *p);
@@ -0,0 +1,166 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/filesystem_node.h"
+
+#include <gtest/gtest.h>
+
+#include "common/special_inode_defs.h"
+#include "master/filesystem.h"
+#include "master/filesystem_metadata.h"
+#include "master/filesystem_operations.h"
+#include "protocol/MFSCommunication.h"
+#include "unittests/master_filesystem.h"
+
+using unittests::MasterFilesystem;
+
+inline bool operator==(const statsrecord &a, const statsrecord &b) {
+	return a.inodes == b.inodes && a.dirs == b.dirs && a.files == b.files &&
+			a.chunks == b.chunks && a.length == b.length && a.size == b.size &&
+			a.realsize == b.realsize;
+}
+
+inline std::ostream &operator<<(std::ostream &out, const statsrecord &sr) {
+	return out << "{inodes: " << sr.inodes << ", dirs: " << sr.dirs << ", files: " << sr.files
+			<< ", length: " << sr.length << "}";
+}
+
+class FsnodesStatsTests : public ::testing::Test {
+protected:
+	void SetUp() override {
+		MasterFilesystem::setTime(1000);
+		// /a/b/c/d and /x/y, each directory with two files
+		a_ = createDirectory(SPECIAL_INODE_ROOT, "a");
+		b_ = createDirectory(a_, "b");
+		c_ = createDirectory(b_, "c");
+		d_ = createDirectory(c_, "d");
+		x_ = createDirectory(SPECIAL_INODE_ROOT, "x");
+		y_ = createDirectory(x_, "y");
+		for (uint32_t dir : {a_, b_, c_, d_, x_, y_}) {
+			for (int i = 0; i < 2; ++i) {
+				createFile(dir, "file" + std::to_string(i));
+			}
+		}
+		fsnodes_flush_stats();
+	}
+
+	static uint32_t createDirectory(uint32_t parent, const std::string &name) {
+		uint32_t inode = 0;
+		Attributes attr;
+		EXPECT_EQ(LIZARDFS_STATUS_OK, fs_mkdir(SPECIAL_INODE_ROOT, 0, parent, HString(name),
+				0755, 0, 0, 0, 0, 0, 0, &inode, attr));
+		return inode;
+	}
+
+	static uint32_t createFile(uint32_t parent, const std::string &name) {
+		uint32_t inode = 0;
+		Attributes attr;
+		EXPECT_EQ(LIZARDFS_STATUS_OK, fs_mknod(SPECIAL_INODE_ROOT, 0, parent, HString(name),
+				TYPE_FILE, 0644, 0, 0, 0, 0, 0, 0, &inode, attr));
+		return inode;
+	}
+
+	static void setLength(uint32_t dir, const std::string &name, uint64_t length) {
+		FSNode *node = fsnodes_lookup(fsnodes_id_to_node<FSNodeDirectory>(dir), HString(name));
+		ASSERT_NE(nullptr, node);
+		fsnodes_setlength(static_cast<FSNodeFile*>(node), length);
+	}
+
+	/// Statistics of the directory computed from scratch
+	static statsrecord recompute(FSNodeDirectory *dir) {
+		statsrecord result;
+		memset(&result, 0, sizeof(result));
+		for (const auto &entry : dir->entries) {
+			statsrecord sr;
+			if (entry.second->type == FSNode::kDirectory) {
+				sr = recompute(static_cast<FSNodeDirectory*>(entry.second));
+				sr.inodes++;
+				sr.dirs++;
+			} else {
+				fsnodes_get_stats(entry.second, &sr);
+			}
+			result.inodes += sr.inodes;
+			result.dirs += sr.dirs;
+			result.files += sr.files;
+			result.chunks += sr.chunks;
+			result.length += sr.length;
+			result.size += sr.size;
+			result.realsize += sr.realsize;
+		}
+		return result;
+	}
+
+	static statsrecord stats(uint32_t dir) {
+		return fsnodes_id_to_node<FSNodeDirectory>(dir)->stats;
+	}
+
+	static statsrecord recompute(uint32_t dir) {
+		return recompute(fsnodes_id_to_node<FSNodeDirectory>(dir));
+	}
+
+	MasterFilesystem fs_;
+	uint32_t a_, b_, c_, d_, x_, y_;
+};
+
+TEST_F(FsnodesStatsTests, SubtreeFlushMakesStatsExact) {
+	setLength(d_, "file0", 1000);
+	setLength(c_, "file1", 2000);
+	setLength(y_, "file0", 3000);
+	createDirectory(d_, "e");
+	EXPECT_FALSE(gMetadata->pending_stats.empty());
+
+	fsnodes_flush_stats(fsnodes_id_to_node<FSNodeDirectory>(b_));
+	EXPECT_EQ(recompute(b_), stats(b_));
+	EXPECT_EQ(recompute(c_), stats(c_));
+	EXPECT_EQ(recompute(d_), stats(d_));
+	// Changes of other subtrees are not flushed
+	EXPECT_EQ(1U, gMetadata->pending_stats.count(y_));
+
+	fsnodes_flush_stats();
+	EXPECT_TRUE(gMetadata->pending_stats.empty());
+	EXPECT_TRUE(gMetadata->pending_stats_children.empty());
+	for (uint32_t dir : {SPECIAL_INODE_ROOT, a_, b_, c_, d_, x_, y_}) {
+		EXPECT_EQ(recompute(dir), stats(dir)) << "inode " << dir;
+	}
+}
+
+TEST_F(FsnodesStatsTests, StatsAreExactAfterRenameAndUnlink) {
+	setLength(d_, "file0", 1000);
+	setLength(d_, "file1", 1500);
+	// Directory with pending changes is moved to another subtree
+	uint32_t inode = d_;
+	ASSERT_EQ(LIZARDFS_STATUS_OK, fs_rename(FsContext::getForMaster(1000), c_, HString("d"),
+			y_, HString("d"), &inode, nullptr));
+	setLength(d_, "file0", 500);
+	ASSERT_EQ(LIZARDFS_STATUS_OK,
+			fs_unlink(SPECIAL_INODE_ROOT, 0, b_, HString("file0"), 0, 0));
+
+	// Directory statistics read by clients are exact without a global flush
+	statsrecord sr;
+	fsnodes_get_stats(fsnodes_id_to_node<FSNode>(a_), &sr);
+	statsrecord expected = recompute(a_);
+	expected.inodes++;
+	expected.dirs++;
+	EXPECT_EQ(expected, sr);
+
+	fsnodes_flush_stats();
+	for (uint32_t dir : {SPECIAL_INODE_ROOT, a_, b_, c_, d_, x_, y_}) {
+		EXPECT_EQ(recompute(dir), stats(dir)) << "inode " << dir;
+	}
+}
@@ -38,11 +38,12 @@
 #include "master/matomlserv.h"
 #include "protocol/matocl.h"
 
-std::array<uint32_t, FsStats::Size> gFsStatsArray = {{}};
+std::array<std::atomic<uint32_t>, FsStats::Size> gFsStatsArray = {{}};
 
 void fs_retrieve_stats(std::array<uint32_t, FsStats::Size> &output_stats) {
-	output_stats = gFsStatsArray;
-	gFsStatsArray.fill(0);
+	for (int i = 0; i < FsStats::Size; ++i) {
+		output_stats[i] = gFsStatsArray[i].exchange(0);
+	}
 }
 
 static const int kInitialTaskBatchSize = 10;
@@ -92,6 +93,15 @@ void fs_changelog(uint32_t ts, const char *format, ...) {
 #endif
 }
 
+bool fs_changelog_followers_have_version(uint32_t version) {
+#ifdef METARESTORE
+	(void)version;
+	return true;
+#else
+	return matomlserv_followers_have_version(version);
+#endif
+}
+
 #ifndef METARESTORE
 uint8_t fs_readreserved_size(uint32_t rootinode, uint8_t sesflags, uint32_t *dbuffsize) {
 	if (rootinode != 0) {
@@ -1348,6 +1358,7 @@ uint8_t fs_rename(const FsContext &context, uint32_t parent_src, const HString &
 		if (fsnodes_isancestor(static_cast<FSNodeDirectory*>(se_child), dwd)) {
 			return LIZARDFS_ERROR_EINVAL;
 		}
+		fsnodes_flush_stats(static_cast<FSNodeDirectory*>(se_child));
 		const statsrecord &stats = static_cast<FSNodeDirectory*>(se_child)->stats;
 		quota_delta = {{(int64_t)stats.inodes, (int64_t)stats.size}};
 	} else if (se_child->type == FSNode::kFile) {
@@ -1366,6 +1377,7 @@ uint8_t fs_rename(const FsContext &context, uint32_t parent_src, const HString &
 			return LIZARDFS_ERROR_EPERM;
 		}
 		if (de_child->type == TYPE_DIRECTORY) {
+			fsnodes_flush_stats(static_cast<FSNodeDirectory*>(de_child));
 			const statsrecord &stats = static_cast<FSNodeDirectory*>(de_child)->stats;
 			quota_delta[(int)QuotaResource::kInodes] -= stats.inodes;
 			quota_delta[(int)QuotaResource::kSize] -= stats.size;
@@ -2043,7 +2055,7 @@ uint8_t fs_readchunk(uint32_t inode, uint32_t indx, uint64_t *chunkid, uint64_t
 
 uint8_t fs_writechunk(const FsContext &context, uint32_t inode, uint32_t indx, bool usedummylockid,
 		/* inout */ uint32_t *lockid, uint64_t *chunkid, uint8_t *opflag,
-		uint64_t *length, uint32_t min_server_version) {
+		uint64_t *length, uint32_t min_server_version, uint32_t client_ip) {
 	ChecksumUpdater cu(context.ts());
 	uint64_t ochunkid, nchunkid;
 	FSNode *node;
@@ -2093,10 +2105,12 @@ uint8_t fs_writechunk(const FsContext &context, uint32_t inode, uint32_t indx, b
 	if (context.isPersonalityMaster()) {
 #ifndef METARESTORE
 		status = chunk_multi_modify(ochunkid, lockid, p->goal, usedummylockid,
-		                            quota_exceeded, opflag, &nchunkid, min_server_version);
+		                            quota_exceeded, opflag, &nchunkid, min_server_version,
+		                            client_ip);
 #else
 		(void)usedummylockid;
 		(void)min_server_version;
+		(void)client_ip;
 		// This will NEVER happen (metarestore doesn't call this in master context)
 		mabort("bad code path: fs_writechunk");
 #endif
@@ -21,6 +21,8 @@
 
 #include "common/platform.h"
 
+#include <array>
+#include <atomic>
 #include <map>
 
 #include "common/goal.h"
@@ -54,7 +56,8 @@ enum {
 };
 }
 
-extern std::array<uint32_t, FsStats::Size> gFsStatsArray;
+// Counters are atomic because read-only requests may be served by matoclserv worker threads
+extern std::array<std::atomic<uint32_t>, FsStats::Size> gFsStatsArray;
 
 void fs_retrieve_stats(std::array<uint32_t, FsStats::Size> &output_stats);
 
@@ -66,6 +69,10 @@ void fs_broadcast_metadata_saved(uint8_t status);
 // Adds an entry to a changelog, updates filesystem.cc internal structures, prepends a
 // proper timestamp to changelog entry and broadcasts it to metaloggers and shadow masters
 void fs_changelog(uint32_t ts, const char *format, ...) __attribute__((__format__(__printf__, 2, 3)));
+
+// Returns true if all metaloggers and shadow masters understand changelog entries in a format
+// introduced in the given version of LizardFS
+bool fs_changelog_followers_have_version(uint32_t version);
 void fs_add_files_to_chunks();
 
 uint64_t fs_getversion();
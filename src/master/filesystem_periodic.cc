@@ -20,11 +20,20 @@
 #include "common/platform.h"
 #include "master/filesystem_periodic.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
 #include <type_traits>
+#include <vector>
 
+#include "common/batch_executor.h"
+#include "common/lizardfs_version.h"
 #include "common/loop_watchdog.h"
 #include "common/main.h"
+#include "master/chunks.h"
+#include "master/filesystem.h"
 #include "master/filesystem_checksum.h"
 #include "master/filesystem_checksum_updater.h"
 #include "master/filesystem_metadata.h"
@@ -50,6 +59,19 @@ static uint32_t fsinfo_loopend = 0;
 
 static int gTasksBatchSize = 1000;
 
+/// Default minimal duration of the loop checking all files (in seconds)
+static constexpr uint32_t kDefaultFileTestLoopMinTime = 14400;
+
+/// Maximum number of inodes in a single PURGE entry in changelog
+/// Entries with many inodes are emitted only if all followers are at least kFirstPurgeBatchVersion
+static constexpr uint32_t kMaxInodesInPurgeEntry = 1000;
+
+/// True if expired trash files were left to be purged in next loops
+static bool gEmptyTrashInProgress = false;
+
+/// Number of trash files purged since the last call of fs_trash_purge_stats
+static uint32_t gPurgedTrashFiles = 0;
+
 void fs_background_task_manager_work() {
 	if (gMetadata->task_manager.workAvailable()) {
 		uint32_t ts = main_time();
@@ -134,11 +156,106 @@ void fs_background_checksum_recalculation_a_bit() {
 	main_make_next_poll_nonblocking();
 }
 
+/// Result of checking chunks of a single file in fs_periodic_test_files
+struct FileTestResult {
+	enum ChunkProblem : uint8_t {
+		kChunkNotFound,
+		kChunkUnavailable
+	};
+
+	explicit FileTestResult(FSNodeFile *node)
+			: node(node), chunks(0), undergoalChunks(0), recheck(false) {
+	}
+
+	FSNodeFile *node;
+	uint32_t chunks;
+	uint32_t undergoalChunks;
+	bool recheck; ///< chunks have to be checked again by the main thread
+	std::vector<std::pair<uint32_t, ChunkProblem>> problems; ///< (chunk index, problem)
+};
+
+/// Counters of defective files kept for each directory
+struct DefectiveFilesCount {
+	DefectiveFilesCount() : unavailable(0), undergoal(0) {
+	}
+
+	uint32_t unavailable;
+	uint32_t undergoal;
+};
+
+/// Workers evaluating chunks of files in fs_periodic_test_files, none if not configured
+static std::unique_ptr<BatchExecutor> gFileTestExecutor;
+
+/// Number of seconds the loop checking all files should take at least
+static uint32_t gFileTestLoopMinTime = kDefaultFileTestLoopMinTime;
+
+/// Defective files found in the last complete loop, by inode of their parent directory
+static std::map<uint32_t, DefectiveFilesCount> gDefectiveDirectories;
+
+/// Defective files found so far in the current loop
+static std::map<uint32_t, DefectiveFilesCount> gDefectiveDirectoriesInProgress;
+
+/*! \brief Checks availability of chunks of a file.
+ *
+ * \param concurrently true if called by a worker thread, in which case chunks which
+ *        can't be checked this way are only marked to be rechecked by the main thread.
+ */
+static void fs_test_file_chunks(FileTestResult &result, bool concurrently) {
+	const auto &chunks = result.node->chunks;
+	result.chunks = 0;
+	result.undergoalChunks = 0;
+	result.recheck = false;
+	result.problems.clear();
+	for (uint32_t j = 0; j < chunks.size(); ++j) {
+		uint64_t chunkid = chunks[j];
+		if (chunkid == 0) {
+			continue;
+		}
+		uint8_t vc;
+		int recover = 0;
+		int status;
+		if (concurrently) {
+			status = chunk_get_availability_concurrently(chunkid, vc, recover);
+			if (status == LIZARDFS_ERROR_TEMP_NOTPOSSIBLE) {
+				result.recheck = true;
+				return;
+			}
+		} else {
+			status = chunk_get_fullcopies(chunkid, &vc);
+			if (status == LIZARDFS_STATUS_OK && vc > 0) {
+				int remove;
+				chunk_get_partstomodify(chunkid, recover, remove);
+			}
+		}
+		if (status != LIZARDFS_STATUS_OK) {
+			result.problems.push_back({j, FileTestResult::kChunkNotFound});
+		} else if (vc == 0) {
+			result.problems.push_back({j, FileTestResult::kChunkUnavailable});
+		} else if (recover > 0) {
+			result.undergoalChunks++;
+		}
+		result.chunks++;
+	}
+}
+
+void fs_test_files_set_workers(uint32_t workers) {
+	if (gFileTestExecutor && gFileTestExecutor->workers() == workers) {
+		return;
+	}
+	gFileTestExecutor.reset();
+	if (workers > 0) {
+		gFileTestExecutor.reset(new BatchExecutor(workers));
+	}
+}
+
+void fs_test_files_set_loop_min_time(uint32_t seconds) {
+	gFileTestLoopMinTime = std::max<uint32_t>(seconds, 1);
+}
+
 void fs_periodic_test_files() {
 	static uint32_t i = 0;
 	uint32_t k;
 	uint64_t chunkid;
-	uint8_t vc, valid, ugflag;
 	static uint32_t files = 0;
 	static uint32_t ugfiles = 0;
 	static uint32_t mfiles = 0;
@@ -153,7 +270,6 @@ void fs_periodic_test_files() {
 	static uint32_t unavailreservedfiles = 0;
 	static char *msgbuff = NULL, *tmp;
 	static uint32_t leng = 0;
-	FSNode *f;
 
 	if ((uint32_t)(main_time()) <= gTestStartTime) {
 		return;
@@ -241,199 +357,260 @@ void fs_periodic_test_files() {
 		}
 		leng = 0;
 
+		gDefectiveDirectories.swap(gDefectiveDirectoriesInProgress);
+		gDefectiveDirectoriesInProgress.clear();
+
 		fsinfo_loopstart = fsinfo_loopend;
 		fsinfo_loopend = main_time();
 	}
-	for (k = 0; k < (NODEHASHSIZE / 14400) && i < NODEHASHSIZE; k++, i++) {
-		for (f = gMetadata->nodehash[i]; f; f = f->next) {
+
+	// Take a snapshot of nodes checked in this call. Chunks of files are evaluated
+	// by workers while the main thread waits, so no metadata is modified meanwhile.
+	uint32_t bucketsPerCall = std::max<uint32_t>(NODEHASHSIZE / gFileTestLoopMinTime, 1);
+	std::vector<FSNode *> nodes;
+	std::vector<FileTestResult> results;
+	for (k = 0; k < bucketsPerCall && i < NODEHASHSIZE; k++, i++) {
+		for (FSNode *f = gMetadata->nodehash[i]; f; f = f->next) {
+			nodes.push_back(f);
 			if (f->type == FSNode::kFile || f->type == FSNode::kTrash || f->type == FSNode::kReserved) {
-				valid = 1;
-				ugflag = 0;
-				for (uint32_t j = 0; j < static_cast<FSNodeFile *>(f)->chunks.size(); ++j) {
-					chunkid = static_cast<FSNodeFile *>(f)->chunks[j];
-					if (chunkid == 0) {
-						continue;
-					}
+				results.emplace_back(static_cast<FSNodeFile *>(f));
+			}
+		}
+	}
+	if (gFileTestExecutor && results.size() > 1) {
+		gFileTestExecutor->run(results.size(), [&results](std::size_t n) {
+			fs_test_file_chunks(results[n], true);
+		});
+	} else {
+		for (FileTestResult &result : results) {
+			fs_test_file_chunks(result, false);
+		}
+	}
 
-					if (chunk_get_fullcopies(chunkid, &vc) != LIZARDFS_STATUS_OK) {
-						if (errors < ERRORS_LOG_MAX) {
-							syslog(LOG_ERR,
-							       "structure error - chunk "
-							       "%016" PRIX64 " not found (inode: %" PRIu32 " ; index: %" PRIu32
-							       ")",
-							       chunkid, f->id, j);
-							if (leng < MSGBUFFSIZE) {
-								leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-								                 "structure error - "
-								                 "chunk %016" PRIX64
-								                 " not found "
-								                 "(inode: %" PRIu32 " ; index: %" PRIu32 ")\n",
-								                 chunkid, f->id, j);
-							}
-							errors++;
+	auto result = results.begin();
+	for (FSNode *f : nodes) {
+		if (f->type == FSNode::kFile || f->type == FSNode::kTrash || f->type == FSNode::kReserved) {
+			if (result->recheck) {
+				fs_test_file_chunks(*result, false);
+			}
+			const FileTestResult &fileResult = *result++;
+			bool valid = fileResult.problems.empty();
+			for (const auto &problem : fileResult.problems) {
+				uint32_t j = problem.first;
+				chunkid = fileResult.node->chunks[j];
+				if (problem.second == FileTestResult::kChunkNotFound) {
+					if (errors < ERRORS_LOG_MAX) {
+						syslog(LOG_ERR,
+						       "structure error - chunk "
+						       "%016" PRIX64 " not found (inode: %" PRIu32 " ; index: %" PRIu32
+						       ")",
+						       chunkid, f->id, j);
+						if (leng < MSGBUFFSIZE) {
+							leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
+							                 "structure error - "
+							                 "chunk %016" PRIX64
+							                 " not found "
+							                 "(inode: %" PRIu32 " ; index: %" PRIu32 ")\n",
+							                 chunkid, f->id, j);
 						}
-						notfoundchunks++;
-						if ((notfoundchunks % 1000) == 0) {
-							syslog(LOG_ERR, "unknown chunks: %" PRIu32 " ...", notfoundchunks);
+						errors++;
+					}
+					notfoundchunks++;
+					if ((notfoundchunks % 1000) == 0) {
+						syslog(LOG_ERR, "unknown chunks: %" PRIu32 " ...", notfoundchunks);
+					}
+					mchunks++;
+				} else {
+					if (errors < ERRORS_LOG_MAX) {
+						syslog(LOG_ERR,
+						       "currently unavailable "
+						       "chunk %016" PRIX64 " (inode: %" PRIu32 " ; index: %" PRIu32 ")",
+						       chunkid, f->id, j);
+						if (leng < MSGBUFFSIZE) {
+							leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
+							                 "currently "
+							                 "unavailable chunk "
+							                 "%016" PRIX64 " (inode: %" PRIu32
+							                 " ; index: %" PRIu32 ")\n",
+							                 chunkid, f->id, j);
 						}
-						valid = 0;
-						mchunks++;
-					} else if (vc == 0) {
-						if (errors < ERRORS_LOG_MAX) {
-							syslog(LOG_ERR,
-							       "currently unavailable "
-							       "chunk %016" PRIX64 " (inode: %" PRIu32 " ; index: %" PRIu32 ")",
-							       chunkid, f->id, j);
-							if (leng < MSGBUFFSIZE) {
-								leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-								                 "currently "
-								                 "unavailable chunk "
-								                 "%016" PRIX64 " (inode: %" PRIu32
-								                 " ; index: %" PRIu32 ")\n",
-								                 chunkid, f->id, j);
-							}
-							errors++;
+						errors++;
+					}
+					unavailchunks++;
+					if ((unavailchunks % 1000) == 0) {
+						syslog(LOG_ERR,
+						       "unavailable chunks: "
+						       "%" PRIu32 " ...",
+						       unavailchunks);
+					}
+					mchunks++;
+				}
+			}
+			chunks += fileResult.chunks;
+			ugchunks += fileResult.undergoalChunks;
+			if (!valid) {
+				mfiles++;
+				if (f->type == FSNode::kTrash) {
+					if (errors < ERRORS_LOG_MAX) {
+						std::string name = (std::string)gMetadata->trash.at(TrashPathKey(f));
+
+						syslog(LOG_ERR,
+						       "- currently unavailable file in "
+						       "trash %" PRIu32 ": %s",
+						       f->id, fsnodes_escape_name(name).c_str());
+						if (leng < MSGBUFFSIZE) {
+							leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
+							                 "- currently unavailable "
+							                 "file in trash %" PRIu32 ": %s\n",
+							                 f->id, fsnodes_escape_name(name).c_str());
 						}
-						unavailchunks++;
-						if ((unavailchunks % 1000) == 0) {
+						errors++;
+						unavailtrashfiles++;
+						if ((unavailtrashfiles % 1000) == 0) {
 							syslog(LOG_ERR,
-							       "unavailable chunks: "
+							       "unavailable trash files: "
 							       "%" PRIu32 " ...",
-							       unavailchunks);
-						}
-						valid = 0;
-						mchunks++;
-					} else {
-						int recover, remove;
-						chunk_get_partstomodify(chunkid, recover, remove);
-						if (recover > 0) {
-							ugflag = 1;
-							ugchunks++;
+							       unavailtrashfiles);
 						}
 					}
-					chunks++;
-				}
-				if (valid == 0) {
-					mfiles++;
-					if (f->type == FSNode::kTrash) {
-						if (errors < ERRORS_LOG_MAX) {
-							std::string name = (std::string)gMetadata->trash.at(TrashPathKey(f));
+				} else if (f->type == FSNode::kReserved) {
+					if (errors < ERRORS_LOG_MAX) {
+						std::string name = (std::string)gMetadata->reserved.at(f->id);
 
+						syslog(LOG_ERR,
+						       "+ currently unavailable reserved "
+						       "file %" PRIu32 ": %s",
+						       f->id, fsnodes_escape_name(name).c_str());
+						if (leng < MSGBUFFSIZE) {
+							leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
+							                 "+ currently unavailable "
+							                 "reserved file %" PRIu32 ": %s\n",
+							                 f->id, fsnodes_escape_name(name).c_str());
+						}
+						errors++;
+						unavailreservedfiles++;
+						if ((unavailreservedfiles % 1000) == 0) {
 							syslog(LOG_ERR,
-							       "- currently unavailable file in "
-							       "trash %" PRIu32 ": %s",
-							       f->id, fsnodes_escape_name(name).c_str());
-							if (leng < MSGBUFFSIZE) {
-								leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-								                 "- currently unavailable "
-								                 "file in trash %" PRIu32 ": %s\n",
-								                 f->id, fsnodes_escape_name(name).c_str());
-							}
-							errors++;
-							unavailtrashfiles++;
-							if ((unavailtrashfiles % 1000) == 0) {
-								syslog(LOG_ERR,
-								       "unavailable trash files: "
-								       "%" PRIu32 " ...",
-								       unavailtrashfiles);
-							}
+							       "unavailable reserved "
+							       "files: %" PRIu32 " ...",
+							       unavailreservedfiles);
 						}
-					} else if (f->type == FSNode::kReserved) {
+					}
+				} else {
+					std::string path;
+					for (const auto parent_inode : f->parent) {
+						gDefectiveDirectoriesInProgress[parent_inode].unavailable++;
 						if (errors < ERRORS_LOG_MAX) {
-							std::string name = (std::string)gMetadata->reserved.at(f->id);
-
+							FSNodeDirectory *parent = fsnodes_id_to_node_verify<FSNodeDirectory>(parent_inode);
+							fsnodes_getpath(parent, f, path);
 							syslog(LOG_ERR,
-							       "+ currently unavailable reserved "
+							       "* currently unavailable "
 							       "file %" PRIu32 ": %s",
-							       f->id, fsnodes_escape_name(name).c_str());
+							       f->id, fsnodes_escape_name(path).c_str());
 							if (leng < MSGBUFFSIZE) {
 								leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-								                 "+ currently unavailable "
-								                 "reserved file %" PRIu32 ": %s\n",
-								                 f->id, fsnodes_escape_name(name).c_str());
+								                 "* currently "
+								                 "unavailable file "
+								                 "%" PRIu32 ": %s\n",
+								                 f->id, fsnodes_escape_name(path).c_str());
 							}
 							errors++;
-							unavailreservedfiles++;
-							if ((unavailreservedfiles % 1000) == 0) {
-								syslog(LOG_ERR,
-								       "unavailable reserved "
-								       "files: %" PRIu32 " ...",
-								       unavailreservedfiles);
-							}
 						}
-					} else {
-						std::string path;
-						for (const auto parent_inode : f->parent) {
-							if (errors < ERRORS_LOG_MAX) {
-								FSNodeDirectory *parent = fsnodes_id_to_node_verify<FSNodeDirectory>(parent_inode);
-								fsnodes_getpath(parent, f, path);
-								syslog(LOG_ERR,
-								       "* currently unavailable "
-								       "file %" PRIu32 ": %s",
-								       f->id, fsnodes_escape_name(path).c_str());
-								if (leng < MSGBUFFSIZE) {
-									leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-									                 "* currently "
-									                 "unavailable file "
-									                 "%" PRIu32 ": %s\n",
-									                 f->id, fsnodes_escape_name(path).c_str());
-								}
-								errors++;
-							}
-							unavailfiles++;
-							if ((unavailfiles % 1000) == 0) {
-								syslog(LOG_ERR, "unavailable files: %" PRIu32 " ...", unavailfiles);
-							}
+						unavailfiles++;
+						if ((unavailfiles % 1000) == 0) {
+							syslog(LOG_ERR, "unavailable files: %" PRIu32 " ...", unavailfiles);
 						}
 					}
-				} else if (ugflag) {
-					ugfiles++;
 				}
-				files++;
+			} else if (fileResult.undergoalChunks > 0) {
+				ugfiles++;
+				if (f->type == FSNode::kFile) {
+					for (const auto parent_inode : f->parent) {
+						gDefectiveDirectoriesInProgress[parent_inode].undergoal++;
+					}
+				}
 			}
-			for (const auto &parent_inode : f->parent) {
-				FSNodeDirectory *parent = fsnodes_id_to_node<FSNodeDirectory>(parent_inode);
-				if (!parent || parent->type != FSNode::kDirectory) {
-					if (errors < ERRORS_LOG_MAX) {
-						syslog(LOG_ERR, "structure error - invalid node's parent (inode: %" PRIu32
-						                " ; parent's inode: %" PRIu32 ")",
-						       f->id, parent_inode);
-						if (leng < MSGBUFFSIZE) {
-							leng +=
-							    snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-							             "structure error - invalid node's parent (inode: %" PRIu32
-							             " ; parent's inode: %" PRIu32 ")",
-							             f->id, parent_inode);
-						}
-						errors++;
+			files++;
+		}
+		for (const auto &parent_inode : f->parent) {
+			FSNodeDirectory *parent = fsnodes_id_to_node<FSNodeDirectory>(parent_inode);
+			if (!parent || parent->type != FSNode::kDirectory) {
+				if (errors < ERRORS_LOG_MAX) {
+					syslog(LOG_ERR, "structure error - invalid node's parent (inode: %" PRIu32
+					                " ; parent's inode: %" PRIu32 ")",
+					       f->id, parent_inode);
+					if (leng < MSGBUFFSIZE) {
+						leng +=
+						    snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
+						             "structure error - invalid node's parent (inode: %" PRIu32
+						             " ; parent's inode: %" PRIu32 ")",
+						             f->id, parent_inode);
 					}
+					errors++;
 				}
 			}
-			if (f->type == FSNode::kDirectory) {
-				for (const auto &entry : static_cast<FSNodeDirectory *>(f)->entries) {
-					FSNode *node = entry.second;
-
-					if (!node ||
-					    std::find(node->parent.begin(), node->parent.end(), f->id) ==
-					        node->parent.end()) {
-						syslog(LOG_ERR,
-						       "structure error - "
-						       "child doesn't point to parent (node: "
-						       "%" PRIu32 " ; parent: %" PRIu32 ")",
-						       node->id, f->id);
-						if (leng < MSGBUFFSIZE) {
-							leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
-							                 "structure error - "
-							                 "child doesn't point to parent (node: "
-							                 "%" PRIu32 " ; parent: %" PRIu32 ")",
-							                 node->id, f->id);
-						}
+		}
+		if (f->type == FSNode::kDirectory) {
+			for (const auto &entry : static_cast<FSNodeDirectory *>(f)->entries) {
+				FSNode *node = entry.second;
+
+				if (!node ||
+				    std::find(node->parent.begin(), node->parent.end(), f->id) ==
+				        node->parent.end()) {
+					syslog(LOG_ERR,
+					       "structure error - "
+					       "child doesn't point to parent (node: "
+					       "%" PRIu32 " ; parent: %" PRIu32 ")",
+					       node->id, f->id);
+					if (leng < MSGBUFFSIZE) {
+						leng += snprintf(msgbuff + leng, MSGBUFFSIZE - leng,
+						                 "structure error - "
+						                 "child doesn't point to parent (node: "
+						                 "%" PRIu32 " ; parent: %" PRIu32 ")",
+						                 node->id, f->id);
 					}
 				}
 			}
 		}
 	}
 }
+
+uint8_t fs_list_defective_directories(uint32_t rootinode,
+		std::vector<DefectiveDirectoryEntry> &entries) {
+	FSNode *root = fsnodes_id_to_node(rootinode);
+	if (root == nullptr || root->type != FSNode::kDirectory) {
+		return LIZARDFS_ERROR_ENOENT;
+	}
+	// Files are counted in their parent directories, which are added to all of their ancestors
+	// within the subtree, so every entry describes the whole subtree of its directory
+	std::map<uint32_t, DefectiveFilesCount> subtrees;
+	std::vector<uint32_t> ancestors;
+	for (const auto &directory : gDefectiveDirectories) {
+		FSNode *node = fsnodes_id_to_node(directory.first);
+		if (node == nullptr || node->type != FSNode::kDirectory) {
+			continue; // removed since the loop ended
+		}
+		ancestors.assign(1, node->id);
+		while (node != root && !node->parent.empty()) {
+			node = fsnodes_id_to_node(node->parent[0]);
+			ancestors.push_back(node->id);
+		}
+		if (node != root) {
+			continue;
+		}
+		for (uint32_t inode : ancestors) {
+			subtrees[inode].unavailable += directory.second.unavailable;
+			subtrees[inode].undergoal += directory.second.undergoal;
+		}
+	}
+	for (const auto &directory : subtrees) {
+		std::string path(fs_getdirpath_size(directory.first), '\0');
+		fs_getdirpath_data(directory.first, (uint8_t *)path.data(), path.size());
+		entries.emplace_back(directory.first, std::move(path), directory.second.unavailable,
+				directory.second.undergoal);
+	}
+	return LIZARDFS_STATUS_OK;
+}
 #endif
 
 struct InodeInfo {
@@ -442,8 +619,27 @@ struct InodeInfo {
 };
 
 #ifndef METARESTORE
+static void fs_changelog_purge(uint32_t ts, std::vector<uint32_t>& inodes) {
+	if (inodes.empty()) {
+		return;
+	}
+	std::string entry;
+	for (uint32_t inode : inodes) {
+		if (!entry.empty()) {
+			entry += ',';
+		}
+		entry += std::to_string(inode);
+	}
+	fs_changelog(ts, "PURGE(%s)", entry.c_str());
+	gPurgedTrashFiles += inodes.size();
+	inodes.clear();
+}
+
 static void fs_do_emptytrash(uint32_t ts) {
 	SignalLoopWatchdog watchdog;
+	std::vector<uint32_t> purged;
+	uint32_t maxInodesInEntry =
+			fs_changelog_followers_have_version(kFirstPurgeBatchVersion) ? kMaxInodesInPurgeEntry : 1;
 
 	auto it = gMetadata->trash.begin();
 	watchdog.start();
@@ -458,11 +654,14 @@ static void fs_do_emptytrash(uint32_t ts) {
 
 		assert(node->type == FSNode::kTrash);
 
-		uint32_t node_id = node->id;
+		purged.push_back(node->id);
 		fsnodes_purge(ts, node);
 
-		// Purge operation should be performed anyway - if it fails, inode will be reserved
-		fs_changelog(ts, "PURGE(%" PRIu32 ")", node_id);
+		// Purge operation should be performed anyway - if it fails, inode will be reserved.
+		// Many purged inodes are stored in one changelog entry.
+		if (purged.size() >= maxInodesInEntry) {
+			fs_changelog_purge(ts, purged);
+		}
 
 		it = gMetadata->trash.begin();
 
@@ -470,6 +669,12 @@ static void fs_do_emptytrash(uint32_t ts) {
 			break;
 		}
 	}
+	fs_changelog_purge(ts, purged);
+
+	gEmptyTrashInProgress = it != gMetadata->trash.end() && (*it).first.timestamp < ts;
+	if (gEmptyTrashInProgress) {
+		main_make_next_poll_nonblocking();
+	}
 }
 #endif
 
@@ -500,10 +705,27 @@ static InodeInfo fs_do_emptytrash_deprecated(uint32_t ts) {
 }
 
 #ifndef METARESTORE
+void fs_periodic_flush_stats(void) {
+	if (gMetadata) {
+		fsnodes_flush_stats();
+	}
+}
+
 void fs_periodic_emptytrash(void) {
 	uint32_t ts = main_time();
 	fs_do_emptytrash(ts);
 }
+
+void fs_background_emptytrash_a_bit(void) {
+	if (gEmptyTrashInProgress) {
+		fs_do_emptytrash(main_time());
+	}
+}
+
+void fs_trash_purge_stats(uint32_t *purged) {
+	*purged = gPurgedTrashFiles;
+	gPurgedTrashFiles = 0;
+}
 #endif
 
 uint8_t fs_apply_emptytrash_deprecated(uint32_t ts, uint32_t freeinodes, uint32_t reservedinodes) {
@@ -515,6 +737,28 @@ uint8_t fs_apply_emptytrash_deprecated(uint32_t ts, uint32_t freeinodes, uint32_
 	return LIZARDFS_STATUS_OK;
 }
 
+uint8_t fs_apply_purge(uint32_t ts, const std::vector<uint32_t>& inodes) {
+	// An entry is applied as a whole or not at all, so all inodes are checked first
+	std::vector<FSNodeFile *> nodes;
+	nodes.reserve(inodes.size());
+	for (uint32_t inode : inodes) {
+		FSNode *node = fsnodes_id_to_node(inode);
+		if (!node || node->type != FSNode::kTrash) {
+			return LIZARDFS_ERROR_MISMATCH;
+		}
+		nodes.push_back(static_cast<FSNodeFile *>(node));
+	}
+	std::sort(nodes.begin(), nodes.end());
+	if (std::adjacent_find(nodes.begin(), nodes.end()) != nodes.end()) {
+		return LIZARDFS_ERROR_MISMATCH;
+	}
+	for (FSNodeFile *node : nodes) {
+		fsnodes_purge(ts, node);
+	}
+	gMetadata->metaversion++;
+	return LIZARDFS_STATUS_OK;
+}
+
 uint8_t fs_apply_emptyreserved_deprecated(uint32_t /*ts*/,uint32_t /*freeinodes*/) {
 	return LIZARDFS_STATUS_OK;
 }
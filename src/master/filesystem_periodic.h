@@ -21,6 +21,8 @@
 
 #include "common/platform.h"
 
+#include <cstdint>
+
 /*! \brief Function processing TaskManager's enqueued tasks.
  *
  * The function processes limited number of tasks in each call,
@@ -36,5 +38,20 @@ void fs_background_task_manager_work();
  */
 void fs_background_checksum_recalculation_a_bit();
 void fs_periodic_test_files();
+
+/// Sets number of threads (besides the main one) checking chunks of files in fs_periodic_test_files
+void fs_test_files_set_workers(uint32_t workers);
+
+/// Sets minimal number of seconds in which fs_periodic_test_files checks all files
+void fs_test_files_set_loop_min_time(uint32_t seconds);
 void fs_periodic_emptytrash(void);
+
+/// Applies statistics changes of directories to their ancestors
+void fs_periodic_flush_stats(void);
+
+/// Continues purging expired trash files if fs_periodic_emptytrash didn't manage to purge all
+void fs_background_emptytrash_a_bit(void);
+
+/// Returns number of trash files purged since the previous call
+void fs_trash_purge_stats(uint32_t *purged);
 void fs_periodic_emptyreserved(void);
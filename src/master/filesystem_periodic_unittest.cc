@@ -0,0 +1,142 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/filesystem_periodic.h"
+
+#include <array>
+#include <gtest/gtest.h>
+
+#include "common/special_inode_defs.h"
+#include "master/chunks.h"
+#include "master/filesystem.h"
+#include "master/filesystem_metadata.h"
+#include "master/filesystem_node.h"
+#include "protocol/MFSCommunication.h"
+#include "unittests/master_filesystem.h"
+
+using unittests::MasterFilesystem;
+
+inline bool operator==(const DefectiveDirectoryEntry &a, const DefectiveDirectoryEntry &b) {
+	return a.inode == b.inode && a.path == b.path && a.unavailableFiles == b.unavailableFiles &&
+			a.undergoalFiles == b.undergoalFiles;
+}
+
+class FileTestLoopTests : public ::testing::Test {
+protected:
+	typedef std::array<uint32_t, 6> Counters; // files, ugfiles, mfiles, chunks, ugchunks, mchunks
+
+	void SetUp() override {
+		MasterFilesystem::setTime(1000);
+		gTestStartTime = 0;
+		fs_test_files_set_loop_min_time(1); // check all files in each call
+		dirA_ = createDirectory(SPECIAL_INODE_ROOT, "a");
+		dirB_ = createDirectory(SPECIAL_INODE_ROOT, "b");
+		dirC_ = createDirectory(dirB_, "c");
+
+		// Chunk which is not known to the master
+		uint32_t file = createFile(dirA_, "unknown_chunk");
+		fsnodes_id_to_node<FSNodeFile>(file)->chunks.push_back(0x1000);
+		createFile(dirA_, "empty");
+		// Chunk without any copies
+		file = createFile(dirC_, "lost_chunk");
+		uint64_t chunkid;
+		ASSERT_EQ(LIZARDFS_STATUS_OK, chunk_apply_modification(1000, 0, 1, 1, false, &chunkid));
+		fsnodes_id_to_node<FSNodeFile>(file)->chunks.push_back(chunkid);
+		createFile(dirC_, "empty");
+	}
+
+	void TearDown() override {
+		fs_test_files_set_workers(0);
+	}
+
+	static uint32_t createDirectory(uint32_t parent, const std::string &name) {
+		uint32_t inode = 0;
+		Attributes attr;
+		EXPECT_EQ(LIZARDFS_STATUS_OK, fs_mkdir(SPECIAL_INODE_ROOT, 0, parent, HString(name),
+				0755, 0, 0, 0, 0, 0, 0, &inode, attr));
+		return inode;
+	}
+
+	static uint32_t createFile(uint32_t parent, const std::string &name) {
+		uint32_t inode = 0;
+		Attributes attr;
+		EXPECT_EQ(LIZARDFS_STATUS_OK, fs_mknod(SPECIAL_INODE_ROOT, 0, parent, HString(name),
+				TYPE_FILE, 0644, 0, 0, 0, 0, 0, 0, &inode, attr));
+		return inode;
+	}
+
+	/// Runs a complete loop, so that its results are published by the next one
+	static void runLoop() {
+		fs_periodic_test_files();
+		fs_periodic_test_files();
+	}
+
+	static Counters counters() {
+		uint32_t loopstart, loopend, msgbuffleng;
+		char *msgbuff;
+		Counters c;
+		fs_test_getdata(&loopstart, &loopend, &c[0], &c[1], &c[2], &c[3], &c[4], &c[5],
+				&msgbuff, &msgbuffleng);
+		return c;
+	}
+
+	static std::vector<DefectiveDirectoryEntry> defectiveDirectories(uint32_t root) {
+		std::vector<DefectiveDirectoryEntry> entries;
+		EXPECT_EQ(LIZARDFS_STATUS_OK, fs_list_defective_directories(root, entries));
+		return entries;
+	}
+
+	MasterFilesystem fs_;
+	uint32_t dirA_, dirB_, dirC_;
+};
+
+TEST_F(FileTestLoopTests, ListDefectiveDirectories) {
+	runLoop();
+	EXPECT_EQ((Counters{{4, 0, 2, 2, 0, 2}}), counters());
+
+	// Counts of a directory include files in its subdirectories
+	std::vector<DefectiveDirectoryEntry> expected{
+			{SPECIAL_INODE_ROOT, "/", 2, 0},
+			{dirA_, "/a", 1, 0},
+			{dirB_, "/b", 1, 0},
+			{dirC_, "/b/c", 1, 0}};
+	EXPECT_EQ(expected, defectiveDirectories(SPECIAL_INODE_ROOT));
+
+	// Only directories in the given subtree are listed
+	expected = {{dirB_, "/b", 1, 0}, {dirC_, "/b/c", 1, 0}};
+	EXPECT_EQ(expected, defectiveDirectories(dirB_));
+	expected = {{dirA_, "/a", 1, 0}};
+	EXPECT_EQ(expected, defectiveDirectories(dirA_));
+
+	std::vector<DefectiveDirectoryEntry> entries;
+	EXPECT_EQ(LIZARDFS_ERROR_ENOENT, fs_list_defective_directories(dirC_ + 100, entries));
+}
+
+TEST_F(FileTestLoopTests, WorkersFindTheSameProblems) {
+	fs_test_files_set_workers(0);
+	runLoop();
+	Counters serialCounters = counters();
+	auto serialDirectories = defectiveDirectories(SPECIAL_INODE_ROOT);
+
+	fs_test_files_set_workers(2);
+	runLoop();
+	EXPECT_EQ(serialCounters, counters());
+	EXPECT_EQ(serialDirectories, defectiveDirectories(SPECIAL_INODE_ROOT));
+	EXPECT_EQ(4U, serialDirectories.size());
+}
@@ -68,6 +68,7 @@ uint8_t fs_quota_get_all(uint8_t sesflags, uint32_t root_inode, uint32_t uid,
 	}
 	results = gMetadata->quota_database.getEntriesWithStats();
 
+	fsnodes_flush_stats();
 	for (auto &entry : results) {
 		if (entry.entryKey.owner.ownerType != QuotaOwnerType::kInode ||
 		    entry.entryKey.rigor != QuotaRigor::kUsed) {
@@ -130,6 +131,7 @@ uint8_t fs_quota_get(uint8_t sesflags, uint32_t root_inode, uint32_t uid, uint32
 				if (owner.ownerType == QuotaOwnerType::kInode && rigor == QuotaRigor::kUsed) {
 					node = fsnodes_id_to_node<FSNodeDirectory>(owner.ownerId);
 					assert(node);
+					fsnodes_flush_stats(node);
 					tmp.push_back({{owner, rigor, QuotaResource::kInodes},
 					               (uint64_t)node->stats.inodes});
 					tmp.push_back({{owner, rigor, QuotaResource::kSize},
@@ -341,6 +343,7 @@ static bool fsnodes_test_dir_quota_noparents(FSNode *node,
 		return false;
 	}
 
+	fsnodes_flush_stats(static_cast<FSNodeDirectory*>(node));
 	const statsrecord &stats = static_cast<FSNodeDirectory*>(node)->stats;
 	uint64_t limit;
 
@@ -17,6 +17,7 @@
 */
 
 #include "common/platform.h"
+#include "master/filesystem_snapshot.h"
 
 #include "common/main.h"
 #include "master/filesystem_checksum_updater.h"
@@ -25,7 +26,7 @@
 #include "master/snapshot_task.h"
 #include "master/task_manager.h"
 
-static const int kInitialSnapshotTaskBatch = 1000;
+static const int kInitialSnapshotTaskBatch = 100;
 
 uint8_t fs_snapshot(const FsContext &context, uint32_t inode_src, uint32_t parent_dst,
 					const HString &name_dst, uint8_t can_overwrite,
@@ -69,7 +70,24 @@ uint8_t fs_clone_node(const FsContext &context, uint32_t inode_src, uint32_t par
 	SnapshotTask task({{inode_src, name_dst}}, 0, parent_dst, inode_dst, can_overwrite,
 			  false, false);
 
-	return task.cloneNode(context.ts());
+	uint8_t status = task.cloneNode(context.ts());
+	if (status == LIZARDFS_STATUS_OK) {
+		gMetadata->metaversion++;
+	}
+	return status;
+}
+
+uint8_t fs_apply_clone(uint32_t ts, const std::vector<CloneEntry> &entries) {
+	for (const auto &entry : entries) {
+		SnapshotTask task({{entry.inode_src, entry.name_dst}}, 0, entry.parent_dst,
+		                  entry.inode_dst, entry.can_overwrite, false, false);
+		uint8_t status = task.cloneNode(ts);
+		if (status != LIZARDFS_STATUS_OK) {
+			return status;
+		}
+	}
+	gMetadata->metaversion++;
+	return LIZARDFS_STATUS_OK;
 }
 
 uint8_t fsnodes_deprecated_snapshot_test(FSNode *origsrcnode, FSNode *srcnode,
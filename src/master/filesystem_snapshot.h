@@ -19,7 +19,21 @@
 #pragma once
 
 #include "common/platform.h"
+
+#include <functional>
+#include <vector>
+
 #include "master/fs_context.h"
+#include "master/hstring.h"
+
+/*! \brief Single clone operation recorded in CLONE changelog entry. */
+struct CloneEntry {
+	uint32_t inode_src;
+	uint32_t parent_dst;
+	uint32_t inode_dst;
+	HString name_dst;
+	uint8_t can_overwrite;
+};
 
 /*! \brief Deprecated snapshot function.
  *
@@ -58,3 +72,12 @@ uint8_t fs_snapshot(const FsContext &context, uint32_t inode_src, uint32_t paren
 uint8_t fs_clone_node(const FsContext &context, uint32_t inode_src, uint32_t parent_dst,
 		uint32_t inode_dst, const HString &name_dst,
 		uint8_t can_overwrite);
+
+/*! \brief Apply all clone operations from a single CLONE changelog entry.
+ *
+ * Metadata version is increased only once for the whole entry.
+ *
+ * \param ts time stamp of the changelog entry.
+ * \param entries clone operations in the order they were performed by master.
+ */
+uint8_t fs_apply_clone(uint32_t ts, const std::vector<CloneEntry> &entries);
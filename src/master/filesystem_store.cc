@@ -23,11 +23,13 @@
 #include <cstdio>
 #include <vector>
 
+#include "common/compressed_metadata.h"
 #include "common/cwrap.h"
 #include "common/main.h"
 #include "common/setup.h"
 #include "common/lizardfs_version.h"
 #include "common/metadata.h"
+#include "common/metrics.h"
 #include "common/rotate_files.h"
 #include "common/setup.h"
 
@@ -478,6 +480,8 @@ int fs_loadedge(FILE *fd, int ignoreflag) {
 			current_parent_id = parent_id;
 		}
 
+		fsnodes_get_stats(child, &sr);
+
 		auto it = parent->entries.insert({hstorage::Handle(name), child}).first;
 		parent->entries_hash ^= (*it).first.hash();
 
@@ -487,7 +491,6 @@ int fs_loadedge(FILE *fd, int ignoreflag) {
 			parent->nlink++;
 		}
 
-		fsnodes_get_stats(child, &sr);
 		fsnodes_add_stats(parent, &sr);
 
 	}
@@ -881,6 +884,7 @@ int fs_loadedges(FILE *fd, int ignoreflag) {
 			return -1;
 		}
 	} while (s == 0);
+	fsnodes_flush_stats();
 	return 0;
 }
 
@@ -1116,6 +1120,24 @@ void fs_store_fd(FILE *fd) {
 	}
 }
 
+bool fs_store_file(FILE *fd) {
+	if (gMetadataDumpCompressionLevel > 0 && compressedMetadataSupported()) {
+		FILE *compressed = compressedMetadataOpenWriter(fd, gMetadata->metaversion,
+				gMetadataDumpCompressionLevel);
+		if (compressed == nullptr) {
+			return false;
+		}
+		fs_store_fd(compressed);
+		bool status = (ferror(compressed) == 0);
+		if (fclose(compressed) != 0) {
+			status = false;
+		}
+		return status && ferror(fd) == 0;
+	}
+	fs_store_fd(fd);
+	return ferror(fd) == 0;
+}
+
 uint64_t fs_loadversion(FILE *fd) {
 	uint8_t hdr[12];
 	const uint8_t *ptr;
@@ -1515,6 +1537,7 @@ void fs_load_changelog(const std::string &path) {
 
 void fs_loadall(const std::string& fname,int ignoreflag) {
 	cstream_t fd(fopen(fname.c_str(), "r"));
+	cstream_t compressed;
 	std::string fnameWithPath;
 	if (fname.front() == '/') {
 		fnameWithPath = fname;
@@ -1526,9 +1549,23 @@ void fs_loadall(const std::string& fname,int ignoreflag) {
 	}
 	lzfs_pretty_syslog(LOG_INFO,"opened metadata file %s", fnameWithPath.c_str());
 	uint8_t hdr[8];
-	if (fread(hdr,1,8,fd.get())!=8) {
+	FILE *stream = fd.get();
+	if (fread(hdr,1,8,stream)!=8) {
 		throw MetadataConsistencyException("can't read metadata header");
 	}
+	if (memcmp(hdr, kCompressedMetadataSignature, 8) == 0) {
+		if (!compressedMetadataSupported()) {
+			throw MetadataConsistencyException("compressed metadata files are not supported");
+		}
+		compressed.reset(compressedMetadataOpenReader(fd.get()));
+		if (compressed == nullptr) {
+			throw MetadataConsistencyException("compressed metadata file is damaged or truncated");
+		}
+		stream = compressed.get();
+		if (fread(hdr,1,8,stream)!=8) {
+			throw MetadataConsistencyException("can't read metadata header");
+		}
+	}
 #ifndef METARESTORE
 	if (metadataserver::isMaster()) {
 		if (memcmp(hdr, "MFSM NEW", 8) == 0) {    // special case - create new file system
@@ -1554,10 +1591,10 @@ void fs_loadall(const std::string& fname,int ignoreflag) {
 		throw MetadataConsistencyException("wrong metadata header version");
 	}
 
-	if (fs_load(fd.get(), ignoreflag, metadataVersion) < 0) {
+	if (fs_load(stream, ignoreflag, metadataVersion) < 0) {
 		throw MetadataConsistencyException(MetadataStructureReadErrorMsg);
 	}
-	if (ferror(fd.get())!=0) {
+	if (ferror(stream)!=0) {
 		throw MetadataConsistencyException(MetadataStructureReadErrorMsg);
 	}
 	lzfs_pretty_syslog_attempt(LOG_INFO,"connecting files and chunks");
@@ -1585,6 +1622,17 @@ void fs_loadall(const std::string& fname,int ignoreflag) {
 // Broadcasts information about status of the freshly finished
 // metadata save process to interested modules.
 void fs_broadcast_metadata_saved(uint8_t status) {
+	static metrics::Histogram &dumpTime = metrics::registry().histogram(
+			"lizardfs_master_metadata_dump_duration_milliseconds",
+			"Time of saving metadata, from the start of a dump until it is finished");
+	static metrics::Counter &failedDumps = metrics::registry().counter(
+			"lizardfs_master_metadata_dump_failures_total",
+			"Number of failed metadata dumps");
+	dumpTime.record(std::chrono::duration_cast<std::chrono::milliseconds>(
+			metadataDumper.dumpTime()).count());
+	if (status != LIZARDFS_STATUS_OK) {
+		failedDumps.increment();
+	}
 	matomlserv_broadcast_metadata_saved(status);
 	matoclserv_broadcast_metadata_saved(status);
 }
@@ -1655,9 +1703,7 @@ uint8_t fs_storeall(MetadataDumper::DumpType dumpType) {
 			return LIZARDFS_ERROR_IO;
 		}
 
-		fs_store_fd(fd.get());
-
-		if (ferror(fd.get()) != 0) {
+		if (!fs_store_file(fd.get())) {
 			syslog(LOG_ERR, "can't write metadata");
 			fd.reset();
 			unlink(kMetadataTmpFilename);
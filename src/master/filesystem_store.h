@@ -38,4 +38,12 @@ void fs_broadcast_metadata_saved(uint8_t status);
 void fs_load_changelogs();
 void fs_load_changelog(const std::string &path);
 void fs_loadall(const std::string& fname,int ignoreflag);
+
+/// Creates a new filesystem which contains only the root directory
+void fs_new(void);
 void fs_store_fd(FILE *fd);
+
+/*! \brief Stores metadata into \a fd, compressed if METADATA_DUMP_COMPRESSION_LEVEL is set.
+ * \return true on success
+ */
+bool fs_store_file(FILE *fd);
@@ -62,53 +62,91 @@ void GetServersForNewChunk::prepareData(ChunkCreationHistory &history) {
 	                 [](const ChunkserverChunkCounter &a, const ChunkserverChunkCounter &b) {
 		                 int64_t aRelativeUsage = a.chunks_created * b.weight;
 		                 int64_t bRelativeUsage = b.chunks_created * a.weight;
-		                 return (aRelativeUsage < bRelativeUsage ||
-		                         (aRelativeUsage == bRelativeUsage && a.weight > b.weight));
+		                 if (aRelativeUsage != bRelativeUsage) {
+			                 return aRelativeUsage < bRelativeUsage;
+		                 }
+		                 return a.weight > b.weight;
 		         });
 }
 
+int GetServersForNewChunk::chooseServer(const MediaLabel &label, uint32_t min_version,
+	const std::vector<matocsserventry *> &used,
+	const std::vector<uint32_t> &used_locations) const {
+	int chosen = -1;
+	for (int i = 0; i < (int)servers_.size(); ++i) {
+		const auto &server = servers_[i];
+		if (server.version < min_version ||
+		    (label != MediaLabel::kWildcard && server.label != label) ||
+		    std::find(used.begin(), used.end(), server.server) != used.end()) {
+			continue;
+		}
+		if (used.empty()) {
+			// The first copy goes to the closest of the servers with the lowest usage
+			if (chosen < 0) {
+				chosen = i;
+			} else if (server.chunks_created * servers_[chosen].weight !=
+			           servers_[chosen].chunks_created * server.weight) {
+				break;
+			} else if (server.distance < servers_[chosen].distance) {
+				chosen = i;
+			}
+			continue;
+		}
+		if (chosen < 0) {
+			chosen = i;
+		}
+		// Other copies go to the least used server in a rack without a copy if there is one,
+		// so that losing a rack doesn't lose all copies
+		if (std::find(used_locations.begin(), used_locations.end(), server.location) ==
+		    used_locations.end()) {
+			return i;
+		}
+	}
+	return chosen;
+}
+
 std::vector<matocsserventry *> GetServersForNewChunk::chooseServersForLabels(
 	ChunkCreationHistory &history, const Goal::Slice::ConstPartProxy &labels, uint32_t min_version,
 	std::vector<matocsserventry *> &used) {
 	std::vector<matocsserventry *> result;
+	std::vector<uint32_t> used_locations;
+	for (const auto &server : servers_) {
+		if (std::find(used.begin(), used.end(), server.server) != used.end()) {
+			used_locations.push_back(server.location);
+		}
+	}
 
 	// TODO(Haze): It should be optimized also for large number of servers.
+	auto add_server = [&](const MediaLabel &label) {
+		int index = chooseServer(label, min_version, used, used_locations);
+		if (index < 0) {
+			return false;
+		}
+		result.push_back(servers_[index].server);
+		used.push_back(servers_[index].server);
+		used_locations.push_back(servers_[index].location);
+		return true;
+	};
 
 	// Choose servers for non-wildcard labels
 	for (const auto &label_and_count : labels) {
-		int copies_to_be_created = label_and_count.second;
 		if (label_and_count.first == MediaLabel::kWildcard) {
 			break;
 		}
-		for (const auto &server : servers_) {
-			if (copies_to_be_created == 0) {
+		for (int i = 0; i < label_and_count.second; ++i) {
+			if (!add_server(label_and_count.first)) {
 				break;
 			}
-			if (server.version < min_version ||
-			    std::find(used.begin(), used.end(), server.server) != used.end()) {
-				continue;
-			}
-			if (server.label == label_and_count.first) {
-				result.push_back(server.server);
-				used.push_back(server.server);
-				--copies_to_be_created;
-			}
 		}
 	}
 
 	int expected_copies = Goal::Slice::countLabels(labels);
 
 	// Add any servers to have the desired number of copies
-	for (const auto &server : servers_) {
-		if ((int)result.size() >= expected_copies) {
+	while ((int)result.size() < expected_copies) {
+		if (!add_server(MediaLabel::kWildcard)) {
 			break;
 		}
-		if (server.version < min_version ||
-		    std::find(used.begin(), used.end(), server.server) != used.end()) {
-			continue;
-		}
-		result.push_back(server.server);
-		used.push_back(server.server);
 	}
 
 	// Update the history
@@ -32,11 +32,13 @@ struct matocsserventry;
 /// information didn't change.
 struct ChunkserverChunkCounter {
 	ChunkserverChunkCounter(matocsserventry *server, MediaLabel label, int64_t weight,
-	                        uint32_t version)
+	                        uint32_t version, uint32_t distance = 0, uint32_t location = 0)
 	    : server(server),
 	      label(std::move(label)),
 	      weight(weight),
 	      version(version),
+	      distance(distance),
+	      location(location),
 	      chunks_created(0) {
 	}
 
@@ -45,6 +47,12 @@ struct ChunkserverChunkCounter {
 	int64_t weight;
 	uint32_t version;
 
+	/// Network distance from the client which creates the chunk, not a part of the history.
+	uint32_t distance;
+
+	/// Id of the server's location (rack) in the network topology, not a part of the history.
+	uint32_t location;
+
 	/// Number of chunks created on this sever.
 	/// This information would be reset if anything did change (eg. list of servers,
 	/// their labels or weights).
@@ -67,10 +75,14 @@ public:
 	 * \param label server's label.
 	 * \param weight server priority used in search.
 	 * \param version chunk server version.
+	 * \param distance network distance from the client, the first copy goes to the closest
+	 *        of the servers with the lowest usage.
+	 * \param location id of the server's rack, the remaining copies go to other racks
+	 *        than the ones already used if possible.
 	 */
 	void addServer(matocsserventry *server, const MediaLabel &label, int64_t weight,
-	               uint32_t version) {
-		servers_.emplace_back(server, label, weight, version);
+	               uint32_t version, uint32_t distance = 0, uint32_t location = 0) {
+		servers_.emplace_back(server, label, weight, version, distance, location);
 	}
 
 	/*! \brief Prepare data for subsequent calls to chooseServersForLabels.
@@ -91,5 +103,14 @@ public:
 	                                                      uint32_t min_version,
 	                                                      std::vector<matocsserventry *> &used);
 private:
+	/*! \brief Chooses a server for the next copy of the chunk.
+	 *
+	 * \param label requested label, kWildcard for any.
+	 * \return index in servers_ or -1 if there is no suitable server.
+	 */
+	int chooseServer(const MediaLabel &label, uint32_t min_version,
+	                 const std::vector<matocsserventry *> &used,
+	                 const std::vector<uint32_t> &used_locations) const;
+
 	std::vector<ChunkserverChunkCounter> servers_;
 };
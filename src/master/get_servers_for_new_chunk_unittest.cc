@@ -20,6 +20,7 @@
 #include "common/media_label.h"
 #include "master/get_servers_for_new_chunk.h"
 
+#include <set>
 #include <gtest/gtest.h>
 
 #include "master/goal_config_loader.h"
@@ -260,6 +261,57 @@ void testScenario(double maxUsageDifference, std::vector<std::string> goalDefs,
 			<< "Disk usage on servers: " << ::testing::PrintToString(diskUsageOnServer);
 }
 
+TEST_F(GetServersForNewChunkTests, ClosestServerFirstOtherRacksNext) {
+	// servers: A1 A2 at distance 1, A3 A4 A5 at distance 2
+	//    goal: _ _
+	Goal::Slice::Labels labels = {{MediaLabel::kWildcard, 2}};
+	auto name = [](matocsserventry* server) {
+		return reinterpret_cast<const AllServers::value_type*>(server)->first;
+	};
+	auto choose = [&](ChunkCreationHistory& history, bool two_racks) {
+		GetServersForNewChunk getter;
+		for (const char* server_name : {"A1", "A2", "A3", "A4", "A5"}) {
+			auto it = allServers.find(server_name);
+			matocsserventry* server = reinterpret_cast<matocsserventry*>(
+					const_cast<AllServers::value_type*>(&(*it)));
+			uint32_t distance = it->first <= "A2" ? 1 : 2;
+			getter.addServer(server, it->second, 1, 0, distance, two_racks ? distance : 1);
+		}
+		getter.prepareData(history);
+		std::vector<matocsserventry *> used;
+		return getter.chooseServersForLabels(history, createProxy(labels), 0, used);
+	};
+
+	// In one rack distance only chooses between servers with the same number of chunks
+	ChunkCreationHistory history;
+	std::map<std::string, int> chunksOnServer;
+	for (int i = 0; i < 5 * kTestAccuracy; ++i) {
+		auto result = choose(history, false);
+		ASSERT_EQ(2U, result.size());
+		if (i % 5 == 0) {
+			EXPECT_LE(name(result[0]), "A2");
+		}
+		for (matocsserventry* server : result) {
+			chunksOnServer[name(server)]++;
+		}
+	}
+	for (const auto& entry : chunksOnServer) {
+		EXPECT_EQ(2 * kTestAccuracy, entry.second) << entry.first;
+	}
+
+	// The second copy goes to the other rack, so losing a rack doesn't lose the chunk
+	history.clear();
+	for (int i = 0; i < 5 * kTestAccuracy; ++i) {
+		auto result = choose(history, true);
+		ASSERT_EQ(2U, result.size());
+		if (i == 0) {
+			EXPECT_LE(name(result[0]), "A2");
+		}
+		EXPECT_NE(name(result[0]) <= "A2", name(result[1]) <= "A2")
+				<< name(result[0]) << " " << name(result[1]);
+	}
+}
+
 TEST_F(GetServersForNewChunkTests, ChunkDistribution) {
 	double acceptableDifference = 0.01;
 
@@ -148,6 +148,10 @@ static void* download_hook;
 #endif /* #ifndef METALOGGER */
 static uint64_t lastlogversion=0;
 
+// Replication lag, known if the master sends changes in batches
+static uint64_t master_metaversion=0;
+static uint32_t lagging_since=0;
+
 static uint32_t stats_bytesout=0;
 static uint32_t stats_bytesin=0;
 
@@ -276,6 +280,8 @@ void masterconn_sendregister(masterconn *eptr) {
 
 	eptr->downloading=0;
 	eptr->metafd=-1;
+	master_metaversion=0;
+	lagging_since=0;
 
 #ifndef METALOGGER
 	// shadow master registration
@@ -398,6 +404,38 @@ void masterconn_registered(masterconn *eptr, const uint8_t *data, uint32_t lengt
 }
 #endif
 
+/*! \brief Stores (and in shadow masters applies) a changelog entry received from the master.
+ *
+ * \return false if the entry couldn't be applied and the session with the master was reset
+ */
+static bool masterconn_apply_changelog_entry(masterconn *eptr, uint64_t version,
+		const char *changelogEntry) {
+	if ((lastlogversion > 0) && (version != (lastlogversion + 1))) {
+		syslog(LOG_WARNING, "some changes lost: [%" PRIu64 "-%" PRIu64 "], download metadata again",lastlogversion,version-1);
+		masterconn_handle_changelog_apply_error(eptr, LIZARDFS_ERROR_METADATAVERSIONMISMATCH);
+		return false;
+	}
+
+#ifndef METALOGGER
+	if (eptr->state == MasterConnectionState::kSynchronized) {
+		std::string buf(": ");
+		buf.append(changelogEntry);
+		static char const network[] = "network";
+		uint8_t status;
+		if ((status = restore(network, version, buf.c_str(),
+				RestoreRigor::kDontIgnoreAnyErrors)) != LIZARDFS_STATUS_OK) {
+			syslog(LOG_WARNING, "malformed changelog sent by the master server, can't apply it. status: %s",
+					mfsstrerr(status));
+			masterconn_handle_changelog_apply_error(eptr, status);
+			return false;
+		}
+	}
+#endif /* #ifndef METALOGGER */
+	changelog(version, changelogEntry);
+	lastlogversion = version;
+	return true;
+}
+
 void masterconn_metachanges_log(masterconn *eptr,const uint8_t *data,uint32_t length) {
 	if ((length == 1) && (data[0] == FORCE_LOG_ROTATE)) {
 #ifdef METALOGGER
@@ -426,30 +464,26 @@ void masterconn_metachanges_log(masterconn *eptr,const uint8_t *data,uint32_t le
 	data++;
 	uint64_t version = get64bit(&data);
 	const char* changelogEntry = reinterpret_cast<const char*>(data);
+	masterconn_apply_changelog_entry(eptr, version, changelogEntry);
+}
 
-	if ((lastlogversion > 0) && (version != (lastlogversion + 1))) {
-		syslog(LOG_WARNING, "some changes lost: [%" PRIu64 "-%" PRIu64 "], download metadata again",lastlogversion,version-1);
-		masterconn_handle_changelog_apply_error(eptr, LIZARDFS_ERROR_METADATAVERSIONMISMATCH);
-		return;
-	}
-
-#ifndef METALOGGER
-	if (eptr->state == MasterConnectionState::kSynchronized) {
-		std::string buf(": ");
-		buf.append(changelogEntry);
-		static char const network[] = "network";
-		uint8_t status;
-		if ((status = restore(network, version, buf.c_str(),
-				RestoreRigor::kDontIgnoreAnyErrors)) != LIZARDFS_STATUS_OK) {
-			syslog(LOG_WARNING, "malformed changelog sent by the master server, can't apply it. status: %s",
-					mfsstrerr(status));
-			masterconn_handle_changelog_apply_error(eptr, status);
+void masterconn_metachanges_log_batch(masterconn *eptr, const uint8_t *data, uint32_t length) {
+	uint64_t firstVersion, masterMetadataVersion;
+	std::vector<std::string> entries;
+	matoml::metachangesLogBatch::deserialize(data, length,
+			firstVersion, masterMetadataVersion, entries);
+	for (uint32_t i = 0; i < entries.size(); ++i) {
+		if (!masterconn_apply_changelog_entry(eptr, firstVersion + i, entries[i].c_str())) {
 			return;
 		}
 	}
-#endif /* #ifndef METALOGGER */
-	changelog(version, changelogEntry);
-	lastlogversion = version;
+	master_metaversion = masterMetadataVersion;
+	if (lastlogversion + 1 >= master_metaversion) {
+		lagging_since = 0;
+	} else if (lagging_since == 0) {
+		lagging_since = main_time();
+	}
+	masterconn_createpacket(eptr, mltoma::metachangesLogAck::build(lastlogversion));
 }
 
 void masterconn_end_session(masterconn *eptr, const uint8_t* data, uint32_t length) {
@@ -748,6 +782,9 @@ void masterconn_gotpacket(masterconn *eptr,uint32_t type,const uint8_t *data,uin
 			case MATOML_METACHANGES_LOG:
 				masterconn_metachanges_log(eptr,data,length);
 				break;
+			case LIZ_MATOML_METACHANGES_LOG_BATCH:
+				masterconn_metachanges_log_batch(eptr,data,length);
+				break;
 			case LIZ_MATOML_END_SESSION:
 				masterconn_end_session(eptr,data,length);
 				break;
@@ -1245,6 +1282,20 @@ int masterconn_init(void) {
 	return 0;
 }
 
+void masterconn_replication_lag(uint64_t& versions, uint32_t& seconds) {
+	versions = 0;
+	seconds = 0;
+	if (!masterconn_is_connected() || master_metaversion == 0) {
+		return;
+	}
+	if (lastlogversion + 1 < master_metaversion) {
+		versions = master_metaversion - (lastlogversion + 1);
+	}
+	if (lagging_since > 0) {
+		seconds = main_time() - lagging_since;
+	}
+}
+
 bool masterconn_is_connected() {
 	masterconn *eptr = masterconnsingleton;
 	return (eptr != nullptr
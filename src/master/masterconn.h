@@ -26,3 +26,11 @@
 int masterconn_init(void);
 
 bool masterconn_is_connected();
+
+/*! \brief Returns how far behind the active master this server is.
+ *
+ * Known only if the master sends changelog in batches, zeros are returned otherwise.
+ * \param versions - number of metadata versions not applied yet
+ * \param seconds - for how long this server hasn't been up to date
+ */
+void masterconn_replication_lag(uint64_t& versions, uint32_t& seconds);
@@ -35,7 +35,9 @@
 #include <unistd.h>
 #include <fstream>
 #include <memory>
+#include <unordered_map>
 
+#include "common/batch_executor.h"
 #include "common/cfg.h"
 #include "common/charts.h"
 #include "common/chunk_type_with_address.h"
@@ -53,12 +55,16 @@
 #include "common/massert.h"
 #include "common/md5.h"
 #include "common/metadata.h"
+#include "common/metrics.h"
 #include "common/moosefs_vector.h"
 #include "common/network_address.h"
 #include "common/random.h"
 #include "common/serialized_goal.h"
 #include "common/slogger.h"
 #include "common/sockets.h"
+#include "common/time_utils.h"
+#include "common/tracing.h"
+#include "master/cache_leases.h"
 #include "master/changelog.h"
 #include "master/chartsdata.h"
 #include "master/chunks.h"
@@ -68,6 +74,7 @@
 #include "master/filesystem.h"
 #include "master/filesystem_operations.h"
 #include "master/filesystem_snapshot.h"
+#include "master/hstring_memstorage.h"
 #include "master/masterconn.h"
 #include "master/matocsserv.h"
 #include "master/matomlserv.h"
@@ -79,6 +86,9 @@
 
 #define MaxPacketSize 1000000
 
+// spans of requests traced by clients, appended in the data directory
+#define TRACES_FILENAME "traces.log"
+
 // matoclserventry.mode
 enum {KILL,HEADER,DATA};
 // chunklis.type
@@ -220,6 +230,8 @@ struct matoclserventry {
 /* CACHENOTIFY
 	dirincache *cacheddirs;
 */
+	uint32_t cacheLeaseTime;                // 0 - client doesn't use cache leases
+	std::vector<uint32_t> leasedInodes;     // leases to be granted after current request
 
 	struct matoclserventry *next;
 };
@@ -242,6 +254,14 @@ static uint32_t gIoLimitsConfigId;
 static std::string gIoLimitsSubsystem;
 static IoLimitsDatabase gIoLimitsDatabase;
 
+static uint32_t gReadOnlyWorkers;
+
+static uint32_t gMaxCacheLeaseTime;
+static CacheLeases gCacheLeases;
+
+/// Writes spans of traced requests to TRACES_FILENAME if DUMP_TRACES is set
+static std::unique_ptr<tracing::Dumper> gTraceDumper;
+
 static uint32_t stats_prcvd = 0;
 static uint32_t stats_psent = 0;
 static uint64_t stats_brcvd = 0;
@@ -263,7 +283,8 @@ public:
 			uint32_t messageId, uint64_t fileLength, uint64_t chunkId, uint32_t chunkVersion,
 			const std::vector<ChunkTypeWithAddress>& chunkCopies) const = 0;
 	virtual void deserializeFuseReadChunk(const std::vector<uint8_t>& packetBuffer,
-			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex) const = 0;
+			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex,
+			tracing::TraceId& traceId) const = 0;
 
 	virtual void serializeFuseWriteChunk(std::vector<uint8_t>& packetBuffer,
 			uint32_t messageId, uint8_t status) const = 0;
@@ -272,7 +293,8 @@ public:
 			uint64_t chunkId, uint32_t chunkVersion, uint32_t lockId,
 			const std::vector<ChunkTypeWithAddress>& chunkCopies) const = 0;
 	virtual void deserializeFuseWriteChunk(const std::vector<uint8_t>& packetBuffer,
-			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId) const = 0;
+			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId,
+			tracing::TraceId& traceId) const = 0;
 
 	virtual void serializeFuseWriteChunkEnd(std::vector<uint8_t>& packetBuffer,
 			uint32_t messageId, uint8_t status) const = 0;
@@ -312,8 +334,10 @@ public:
 	}
 
 	virtual void deserializeFuseReadChunk(const std::vector<uint8_t>& packetBuffer,
-			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex) const {
+			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex,
+			tracing::TraceId& traceId) const {
 		deserializeAllMooseFsPacketDataNoHeader(packetBuffer, messageId, inode, chunkIndex);
+		traceId = 0;
 	}
 
 	virtual void serializeFuseWriteChunk(std::vector<uint8_t>& packetBuffer,
@@ -333,9 +357,11 @@ public:
 	}
 
 	virtual void deserializeFuseWriteChunk(const std::vector<uint8_t>& packetBuffer,
-			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId) const {
+			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId,
+			tracing::TraceId& traceId) const {
 		deserializeAllMooseFsPacketDataNoHeader(packetBuffer, messageId, inode, chunkIndex);
 		lockId = 1;
+		traceId = 0;
 	}
 
 	virtual void serializeFuseWriteChunkEnd(std::vector<uint8_t>& packetBuffer,
@@ -404,8 +430,17 @@ public:
 	}
 
 	virtual void deserializeFuseReadChunk(const std::vector<uint8_t>& packetBuffer,
-			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex) const {
-		cltoma::fuseReadChunk::deserialize(packetBuffer, messageId, inode, chunkIndex);
+			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex,
+			tracing::TraceId& traceId) const {
+		PacketVersion version;
+		deserializePacketVersionNoHeader(packetBuffer, version);
+		if (version == cltoma::fuseReadChunk::kTraced) {
+			cltoma::fuseReadChunk::deserialize(packetBuffer, messageId, inode, chunkIndex,
+					traceId);
+		} else {
+			cltoma::fuseReadChunk::deserialize(packetBuffer, messageId, inode, chunkIndex);
+			traceId = 0;
+		}
 	}
 
 	virtual void serializeFuseWriteChunk(std::vector<uint8_t>& packetBuffer,
@@ -422,8 +457,18 @@ public:
 	}
 
 	virtual void deserializeFuseWriteChunk(const std::vector<uint8_t>& packetBuffer,
-			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId) const {
-		cltoma::fuseWriteChunk::deserialize(packetBuffer, messageId, inode, chunkIndex, lockId);
+			uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId,
+			tracing::TraceId& traceId) const {
+		PacketVersion version;
+		deserializePacketVersionNoHeader(packetBuffer, version);
+		if (version == cltoma::fuseWriteChunk::kTraced) {
+			cltoma::fuseWriteChunk::deserialize(packetBuffer, messageId, inode, chunkIndex,
+					lockId, traceId);
+		} else {
+			cltoma::fuseWriteChunk::deserialize(packetBuffer, messageId, inode, chunkIndex,
+					lockId);
+			traceId = 0;
+		}
 	}
 
 	virtual void serializeFuseWriteChunkEnd(std::vector<uint8_t>& packetBuffer,
@@ -1265,6 +1310,37 @@ void matoclserv_iolimits_status(matoclserventry* eptr, const uint8_t* data, uint
 	matoclserv_createpacket(eptr, std::move(buffer));
 }
 
+void matoclserv_metadataserver_replication_lag(matoclserventry* eptr, const uint8_t* data,
+		uint32_t length) {
+	uint32_t messageId;
+	cltoma::metadataserverReplicationLag::deserialize(data, length, messageId);
+
+	uint64_t lagVersions = 0;
+	uint32_t lagSeconds = 0;
+	if (!metadataserver::isMaster()) {
+		masterconn_replication_lag(lagVersions, lagSeconds);
+	}
+	MessageBuffer buffer;
+	matocl::metadataserverReplicationLag::serialize(buffer, messageId, lagVersions, lagSeconds);
+	matoclserv_createpacket(eptr, std::move(buffer));
+}
+
+void matoclserv_metadataserver_registration_progress(matoclserventry* eptr,
+		const uint8_t* data, uint32_t length) {
+	uint32_t messageId;
+	cltoma::metadataserverRegistrationProgress::deserialize(data, length, messageId);
+
+	uint32_t registeringServers = 0;
+	uint64_t pendingChunks = 0;
+	if (metadataserver::isMaster()) {
+		matocsserv_registration_progress(registeringServers, pendingChunks);
+	}
+	MessageBuffer buffer;
+	matocl::metadataserverRegistrationProgress::serialize(buffer, messageId,
+			registeringServers, pendingChunks);
+	matoclserv_createpacket(eptr, std::move(buffer));
+}
+
 void matoclserv_metadataserver_status(matoclserventry* eptr, const uint8_t* data, uint32_t length) {
 	uint32_t messageId;
 	cltoma::metadataserverStatus::deserialize(data, length, messageId);
@@ -1296,6 +1372,15 @@ void matoclserv_list_goals(matoclserventry* eptr) {
 	matoclserv_createpacket(eptr, matocl::listGoals::build(serialized_goals));
 }
 
+void matoclserv_list_defective_directories(matoclserventry *eptr, const uint8_t *data,
+		uint32_t length) {
+	uint32_t inode;
+	cltoma::listDefectiveDirectories::deserialize(data, length, inode);
+	std::vector<DefectiveDirectoryEntry> directories;
+	uint8_t status = fs_list_defective_directories(inode, directories);
+	matoclserv_createpacket(eptr, matocl::listDefectiveDirectories::build(status, directories));
+}
+
 void matoclserv_chunks_health(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
 	bool regularChunksOnly;
 	cltoma::chunksHealth::deserialize(data, length, regularChunksOnly);
@@ -1704,6 +1789,81 @@ static void matoclserv_broadcast_iolimits_cfg() {
 	}
 }
 
+/*! \brief Remembers that the client will cache data of an inode.
+ *
+ * Lease is granted by matoclserv_grant_cache_leases after the request is handled, because
+ * read-only requests are executed on a detached copy of the connection.
+ */
+static void matoclserv_lease_inode(matoclserventry *eptr, uint32_t inode) {
+	if (eptr->cacheLeaseTime > 0) {
+		eptr->leasedInodes.push_back(
+				inode == SPECIAL_INODE_ROOT ? eptr->sesdata->rootinode : inode);
+	}
+}
+
+static void matoclserv_grant_cache_leases(matoclserventry *eptr) {
+	if (eptr->leasedInodes.empty()) {
+		return;
+	}
+	if (eptr->sesdata) {
+		// Client counts its lease from the moment it receives the reply, so keep
+		// ours a bit longer to cover the delivery time and granularity of main_time()
+		uint32_t expires = main_time() + eptr->cacheLeaseTime + 2;
+		for (uint32_t inode : eptr->leasedInodes) {
+			gCacheLeases.grant(inode, eptr->sesdata->sessionid, expires);
+		}
+	}
+	eptr->leasedInodes.clear();
+}
+
+void matoclserv_node_changed(uint32_t inode) {
+	if (!gCacheLeases.empty()) {
+		gCacheLeases.changed(inode, main_time());
+	}
+}
+
+static void matoclserv_send_cache_invalidations() {
+	CacheLeases::Invalidations invalidations = gCacheLeases.takeInvalidations();
+	if (invalidations.empty()) {
+		return;
+	}
+	for (matoclserventry *eptr = matoclservhead; eptr; eptr = eptr->next) {
+		if (eptr->cacheLeaseTime == 0 || eptr->sesdata == NULL || eptr->mode == KILL) {
+			continue;
+		}
+		std::vector<uint32_t> inodes;
+		if (!CacheLeases::takeSessionInvalidations(invalidations, eptr->sesdata->sessionid,
+				inodes)) {
+			continue;
+		}
+		for (uint32_t &inode : inodes) {
+			if (inode == eptr->sesdata->rootinode) {
+				inode = SPECIAL_INODE_ROOT;
+			}
+		}
+		matoclserv_createpacket(eptr, matocl::fuseInvalidateCache::build(inodes));
+	}
+}
+
+static void matoclserv_cache_leases_expire(void) {
+	gCacheLeases.removeExpired(main_time());
+}
+
+static void matoclserv_dump_traces_reload(void) {
+	if (!cfg_getuint8("DUMP_TRACES", 0)) {
+		gTraceDumper.reset();
+	} else if (!gTraceDumper) {
+		gTraceDumper.reset(new tracing::Dumper(TRACES_FILENAME));
+	}
+}
+
+void matoclserv_fuse_cache_lease(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
+	uint32_t msgid, leaseTime;
+	cltoma::fuseCacheLease::deserialize(data, length, msgid, leaseTime);
+	eptr->cacheLeaseTime = std::min(leaseTime, gMaxCacheLeaseTime);
+	matoclserv_createpacket(eptr, matocl::fuseCacheLease::build(msgid, eptr->cacheLeaseTime));
+}
+
 void matoclserv_ping(matoclserventry *eptr,const uint8_t *data,uint32_t length) {
 	uint32_t size;
 	deserializeAllMooseFsPacketDataNoHeader(data, length, size);
@@ -2246,6 +2406,8 @@ void matoclserv_fuse_lookup(matoclserventry *eptr,const uint8_t *data,uint32_t l
 	} else {
 		put32bit(&ptr,newinode);
 		memcpy(ptr,attr,35);
+		matoclserv_lease_inode(eptr, inode);
+		matoclserv_lease_inode(eptr, newinode);
 	}
 	if (eptr->sesdata) {
 		eptr->sesdata->currentopstats[3]++;
@@ -2280,6 +2442,7 @@ void matoclserv_fuse_getattr(matoclserventry *eptr,const uint8_t *data,uint32_t
 		put8bit(&ptr,status);
 	} else {
 		memcpy(ptr,attr,35);
+		matoclserv_lease_inode(eptr, inode);
 	}
 	if (eptr->sesdata) {
 		eptr->sesdata->currentopstats[1]++;
@@ -2918,8 +3081,11 @@ void matoclserv_fuse_read_chunk(matoclserventry *eptr, PacketHeader header, cons
 	std::vector<uint8_t> outMessage;
 	const PacketSerializer* serializer = PacketSerializer::getSerializer(header.type, eptr->version);
 
+	tracing::TraceId traceId;
 	std::vector<uint8_t> receivedData(data, data + header.length);
-	serializer->deserializeFuseReadChunk(receivedData, messageId, inode, index);
+	serializer->deserializeFuseReadChunk(receivedData, messageId, inode, index, traceId);
+	tracing::TraceScope trace(traceId);
+	tracing::ScopedSpan span("master.read_chunk", inode);
 
 	status = fs_readchunk(inode, index, &chunkid, &fleng);
 	std::vector<ChunkTypeWithAddress> allChunkCopies;
@@ -2948,6 +3114,184 @@ void matoclserv_fuse_read_chunk(matoclserventry *eptr, PacketHeader header, cons
 	}
 }
 
+/*! \brief Finds locations of consecutive chunks of a file.
+ *
+ * Stops at the end of the file or at the first chunk which can't be located,
+ * so at least one chunk is returned unless the first one fails.
+ */
+static uint8_t matoclserv_locate_chunks(matoclserventry *eptr, uint32_t inode,
+		uint32_t firstIndex, uint32_t count,
+		uint64_t &fileLength, std::vector<ChunkLocationsEntry> &chunks) {
+	static const uint32_t kMaxChunksPerRequest = 256;
+	count = std::min(count, kMaxChunksPerRequest);
+
+	uint8_t status = LIZARDFS_STATUS_OK;
+	fileLength = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t index = firstIndex + i;
+		uint64_t chunkId;
+		uint64_t fleng;
+		uint32_t version = 0;
+		std::vector<ChunkTypeWithAddress> allChunkCopies;
+		status = fs_readchunk(inode, index, &chunkId, &fleng);
+		if (status == LIZARDFS_STATUS_OK && chunkId > 0) {
+			status = chunk_getversionandlocations(chunkId, eptr->peerip, version,
+					kMaxNumberOfChunkCopies, allChunkCopies);
+		}
+		if (status != LIZARDFS_STATUS_OK) {
+			break;
+		}
+		fileLength = fleng;
+		chunks.emplace_back(chunkId, version, std::move(allChunkCopies));
+		if ((uint64_t(index) + 1) * MFSCHUNKSIZE >= fleng) {
+			break;
+		}
+	}
+	if (chunks.empty()) {
+		return status;
+	}
+	dcm_access(inode, eptr->sesdata->sessionid);
+	return LIZARDFS_STATUS_OK;
+}
+
+/// Returns locations of consecutive chunks of a file in a single reply
+void matoclserv_fuse_read_chunks(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
+	uint32_t messageId;
+	uint32_t inode;
+	uint32_t firstIndex;
+	uint32_t count;
+	tracing::TraceId traceId = 0;
+	PacketVersion version;
+	deserializePacketVersionNoHeader(data, length, version);
+	if (version == cltoma::fuseReadChunks::kTraced) {
+		cltoma::fuseReadChunks::deserialize(data, length, messageId, inode, firstIndex, count,
+				traceId);
+	} else {
+		cltoma::fuseReadChunks::deserialize(data, length, messageId, inode, firstIndex, count);
+	}
+	tracing::TraceScope trace(traceId);
+	tracing::ScopedSpan span("master.read_chunks", inode);
+
+	uint64_t fileLength;
+	std::vector<ChunkLocationsEntry> chunks;
+	uint8_t status = matoclserv_locate_chunks(eptr, inode, firstIndex, count, fileLength, chunks);
+
+	MessageBuffer reply;
+	if (status != LIZARDFS_STATUS_OK) {
+		matocl::fuseReadChunks::serialize(reply, messageId, status);
+		matoclserv_createpacket(eptr, std::move(reply));
+		return;
+	}
+
+	matocl::fuseReadChunks::serialize(reply, messageId, fileLength, chunks);
+	matoclserv_createpacket(eptr, std::move(reply));
+
+	if (eptr->sesdata) {
+		eptr->sesdata->currentopstats[14]++;
+	}
+}
+
+/*! \brief Executes a list of operations as a single request.
+ *
+ * Operations are executed in order without handling any other request in between, so
+ * e.g. a file can be created and opened in one round trip. Execution stops at the first
+ * failed operation. Operations which already succeeded are not rolled back.
+ */
+void matoclserv_fuse_compound(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
+	uint32_t messageId, uid, gid;
+	std::vector<CompoundOperation> operations;
+	cltoma::fuseCompound::deserialize(data, length, messageId, uid, gid, operations);
+	uint32_t auid = uid;
+	uint32_t agid = gid;
+	matoclserv_ugid_remap(eptr, &uid, &gid);
+
+	MessageBuffer reply;
+	if (operations.empty() || operations.size() > kMaxCompoundOperations) {
+		matocl::fuseCompound::serialize(reply, messageId, uint8_t(LIZARDFS_ERROR_EINVAL));
+		matoclserv_createpacket(eptr, std::move(reply));
+		return;
+	}
+
+	uint32_t rootinode = eptr->sesdata->rootinode;
+	uint8_t sesflags = eptr->sesdata->sesflags;
+	std::vector<CompoundResult> results;
+	results.reserve(operations.size());
+	for (CompoundOperation &op : operations) {
+		results.emplace_back();
+		CompoundResult &result = results.back();
+		uint8_t &status = result.status;
+		Attributes attr;
+		memset(attr, 0, sizeof(attr));
+		uint32_t inode = op.inode;
+		if (op.inodeSource > 0) {
+			// only results of previous operations can be referenced
+			if (op.inodeSource >= results.size()) {
+				status = LIZARDFS_ERROR_EINVAL;
+				break;
+			}
+			inode = results[op.inodeSource - 1].inode;
+		}
+		// names are limited like in the packets of single operations
+		if (op.name.size() > MFS_NAME_MAX) {
+			status = LIZARDFS_ERROR_EINVAL;
+			break;
+		}
+		switch (op.type) {
+		case CompoundOperationType::kLookup:
+			status = fs_lookup(rootinode, sesflags, inode, HString(op.name),
+					uid, gid, auid, agid, &result.inode, attr);
+			if (status == LIZARDFS_STATUS_OK) {
+				matoclserv_lease_inode(eptr, inode);
+				matoclserv_lease_inode(eptr, result.inode);
+			}
+			eptr->sesdata->currentopstats[3]++;
+			break;
+		case CompoundOperationType::kGetattr:
+			status = fs_getattr(rootinode, sesflags, inode, uid, gid, auid, agid, attr);
+			result.inode = inode;
+			if (status == LIZARDFS_STATUS_OK) {
+				matoclserv_lease_inode(eptr, inode);
+			}
+			eptr->sesdata->currentopstats[1]++;
+			break;
+		case CompoundOperationType::kMknod:
+			status = fs_mknod(rootinode, sesflags, inode, HString(op.name), op.nodeType,
+					op.mode, op.umask, uid, gid, auid, agid, op.rdev, &result.inode, attr);
+			eptr->sesdata->currentopstats[8]++;
+			break;
+		case CompoundOperationType::kMkdir:
+			status = fs_mkdir(rootinode, sesflags, inode, HString(op.name), op.mode,
+					op.umask, uid, gid, auid, agid, op.flags, &result.inode, attr);
+			eptr->sesdata->currentopstats[4]++;
+			break;
+		case CompoundOperationType::kOpen:
+			status = matoclserv_insert_openfile(eptr->sesdata, inode);
+			if (status == LIZARDFS_STATUS_OK) {
+				status = fs_opencheck(rootinode, sesflags, inode, uid, gid, auid, agid,
+						op.flags, attr);
+			}
+			if (status == LIZARDFS_STATUS_OK && dcm_open(inode, eptr->sesdata->sessionid) == 0) {
+				attr[1] &= (0xFF ^ (MATTR_ALLOWDATACACHE << 4));
+			}
+			result.inode = inode;
+			eptr->sesdata->currentopstats[13]++;
+			break;
+		case CompoundOperationType::kReadChunks:
+			status = matoclserv_locate_chunks(eptr, inode, op.firstIndex, op.count,
+					result.fileLength, result.chunks);
+			result.inode = inode;
+			eptr->sesdata->currentopstats[14]++;
+			break;
+		}
+		if (status != LIZARDFS_STATUS_OK) {
+			break;
+		}
+		memcpy(result.attributes.data(), attr, sizeof(attr));
+	}
+	matocl::fuseCompound::serialize(reply, messageId, results);
+	matoclserv_createpacket(eptr, std::move(reply));
+}
+
 void matoclserv_chunk_info(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
 	uint8_t status;
 	uint64_t chunkid;
@@ -3029,7 +3373,11 @@ void matoclserv_fuse_write_chunk(matoclserventry *eptr, PacketHeader header, con
 	const PacketSerializer* serializer = PacketSerializer::getSerializer(header.type, eptr->version);
 
 	std::vector<uint8_t> receivedData(data, data + header.length);
-	serializer->deserializeFuseWriteChunk(receivedData, messageId, inode, chunkIndex, lockId);
+	tracing::TraceId traceId;
+	serializer->deserializeFuseWriteChunk(receivedData, messageId, inode, chunkIndex, lockId,
+			traceId);
+	tracing::TraceScope trace(traceId);
+	tracing::ScopedSpan span("master.write_chunk", inode);
 
 	uint32_t min_server_version
 		= header.type == LIZ_CLTOMA_FUSE_WRITE_CHUNK ? kFirstXorVersion : 0;
@@ -3037,7 +3385,7 @@ void matoclserv_fuse_write_chunk(matoclserventry *eptr, PacketHeader header, con
 	// Original MooseFS (1.6.27) does not use lock ID's
 	bool useDummyLockId = (header.type == CLTOMA_FUSE_WRITE_CHUNK);
 	status = fs_writechunk(matoclserv_get_context(eptr), inode, chunkIndex, useDummyLockId,
-			&lockId, &chunkId, &opflag, &fileLength, min_server_version);
+			&lockId, &chunkId, &opflag, &fileLength, min_server_version, eptr->peerip);
 
 	if (status != LIZARDFS_STATUS_OK) {
 		serializer->serializeFuseWriteChunk(outMessage, messageId, status);
@@ -4307,6 +4655,11 @@ void matoclserv_hostname(matoclserventry* eptr, const uint8_t* data, uint32_t le
 	matoclserv_createpacket(eptr, matocl::hostname::build(std::string(hostname)));
 }
 
+void matoclserv_metrics(matoclserventry* eptr, const uint8_t* data, uint32_t length) {
+	cltoma::metrics::deserialize(data, length);
+	matoclserv_createpacket(eptr, matocl::metrics::build(metrics::registry().exportText()));
+}
+
 void matoclserv_admin_register(matoclserventry* eptr, const uint8_t* data, uint32_t length) {
 	cltoma::adminRegister::deserialize(data, length);
 	if (!eptr->adminChallenge) {
@@ -4558,7 +4911,387 @@ void matocl_beforedisconnect(matoclserventry *eptr) {
 */
 }
 
-void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *data,uint32_t length) {
+/*! \brief Read-only request waiting for parallel execution.
+ *
+ * Requests which only inspect metadata are not executed immediately. They are collected
+ * and executed together on gReadOnlyExecutor right before the next request which may modify
+ * metadata and at the end of every matoclserv_serve call, so each of them observes the same
+ * metadata as it would if all requests were executed sequentially.
+ */
+struct ReadOnlyRequest {
+	matoclserventry *eptr;
+	uint32_t type;
+	uint8_t *data;                          // owned copy of the packet, released with free()
+	uint32_t length;
+	packetstruct *outputhead,**outputtail;  // replies prepared by a worker
+	uint32_t opstats[SESSION_STATS];
+	std::vector<uint32_t> leasedInodes;
+	bool kill;
+	metrics::Histogram *latency;
+};
+
+// Below this size a batch is cheaper to execute in the main thread than to hand over to workers
+static const uint32_t kReadOnlyMinParallelBatch = 16;
+
+static std::vector<ReadOnlyRequest> gReadOnlyRequests;
+static std::unique_ptr<BatchExecutor> gReadOnlyExecutor;
+
+/*! \brief Name of the handler of a packet type, nullptr for types which aren't handled.
+ *
+ * Has to list all types dispatched by matoclserv_handle_packet, so that latency of
+ * each of them is measured. Other types don't get their own metrics.
+ */
+static const char *matoclserv_handler_name(uint32_t type) {
+	switch (type) {
+		case ANTOAN_PING:
+			return "ping";
+		case LIZ_CLTOMA_METADATASERVER_STATUS:
+			return "metadataserver_status";
+		case LIZ_CLTOMA_METADATASERVER_REPLICATION_LAG:
+			return "metadataserver_replication_lag";
+		case LIZ_CLTOMA_METADATASERVER_REGISTRATION_PROGRESS:
+			return "metadataserver_registration_progress";
+		case LIZ_CLTOMA_HOSTNAME:
+			return "hostname";
+		case LIZ_CLTOMA_METRICS:
+			return "metrics";
+		case LIZ_CLTOMA_ADMIN_REGISTER_CHALLENGE:
+			return "admin_register";
+		case LIZ_CLTOMA_ADMIN_REGISTER_RESPONSE:
+			return "admin_register_response";
+		case LIZ_CLTOMA_ADMIN_BECOME_MASTER:
+			return "admin_become_master";
+		case LIZ_CLTOMA_ADMIN_STOP_WITHOUT_METADATA_DUMP:
+			return "admin_stop_without_metadata_dump";
+		case LIZ_CLTOMA_ADMIN_RELOAD:
+			return "admin_reload";
+		case LIZ_CLTOMA_ADMIN_SAVE_METADATA:
+			return "admin_save_metadata";
+		case CLTOMA_FUSE_REGISTER:
+			return "fuse_register";
+		case CLTOMA_CSERV_LIST:
+			return "cserv_list";
+		case LIZ_CLTOMA_CSERV_LIST:
+			return "liz_cserv_list";
+		case CLTOMA_SESSION_LIST:
+			return "session_list";
+		case CLTOAN_CHART:
+			return "chart";
+		case CLTOAN_CHART_DATA:
+			return "chart_data";
+		case CLTOMA_INFO:
+			return "info";
+		case CLTOMA_FSTEST_INFO:
+			return "fstest_info";
+		case CLTOMA_CHUNKSTEST_INFO:
+			return "chunkstest_info";
+		case CLTOMA_CHUNKS_MATRIX:
+			return "chunks_matrix";
+		case CLTOMA_EXPORTS_INFO:
+			return "exports_info";
+		case CLTOMA_MLOG_LIST:
+			return "mlog_list";
+		case CLTOMA_CSSERV_REMOVESERV:
+			return "cserv_removeserv";
+		case LIZ_CLTOMA_IOLIMITS_STATUS:
+			return "iolimits_status";
+		case LIZ_CLTOMA_METADATASERVERS_LIST:
+			return "metadataservers_list";
+		case LIZ_CLTOMA_LIST_GOALS:
+			return "list_goals";
+		case LIZ_CLTOMA_CHUNKS_HEALTH:
+			return "chunks_health";
+		case LIZ_CLTOMA_LIST_DEFECTIVE_DIRECTORIES:
+			return "list_defective_directories";
+		case LIZ_CLTOMA_ADMIN_RECALCULATE_METADATA_CHECKSUM:
+			return "admin_recalculate_metadata_checksum";
+		case LIZ_CLTOMA_LIST_TAPESERVERS:
+			return "list_tapeservers";
+		case LIZ_CLTOMA_MANAGE_LOCKS_LIST:
+			return "manage_locks_list";
+		case LIZ_CLTOMA_MANAGE_LOCKS_UNLOCK:
+			return "manage_locks_unlock";
+		case CLTOMA_FUSE_RESERVED_INODES:
+			return "fuse_reserved_inodes";
+		case CLTOMA_FUSE_STATFS:
+			return "fuse_statfs";
+		case CLTOMA_FUSE_ACCESS:
+			return "fuse_access";
+		case CLTOMA_FUSE_LOOKUP:
+			return "fuse_lookup";
+		case CLTOMA_FUSE_GETATTR:
+			return "fuse_getattr";
+		case LIZ_CLTOMA_FUSE_CACHE_LEASE:
+			return "fuse_cache_lease";
+		case CLTOMA_FUSE_SETATTR:
+			return "fuse_setattr";
+		case CLTOMA_FUSE_READLINK:
+			return "fuse_readlink";
+		case CLTOMA_FUSE_SYMLINK:
+			return "fuse_symlink";
+		case CLTOMA_FUSE_MKNOD:
+		case LIZ_CLTOMA_FUSE_MKNOD:
+			return "fuse_mknod";
+		case CLTOMA_FUSE_MKDIR:
+		case LIZ_CLTOMA_FUSE_MKDIR:
+			return "fuse_mkdir";
+		case CLTOMA_FUSE_UNLINK:
+			return "fuse_unlink";
+		case CLTOMA_FUSE_RMDIR:
+			return "fuse_rmdir";
+		case CLTOMA_FUSE_RENAME:
+			return "fuse_rename";
+		case CLTOMA_FUSE_LINK:
+			return "fuse_link";
+		case CLTOMA_FUSE_GETDIR:
+			return "fuse_getdir";
+		case CLTOMA_FUSE_OPEN:
+			return "fuse_open";
+		case LIZ_CLTOMA_FUSE_READ_CHUNK:
+		case CLTOMA_FUSE_READ_CHUNK:
+			return "fuse_read_chunk";
+		case LIZ_CLTOMA_FUSE_READ_CHUNKS:
+			return "fuse_read_chunks";
+		case LIZ_CLTOMA_FUSE_COMPOUND:
+			return "fuse_compound";
+		case LIZ_CLTOMA_CHUNK_INFO:
+			return "chunk_info";
+		case LIZ_CLTOMA_TAPE_INFO:
+			return "tape_info";
+		case LIZ_CLTOMA_FUSE_WRITE_CHUNK:
+		case CLTOMA_FUSE_WRITE_CHUNK:
+			return "fuse_write_chunk";
+		case LIZ_CLTOMA_FUSE_WRITE_CHUNK_END:
+		case CLTOMA_FUSE_WRITE_CHUNK_END:
+			return "fuse_write_chunk_end";
+		case CLTOMA_FUSE_GETTRASH:
+			return "fuse_gettrash";
+		case CLTOMA_FUSE_GETDETACHEDATTR:
+			return "fuse_getdetachedattr";
+		case CLTOMA_FUSE_GETTRASHPATH:
+			return "fuse_gettrashpath";
+		case CLTOMA_FUSE_SETTRASHPATH:
+			return "fuse_settrashpath";
+		case CLTOMA_FUSE_UNDEL:
+			return "fuse_undel";
+		case CLTOMA_FUSE_PURGE:
+			return "fuse_purge";
+		case CLTOMA_FUSE_GETRESERVED:
+			return "fuse_getreserved";
+		case CLTOMA_FUSE_CHECK:
+			return "fuse_check";
+		case CLTOMA_FUSE_GETTRASHTIME:
+			return "fuse_gettrashtime";
+		case CLTOMA_FUSE_SETTRASHTIME:
+			return "fuse_settrashtime";
+		case CLTOMA_FUSE_GETGOAL:
+		case LIZ_CLTOMA_FUSE_GETGOAL:
+			return "fuse_getgoal";
+		case CLTOMA_FUSE_SETGOAL:
+		case LIZ_CLTOMA_FUSE_SETGOAL:
+			return "fuse_setgoal";
+		case CLTOMA_FUSE_APPEND:
+			return "fuse_append";
+		case CLTOMA_FUSE_GETDIRSTATS:
+			return "fuse_getdirstats";
+		case LIZ_CLTOMA_FUSE_TRUNCATE_END:
+		case LIZ_CLTOMA_FUSE_TRUNCATE:
+		case CLTOMA_FUSE_TRUNCATE:
+			return "fuse_truncate";
+		case CLTOMA_FUSE_REPAIR:
+			return "fuse_repair";
+		case CLTOMA_FUSE_SNAPSHOT:
+			return "fuse_snapshot";
+		case CLTOMA_FUSE_GETEATTR:
+			return "fuse_geteattr";
+		case CLTOMA_FUSE_SETEATTR:
+			return "fuse_seteattr";
+		case LIZ_CLTOMA_FUSE_DELETE_ACL:
+			return "fuse_deleteacl";
+		case LIZ_CLTOMA_FUSE_GET_ACL:
+			return "fuse_getacl";
+		case LIZ_CLTOMA_FUSE_SET_ACL:
+			return "fuse_setacl";
+		case LIZ_CLTOMA_FUSE_SET_QUOTA:
+			return "fuse_setquota";
+		case LIZ_CLTOMA_FUSE_GET_QUOTA:
+			return "fuse_getquota";
+		case CLTOMA_FUSE_GETXATTR:
+			return "fuse_getxattr";
+		case CLTOMA_FUSE_SETXATTR:
+			return "fuse_setxattr";
+		case LIZ_CLTOMA_IOLIMIT:
+			return "iolimit";
+		case LIZ_CLTOMA_FUSE_SETLK:
+			return "fuse_setlk";
+		case LIZ_CLTOMA_FUSE_GETLK:
+			return "fuse_getlk";
+		case LIZ_CLTOMA_FUSE_FLOCK:
+			return "fuse_flock";
+		case LIZ_CLTOMA_FUSE_FLOCK_INTERRUPT:
+		case LIZ_CLTOMA_FUSE_SETLK_INTERRUPT:
+			return "fuse_locks_interrupt";
+		default:
+			return nullptr;
+	}
+}
+
+/// Histograms of time of handling requests for each packet type, used by the main thread only
+static std::unordered_map<uint32_t, metrics::Histogram *> gRequestLatency;
+
+/// Histogram of time of handling requests of a given type, nullptr if the type is unknown
+static metrics::Histogram *matoclserv_request_latency(uint32_t type) {
+	auto it = gRequestLatency.find(type);
+	if (it != gRequestLatency.end()) {
+		return it->second;
+	}
+	const char *handler = matoclserv_handler_name(type);
+	if (handler == nullptr) {
+		return nullptr;
+	}
+	metrics::Histogram *histogram = &metrics::registry().histogram(
+			"lizardfs_master_client_request_duration_microseconds",
+			"Time of handling requests from clients and admin tools by handler",
+			"handler=\"" + std::string(handler) + "\"");
+	gRequestLatency[type] = histogram;
+	return histogram;
+}
+
+static bool matoclserv_is_readonly_request(uint32_t type) {
+	switch (type) {
+		case CLTOMA_FUSE_LOOKUP:
+		case CLTOMA_FUSE_GETATTR:
+		case CLTOMA_FUSE_ACCESS:
+		case CLTOMA_FUSE_GETXATTR:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*! \brief Executes a deferred request. Safe to call concurrently for different requests.
+ *
+ * Handler is called with a detached copy of the connection and session, so that packets
+ * and statistics are gathered in the request and nothing shared is modified.
+ */
+static void matoclserv_execute_readonly_request(ReadOnlyRequest &request) {
+	Timer timer;
+	session sesdata = *request.eptr->sesdata;
+	memset(sesdata.currentopstats, 0, sizeof(sesdata.currentopstats));
+	matoclserventry eptr;
+	eptr.registered = request.eptr->registered;
+	eptr.mode = HEADER;
+	eptr.version = request.eptr->version;
+	eptr.peerip = request.eptr->peerip;
+	eptr.sesdata = &sesdata;
+	eptr.chunkdelayedops = NULL;
+	eptr.cacheLeaseTime = request.eptr->cacheLeaseTime;
+	eptr.outputhead = NULL;
+	eptr.outputtail = &(eptr.outputhead);
+	switch (request.type) {
+		case CLTOMA_FUSE_LOOKUP:
+			matoclserv_fuse_lookup(&eptr, request.data, request.length);
+			break;
+		case CLTOMA_FUSE_GETATTR:
+			matoclserv_fuse_getattr(&eptr, request.data, request.length);
+			break;
+		case CLTOMA_FUSE_ACCESS:
+			matoclserv_fuse_access(&eptr, request.data, request.length);
+			break;
+		case CLTOMA_FUSE_GETXATTR:
+			matoclserv_fuse_getxattr(&eptr, request.data, request.length);
+			break;
+	}
+	request.outputhead = eptr.outputhead;
+	request.outputtail = eptr.outputtail;
+	memcpy(request.opstats, sesdata.currentopstats, sizeof(request.opstats));
+	request.leasedInodes = std::move(eptr.leasedInodes);
+	request.kill = (eptr.mode == KILL);
+	request.latency->record(timer.elapsed_us());
+}
+
+static void matoclserv_flush_readonly_requests() {
+	if (gReadOnlyRequests.empty()) {
+		return;
+	}
+	if (gReadOnlyRequests.size() < kReadOnlyMinParallelBatch) {
+		for (ReadOnlyRequest &request : gReadOnlyRequests) {
+			matoclserv_execute_readonly_request(request);
+		}
+	} else {
+		gReadOnlyExecutor->run(gReadOnlyRequests.size(), [](std::size_t i) {
+			matoclserv_execute_readonly_request(gReadOnlyRequests[i]);
+		});
+	}
+	// Replies are queued in the order in which requests arrived
+	for (ReadOnlyRequest &request : gReadOnlyRequests) {
+		matoclserventry *eptr = request.eptr;
+		if (request.outputhead) {
+			*(eptr->outputtail) = request.outputhead;
+			eptr->outputtail = request.outputtail;
+		}
+		for (int i = 0; i < SESSION_STATS; ++i) {
+			eptr->sesdata->currentopstats[i] += request.opstats[i];
+		}
+		if (request.kill) {
+			eptr->mode = KILL;
+		}
+		eptr->leasedInodes.swap(request.leasedInodes);
+		matoclserv_grant_cache_leases(eptr);
+		free(request.data);
+	}
+	gReadOnlyRequests.clear();
+}
+
+/*! \brief Puts a request aside for parallel execution if it is possible.
+ *
+ * \return true if request was deferred and should not be handled now
+ */
+static bool matoclserv_defer_readonly_request(matoclserventry *eptr, uint32_t type,
+		const uint8_t *data, uint32_t length) {
+	if (!gReadOnlyExecutor || !matoclserv_is_readonly_request(type)
+			|| !metadataserver::isMaster() || eptr->registered != ClientState::kRegistered
+			|| eptr->sesdata == NULL || eptr->mode == KILL) {
+		return false;
+	}
+	ReadOnlyRequest request;
+	request.eptr = eptr;
+	request.type = type;
+	request.length = length;
+	request.data = (uint8_t*) malloc(std::max<uint32_t>(length, 1));
+	passert(request.data);
+	if (length > 0) {
+		memcpy(request.data, data, length);
+	}
+	request.outputhead = NULL;
+	request.outputtail = NULL;
+	request.kill = false;
+	request.latency = matoclserv_request_latency(type);
+	gReadOnlyRequests.push_back(request);
+	return true;
+}
+
+static void matoclserv_readonly_workers_reload() {
+	uint32_t workers = cfg_get_maxvalue<uint32_t>("MATOCL_READONLY_WORKERS", 0, 64);
+	if (workers > 0 && !dynamic_cast<hstorage::MemStorage*>(&hstorage::Storage::instance())) {
+		lzfs_pretty_syslog(LOG_WARNING, "MATOCL_READONLY_WORKERS requires names to be kept in "
+				"memory (USE_BDB_FOR_NAME_STORAGE = 0), read-only requests will be executed "
+				"by the main thread");
+		workers = 0;
+	}
+	if (workers == gReadOnlyWorkers) {
+		return;
+	}
+	sassert(gReadOnlyRequests.empty());
+	gReadOnlyExecutor.reset();
+	if (workers > 0) {
+		gReadOnlyExecutor.reset(new BatchExecutor(workers));
+	}
+	gReadOnlyWorkers = workers;
+}
+
+static void matoclserv_handle_packet(matoclserventry *eptr, uint32_t type, const uint8_t *data,
+		uint32_t length) {
 	if (type==ANTOAN_NOP) {
 		return;
 	}
@@ -4578,9 +5311,18 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 				case LIZ_CLTOMA_METADATASERVER_STATUS:
 					matoclserv_metadataserver_status(eptr, data, length);
 					break;
+				case LIZ_CLTOMA_METADATASERVER_REPLICATION_LAG:
+					matoclserv_metadataserver_replication_lag(eptr, data, length);
+					break;
+				case LIZ_CLTOMA_METADATASERVER_REGISTRATION_PROGRESS:
+					matoclserv_metadataserver_registration_progress(eptr, data, length);
+					break;
 				case LIZ_CLTOMA_HOSTNAME:
 					matoclserv_hostname(eptr, data, length);
 					break;
+				case LIZ_CLTOMA_METRICS:
+					matoclserv_metrics(eptr, data, length);
+					break;
 				case LIZ_CLTOMA_ADMIN_REGISTER_CHALLENGE:
 					matoclserv_admin_register(eptr, data, length);
 					break;
@@ -4654,15 +5396,27 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 				case LIZ_CLTOMA_METADATASERVER_STATUS:
 					matoclserv_metadataserver_status(eptr, data, length);
 					break;
+				case LIZ_CLTOMA_METADATASERVER_REPLICATION_LAG:
+					matoclserv_metadataserver_replication_lag(eptr, data, length);
+					break;
+				case LIZ_CLTOMA_METADATASERVER_REGISTRATION_PROGRESS:
+					matoclserv_metadataserver_registration_progress(eptr, data, length);
+					break;
 				case LIZ_CLTOMA_LIST_GOALS:
 					matoclserv_list_goals(eptr);
 					break;
 				case LIZ_CLTOMA_CHUNKS_HEALTH:
 					matoclserv_chunks_health(eptr, data, length);
 					break;
+				case LIZ_CLTOMA_LIST_DEFECTIVE_DIRECTORIES:
+					matoclserv_list_defective_directories(eptr, data, length);
+					break;
 				case LIZ_CLTOMA_HOSTNAME:
 					matoclserv_hostname(eptr, data, length);
 					break;
+				case LIZ_CLTOMA_METRICS:
+					matoclserv_metrics(eptr, data, length);
+					break;
 				case LIZ_CLTOMA_ADMIN_REGISTER_CHALLENGE:
 					matoclserv_admin_register(eptr, data, length);
 					break;
@@ -4715,9 +5469,14 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 					break;
 				case CLTOMA_FUSE_LOOKUP:
 					matoclserv_fuse_lookup(eptr,data,length);
+					matoclserv_grant_cache_leases(eptr);
 					break;
 				case CLTOMA_FUSE_GETATTR:
 					matoclserv_fuse_getattr(eptr,data,length);
+					matoclserv_grant_cache_leases(eptr);
+					break;
+				case LIZ_CLTOMA_FUSE_CACHE_LEASE:
+					matoclserv_fuse_cache_lease(eptr, data, length);
 					break;
 				case CLTOMA_FUSE_SETATTR:
 					matoclserv_fuse_setattr(eptr,data,length);
@@ -4763,6 +5522,13 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 				case CLTOMA_FUSE_READ_CHUNK:
 					matoclserv_fuse_read_chunk(eptr, PacketHeader(type, length), data);
 					break;
+				case LIZ_CLTOMA_FUSE_READ_CHUNKS:
+					matoclserv_fuse_read_chunks(eptr, data, length);
+					break;
+				case LIZ_CLTOMA_FUSE_COMPOUND:
+					matoclserv_fuse_compound(eptr, data, length);
+					matoclserv_grant_cache_leases(eptr);
+					break;
 				case LIZ_CLTOMA_CHUNK_INFO:
 					matoclserv_chunk_info(eptr, data, length);
 					break;
@@ -4984,6 +5750,21 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 	}
 }
 
+void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *data,uint32_t length) {
+	if (matoclserv_defer_readonly_request(eptr, type, data, length)) {
+		return;
+	}
+	// Anything else may modify metadata, so all previously received requests have to be
+	// answered first
+	matoclserv_flush_readonly_requests();
+	Timer timer;
+	matoclserv_handle_packet(eptr, type, data, length);
+	metrics::Histogram *latency = matoclserv_request_latency(type);
+	if (latency) {
+		latency->record(timer.elapsed_us());
+	}
+}
+
 void matoclserv_term(void) {
 	matoclserventry *eptr,*eptrn;
 	packetstruct *pptr,*pptrn;
@@ -5011,6 +5792,8 @@ void matoclserv_term(void) {
 		delete eptr;
 	}
 	matoclserv_session_unload();
+	gReadOnlyExecutor.reset();
+	gTraceDumper.reset();
 
 	free(ListenHost);
 	free(ListenPort);
@@ -5236,6 +6019,7 @@ void matoclserv_serve(const std::vector<pollfd> &pdesc) {
 
 			eptr->chunkdelayedops = NULL;
 			eptr->sesdata = NULL;
+			eptr->cacheLeaseTime = 0;
 /* CACHENOTIFY
 			eptr->cacheddirs = NULL;
 */
@@ -5255,6 +6039,8 @@ void matoclserv_serve(const std::vector<pollfd> &pdesc) {
 			}
 		}
 	}
+	matoclserv_flush_readonly_requests();
+	matoclserv_send_cache_invalidations();
 
 // write
 	for (eptr=matoclservhead ; eptr ; eptr=eptr->next) {
@@ -5418,6 +6204,9 @@ void matoclserv_reload(void) {
 	}
 
 	matoclserv_iolimits_reload();
+	matoclserv_readonly_workers_reload();
+	matoclserv_dump_traces_reload();
+	gMaxCacheLeaseTime = cfg_get_maxvalue<uint32_t>("MAX_CACHE_LEASE_TIME", 60, 3600);
 
 	char *oldListenHost = ListenHost;
 	char *oldListenPort = ListenPort;
@@ -5481,6 +6270,9 @@ int matoclserv_networkinit(void) {
 	if (matoclserv_iolimits_reload() != 0) {
 		return -1;
 	}
+	matoclserv_readonly_workers_reload();
+	matoclserv_dump_traces_reload();
+	gMaxCacheLeaseTime = cfg_get_maxvalue<uint32_t>("MAX_CACHE_LEASE_TIME", 60, 3600);
 
 	exiting = 0;
 	lsock = tcpsocket();
@@ -5509,6 +6301,7 @@ int matoclserv_networkinit(void) {
 		matoclserv_become_master();
 	}
 	main_reloadregister(matoclserv_reload);
+	main_timeregister(TIMEMODE_RUN_LATE, 10, 0, matoclserv_cache_leases_expire);
 	metadataserver::registerFunctionCalledOnPromotion(matoclserv_become_master);
 	main_destructregister(matoclserv_term);
 	main_pollregister(matoclserv_desc,matoclserv_serve);
@@ -33,6 +33,9 @@ void matoclserv_notify_parent(uint32_t dirinode,uint32_t parent);
 void matoclserv_chunk_status(uint64_t chunkid,uint8_t status);
 void matoclserv_add_open_file(uint32_t sessionid,uint32_t inode);
 void matoclserv_remove_open_file(uint32_t sessionid,uint32_t inode);
+
+/// Tells clients caching data of the inode (see CacheLeases) that it has changed.
+void matoclserv_node_changed(uint32_t inode);
 int matoclserv_sessionsinit(void);
 int matoclserv_networkinit(void);
 void matoclserv_session_unload(void);
@@ -31,6 +31,7 @@
 #include <time.h>
 #include <unistd.h>
 #include <algorithm>
+#include <deque>
 #include <list>
 #include <set>
 #include <vector>
@@ -55,6 +56,7 @@
 #include "master/filesystem.h"
 #include "master/get_servers_for_new_chunk.h"
 #include "master/personality.h"
+#include "master/topology.h"
 #include "protocol/cstoma.h"
 #include "protocol/input_packet.h"
 #include "protocol/matocs.h"
@@ -91,9 +93,15 @@ struct matocsserventry {
 	uint16_t rrepcounter;
 	uint16_t wrepcounter;
 	uint16_t delcounter;
+	uint32_t load;                  // operations queued on the chunkserver
 
 	csdbentry *csdb; /*!< Pointer to database entry for chunkserver. */
 
+	/*! Chunks received in LIZ_CSTOMA_REGISTER_CHUNKS which are not yet registered.
+	 * Reading from the connection is suspended until all of them are processed. */
+	std::deque<std::vector<ChunkWithVersionAndType>> registrationQueue;
+	size_t registrationQueuePosition; /*!< First unprocessed chunk of registrationQueue.front() */
+
 	matocsserventry *next;
 };
 
@@ -342,7 +350,8 @@ std::vector<ServerWithUsage> matocsserv_getservers_sorted() {
 				&& eptr->totalspace > 0
 				&& eptr->usedspace <= eptr->totalspace) {
 			double usage = double(eptr->usedspace) / double(eptr->totalspace);
-			result.emplace_back(eptr, usage, eptr->label);
+			result.emplace_back(eptr, usage, eptr->label, eptr->usedspace, eptr->totalspace,
+					eptr->chunkscount);
 		}
 	}
 	std::sort(result.begin(), result.end(), [](const ServerWithUsage& a, const ServerWithUsage& b) {
@@ -352,7 +361,7 @@ std::vector<ServerWithUsage> matocsserv_getservers_sorted() {
 }
 
 std::vector<std::pair<matocsserventry *, ChunkPartType>> matocsserv_getservers_for_new_chunk(
-		uint8_t goal_id, uint32_t min_server_version) {
+		uint8_t goal_id, uint32_t min_server_version, uint32_t client_ip) {
 	static std::array<ChunkCreationHistory, GoalId::kMax + 1> history;
 	GetServersForNewChunk getter;
 	const Goal &goal(fs_get_goal_definition(goal_id));
@@ -363,7 +372,9 @@ std::vector<std::pair<matocsserventry *, ChunkPartType>> matocsserv_getservers_f
 		    (eptr->totalspace - eptr->usedspace) >= MFSCHUNKSIZE) {
 			int64_t weight =
 			        eptr->totalspace / 1024U / 1024U;  // weight = total space in MB
-			getter.addServer(eptr, eptr->label, weight, eptr->version);
+			uint32_t distance = client_ip ? topology_distance(eptr->servip, client_ip) : 0;
+			getter.addServer(eptr, eptr->label, weight, eptr->version, distance,
+			                 topology_location(eptr->servip));
 		}
 	}
 
@@ -1230,6 +1241,10 @@ void matocsserv_space(matocsserventry *eptr,const uint8_t *data,uint32_t length)
 	}
 }
 
+void matocsserv_got_load(matocsserventry *eptr, const std::vector<uint8_t> &data) {
+	cstoma::getLoad::deserialize(data, eptr->load);
+}
+
 void matocsserv_liz_register_host(matocsserventry *eptr, const std::vector<uint8_t>& data)
 		throw (IncorrectDeserializationException) {
 	uint32_t version;
@@ -1244,25 +1259,84 @@ void matocsserv_liz_register_chunks(matocsserventry *eptr, const std::vector<uin
 		throw (IncorrectDeserializationException) {
 	PacketVersion v;
 	deserializePacketVersionNoHeader(data, v);
+	std::vector<ChunkWithVersionAndType> chunks;
 	if (v == cstoma::registerChunks::kECChunks) {
-		std::vector<ChunkWithVersionAndType> chunks;
 		cstoma::registerChunks::deserialize(data, chunks);
-		for (auto& chunk : chunks) {
-			chunk_server_has_chunk(eptr, chunk.id, chunk.version, chunk.type);
-		}
 	} else if (v == cstoma::registerChunks::kStandardAndXorChunks) {
-		std::vector<legacy::ChunkWithVersionAndType> chunks;
-		cstoma::registerChunks::deserialize(data, chunks);
-		for (auto& chunk : chunks) {
-			chunk_server_has_chunk(eptr, chunk.id, chunk.version, ChunkPartType(chunk.type));
+		std::vector<legacy::ChunkWithVersionAndType> legacyChunks;
+		cstoma::registerChunks::deserialize(data, legacyChunks);
+		chunks.reserve(legacyChunks.size());
+		for (auto& chunk : legacyChunks) {
+			chunks.emplace_back(chunk.id, chunk.version, ChunkPartType(chunk.type));
 		}
 	} else {
-		std::vector<ChunkWithVersion> chunks;
-		cstoma::registerChunks::deserialize(data, chunks);
-		for (auto& chunk : chunks) {
-			chunk_server_has_chunk(eptr, chunk.id, chunk.version, slice_traits::standard::ChunkPartType());
+		std::vector<ChunkWithVersion> standardChunks;
+		cstoma::registerChunks::deserialize(data, standardChunks);
+		chunks.reserve(standardChunks.size());
+		for (auto& chunk : standardChunks) {
+			chunks.emplace_back(chunk.id, chunk.version,
+					slice_traits::standard::ChunkPartType());
 		}
 	}
+	if (!chunks.empty()) {
+		// Registered in matocsserv_register_chunks_a_bit, so that many chunkservers connecting
+		// at once don't block the master for a long time
+		eptr->registrationQueue.push_back(std::move(chunks));
+	}
+}
+
+/*! \brief Registers queued chunks of chunkservers for a limited amount of time.
+ *
+ * Connections are handled one after another, so that each chunkserver becomes fully registered
+ * as soon as possible instead of all of them finishing at the end of a registration storm.
+ */
+static void matocsserv_register_chunks_a_bit() {
+	SignalLoopWatchdog watchdog;
+	bool workLeft = false;
+
+	watchdog.start();
+	for (matocsserventry *eptr = matocsservhead; eptr; eptr = eptr->next) {
+		if (eptr->mode == KILL || eptr->registrationQueue.empty()) {
+			continue;
+		}
+		// The chunkserver is not read from while its chunks wait here, so don't time it out
+		eptr->lastread.reset();
+		if (workLeft) {
+			continue;
+		}
+		while (!eptr->registrationQueue.empty()) {
+			const auto& chunks = eptr->registrationQueue.front();
+			size_t& position = eptr->registrationQueuePosition;
+			while (position < chunks.size() && !watchdog.expired()) {
+				const ChunkWithVersionAndType& chunk = chunks[position++];
+				chunk_server_has_chunk(eptr, chunk.id, chunk.version, chunk.type);
+			}
+			if (position < chunks.size()) {
+				break;
+			}
+			eptr->registrationQueue.pop_front();
+			position = 0;
+		}
+		workLeft = !eptr->registrationQueue.empty();
+	}
+	if (workLeft) {
+		main_make_next_poll_nonblocking();
+	}
+}
+
+void matocsserv_registration_progress(uint32_t& registeringServers, uint64_t& pendingChunks) {
+	registeringServers = 0;
+	pendingChunks = 0;
+	for (matocsserventry *eptr = matocsservhead; eptr; eptr = eptr->next) {
+		if (eptr->mode == KILL || eptr->registrationQueue.empty()) {
+			continue;
+		}
+		++registeringServers;
+		for (const auto& chunks : eptr->registrationQueue) {
+			pendingChunks += chunks.size();
+		}
+		pendingChunks -= eptr->registrationQueuePosition;
+	}
 }
 
 void matocsserv_liz_register_space(matocsserventry *eptr, const std::vector<uint8_t>& data)
@@ -1447,6 +1521,9 @@ void matocsserv_gotpacket(matocsserventry *eptr, PacketHeader header, const Mess
 			case CSTOMA_SPACE:
 				matocsserv_space(eptr, data.data(), length);
 				break;
+			case LIZ_CSTOMA_GET_LOAD:
+				matocsserv_got_load(eptr, data);
+				break;
 			case CSTOMA_CHUNK_DAMAGED:
 				matocsserv_chunk_damaged(eptr, data.data(), length);
 				break;
@@ -1584,7 +1661,7 @@ void matocsserv_read(matocsserventry *eptr) {
 		matocsserv_gotpacket(eptr, eptr->inputPacket.getHeader(), eptr->inputPacket.getData());
 		eptr->inputPacket.reset();
 
-		if (watchdog.expired()) {
+		if (watchdog.expired() || !eptr->registrationQueue.empty()) {
 			break;
 		}
 	}
@@ -1622,7 +1699,9 @@ void matocsserv_desc(std::vector<pollfd> &pdesc) {
 	pdesc.push_back({lsock,POLLIN,0});
 	lsockpdescpos = pdesc.size()-1;
 	for (eptr=matocsservhead ; eptr ; eptr=eptr->next) {
-		pdesc.push_back({eptr->sock,POLLIN,0});
+		// packets following registered chunks are handled after the chunks are processed
+		pdesc.push_back({eptr->sock,
+				static_cast<short>(eptr->registrationQueue.empty() ? POLLIN : 0), 0});
 		eptr->pdescpos = pdesc.size() - 1;
 		if (!eptr->outputPackets.empty()) {
 			pdesc.back().events |= POLLOUT;
@@ -1669,7 +1748,9 @@ void matocsserv_serve(const std::vector<pollfd> &pdesc) {
 			eptr->rrepcounter = 0;
 			eptr->wrepcounter = 0;
 			eptr->delcounter = 0;
+			eptr->load = 0;
 			eptr->csdb = nullptr;
+			eptr->registrationQueuePosition = 0;
 			chunk_server_unlabelled_connected();
 		} else {
 			tcpclose(ns);
@@ -1696,6 +1777,7 @@ void matocsserv_serve(const std::vector<pollfd> &pdesc) {
 			matocsserv_createpacket(eptr,ANTOAN_NOP,0);
 		}
 	}
+	matocsserv_register_chunks_a_bit();
 	kptr = &matocsservhead;
 	while ((eptr=*kptr)) {
 		if (eptr->mode == KILL) {
@@ -1775,6 +1857,27 @@ uint32_t matocsserv_get_version(matocsserventry *e) {
 	return e->version;
 }
 
+uint32_t matocsserv_get_ip(matocsserventry *e) {
+	return e->servip;
+}
+
+uint32_t matocsserv_get_load(matocsserventry *e) {
+	return e->load;
+}
+
+/*! \brief Asks chunkservers for their load, which is used to order chunk locations for clients.
+ *
+ * Replies come within a fraction of a second, so the order follows changes of load closely.
+ */
+void matocsserv_request_load(void) {
+	for (matocsserventry *eptr = matocsservhead; eptr; eptr = eptr->next) {
+		if (eptr->mode != KILL && eptr->version >= kFirstLoadReportingVersion) {
+			eptr->outputPackets.push_back(OutputPacket());
+			matocs::getLoad::serialize(eptr->outputPackets.back().packet);
+		}
+	}
+}
+
 int matocsserv_init(void) {
 	ListenHost = cfg_getstr("MATOCS_LISTEN_HOST","*");
 	ListenPort = cfg_getstr("MATOCS_LISTEN_PORT","9420");
@@ -1801,5 +1904,6 @@ int matocsserv_init(void) {
 	main_reloadregister(matocsserv_reload);
 	main_destructregister(matocsserv_term);
 	main_pollregister(matocsserv_desc,matocsserv_serve);
+	main_timeregister(TIMEMODE_RUN_LATE,1,0,matocsserv_request_load);
 	return 0;
 }
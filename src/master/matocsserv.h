@@ -38,15 +38,22 @@ typedef std::vector<matocsserventry*> Chunkservers;
 
 /// A struct used in matocsserv_getservers_sorted
 struct ServerWithUsage {
-	ServerWithUsage(matocsserventry* server, double diskUsage, const MediaLabel& label)
+	ServerWithUsage(matocsserventry* server, double diskUsage, const MediaLabel& label,
+			uint64_t usedSpace = 0, uint64_t totalSpace = 0, uint32_t chunkCount = 0)
 			: server(server),
 			  diskUsage(diskUsage),
-			  label(label) {
+			  label(label),
+			  usedSpace(usedSpace),
+			  totalSpace(totalSpace),
+			  chunkCount(chunkCount) {
 	}
 
 	matocsserventry* server;
 	double diskUsage;
 	MediaLabel label;
+	uint64_t usedSpace;
+	uint64_t totalSpace;
+	uint32_t chunkCount;
 };
 
 
@@ -80,10 +87,14 @@ double matocsserv_get_usage(matocsserventry* e);
 std::vector<ServerWithUsage> matocsserv_getservers_sorted();
 
 uint32_t matocsserv_get_version(matocsserventry* e);
+uint32_t matocsserv_get_ip(matocsserventry* e);
+/// Number of operations queued on the chunkserver, as reported by it recently
+uint32_t matocsserv_get_load(matocsserventry* e);
 void matocsserv_usagedifference(double* minusage, double* maxusage,
 		uint16_t* usablescount, uint16_t* totalscount);
+/// Chooses servers for a new chunk, prefers servers close to client_ip (0 if not known)
 std::vector<std::pair<matocsserventry*, ChunkPartType>> matocsserv_getservers_for_new_chunk(
-		uint8_t goalId, uint32_t min_server_version = 0);
+		uint8_t goalId, uint32_t min_server_version = 0, uint32_t client_ip = 0);
 void matocsserv_getspace(uint64_t* totalspace, uint64_t* availspace);
 const char* matocsserv_getstrip(matocsserventry* e);
 int matocsserv_getlocation(matocsserventry* e, uint32_t* servip, uint16_t* servport,
@@ -119,3 +130,6 @@ int matocsserv_init(void);
 void matocsserv_getserverdata(const matocsserventry* s, ChunkserverListEntry &result);
 csdbentry *matocsserv_get_csdb(matocsserventry* s);
 
+/// Number of chunkservers with chunks waiting for registration and number of these chunks
+void matocsserv_registration_progress(uint32_t& registeringServers, uint64_t& pendingChunks);
+
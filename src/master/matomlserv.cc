@@ -32,7 +32,10 @@
 #include <syslog.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <set>
+#include <string>
+#include <vector>
 
 #include "common/cfg.h"
 #include "common/crc.h"
@@ -53,6 +56,10 @@
 #define MaxPacketSize 1500000
 #define OLD_CHANGES_BLOCK_SIZE 5000
 
+// Limits of a single LIZ_MATOML_METACHANGES_LOG_BATCH packet
+#define METACHANGES_BATCH_MAX_ENTRIES 5000
+#define METACHANGES_BATCH_MAX_SIZE 1000000
+
 // matomlserventry.mode
 enum{KILL,HEADER,DATA};
 
@@ -80,6 +87,11 @@ typedef struct matomlserventry {
 	uint16_t servport;
 	bool shadow;
 
+	// Changelog is sent in batches read from old changes, see matomlserv_send_changes_batches
+	bool batched;
+	uint64_t sentlogversion;
+	uint64_t ackedlogversion;
+
 	int metafd,chain1fd,chain2fd;
 
 	struct matomlserventry *next;
@@ -160,11 +172,13 @@ void matomlserv_broadcast_metadata_saved(uint8_t status) {
 
 static old_changes_block *old_changes_head=NULL;
 static old_changes_block *old_changes_current=NULL;
+static uint64_t last_logversion=0;
 
 // from config
 static char *ListenHost;
 static char *ListenPort;
 static uint16_t ChangelogSecondsToRemember;
+static uint32_t ChangelogWindow;
 
 void matomlserv_old_changes_free_block(old_changes_block *oc) {
 	uint32_t i;
@@ -178,6 +192,7 @@ void matomlserv_store_logstring(uint64_t version,uint8_t *logstr,uint32_t logstr
 	old_changes_block *oc;
 	old_changes_entry *oce;
 	uint32_t ts;
+	last_logversion = version;
 	if (ChangelogSecondsToRemember==0) {
 		while (old_changes_head) {
 			oc = old_changes_head->next;
@@ -248,6 +263,15 @@ std::vector<MetadataserverListEntry> matomlserv_shadows() {
 	return ret;
 }
 
+bool matomlserv_followers_have_version(uint32_t version) {
+	for (matomlserventry* eptr = matomlservhead; eptr; eptr=eptr->next) {
+		if (eptr->mode != KILL && eptr->version != 0 && eptr->version < version) {
+			return false;
+		}
+	}
+	return true;
+}
+
 uint32_t matomlserv_shadows_count() {
 	uint32_t count = 0;
 	for (matomlserventry* eptr = matomlservhead; eptr; eptr=eptr->next) {
@@ -326,12 +350,92 @@ void matomlserv_createpacket(matomlserventry *eptr, std::vector<uint8_t> data) {
 	eptr->outputtail = &(outpacket->next);
 }
 
+/*! \brief Finds entry with the given version in old changes.
+ *
+ * \return true if the entry is stored, its position is returned in \a block and \a index
+ */
+static bool matomlserv_find_old_change(uint64_t version, old_changes_block **block, uint32_t *index) {
+	old_changes_block *oc;
+	uint32_t i;
+	for (oc=old_changes_head ; oc ; oc=oc->next) {
+		if (oc->minversion<=version && (oc->next==NULL || oc->next->minversion>version)) {
+			for (i=0 ; i<oc->entries ; i++) {
+				if (oc->old_changes_block[i].version==version) {
+					*block = oc;
+					*index = i;
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+	return false;
+}
+
+/*! \brief Sends stored changes to a connection which receives them in batches.
+ *
+ * Sends entries newer than eptr->sentlogversion as long as the peer hasn't more than
+ * MATOML_LOG_WINDOW unacknowledged entries (unless \a ignoreWindow is set).
+ */
+void matomlserv_send_changes_batches(matomlserventry *eptr, bool ignoreWindow) {
+	while (eptr->sentlogversion < last_logversion && eptr->mode != KILL) {
+		uint64_t inFlight = eptr->sentlogversion - eptr->ackedlogversion;
+		if (!ignoreWindow && inFlight >= ChangelogWindow) {
+			return;
+		}
+		uint64_t firstVersion = eptr->sentlogversion + 1;
+		old_changes_block *oc;
+		uint32_t index;
+		if (!matomlserv_find_old_change(firstVersion, &oc, &index)) {
+			if (old_changes_head != NULL && old_changes_head->minversion > firstVersion) {
+				// The peer will notice the hole and download metadata
+				syslog(LOG_WARNING, "ML(%s) wants changes since version: %" PRIu64 ", but minimal "
+						"version in storage is: %" PRIu64, eptr->servstrip, firstVersion,
+						old_changes_head->minversion);
+				eptr->sentlogversion = eptr->ackedlogversion = old_changes_head->minversion - 1;
+				continue;
+			}
+			syslog(LOG_WARNING, "ML(%s) - changes since version %" PRIu64 " are not stored, "
+					"closing connection", eptr->servstrip, firstVersion);
+			eptr->mode = KILL;
+			return;
+		}
+		std::vector<std::string> entries;
+		uint32_t size = 0;
+		uint64_t limit = ignoreWindow ? METACHANGES_BATCH_MAX_ENTRIES
+				: std::min<uint64_t>(METACHANGES_BATCH_MAX_ENTRIES, ChangelogWindow - inFlight);
+		while (oc && entries.size() < limit && size < METACHANGES_BATCH_MAX_SIZE) {
+			if (index >= oc->entries) {
+				oc = oc->next;
+				index = 0;
+				continue;
+			}
+			old_changes_entry *oce = oc->old_changes_block + index;
+			if (oce->version != firstVersion + entries.size()) {
+				break;
+			}
+			// stored entries contain the terminating null character
+			entries.emplace_back((const char*)oce->data, oce->length > 0 ? oce->length - 1 : 0);
+			size += oce->length + 4;
+			index++;
+		}
+		matomlserv_createpacket(eptr, matoml::metachangesLogBatch::build(
+				firstVersion, fs_getversion(), entries));
+		eptr->sentlogversion += entries.size();
+	}
+}
+
 void matomlserv_send_old_changes(matomlserventry *eptr,uint64_t version) {
 	old_changes_block *oc;
 	old_changes_entry *oce;
 	uint8_t *data;
 	uint8_t start=0;
 	uint32_t i;
+	if (eptr->batched) {
+		// changes will be sent in batches by matomlserv_desc
+		eptr->sentlogversion = eptr->ackedlogversion = version;
+		return;
+	}
 	if (old_changes_head==NULL) {
 		// syslog(LOG_WARNING,"meta logger wants old changes, but storage is disabled");
 		return;
@@ -360,6 +464,11 @@ void matomlserv_send_old_changes(matomlserventry *eptr,uint64_t version) {
 	}
 }
 
+/// Changelog can be sent in batches to peers which understand them if old changes are stored
+static bool matomlserv_can_send_batches(matomlserventry *eptr) {
+	return eptr->version >= kFirstChangelogBatchVersion && ChangelogSecondsToRemember > 0;
+}
+
 void matomlserv_register(matomlserventry *eptr,const uint8_t *data,uint32_t length) {
 	if (eptr->version>0) {
 		syslog(LOG_WARNING,"got register message from registered metalogger !!!");
@@ -395,9 +504,13 @@ void matomlserv_register(matomlserventry *eptr,const uint8_t *data,uint32_t leng
 			eptr->mode=KILL;
 			return;
 		}
+		eptr->batched = matomlserv_can_send_batches(eptr);
 		if (rversion == 2 || rversion == 4) {
 			uint64_t minversion = get64bit(&data);
 			matomlserv_send_old_changes(eptr,minversion);
+		} else {
+			// only new changes are sent
+			eptr->sentlogversion = eptr->ackedlogversion = last_logversion;
 		}
 		if (eptr->timeout<10) {
 			syslog(LOG_NOTICE,"MLTOMA_REGISTER communication timeout too small (%" PRIu16 " seconds - should be at least 10 seconds)",eptr->timeout);
@@ -431,6 +544,7 @@ void matomlserv_register_shadow(matomlserventry *eptr, const uint8_t *data, uint
 		return;
 	}
 
+	eptr->batched = matomlserv_can_send_batches(eptr);
 	uint64_t myMedatataVersion = fs_getversion();
 	uint64_t replyVersion;
 	if (myMedatataVersion > shadowMetadataVersion
@@ -597,6 +711,12 @@ void matomlserv_changelog_apply_error(matomlserventry *eptr, const uint8_t *data
 	}
 }
 
+void matomlserv_metachanges_log_ack(matomlserventry *eptr, const uint8_t *data, uint32_t length) {
+	uint64_t version;
+	mltoma::metachangesLogAck::deserialize(data, length, version);
+	eptr->ackedlogversion = std::max(eptr->ackedlogversion, version);
+}
+
 void matomlserv_broadcast_logstring(uint64_t version,uint8_t *logstr,uint32_t logstrsize) {
 	matomlserventry *eptr;
 	uint8_t *data;
@@ -604,7 +724,8 @@ void matomlserv_broadcast_logstring(uint64_t version,uint8_t *logstr,uint32_t lo
 	matomlserv_store_logstring(version,logstr,logstrsize);
 
 	for (eptr = matomlservhead ; eptr ; eptr=eptr->next) {
-		if (eptr->version>0) {
+		// batched connections get the new entry in matomlserv_desc
+		if (eptr->version>0 && !eptr->batched) {
 			data = matomlserv_createpacket(eptr,MATOML_METACHANGES_LOG,9+logstrsize);
 			put8bit(&data,0xFF);
 			put64bit(&data,version);
@@ -619,6 +740,10 @@ void matomlserv_broadcast_logrotate() {
 
 	for (eptr = matomlservhead ; eptr ; eptr=eptr->next) {
 		if (eptr->version>0) {
+			if (eptr->batched) {
+				// the peer has to rotate its changelog after all previous entries
+				matomlserv_send_changes_batches(eptr, true);
+			}
 			data = matomlserv_createpacket(eptr,MATOML_METACHANGES_LOG,1);
 			put8bit(&data, FORCE_LOG_ROTATE);
 		}
@@ -671,6 +796,9 @@ void matomlserv_gotpacket(matomlserventry *eptr,uint32_t type,const uint8_t *dat
 			case LIZ_MLTOMA_CLTOMA_PORT:
 				matomlserv_matoclport(eptr, data, length);
 				break;
+			case LIZ_MLTOMA_METACHANGES_LOG_ACK:
+				matomlserv_metachanges_log_ack(eptr, data, length);
+				break;
 			default:
 				syslog(LOG_NOTICE,"master <-> metaloggers module: got unknown message (type:%" PRIu32 ")",type);
 				eptr->mode=KILL;
@@ -833,6 +961,10 @@ void matomlserv_desc(std::vector<pollfd> &pdesc) {
 		lsockpdescpos = -1;
 	}
 	for (eptr=matomlservhead ; eptr ; eptr=eptr->next) {
+		// Changes made in the current loop iteration are sent together
+		if (eptr->batched && eptr->version>0 && !gExiting) {
+			matomlserv_send_changes_batches(eptr, false);
+		}
 		pdesc.push_back({eptr->sock,POLLIN,0});
 		eptr->pdescpos = pdesc.size() - 1;
 		if (eptr->outputhead!=NULL) {
@@ -872,6 +1004,9 @@ void matomlserv_serve(const std::vector<pollfd> &pdesc) {
 			eptr->timeout = 10;
 			eptr->servport = 0;// For shadow masters this will be changed to their MATOCL_SERV_PORT
 			eptr->shadow = false;
+			eptr->batched = false;
+			eptr->sentlogversion = 0;
+			eptr->ackedlogversion = 0;
 
 			tcpgetpeer(eptr->sock,&(eptr->servip),NULL);
 			eptr->servstrip = matomlserv_makestrip(eptr->servip);
@@ -937,6 +1072,9 @@ void matomlserv_serve(const std::vector<pollfd> &pdesc) {
 void matomlserv_wantexit(void) {
 	gExiting = true;
 	for (matomlserventry *eptr = matomlservhead; eptr != nullptr; eptr = eptr->next) {
+		if (eptr->batched && eptr->version > 0) {
+			matomlserv_send_changes_batches(eptr, true);
+		}
 		matomlserv_createpacket(eptr, matoml::endSession::build());
 	}
 	// Now we won't create any new packets, but we will wait for all existing packets to be
@@ -957,6 +1095,7 @@ void matomlserv_become_master() {
 /// Used on init and reload.
 void matomlserv_read_config_file() {
 	gMinMetadataSaveRequestPeriod_s = cfg_getuint32("METADATA_SAVE_REQUEST_MIN_PERIOD", 1800);
+	ChangelogWindow = cfg_get_minvalue<uint32_t>("MATOML_LOG_WINDOW", 100000, 1);
 }
 
 void matomlserv_reload(void) {
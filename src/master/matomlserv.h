@@ -44,6 +44,10 @@ int matomlserv_init(void);
  * Returns 1 if all connections to metaloggers were closed, 0 otherwise
  */
 int matomlserv_canexit(void);
+/*
+ * Returns true if all registered metaloggers and shadow masters run at least the given version
+ */
+bool matomlserv_followers_have_version(uint32_t version);
 /*
  * Returns number of connected shadow masters
  */
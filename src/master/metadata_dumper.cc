@@ -94,6 +94,7 @@ void MetadataDumper::setUseMetarestore(bool useMetarestore) {
  */
 
 bool MetadataDumper::start(MetadataDumper::DumpType& dumpType, uint64_t checksum) {
+	dumpTimer_.reset();
 	if (dumpType == kForegroundDump) {
 		return false;
 	}
@@ -143,6 +144,7 @@ bool MetadataDumper::start(MetadataDumper::DumpType& dumpType, uint64_t checksum
 				// exec mfsmetarestore
 				std::string checksumStringified = std::to_string(checksum);
 				std::string storedMetaCopies = std::to_string(gStoredPreviousBackMetaCopies);
+				std::string compressionLevel = std::to_string(gMetadataDumpCompressionLevel);
 				char* metarestoreArgs[] = {
 					const_cast<char*>(metarestorePath_.c_str()),
 					const_cast<char*>("-m"),
@@ -153,6 +155,8 @@ bool MetadataDumper::start(MetadataDumper::DumpType& dumpType, uint64_t checksum
 					const_cast<char*>(checksumStringified.c_str()),
 					const_cast<char*>("-B"),
 					const_cast<char*>(storedMetaCopies.c_str()),
+					const_cast<char*>("-Z"),
+					const_cast<char*>(compressionLevel.c_str()),
 					const_cast<char*>("-#"),
 					const_cast<char*>(changelogFilename.c_str()),
 					NULL};
@@ -61,6 +61,11 @@ public:
 	/// waits until the metadumper finishes but not longer than timeout
 	void waitUntilFinished(SteadyDuration timeout);
 
+	/// time since the last dump was started
+	SteadyDuration dumpTime() const {
+		return dumpTimer_.elapsedTime();
+	}
+
 protected:
 	void dumpingFinished();
 
@@ -85,4 +90,6 @@ protected:
 	std::string metarestorePath_;
 	std::string metadataFilename_;
 	std::string metadataTmpFilename_;
+
+	Timer dumpTimer_;
 };
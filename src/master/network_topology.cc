@@ -0,0 +1,85 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/network_topology.h"
+
+#include <algorithm>
+
+#include "master/itree.h"
+
+NetworkTopology::NetworkTopology() : tree_(nullptr), levels_(0) {
+}
+
+NetworkTopology::~NetworkTopology() {
+	itree_freeall(tree_);
+}
+
+void NetworkTopology::addNetwork(uint32_t fromip, uint32_t toip, const Location &location) {
+	// Networks in the same location share its id
+	auto it = std::find(locations_.begin(), locations_.end(), location);
+	if (it == locations_.end()) {
+		it = locations_.insert(it, location);
+	}
+	levels_ = std::max<uint32_t>(levels_, location.size());
+	tree_ = itree_add_interval(tree_, fromip, toip, it - locations_.begin() + 1);
+}
+
+void NetworkTopology::setLevelDistances(std::vector<uint32_t> distances) {
+	levelDistances_ = std::move(distances);
+}
+
+void NetworkTopology::finalize() {
+	if (tree_) {
+		tree_ = itree_rebalance(tree_);
+	}
+}
+
+uint32_t NetworkTopology::levelDistance(uint32_t level) const {
+	if (level < levelDistances_.size()) {
+		return levelDistances_[level];
+	}
+	return 2 + (levels_ - 1 - level);
+}
+
+uint32_t NetworkTopology::location(uint32_t ip) const {
+	return itree_find(tree_, ip);
+}
+
+uint32_t NetworkTopology::distance(uint32_t ip1, uint32_t ip2) const {
+	if (ip1 == ip2) {
+		return 0;
+	}
+	uint32_t id1 = itree_find(tree_, ip1);
+	uint32_t id2 = itree_find(tree_, ip2);
+	if (id1 == id2) {
+		return 1;
+	}
+	// Machines from undefined networks are in location 0, missing lower levels are 0 too
+	static const Location kUndefined;
+	const Location &location1 = id1 > 0 ? locations_[id1 - 1] : kUndefined;
+	const Location &location2 = id2 > 0 ? locations_[id2 - 1] : kUndefined;
+	for (uint32_t level = 0; level < levels_; ++level) {
+		uint32_t part1 = level < location1.size() ? location1[level] : 0;
+		uint32_t part2 = level < location2.size() ? location2[level] : 0;
+		if (part1 != part2) {
+			return levelDistance(level);
+		}
+	}
+	return 1;
+}
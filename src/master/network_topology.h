@@ -0,0 +1,74 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Hierarchical locations of machines in the network.
+ *
+ * Each network is assigned a location, which is a path of ids from the topmost level of the
+ * hierarchy (e.g. datacenter, row, rack). Distance between two machines is 0 if it is the same
+ * machine, 1 if their locations are equal and otherwise it depends on the first level on which
+ * their locations differ -- the higher level, the bigger distance.
+ */
+class NetworkTopology {
+public:
+	typedef std::vector<uint32_t> Location;
+
+	NetworkTopology();
+	~NetworkTopology();
+
+	NetworkTopology(const NetworkTopology&) = delete;
+	NetworkTopology& operator=(const NetworkTopology&) = delete;
+
+	/// Assigns a location to ip range, later definitions override the former ones
+	void addNetwork(uint32_t fromip, uint32_t toip, const Location &location);
+
+	/*! \brief Sets distances between locations.
+	 *
+	 * distances[i] is a distance between machines which locations differ on level i (0 is the
+	 * topmost one) for the first time. Levels without a distance given use the defaults:
+	 * 2 for the lowest level, 3 for the level above it and so on.
+	 */
+	void setLevelDistances(std::vector<uint32_t> distances);
+
+	/// Prepares the structure for queries, has to be called after all networks are added
+	void finalize();
+
+	uint32_t distance(uint32_t ip1, uint32_t ip2) const;
+
+	/// Id of the location (e.g. rack) of the machine, 0 if its network is undefined
+	uint32_t location(uint32_t ip) const;
+
+	/// Number of levels of the hierarchy, i.e. length of the longest location
+	uint32_t levels() const {
+		return levels_;
+	}
+
+private:
+	uint32_t levelDistance(uint32_t level) const;
+
+	void *tree_;
+	std::vector<Location> locations_; // ids of locations stored in tree_ are indexes + 1
+	std::vector<uint32_t> levelDistances_;
+	uint32_t levels_;
+};
@@ -0,0 +1,66 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/network_topology.h"
+
+#include <gtest/gtest.h>
+
+TEST(NetworkTopologyTests, FlatTopology) {
+	NetworkTopology topology;
+	topology.addNetwork(0x0A000000, 0x0A0000FF, {1});
+	topology.addNetwork(0x0A000100, 0x0A0001FF, {2});
+	topology.addNetwork(0x0A000105, 0x0A000105, {1});
+	topology.finalize();
+
+	EXPECT_EQ(0U, topology.distance(0x0A000001, 0x0A000001));
+	EXPECT_EQ(1U, topology.distance(0x0A000001, 0x0A000002));
+	EXPECT_EQ(2U, topology.distance(0x0A000001, 0x0A000101));
+	EXPECT_EQ(1U, topology.distance(0x0A000001, 0x0A000105));
+	// Machines from undefined networks are in one location
+	EXPECT_EQ(2U, topology.distance(0x0A000001, 0x0B000001));
+	EXPECT_EQ(1U, topology.distance(0x0C000001, 0x0B000001));
+
+	// Networks in the same location share its id
+	EXPECT_NE(0U, topology.location(0x0A000001));
+	EXPECT_EQ(topology.location(0x0A000001), topology.location(0x0A000105));
+	EXPECT_NE(topology.location(0x0A000001), topology.location(0x0A000101));
+	EXPECT_EQ(0U, topology.location(0x0B000001));
+}
+
+TEST(NetworkTopologyTests, HierarchicalTopology) {
+	NetworkTopology topology;
+	// datacenter:row:rack
+	topology.addNetwork(0x0A000000, 0x0A0000FF, {1, 1, 1});
+	topology.addNetwork(0x0A000100, 0x0A0001FF, {1, 1, 2});
+	topology.addNetwork(0x0A000200, 0x0A0002FF, {1, 2, 1});
+	topology.addNetwork(0x0B000000, 0x0B0000FF, {2, 1, 1});
+	topology.finalize();
+	EXPECT_EQ(3U, topology.levels());
+
+	EXPECT_EQ(1U, topology.distance(0x0A000001, 0x0A000002));
+	EXPECT_EQ(2U, topology.distance(0x0A000001, 0x0A000101));
+	EXPECT_EQ(3U, topology.distance(0x0A000001, 0x0A000201));
+	EXPECT_EQ(4U, topology.distance(0x0A000001, 0x0B000001));
+
+	topology.setLevelDistances({100, 10});
+	EXPECT_EQ(1U, topology.distance(0x0A000001, 0x0A000002));
+	EXPECT_EQ(2U, topology.distance(0x0A000001, 0x0A000101));
+	EXPECT_EQ(10U, topology.distance(0x0A000001, 0x0A000201));
+	EXPECT_EQ(100U, topology.distance(0x0A000001, 0x0B000001));
+}
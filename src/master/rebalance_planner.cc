@@ -0,0 +1,134 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "master/rebalance_planner.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <utility>
+
+#include "common/linear_assignment_optimizer.h"
+
+constexpr int RebalancePlanner::kMaxMatching;
+
+std::vector<RebalancePlanner::Move> RebalancePlanner::plan(const std::vector<Server> &servers,
+		double acceptableDifference, bool betweenLabels, uint64_t minMove,
+		const DistanceFunction &distance) {
+	std::map<MediaLabel, std::vector<const Server *>> groups;
+	for (const Server &server : servers) {
+		if (server.totalSpace > 0) {
+			groups[betweenLabels ? MediaLabel::kWildcard : server.label].push_back(&server);
+		}
+	}
+
+	std::vector<Move> moves;
+	for (auto &group : groups) {
+		planGroup(group.second, acceptableDifference, minMove, distance, moves);
+	}
+
+	// Pairs may be matched many times, merge their moves
+	std::map<std::pair<uint16_t, uint16_t>, uint64_t> merged;
+	for (const Move &move : moves) {
+		merged[std::make_pair(move.source, move.destination)] += move.bytes;
+	}
+	moves.clear();
+	for (const auto &entry : merged) {
+		moves.push_back(Move{entry.first.first, entry.first.second, entry.second});
+	}
+	return moves;
+}
+
+void RebalancePlanner::planGroup(std::vector<const Server *> &group, double acceptableDifference,
+		uint64_t minMove, const DistanceFunction &distance, std::vector<Move> &moves) {
+	uint64_t usedSpace = 0, totalSpace = 0;
+	double minUsage = 1.0, maxUsage = 0.0;
+	for (const Server *server : group) {
+		double usage = double(server->usedSpace) / double(server->totalSpace);
+		minUsage = std::min(minUsage, usage);
+		maxUsage = std::max(maxUsage, usage);
+		usedSpace += server->usedSpace;
+		totalSpace += server->totalSpace;
+	}
+	if (maxUsage - minUsage <= acceptableDifference) {
+		return;
+	}
+
+	double targetUsage = double(usedSpace) / double(totalSpace);
+	std::vector<Balance> sources, destinations;
+	for (const Server *server : group) {
+		double target = targetUsage * server->totalSpace;
+		if (server->usedSpace > target) {
+			sources.push_back(Balance{server, uint64_t(server->usedSpace - target)});
+		} else {
+			destinations.push_back(Balance{server, uint64_t(target - server->usedSpace)});
+		}
+	}
+	matchAndMove(sources, destinations, minMove, distance, moves);
+}
+
+void RebalancePlanner::matchAndMove(std::vector<Balance> &sources,
+		std::vector<Balance> &destinations, uint64_t minMove, const DistanceFunction &distance,
+		std::vector<Move> &moves) {
+	auto tooSmall = [minMove](const Balance &balance) { return balance.bytes < minMove; };
+	auto larger = [](const Balance &a, const Balance &b) { return a.bytes > b.bytes; };
+
+	while (true) {
+		sources.erase(std::remove_if(sources.begin(), sources.end(), tooSmall), sources.end());
+		destinations.erase(std::remove_if(destinations.begin(), destinations.end(), tooSmall),
+				destinations.end());
+		if (sources.empty() || destinations.empty()) {
+			return;
+		}
+		// Servers with the biggest imbalance are matched first
+		std::sort(sources.begin(), sources.end(), larger);
+		std::sort(destinations.begin(), destinations.end(), larger);
+		int rows = std::min<int>(sources.size(), kMaxMatching);
+		int columns = std::min<int>(destinations.size(), kMaxMatching);
+		int size = std::max(rows, columns);
+
+		// Closer servers have higher value, dummy rows and columns have value 0
+		std::vector<std::vector<uint32_t>> distances(rows, std::vector<uint32_t>(columns));
+		uint32_t maxDistance = 0;
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < columns; ++j) {
+				distances[i][j] = distance(sources[i].server->ip, destinations[j].server->ip);
+				maxDistance = std::max(maxDistance, distances[i][j]);
+			}
+		}
+		std::vector<std::vector<int>> value(size, std::vector<int>(size, 0));
+		for (int i = 0; i < rows; ++i) {
+			for (int j = 0; j < columns; ++j) {
+				value[i][j] = maxDistance + 1 - distances[i][j];
+			}
+		}
+		std::array<int, kMaxMatching> assignment, objectAssignment;
+		linear_assignment::auctionOptimization(value, assignment, objectAssignment, size);
+
+		for (int i = 0; i < rows; ++i) {
+			int j = assignment[i];
+			if (j < 0 || j >= columns) {
+				continue;
+			}
+			uint64_t bytes = std::min(sources[i].bytes, destinations[j].bytes);
+			moves.push_back(Move{sources[i].server->csid, destinations[j].server->csid, bytes});
+			sources[i].bytes -= bytes;
+			destinations[j].bytes -= bytes;
+		}
+	}
+}
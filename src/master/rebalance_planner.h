@@ -0,0 +1,82 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common/media_label.h"
+
+/*! \brief Plans moving data between chunkservers to even out their disk usage.
+ *
+ * The plan is computed for all servers at once. If usage of servers in a group (all servers
+ * or servers with the same label) differs by more than the acceptable difference, servers above
+ * the average usage of the group give data away and servers below it receive the data. Sources
+ * are matched with destinations by the linear assignment optimizer, so that data is moved
+ * between servers close to each other in the network. Each pair moves as much data as the
+ * source has to give and the destination can take, and matching is repeated for the rest.
+ *
+ * The plan does not change when it is executed, so a chunk is never moved back when usage
+ * fluctuates.
+ */
+class RebalancePlanner {
+public:
+	struct Server {
+		uint16_t csid;
+		MediaLabel label;
+		uint32_t ip;
+		uint64_t usedSpace;
+		uint64_t totalSpace;
+	};
+
+	struct Move {
+		uint16_t source;
+		uint16_t destination;
+		uint64_t bytes;
+	};
+
+	typedef std::function<uint32_t(uint32_t, uint32_t)> DistanceFunction;
+
+	/// Maximal number of sources and destinations matched in one step
+	static constexpr int kMaxMatching = 64;
+
+	/*! \brief Computes a plan.
+	 *
+	 * \param servers all chunkservers which can be used.
+	 * \param acceptableDifference difference of usage which doesn't trigger rebalancing.
+	 * \param betweenLabels whether data can be moved between servers with different labels.
+	 * \param minMove moves smaller than this are omitted.
+	 * \param distance network distance between servers with given ips.
+	 */
+	static std::vector<Move> plan(const std::vector<Server> &servers, double acceptableDifference,
+			bool betweenLabels, uint64_t minMove, const DistanceFunction &distance);
+
+private:
+	struct Balance {
+		const Server *server;
+		uint64_t bytes;
+	};
+
+	static void planGroup(std::vector<const Server *> &group, double acceptableDifference,
+			uint64_t minMove, const DistanceFunction &distance, std::vector<Move> &moves);
+	static void matchAndMove(std::vector<Balance> &sources, std::vector<Balance> &destinations,
+			uint64_t minMove, const DistanceFunction &distance, std::vector<Move> &moves);
+};
@@ -0,0 +1,124 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "master/rebalance_planner.h"
+
+#include <algorithm>
+#include <map>
+#include <gtest/gtest.h>
+
+static const uint64_t GiB = 1024ULL * 1024 * 1024;
+
+static uint32_t flatDistance(uint32_t ip1, uint32_t ip2) {
+	return ip1 == ip2 ? 0 : 1;
+}
+
+static std::map<uint16_t, int64_t> applyPlan(const std::vector<RebalancePlanner::Server> &servers,
+		const std::vector<RebalancePlanner::Move> &moves) {
+	std::map<uint16_t, int64_t> used;
+	for (const auto &server : servers) {
+		used[server.csid] = server.usedSpace;
+	}
+	for (const auto &move : moves) {
+		used[move.source] -= move.bytes;
+		used[move.destination] += move.bytes;
+	}
+	return used;
+}
+
+TEST(RebalancePlannerTests, BalancedServers) {
+	std::vector<RebalancePlanner::Server> servers{
+		{1, MediaLabel::kWildcard, 1, 50 * GiB, 100 * GiB},
+		{2, MediaLabel::kWildcard, 2, 104 * GiB, 200 * GiB},
+	};
+	EXPECT_TRUE(RebalancePlanner::plan(servers, 0.05, false, GiB, flatDistance).empty());
+}
+
+TEST(RebalancePlannerTests, EvensOutUsage) {
+	std::vector<RebalancePlanner::Server> servers{
+		{1, MediaLabel::kWildcard, 1, 90 * GiB, 100 * GiB},
+		{2, MediaLabel::kWildcard, 2, 80 * GiB, 100 * GiB},
+		{3, MediaLabel::kWildcard, 3, 10 * GiB, 100 * GiB},
+		{4, MediaLabel::kWildcard, 4, 20 * GiB, 200 * GiB},
+	};
+	auto moves = RebalancePlanner::plan(servers, 0.05, false, GiB, flatDistance);
+	ASSERT_FALSE(moves.empty());
+	auto used = applyPlan(servers, moves);
+	// Target usage is 40%
+	EXPECT_NEAR(40 * GiB, used[1], GiB);
+	EXPECT_NEAR(40 * GiB, used[2], GiB);
+	EXPECT_NEAR(40 * GiB, used[3], GiB);
+	EXPECT_NEAR(80 * GiB, used[4], GiB);
+	for (const auto &move : moves) {
+		EXPECT_TRUE(move.source == 1 || move.source == 2);
+		EXPECT_TRUE(move.destination == 3 || move.destination == 4);
+	}
+}
+
+TEST(RebalancePlannerTests, LabelsAreSeparate) {
+	MediaLabel ssd("SSD"), hdd("HDD");
+	std::vector<RebalancePlanner::Server> servers{
+		{1, ssd, 1, 90 * GiB, 100 * GiB},
+		{2, hdd, 2, 10 * GiB, 100 * GiB},
+		{3, hdd, 3, 12 * GiB, 100 * GiB},
+	};
+	EXPECT_TRUE(RebalancePlanner::plan(servers, 0.05, false, GiB, flatDistance).empty());
+
+	auto moves = RebalancePlanner::plan(servers, 0.05, true, GiB, flatDistance);
+	auto used = applyPlan(servers, moves);
+	EXPECT_NEAR(112 * GiB / 3, used[1], GiB);
+	EXPECT_NEAR(112 * GiB / 3, used[2], GiB);
+	EXPECT_NEAR(112 * GiB / 3, used[3], GiB);
+}
+
+TEST(RebalancePlannerTests, CloseServersArePaired) {
+	// Servers with ips 1x are in one rack, servers with ips 2x in another
+	auto distance = [](uint32_t ip1, uint32_t ip2) -> uint32_t {
+		return ip1 == ip2 ? 0 : (ip1 / 10 == ip2 / 10 ? 1 : 2);
+	};
+	std::vector<RebalancePlanner::Server> servers{
+		{1, MediaLabel::kWildcard, 11, 80 * GiB, 100 * GiB},
+		{2, MediaLabel::kWildcard, 21, 80 * GiB, 100 * GiB},
+		{3, MediaLabel::kWildcard, 22, 20 * GiB, 100 * GiB},
+		{4, MediaLabel::kWildcard, 12, 20 * GiB, 100 * GiB},
+	};
+	auto moves = RebalancePlanner::plan(servers, 0.05, false, GiB, distance);
+	ASSERT_EQ(2U, moves.size());
+	EXPECT_EQ(1, moves[0].source);
+	EXPECT_EQ(4, moves[0].destination);
+	EXPECT_EQ(30 * GiB, moves[0].bytes);
+	EXPECT_EQ(2, moves[1].source);
+	EXPECT_EQ(3, moves[1].destination);
+	EXPECT_EQ(30 * GiB, moves[1].bytes);
+}
+
+TEST(RebalancePlannerTests, ManyServers) {
+	std::vector<RebalancePlanner::Server> servers;
+	for (int i = 0; i < 300; ++i) {
+		servers.push_back({uint16_t(i), MediaLabel::kWildcard, uint32_t(i),
+				(i % 2 ? 70 : 30) * GiB + i * GiB / 10, 100 * GiB});
+	}
+	auto moves = RebalancePlanner::plan(servers, 0.05, false, GiB / 16, flatDistance);
+	auto used = applyPlan(servers, moves);
+	int64_t maxUsed = 0, minUsed = 100 * GiB;
+	for (const auto &entry : used) {
+		maxUsed = std::max(maxUsed, entry.second);
+		minUsed = std::min(minUsed, entry.second);
+	}
+	EXPECT_LT(maxUsed - minUsed, int64_t(GiB / 4));
+}
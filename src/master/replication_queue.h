@@ -0,0 +1,97 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/platform.h"
+
+#include <array>
+#include <cstddef>
+#include <deque>
+
+/*! \brief Chunks waiting for repair, served before the rest of chunks.
+ *
+ * Chunks are kept on several levels, the level is computed by replicationPriority from how
+ * much redundancy a chunk lacks and how many copies its goal requires. Lower levels are
+ * served first, chunks on the same level are served in the order of insertion.
+ */
+template <typename T>
+class ReplicationQueue {
+public:
+	static constexpr int kLevelCount = 6;
+
+	ReplicationQueue() : size_(0) {
+	}
+
+	void push(const T &value, int level) {
+		levels_[level].push_back(value);
+		++size_;
+	}
+
+	/// Removes and returns an element with the highest priority, queue must not be empty
+	T pop() {
+		int level;
+		return pop(level);
+	}
+
+	/// Same as pop(), also returns the level from which the element was taken
+	T pop(int &level) {
+		for (level = 0; level < kLevelCount; ++level) {
+			if (!levels_[level].empty()) {
+				T value = levels_[level].front();
+				levels_[level].pop_front();
+				--size_;
+				return value;
+			}
+		}
+		return T();
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	std::size_t size() const {
+		return size_;
+	}
+
+	std::size_t size(int level) const {
+		return levels_[level].size();
+	}
+
+private:
+	std::array<std::deque<T>, kLevelCount> levels_;
+	std::size_t size_;
+};
+
+template <typename T>
+constexpr int ReplicationQueue<T>::kLevelCount;
+
+/*! \brief Level of a chunk in ReplicationQueue.
+ *
+ * Endangered chunks, which are lost after one more failure, go first. Then chunks missing
+ * at least two parts and chunks missing one part. In each of these classes chunks with goals
+ * requiring more than two copies are preferred.
+ *
+ * \param endangered whether the chunk is endangered.
+ * \param missingParts number of parts needed to fulfill the goal.
+ * \param goalCopies number of full copies required by the goal.
+ */
+inline int replicationPriority(bool endangered, int missingParts, int goalCopies) {
+	int deficit = endangered ? 0 : (missingParts >= 2 ? 1 : 2);
+	return 2 * deficit + (goalCopies > 2 ? 0 : 1);
+}
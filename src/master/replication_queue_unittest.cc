@@ -0,0 +1,69 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+#include "master/replication_queue.h"
+
+#include <gtest/gtest.h>
+
+TEST(ReplicationQueueTests, Priorities) {
+	EXPECT_EQ(0, replicationPriority(true, 1, 3));
+	EXPECT_EQ(1, replicationPriority(true, 2, 2));
+	EXPECT_EQ(2, replicationPriority(false, 2, 3));
+	EXPECT_EQ(3, replicationPriority(false, 3, 2));
+	EXPECT_EQ(4, replicationPriority(false, 1, 4));
+	EXPECT_EQ(5, replicationPriority(false, 1, 2));
+	EXPECT_LT(replicationPriority(false, 2, 2), ReplicationQueue<int>::kLevelCount);
+}
+
+TEST(ReplicationQueueTests, LowerLevelsFirst) {
+	ReplicationQueue<int> queue;
+	EXPECT_TRUE(queue.empty());
+	queue.push(1, 5);
+	queue.push(2, 3);
+	queue.push(3, 0);
+	queue.push(4, 3);
+	queue.push(5, 0);
+	EXPECT_EQ(5U, queue.size());
+	EXPECT_EQ(2U, queue.size(3));
+
+	EXPECT_EQ(3, queue.pop());
+	EXPECT_EQ(5, queue.pop());
+	EXPECT_EQ(2, queue.pop());
+	queue.push(6, 1);
+	EXPECT_EQ(6, queue.pop());
+	EXPECT_EQ(4, queue.pop());
+	EXPECT_EQ(1, queue.pop());
+	EXPECT_TRUE(queue.empty());
+}
+
+TEST(ReplicationQueueTests, PopReturnsLevel) {
+	ReplicationQueue<int> queue;
+	// Element queued again on a higher level is popped from both of them
+	queue.push(1, 4);
+	queue.push(1, 2);
+	queue.push(2, 4);
+
+	int level = -1;
+	EXPECT_EQ(1, queue.pop(level));
+	EXPECT_EQ(2, level);
+	EXPECT_EQ(1, queue.pop(level));
+	EXPECT_EQ(4, level);
+	EXPECT_EQ(2, queue.pop(level));
+	EXPECT_EQ(4, level);
+	EXPECT_TRUE(queue.empty());
+}
@@ -23,9 +23,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "protocol/MFSCommunication.h"
 #include "common/slogger.h"
+#include "common/time_utils.h"
 #include "master/filesystem.h"
 #include "master/filesystem_snapshot.h"
 #include "master/filesystem_operations.h"
@@ -466,10 +472,17 @@ int do_lock_unlock_inode(const char *filename, uint64_t lv, uint32_t ts, const c
 
 int do_purge(const char* filename, uint64_t lv, uint32_t ts, const char* ptr) {
 	uint32_t inode;
+	std::vector<uint32_t> inodes;
 	EAT(ptr,filename,lv,'(');
 	GETU32(inode,ptr);
+	inodes.push_back(inode);
+	while (*ptr == ',') {
+		ptr++;
+		GETU32(inode,ptr);
+		inodes.push_back(inode);
+	}
 	EAT(ptr,filename,lv,')');
-	return fs_purge(FsContext::getForRestore(ts), inode);
+	return fs_apply_purge(ts,inodes);
 }
 
 int do_release(const char* filename, uint64_t lv, uint32_t ts, const char* ptr) {
@@ -689,19 +702,30 @@ int do_snapshot(const char* filename, uint64_t lv, uint32_t ts, const char* ptr)
 int do_clone_node(const char* filename, uint64_t lv, uint32_t ts, const char* ptr) {
 	uint32_t src_inode, dst_parent, dst_inode, can_overwrite;
 	uint8_t name[256];
+	std::vector<CloneEntry> entries;
 	EAT(ptr,filename,lv,'(');
-	GETU32(src_inode,ptr);
-	EAT(ptr,filename,lv,',');
-	GETU32(dst_parent,ptr);
-	EAT(ptr,filename,lv,',');
-	GETU32(dst_inode,ptr);
-	EAT(ptr,filename,lv,',');
-	GETNAME(name,ptr,filename,lv,',');
-	EAT(ptr,filename,lv,',');
-	GETU32(can_overwrite,ptr);
+	do {
+		if (!entries.empty()) {
+			ptr++;
+		}
+		GETU32(src_inode,ptr);
+		EAT(ptr,filename,lv,',');
+		GETU32(dst_parent,ptr);
+		EAT(ptr,filename,lv,',');
+		GETU32(dst_inode,ptr);
+		EAT(ptr,filename,lv,',');
+		GETNAME(name,ptr,filename,lv,',');
+		EAT(ptr,filename,lv,',');
+		GETU32(can_overwrite,ptr);
+		entries.push_back({src_inode, dst_parent, dst_inode, HString((const char*)name),
+				(uint8_t)can_overwrite});
+	} while (*ptr == ',');
 	EAT(ptr,filename,lv,')');
-	return fs_clone_node(FsContext::getForRestore(ts), src_inode, dst_parent, dst_inode,
-				HString((const char*)name), can_overwrite);
+	if (entries.size() == 1) {
+		return fs_clone_node(FsContext::getForRestore(ts), src_inode, dst_parent, dst_inode,
+					entries[0].name_dst, can_overwrite);
+	}
+	return fs_apply_clone(ts, entries);
 }
 
 int do_symlink(const char* filename, uint64_t lv, uint32_t ts, const char* ptr) {
@@ -811,6 +835,21 @@ int do_write(const char* filename, uint64_t lv, uint32_t ts, const char* ptr) {
 	return fs_writechunk(FsContext::getForRestore(ts), inode, indx, false, &lockid, &chunkid, &opflag, nullptr);
 }
 
+namespace {
+
+struct OperationStats {
+	OperationStats() : count(0), time(0) {}
+
+	uint64_t count;
+	SteadyDuration time;
+};
+
+uint8_t verbosity = 0;
+/* Replay time of each type of changelog entries, gathered if verbosity > 0 */
+std::map<std::string, OperationStats> operationStats;
+
+}
+
 int restore_line(const char* filename, uint64_t lv, const char* line) {
 	uint32_t ts;
 	int status;
@@ -823,6 +862,7 @@ int restore_line(const char* filename, uint64_t lv, const char* line) {
 	EAT(ptr,filename,lv,' ');
 	GETU32(ts,ptr);
 	EAT(ptr,filename,lv,'|');
+	Timer timer;
 	switch (*ptr) {
 		case 'A':
 			if (strncmp(ptr,"ACCESS",6)==0) {
@@ -953,6 +993,12 @@ int restore_line(const char* filename, uint64_t lv, const char* line) {
 			break;
 	}
 
+	if (verbosity > 0) {
+		OperationStats& stats = operationStats[std::string(ptr, strspn(ptr, "ABCDEFGHIJKLMNOPQRSTUVWXYZ"))];
+		stats.count++;
+		stats.time += timer.elapsedTime();
+	}
+
 	if (status == LIZARDFS_ERROR_MAX) {
 #ifndef METARESTORE
 		DEBUG_LOG("master.mismatch")
@@ -980,7 +1026,6 @@ uint64_t currentFsVersion = 0; /* Metadata version from before restore_line() ca
  *   currentFsVersion == nextFsVersion - 1
  */
 const char *lastfn = NULL;
-uint8_t verbosity = 0;
 
 }
 
@@ -1049,3 +1094,19 @@ uint8_t restore(const char* filename, uint64_t newLogVersion, const char *ptr, R
 void restore_setverblevel(uint8_t _vlevel) {
 	verbosity = _vlevel;
 }
+
+void restore_log_stats() {
+	std::vector<std::pair<std::string, OperationStats>> stats(
+			operationStats.begin(), operationStats.end());
+	std::sort(stats.begin(), stats.end(), [](const std::pair<std::string, OperationStats>& a,
+			const std::pair<std::string, OperationStats>& b) {
+		return a.second.time > b.second.time;
+	});
+	for (const auto& entry : stats) {
+		int64_t totalUs = std::chrono::duration_cast<std::chrono::microseconds>(
+				entry.second.time).count();
+		lzfs_pretty_syslog(LOG_NOTICE, "replayed %" PRIu64 " %s entries in %" PRIi64 " ms"
+				" (%" PRIi64 " us per entry)", entry.second.count, entry.first.c_str(),
+				totalUs / 1000, totalUs / (int64_t)entry.second.count);
+	}
+}
@@ -27,3 +27,6 @@ enum class RestoreRigor { kIgnoreParseErrors, kDontIgnoreAnyErrors };
 void restore_reset();
 uint8_t restore(const char* filename, uint64_t lv, const char* ptr, RestoreRigor rigor);
 void restore_setverblevel(uint8_t _vlevel);
+
+/// Logs replay time of each type of changelog entries (gathered only if verbosity level > 0)
+void restore_log_stats();
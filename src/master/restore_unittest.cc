@@ -0,0 +1,136 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/restore.h"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "common/special_inode_defs.h"
+#include "master/filesystem.h"
+#include "master/filesystem_metadata.h"
+#include "master/filesystem_periodic.h"
+#include "master/filesystem_snapshot.h"
+#include "protocol/MFSCommunication.h"
+#include "unittests/master_filesystem.h"
+
+using unittests::MasterFilesystem;
+
+static uint32_t createFile(uint32_t parent, const std::string &name) {
+	uint32_t inode = 0;
+	Attributes attr;
+	EXPECT_EQ(LIZARDFS_STATUS_OK, fs_mknod(SPECIAL_INODE_ROOT, 0, parent, HString(name),
+			TYPE_FILE, 0644, 0, 0, 0, 0, 0, 0, &inode, attr));
+	return inode;
+}
+
+static uint32_t createDirectory(uint32_t parent, const std::string &name) {
+	uint32_t inode = 0;
+	Attributes attr;
+	EXPECT_EQ(LIZARDFS_STATUS_OK, fs_mkdir(SPECIAL_INODE_ROOT, 0, parent, HString(name),
+			0755, 0, 0, 0, 0, 0, 0, &inode, attr));
+	return inode;
+}
+
+static int countEntries(const std::vector<std::string> &lines, const std::string &type) {
+	return std::count_if(lines.begin(), lines.end(), [&type](const std::string &line) {
+		return line.find("|" + type + "(") != std::string::npos;
+	});
+}
+
+TEST(RestoreTests, BatchedPurgeRoundTrip) {
+	MasterFilesystem fs;
+	MasterFilesystem::setTime(1000);
+	for (int i = 0; i < 50; ++i) {
+		createFile(SPECIAL_INODE_ROOT, "file" + std::to_string(i));
+	}
+	for (int i = 0; i < 50; ++i) {
+		ASSERT_EQ(LIZARDFS_STATUS_OK, fs_unlink(SPECIAL_INODE_ROOT, 0, SPECIAL_INODE_ROOT,
+				HString("file" + std::to_string(i)), 0, 0));
+	}
+	MasterFilesystem::setTime(1000 + 2 * 86400);
+	fs_periodic_emptytrash();
+	for (int i = 0; i < 100; ++i) {
+		fs_background_emptytrash_a_bit();
+	}
+
+	auto changelog = fs.changelog();
+	int purgeEntries = countEntries(changelog, "PURGE");
+	EXPECT_GT(purgeEntries, 0);
+	EXPECT_LT(purgeEntries, 50);
+	uint64_t version = fs_getversion();
+	uint64_t checksum = MasterFilesystem::checksum();
+
+	fs.reset();
+	ASSERT_EQ(LIZARDFS_STATUS_OK, MasterFilesystem::apply(changelog));
+	EXPECT_EQ(version, fs_getversion());
+	EXPECT_EQ(checksum, MasterFilesystem::checksum());
+}
+
+TEST(RestoreTests, BatchedPurgeIsAppliedAsAWhole) {
+	MasterFilesystem fs;
+	MasterFilesystem::setTime(1000);
+	uint32_t file0 = createFile(SPECIAL_INODE_ROOT, "file0");
+	uint32_t file1 = createFile(SPECIAL_INODE_ROOT, "file1");
+	for (const char *name : {"file0", "file1"}) {
+		ASSERT_EQ(LIZARDFS_STATUS_OK,
+				fs_unlink(SPECIAL_INODE_ROOT, 0, SPECIAL_INODE_ROOT, HString(name), 0, 0));
+	}
+	uint64_t version = fs_getversion();
+	uint64_t checksum = MasterFilesystem::checksum();
+
+	// Neither an unknown inode nor a repeated one purges anything
+	EXPECT_EQ(LIZARDFS_ERROR_MISMATCH, fs_apply_purge(2000, {file0, file1, file1 + 100}));
+	EXPECT_EQ(LIZARDFS_ERROR_MISMATCH, fs_apply_purge(2000, {file0, file1, file0}));
+	EXPECT_EQ(version, fs_getversion());
+	EXPECT_EQ(checksum, MasterFilesystem::checksum());
+
+	EXPECT_EQ(LIZARDFS_STATUS_OK, fs_apply_purge(2000, {file0, file1}));
+	EXPECT_EQ(version + 1, fs_getversion());
+}
+
+TEST(RestoreTests, BatchedCloneRoundTrip) {
+	MasterFilesystem fs;
+	MasterFilesystem::setTime(1000);
+	uint32_t src = createDirectory(SPECIAL_INODE_ROOT, "src");
+	for (int i = 0; i < 3; ++i) {
+		uint32_t dir = createDirectory(src, "dir" + std::to_string(i));
+		for (int j = 0; j < 20; ++j) {
+			createFile(dir, "file" + std::to_string(j));
+		}
+	}
+	ASSERT_EQ(LIZARDFS_STATUS_OK, fs_snapshot(FsContext::getForMaster(1000), src,
+			SPECIAL_INODE_ROOT, HString("dst"), 0, [](int) {}));
+	while (gMetadata->task_manager.workAvailable()) {
+		fs_background_task_manager_work();
+	}
+
+	// 64 nodes are cloned
+	auto changelog = fs.changelog();
+	int cloneEntries = countEntries(changelog, "CLONE");
+	EXPECT_GT(cloneEntries, 0);
+	EXPECT_LT(cloneEntries, 64);
+	uint64_t version = fs_getversion();
+	uint64_t checksum = MasterFilesystem::checksum();
+
+	fs.reset();
+	ASSERT_EQ(LIZARDFS_STATUS_OK, MasterFilesystem::apply(changelog));
+	EXPECT_EQ(version, fs_getversion());
+	EXPECT_EQ(checksum, MasterFilesystem::checksum());
+}
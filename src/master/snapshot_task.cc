@@ -20,19 +20,22 @@
 
 #include "master/snapshot_task.h"
 
+#include "common/lizardfs_version.h"
 #include "master/filesystem_checksum.h"
 #include "master/filesystem_metadata.h"
 #include "master/filesystem_operations.h"
 #include "master/filesystem_quota.h"
 
 int SnapshotTask::cloneNodeTest(FSNode *src_node, FSNode *dst_node, FSNodeDirectory *dst_parent) {
-	if (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kInodes, 1}}) ||
-	    fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kInodes, 1}})) {
-		return LIZARDFS_ERROR_QUOTA;
-	}
-	if (src_node->type == FSNode::kFile &&
-	    (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kSize, 1}}) ||
-	     fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kSize, 1}}))) {
+	if (src_node->type == FSNode::kFile) {
+		if (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kInodes, 1},
+		                                         {QuotaResource::kSize, 1}}) ||
+		    fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kInodes, 1},
+		                                            {QuotaResource::kSize, 1}})) {
+			return LIZARDFS_ERROR_QUOTA;
+		}
+	} else if (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kInodes, 1}}) ||
+	           fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kInodes, 1}})) {
 		return LIZARDFS_ERROR_QUOTA;
 	}
 	if (dst_node) {
@@ -203,15 +206,26 @@ void SnapshotTask::cloneSymlinkData(FSNodeSymlink *src_node, FSNodeSymlink *dst_
 	fsnodes_add_sub_stats(dst_parent, &nsr, &psr);
 }
 
-void SnapshotTask::emitChangelog(uint32_t ts, uint32_t dst_inode) {
+void SnapshotTask::emitChangelog(uint32_t /*ts*/, uint32_t dst_inode) {
 	if (!emit_changelog_) {
-		gMetadata->metaversion++;
 		return;
 	}
 
-	fs_changelog(ts, "CLONE(%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%s,%" PRIu8 ")",
-	             current_subtask_->first, dst_parent_inode_, dst_inode,
-	             fsnodes_escape_name(current_subtask_->second).c_str(), can_overwrite_);
+	if (!changelog_.empty()) {
+		changelog_ += ',';
+	}
+	changelog_ += std::to_string(current_subtask_->first) + ',' +
+	              std::to_string(dst_parent_inode_) + ',' + std::to_string(dst_inode) + ',' +
+	              fsnodes_escape_name(current_subtask_->second) + ',' +
+	              std::to_string(can_overwrite_);
+}
+
+void SnapshotTask::flushChangelog(uint32_t ts) {
+	if (changelog_.empty()) {
+		return;
+	}
+	fs_changelog(ts, "CLONE(%s)", changelog_.c_str());
+	changelog_.clear();
 }
 
 int SnapshotTask::cloneNode(uint32_t ts) {
@@ -251,11 +265,21 @@ int SnapshotTask::cloneNode(uint32_t ts) {
 int SnapshotTask::execute(uint32_t ts, intrusive_list<Task> &work_queue) {
 	assert(current_subtask_ != subtask_.end());
 
-	int status = cloneNode(ts);
-	if (status == LIZARDFS_STATUS_OK) {
+	// Older followers can't apply CLONE entries with many nodes
+	bool batch_changelog = fs_changelog_followers_have_version(kFirstCloneBatchVersion);
+	int status = LIZARDFS_STATUS_OK;
+	for (int i = 0; i < kMaxClonesPerExecution && current_subtask_ != subtask_.end(); ++i) {
+		status = cloneNode(ts);
+		++current_subtask_;
+		if (status != LIZARDFS_STATUS_OK) {
+			break;
+		}
 		work_queue.splice(work_queue.end(), local_tasks_);
+		if (!batch_changelog) {
+			flushChangelog(ts);
+		}
 	}
-	++current_subtask_;
+	flushChangelog(ts);
 
 	return status;
 }
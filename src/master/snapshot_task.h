@@ -38,18 +38,27 @@
  * with child inodes.
  *
  * Processing of enqueued tasks is done by Task Manager class.
+ *
+ * Chunks are never copied - a clone shares chunk ids with its source and
+ * chunk data is duplicated only when one of the files is written to. A single
+ * call to execute clones several nodes and records all of them in one
+ * CLONE changelog entry.
  */
 class SnapshotTask : public TaskManager::Task {
 public:
 	typedef std::vector<std::pair<uint32_t, HString>> SubtaskContainer;
 
+	/*! \brief Maximum number of nodes cloned in a single call to execute. */
+	static constexpr int kMaxClonesPerExecution = 32;
+
 	SnapshotTask(SubtaskContainer &&subtask, uint32_t orig_inode, uint32_t dst_parent_inode,
 		     uint32_t dst_inode, uint8_t can_overwrite,
 		     bool emit_changelog, bool enqueue_work) :
 		     subtask_(std::move(subtask)), orig_inode_(orig_inode),
 		     dst_parent_inode_(dst_parent_inode),dst_inode_(dst_inode),
 		     can_overwrite_(can_overwrite),
-		     emit_changelog_(emit_changelog), enqueue_work_(enqueue_work), local_tasks_() {
+		     emit_changelog_(emit_changelog), enqueue_work_(enqueue_work), local_tasks_(),
+		     changelog_() {
 		assert(subtask_.size() == 1 || (subtask_.size() > 1 && dst_inode == 0));
 		current_subtask_ = subtask_.begin();
 	}
@@ -68,7 +77,8 @@ public:
 	 *
 	 * This function overrides pure virtual execute function of TaskManager::Task.
 	 * It is the only function to be called by Task Manager in order to
-	 * execute enqueued task.
+	 * execute enqueued task. Up to kMaxClonesPerExecution subtasks are processed
+	 * and a single changelog entry is emitted for all of them.
 	 *
 	 * \param ts current time stamp.
 	 * \param work_queue a list to which this task adds newly created tasks.
@@ -96,11 +106,13 @@ protected:
 
 	/*! \brief Emit metadata changelog.
 	 *
-	 * The function (for master) emits metadata CLONE information. For shadow it updates
-	 * metadata version.
+	 * The function (for master) appends CLONE information to the pending changelog entry.
 	 */
 	void emitChangelog(uint32_t ts, uint32_t dst_inode);
 
+	/*! \brief Write pending CLONE information to changelog. */
+	void flushChangelog(uint32_t ts);
+
 private:
 	SubtaskContainer subtask_; /*!< List of pairs (inode to be cloned, clone file name). */
 	SubtaskContainer::iterator current_subtask_; /*!< Current subtask to execute. */
@@ -115,4 +127,5 @@ private:
 	                                 for source inode's children. */
 	intrusive_list<Task> local_tasks_; /*< List of snapshot tasks created by this
 	                                                   task for source inode's children. */
+	std::string changelog_; /*!< Arguments of CLONE entry not yet written to changelog. */
 };
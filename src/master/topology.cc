@@ -27,14 +27,13 @@
 #include <string.h>
 #include <syslog.h>
 #include <unistd.h>
+#include <memory>
 
 #include "common/cfg.h"
 #include "common/main.h"
 #include "common/massert.h"
 #include "common/slogger.h"
-#include "master/itree.h"
 
-static void *racktree;
 static char *TopologyFileName;
 
 // hash is much faster than itree, but it is hard to define ip classes in hash tab
@@ -152,162 +151,66 @@ int topology_parsenet(char *net,uint32_t *fromip,uint32_t *toip) {
 	return -1;
 }
 
-// as for now:
-//
-// 0 - same machine
-// 1 - same rack, different machines
-// 2 - different racks
+static std::unique_ptr<NetworkTopology> gTopology;
 
-uint8_t topology_distance(uint32_t ip1,uint32_t ip2) {
-	uint32_t rid1,rid2;
-	if (ip1==ip2) {
-		return 0;
+uint32_t topology_distance(uint32_t ip1,uint32_t ip2) {
+	if (!gTopology) {
+		return ip1 == ip2 ? 0 : 1;
 	}
-	rid1 = itree_find(racktree,ip1);
-	rid2 = itree_find(racktree,ip2);
-	return (rid1==rid2)?1:2;
+	return gTopology->distance(ip1, ip2);
+}
+
+uint32_t topology_location(uint32_t ip) {
+	return gTopology ? gTopology->location(ip) : 0;
 }
 
 // format:
-// network      rackid
+// network      location
+// LEVEL_DISTANCES distance...
+//
+// where location is a path of ids separated with colons, e.g. datacenter:row:rack
 
-/*
-idea for the future:
-
-distance(id1,id2) = number of one bits in id1^id2
-
-network topology examples with rack ids
-
-1. chain
-
-A--B--C--D--E
-
-A: 1111
-B: 1110
-C: 1100
-D: 1000
-E: 0000
-
-2. star
-
-|      A
-|    B | C
-|     \|/
-|   D--*--E
-
-A: 00001
-B: 00010
-C: 00100
-D: 01000
-E: 10000
-
-3. two chains
-
-|  A--B--C--D--E--F
-|        |
-|  G--H--I--J--K--L--M--N
-
-A: 1111111111001
-B: 1111011111001
-C: 1110011111001
-D: 1100011111001
-E: 1000011111001
-F: 0000011111001
-G: 1110011111110
-H: 1110011111100
-I: 1110011111000
-J: 1110011110000
-K: 1110011100000
-L: 1110011000000
-M: 1110010000000
-N: 1110000000000
-
-4. star and chain
-
-|         A
-|       B | C
-|        \|/
-|      D--*--E
-|        /|
-|       F |
-|         |
-|   G--H--I--J--K--L--M--N
-
-A: 00000111111001
-B: 00001011111001
-C: 00010011111001
-D: 00100011111001
-E: 01000011111001
-F: 10000011111001
-G: 00000011111110
-H: 00000011111100
-I: 00000011111000
-J: 00000011110000
-K: 00000011100000
-L: 00000011000000
-M: 00000010000000
-N: 00000000000000
-
-5. two stars
-
-|         A
-|       B | C
-|        \|/
-|      D--*--E
-|        /|
-|       F |
-|         |
-|       G | H
-|        \|/
-|      I--*--J
-|        /|\
-|       K L M
-
-A: 00000100000001
-B: 00001000000001
-C: 00010000000001
-D: 00100000000001
-E: 01000000000001
-F: 10000000000001
-G: 00000000000010
-H: 00000000000100
-I: 00000000001000
-J: 00000000010000
-K: 00000000100000
-L: 00000001000000
-M: 00000010000000
-
-6. two stars with poor link
-
-|         A
-|       B | C
-|        \|/
-|      D--*--E
-|        /.
-|       F .
-|         .
-|       G . H
-|        \./
-|      I--*--J
-|        /|\
-|       K L M
-
-A: 00000100000001111111
-B: 00001000000001111111
-C: 00010000000001111111
-D: 00100000000001111111
-E: 01000000000001111111
-F: 10000000000001111111
-G: 00000000000010000000
-H: 00000000000100000000
-I: 00000000001000000000
-J: 00000000010000000000
-K: 00000000100000000000
-L: 00000001000000000000
-M: 00000010000000000000
-*/
-
-int topology_parseline(char *line,uint32_t lineno,uint32_t *fip,uint32_t *tip,uint32_t *rid) {
+static bool topology_isspace(char c) {
+	return c==' ' || c=='\t';
+}
+
+static bool topology_isend(char c) {
+	return c==0 || c=='\r' || c=='\n' || c=='#';
+}
+
+// parses ids separated with colons, returns pointer to the first unparsed char
+static char *topology_parselocation(char *p,NetworkTopology::Location &location) {
+	location.clear();
+	while (*p>='0' && *p<='9') {
+		location.push_back(strtoul(p,&p,10));
+		if (*p!=':' || p[1]<'0' || p[1]>'9') {
+			break;
+		}
+		p++;
+	}
+	return p;
+}
+
+static int topology_checkend(char *p,uint32_t lineno) {
+	while (topology_isspace(*p)) {
+		p++;
+	}
+	if (!topology_isend(*p)) {
+		lzfs_pretty_syslog(LOG_WARNING,"mfstopology: garbage found at the end of line: %" PRIu32,lineno);
+		return -1;
+	}
+	return 0;
+}
+
+static const char kLevelDistances[] = "LEVEL_DISTANCES";
+
+/*! \brief Parses a line of the topology file.
+ *
+ * \return -1 if the line should be ignored, 0 if it defines a network, 1 if it defines
+ *         distances between levels.
+ */
+int topology_parseline(char *line,uint32_t lineno,uint32_t *fip,uint32_t *tip,
+		NetworkTopology::Location &location) {
 	char *net;
 	char *p;
 
@@ -316,14 +219,34 @@ int topology_parseline(char *line,uint32_t lineno,uint32_t *fip,uint32_t *tip,ui
 	}
 
 	p = line;
-	while (*p==' ' || *p=='\t') {
+	while (topology_isspace(*p)) {
 		p++;
 	}
 	if (*p==0 || *p=='\r' || *p=='\n') {
 		return -1;
 	}
+
+	if (strncmp(p,kLevelDistances,sizeof(kLevelDistances)-1)==0
+			&& topology_isspace(p[sizeof(kLevelDistances)-1])) {
+		p += sizeof(kLevelDistances)-1;
+		location.clear();
+		while (topology_isspace(*p)) {
+			while (topology_isspace(*p)) {
+				p++;
+			}
+			if (*p>='0' && *p<='9') {
+				location.push_back(strtoul(p,&p,10));
+			}
+		}
+		if (location.empty()) {
+			lzfs_pretty_syslog(LOG_WARNING,"mfstopology: incorrect distances in line: %" PRIu32,lineno);
+			return -1;
+		}
+		return topology_checkend(p,lineno) < 0 ? -1 : 1;
+	}
+
 	net = p;
-	while (*p && *p!=' ' && *p!='\t') {
+	while (*p && !topology_isspace(*p)) {
 		p++;
 	}
 	if (*p==0 || *p=='\r' || *p=='\n') {
@@ -337,40 +260,30 @@ int topology_parseline(char *line,uint32_t lineno,uint32_t *fip,uint32_t *tip,ui
 		return -1;
 	}
 
-	while (*p==' ' || *p=='\t') {
+	while (topology_isspace(*p)) {
 		p++;
 	}
 
-	if (*p<'0' || *p>'9') {
+	p = topology_parselocation(p,location);
+	if (location.empty()) {
 		lzfs_pretty_syslog(LOG_WARNING,"mfstopology: incorrect rack id in line: %" PRIu32,lineno);
 		return -1;
 	}
-
-	*rid = strtoul(p,&p,10);
-
-	while (*p==' ' || *p=='\t') {
-		p++;
-	}
-
-	if (*p && *p!='\r' && *p!='\n' && *p!='#') {
-		lzfs_pretty_syslog(LOG_WARNING,"mfstopology: garbage found at the end of line: %" PRIu32,lineno);
-		return -1;
-	}
-	return 0;
+	return topology_checkend(p,lineno);
 }
 
 void topology_load(void) {
 	FILE *fd;
 	char linebuff[10000];
 	uint32_t lineno;
-	uint32_t fip,tip,rid;
-	void *newtree;
+	uint32_t fip,tip;
+	NetworkTopology::Location location;
 
 	fd = fopen(TopologyFileName,"r");
 	if (fd==NULL) {
 		if (errno==ENOENT) {
 
-			if (racktree) {
+			if (gTopology) {
 				lzfs_pretty_syslog(LOG_WARNING,
 						"topology file %s not found - network topology not changed; "
 						"if you don't want to define network topology create an empty file %s "
@@ -384,7 +297,7 @@ void topology_load(void) {
 						TopologyFileName, TopologyFileName);
 			}
 		} else {
-			if (racktree) {
+			if (gTopology) {
 				lzfs_pretty_syslog(LOG_WARNING,
 						"can't open topology file %s: %s - network topology not changed",
 						TopologyFileName, strerr(errno));
@@ -397,17 +310,22 @@ void topology_load(void) {
 		return;
 	}
 
-	newtree = NULL;
+	std::unique_ptr<NetworkTopology> topology(new NetworkTopology);
 	lineno = 1;
 	while (fgets(linebuff,10000,fd)) {
-		if (topology_parseline(linebuff,lineno,&fip,&tip,&rid)>=0) {
-			newtree = itree_add_interval(newtree,fip,tip,rid);
+		switch (topology_parseline(linebuff,lineno,&fip,&tip,location)) {
+		case 0:
+			topology->addNetwork(fip,tip,location);
+			break;
+		case 1:
+			topology->setLevelDistances(location);
+			break;
 		}
 		lineno++;
 	}
 	if (ferror(fd)) {
 		fclose(fd);
-		if (racktree) {
+		if (gTopology) {
 			lzfs_pretty_syslog(LOG_WARNING,
 					"error reading topology file %s - network topology not changed",
 					TopologyFileName);
@@ -416,15 +334,11 @@ void topology_load(void) {
 					"error reading topology file %s - network topology feature will be disabled",
 					TopologyFileName);
 		}
-		itree_freeall(newtree);
 		return;
 	}
 	fclose(fd);
-	itree_freeall(racktree);
-	racktree = newtree;
-	if (racktree) {
-		racktree = itree_rebalance(racktree);
-	}
+	topology->finalize();
+	gTopology = std::move(topology);
 	lzfs_pretty_syslog(LOG_INFO, "initialized topology from file %s", TopologyFileName);
 }
 
@@ -437,7 +351,7 @@ void topology_reload(void) {
 }
 
 void topology_term(void) {
-	itree_freeall(racktree);
+	gTopology.reset();
 	if (TopologyFileName) {
 		free(TopologyFileName);
 	}
@@ -445,7 +359,6 @@ void topology_term(void) {
 
 int topology_init(void) {
 	TopologyFileName = NULL;
-	racktree = NULL;
 	topology_reload();
 	main_reloadregister(topology_reload);
 	main_destructregister(topology_term);
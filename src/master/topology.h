@@ -22,5 +22,10 @@
 
 #include <inttypes.h>
 
-uint8_t topology_distance(uint32_t ip1,uint32_t ip2);
+#include "master/network_topology.h"
+
+/// Distance between machines in the network, see NetworkTopology
+uint32_t topology_distance(uint32_t ip1,uint32_t ip2);
+/// Id of the location of the machine, machines with equal ids are in the same rack
+uint32_t topology_location(uint32_t ip);
 int topology_init(void);
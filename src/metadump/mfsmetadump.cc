@@ -24,6 +24,7 @@
 #include <sys/types.h>
 #include <vector>
 
+#include "common/compressed_metadata.h"
 #include "common/datapack.h"
 #include "protocol/MFSCommunication.h"
 
@@ -478,57 +479,85 @@ inline int fs_load_29(FILE *fd) {
 	return fs_load_2x(fd, true);
 }
 
-int fs_loadall(const char *fname) {
-	FILE *fd;
-	uint8_t hdr[8];
-
-	fd = fopen(fname,"r");
-
-	if (fd==NULL) {
-		printf("can't open metadata file\n");
-		return -1;
-	}
-	if (fread(hdr,1,8,fd)!=8) {
-		printf("can't read metadata header\n");
-		fclose(fd);
-		return -1;
-	}
+static void print_header(const uint8_t *hdr) {
 	printf("# header: %c%c%c%c%c%c%c%c (%02X%02X%02X%02X%02X%02X%02X%02X)\n",dispchar(hdr[0]),dispchar(hdr[1]),dispchar(hdr[2]),dispchar(hdr[3]),dispchar(hdr[4]),dispchar(hdr[5]),dispchar(hdr[6]),dispchar(hdr[7]),hdr[0],hdr[1],hdr[2],hdr[3],hdr[4],hdr[5],hdr[6],hdr[7]);
+}
+
+static int fs_loadimage(FILE *fd, const uint8_t *hdr) {
 	if (memcmp(hdr,MFSSIGNATURE "M 1.5",8)==0 || memcmp(hdr,MFSSIGNATURE "M 1.6",8)==0) {
 		bool loadLockIds = (hdr[7] == '6');
 		if (fs_load(fd) < 0) {
 			printf("error reading metadata (structure)\n");
-			fclose(fd);
 			return -1;
 		}
 		if (chunk_load(fd, loadLockIds) < 0) {
 			printf("error reading metadata (chunks)\n");
-			fclose(fd);
 			return -1;
 		}
 	} else if (memcmp(hdr,MFSSIGNATURE "M 2.0",8) == 0) {
 		if (fs_load_20(fd) < 0) {
-			fclose(fd);
 			return -1;
 		}
 	/* Note LIZARDFSSIGNATURE instead of MFSSIGNATURE! */
 	} else if (memcmp(hdr,LIZARDFSSIGNATURE "M 2.9",8) == 0) {
 		if (fs_load_29(fd) < 0) {
-			fclose(fd);
 			return -1;
 		}
 	} else {
 		printf("wrong metadata header (old version ?)\n");
-		fclose(fd);
 		return -1;
 	}
 	if (ferror(fd)!=0) {
 		printf("error reading metadata\n");
+		return -1;
+	}
+	return 0;
+}
+
+int fs_loadall(const char *fname) {
+	FILE *fd;
+	uint8_t hdr[8];
+
+	fd = fopen(fname,"r");
+
+	if (fd==NULL) {
+		printf("can't open metadata file\n");
+		return -1;
+	}
+	if (fread(hdr,1,8,fd)!=8) {
+		printf("can't read metadata header\n");
+		fclose(fd);
+		return -1;
+	}
+	print_header(hdr);
+	if (memcmp(hdr,kCompressedMetadataSignature,8) != 0) {
+		int ret = fs_loadimage(fd, hdr);
+		fclose(fd);
+		return ret;
+	}
+
+	// Block-compressed image (METADATA_DUMP_COMPRESSION_LEVEL) holds an ordinary one
+	if (!compressedMetadataSupported()) {
+		printf("compressed metadata files are not supported by this build\n");
+		fclose(fd);
+		return -1;
+	}
+	FILE *image = compressedMetadataOpenReader(fd);
+	if (image==NULL) {
+		printf("compressed metadata file is damaged or truncated\n");
 		fclose(fd);
 		return -1;
 	}
+	int ret = -1;
+	if (fread(hdr,1,8,image)!=8) {
+		printf("can't read metadata header\n");
+	} else {
+		print_header(hdr);
+		ret = fs_loadimage(image, hdr);
+	}
+	fclose(image);
 	fclose(fd);
-	return 0;
+	return ret;
 }
 
 int main(int argc,char **argv) {
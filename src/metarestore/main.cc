@@ -100,12 +100,12 @@ int changelog_checkname(const char *fname) {
 void usage(const char* appname) {
 	lzfs_pretty_syslog(LOG_ERR, "invalid/missing arguments");
 	fprintf(stderr, "restore metadata:\n"
-			"\t%s [-c] [-k <checksum>] [-z] [-f] [-b] [-i] [-x [-x]] [-B n] -m <meta data file> -o "
+			"\t%s [-c] [-k <checksum>] [-z] [-Z n] [-f] [-b] [-i] [-x [-x]] [-B n] -m <meta data file> -o "
 			"<restored meta data file> [ <change log file> [ <change log file> [ .... ]]\n"
 			"dump metadata:\n"
 			"\t%s [-i] -m <meta data file>\n"
 			"autorestore:\n"
-			"\t%s [-f] [-z] [-b] [-i] [-x [-x]] [-B n] -a [-d <data path>]\n"
+			"\t%s [-f] [-z] [-Z n] [-b] [-i] [-x [-x]] [-B n] -a [-d <data path>]\n"
 			"print version of metadata that can be read from disk by a master server in auto recovery mode:\n"
 			"\t%s -g -d <data path>\n"
 			"print version:\n"
@@ -115,6 +115,7 @@ void usage(const char* appname) {
 			"-c   - print checksum of the metadata\n"
 			"-k   - check checksum against given checksum\n"
 			"-z   - ignore metadata checksum inconsistency while applying changelogs\n"
+			"-Z n - compress stored metadata file with zlib level n (1-9)\n"
 			"-x   - produce more verbose output\n"
 			"-xx  - even more verbose output\n"
 			"-b   - if there is any error in change logs then save the best possible metadata file\n"
@@ -202,7 +203,7 @@ int main(int argc,char **argv) {
 	strerr_init();
 	openlog(nullptr, LOG_PID | LOG_NDELAY, LOG_USER);
 
-	while ((ch = getopt(argc, argv, "gfck:vm:o:d:abB:xih:z#?")) != -1) {
+	while ((ch = getopt(argc, argv, "gfck:vm:o:d:abB:xih:zZ:#?")) != -1) {
 		switch (ch) {
 			case 'g':
 				versionRecovery = true;
@@ -257,6 +258,13 @@ int main(int argc,char **argv) {
 			case 'z':
 				fs_disable_checksum_verification(true);
 				break;
+			case 'Z':
+				gMetadataDumpCompressionLevel = strtoul(optarg, nullptr, 10);
+				if (gMetadataDumpCompressionLevel > kMaxMetadataDumpCompressionLevel) {
+					lzfs_pretty_syslog(LOG_ERR, "invalid compression level: %s", optarg);
+					return 1;
+				}
+				break;
 			case '#':
 				noLock = true;
 				break;
@@ -450,6 +458,9 @@ int main(int argc,char **argv) {
 	}
 
 	uint8_t status = merger_loop();
+	if (vl > 0) {
+		restore_log_stats();
+	}
 
 	if (status != LIZARDFS_STATUS_OK && savebest==0) {
 		return 1;
@@ -24,6 +24,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #include "protocol/MFSCommunication.h"
 #include "common/slogger.h"
@@ -37,11 +42,82 @@ typedef struct _hentry {
 	char *buff;
 	char *ptr;
 	uint64_t nextid;
+	uint32_t fileindex;
 } hentry;
 
 static hentry *heap;
 static uint32_t heapsize;
 static uint64_t maxidhole;
+// Names of merged files, they have to outlive heap entries because restore() remembers them
+static std::vector<std::string> mergedfiles;
+
+namespace {
+
+// Changelog entries are read and merged in a separate thread and applied in batches
+struct MergerEntry {
+	uint32_t fileindex;
+	uint64_t id;
+	std::string data;
+};
+
+typedef std::vector<MergerEntry> MergerBatch;
+
+const uint32_t kMergerBatchSize = 4096;
+const uint32_t kMergerMaxQueuedBatches = 16;
+
+class MergerQueue {
+public:
+	MergerQueue() : finished_(false), cancelled_(false) {}
+
+	/// Returns false if the consumer doesn't want more batches
+	bool push(MergerBatch&& batch) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		notFull_.wait(lock, [this]() {
+			return cancelled_ || batches_.size() < kMergerMaxQueuedBatches;
+		});
+		if (cancelled_) {
+			return false;
+		}
+		batches_.push_back(std::move(batch));
+		notEmpty_.notify_one();
+		return true;
+	}
+
+	/// Returns false if there are no more batches
+	bool pop(MergerBatch& batch) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		notEmpty_.wait(lock, [this]() { return finished_ || !batches_.empty(); });
+		if (batches_.empty()) {
+			return false;
+		}
+		batch = std::move(batches_.front());
+		batches_.pop_front();
+		notFull_.notify_one();
+		return true;
+	}
+
+	void finish() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		finished_ = true;
+		notEmpty_.notify_one();
+	}
+
+	void cancel() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		cancelled_ = true;
+		notFull_.notify_one();
+	}
+
+private:
+	std::mutex mutex_;
+	std::condition_variable notEmpty_;
+	std::condition_variable notFull_;
+	std::deque<MergerBatch> batches_;
+	bool finished_;
+	bool cancelled_;
+};
+
+} // anonymous namespace
 
 #define PARENT(x) (((x)-1)/2)
 #define CHILD(x) (((x)*2)+1)
@@ -116,6 +192,8 @@ void merger_delete_entry(void) {
 
 void merger_new_entry(const char *filename) {
 	// printf("add file: %s\n",filename);
+	heap[heapsize].fileindex = mergedfiles.size();
+	mergedfiles.push_back(filename);
 	if ((heap[heapsize].fd = fopen(filename,"r"))!=NULL) {
 		heap[heapsize].filename = strdup(filename);
 		heap[heapsize].buff = (char*) malloc(BSIZE);
@@ -133,6 +211,8 @@ void merger_new_entry(const char *filename) {
 
 int merger_start(const std::vector<std::string>& filenames, uint64_t maxhole) {
 	heapsize = 0;
+	mergedfiles.clear();
+	mergedfiles.reserve(filenames.size());
 	heap = (hentry*)malloc(sizeof(hentry)*filenames.size());
 	if (heap==NULL) {
 		return -1;
@@ -150,20 +230,12 @@ int merger_start(const std::vector<std::string>& filenames, uint64_t maxhole) {
 	return 0;
 }
 
-uint8_t merger_loop(void) {
-	uint8_t status;
+static void merger_read_loop(MergerQueue& queue) {
+	MergerBatch batch;
 	hentry h;
 
 	while (heapsize) {
-//              lzfs_pretty_syslog(LOG_DEBUG, "current id: %" PRIu64 " / %s",heap[0].nextid,heap[0].ptr);
-		if ((status=restore(heap[0].filename, heap[0].nextid, heap[0].ptr,
-				RestoreRigor::kIgnoreParseErrors)) != LIZARDFS_STATUS_OK) {
-			while (heapsize) {
-				heapsize--;
-				merger_delete_entry();
-			}
-			return status;
-		}
+		batch.push_back(MergerEntry{heap[0].fileindex, heap[0].nextid, heap[0].ptr});
 		merger_nextentry(0);
 		if (heap[0].nextid==0) {
 			heapsize--;
@@ -173,6 +245,41 @@ uint8_t merger_loop(void) {
 			merger_delete_entry();
 		}
 		merger_heap_sort_down();
+		if (batch.size() >= kMergerBatchSize) {
+			if (!queue.push(std::move(batch))) {
+				break;
+			}
+			batch.clear();
+		}
 	}
-	return 0;
+	if (!batch.empty()) {
+		queue.push(std::move(batch));
+	}
+	queue.finish();
+}
+
+uint8_t merger_loop(void) {
+	uint8_t status = LIZARDFS_STATUS_OK;
+	MergerQueue queue;
+	MergerBatch batch;
+
+	// Reading and merging files doesn't touch metadata, so it is done while entries are applied
+	std::thread reader(merger_read_loop, std::ref(queue));
+	while (status == LIZARDFS_STATUS_OK && queue.pop(batch)) {
+		for (const MergerEntry& entry : batch) {
+//			lzfs_pretty_syslog(LOG_DEBUG, "current id: %" PRIu64 " / %s",entry.id,entry.data.c_str());
+			status = restore(mergedfiles[entry.fileindex].c_str(), entry.id, entry.data.c_str(),
+					RestoreRigor::kIgnoreParseErrors);
+			if (status != LIZARDFS_STATUS_OK) {
+				break;
+			}
+		}
+	}
+	queue.cancel();
+	reader.join();
+	while (heapsize) {
+		heapsize--;
+		merger_delete_entry();
+	}
+	return status;
 }
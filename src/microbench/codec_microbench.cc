@@ -0,0 +1,139 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "common/block_xor.h"
+#include "common/crc.h"
+#include "common/reed_solomon.h"
+#include "common/slice_traits.h"
+#include "protocol/MFSCommunication.h"
+
+typedef ReedSolomon<slice_traits::ec::kMaxDataCount, slice_traits::ec::kMaxParityCount> RS;
+
+static std::vector<uint8_t> randomBlock(std::size_t size, unsigned seed) {
+	std::mt19937 generator(seed);
+	std::vector<uint8_t> block(size);
+	std::generate(block.begin(), block.end(), [&generator]() { return generator(); });
+	return block;
+}
+
+static void BM_Crc32(benchmark::State &state) {
+	std::vector<uint8_t> block = randomBlock(state.range(0), 1);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(mycrc32(0, block.data(), block.size()));
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * block.size());
+}
+BENCHMARK(BM_Crc32)->Arg(4096)->Arg(MFSBLOCKSIZE);
+
+// Second argument is an offset of the source, to compare aligned and unaligned loads
+static void BM_BlockXor(benchmark::State &state) {
+	std::size_t size = state.range(0);
+	std::vector<uint8_t> dest = randomBlock(size, 1);
+	std::vector<uint8_t> source = randomBlock(size + 64, 2);
+	for (auto _ : state) {
+		blockXor(dest.data(), source.data() + state.range(1), size);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * size);
+}
+BENCHMARK(BM_BlockXor)->Args({4096, 0})->Args({MFSBLOCKSIZE, 0})->Args({MFSBLOCKSIZE, 1});
+
+// Parity block of a xor stripe computed in the same way as by the mount
+static void BM_XorParity(benchmark::State &state) {
+	int level = state.range(0);
+	std::vector<std::vector<uint8_t>> blocks;
+	for (int i = 0; i < level; ++i) {
+		blocks.push_back(randomBlock(MFSBLOCKSIZE, i));
+	}
+	std::vector<const uint8_t *> sources;
+	for (const auto &block : blocks) {
+		sources.push_back(block.data());
+	}
+	std::vector<uint8_t> parity(MFSBLOCKSIZE);
+	for (auto _ : state) {
+		blockXorMany(parity.data(), sources.data(), sources.size(), MFSBLOCKSIZE);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * level * MFSBLOCKSIZE);
+}
+BENCHMARK(BM_XorParity)->Arg(2)->Arg(3)->Arg(5)->Arg(9);
+
+class ReedSolomonFixture {
+public:
+	ReedSolomonFixture(int k, int m) : rs(k, m), data_fragments{{0}}, parity_fragments{{0}} {
+		for (int i = 0; i < k; ++i) {
+			data.push_back(randomBlock(MFSBLOCKSIZE, i));
+			data_fragments[i] = data.back().data();
+		}
+		parity.assign(m, std::vector<uint8_t>(MFSBLOCKSIZE));
+		for (int i = 0; i < m; ++i) {
+			parity_fragments[i] = parity[i].data();
+		}
+	}
+
+	RS rs;
+	std::vector<std::vector<uint8_t>> data;
+	std::vector<std::vector<uint8_t>> parity;
+	RS::ConstFragmentMap data_fragments;
+	RS::FragmentMap parity_fragments;
+};
+
+static void BM_ReedSolomonEncode(benchmark::State &state) {
+	int k = state.range(0), m = state.range(1);
+	ReedSolomonFixture fixture(k, m);
+	for (auto _ : state) {
+		fixture.rs.encode(fixture.data_fragments, fixture.parity_fragments, MFSBLOCKSIZE);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * k * MFSBLOCKSIZE);
+}
+BENCHMARK(BM_ReedSolomonEncode)->Args({3, 2})->Args({6, 3})->Args({16, 4});
+
+// Recovers the first m data parts, which is the worst case for the mount
+static void BM_ReedSolomonRecover(benchmark::State &state) {
+	int k = state.range(0), m = state.range(1);
+	ReedSolomonFixture fixture(k, m);
+	fixture.rs.encode(fixture.data_fragments, fixture.parity_fragments, MFSBLOCKSIZE);
+
+	RS::ConstFragmentMap input{{0}};
+	RS::FragmentMap output{{0}};
+	RS::ErasedMap erased;
+	std::vector<std::vector<uint8_t>> recovered(m, std::vector<uint8_t>(MFSBLOCKSIZE));
+	for (int i = 0; i < m; ++i) {
+		erased.set(i);
+		output[i] = recovered[i].data();
+	}
+	for (int i = m; i < k; ++i) {
+		input[i] = fixture.data[i].data();
+	}
+	for (int i = 0; i < m; ++i) {
+		input[k + i] = fixture.parity[i].data();
+	}
+	for (auto _ : state) {
+		fixture.rs.recover(input, erased, output, MFSBLOCKSIZE);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * k * MFSBLOCKSIZE);
+}
+BENCHMARK(BM_ReedSolomonRecover)->Args({3, 2})->Args({6, 3})->Args({16, 4});
@@ -0,0 +1,44 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "common/crc.h"
+#include "common/random.h"
+
+/*
+ * Results are printed as JSON unless another format is requested, so that they can be
+ * compared between builds. Use --benchmark_format=console to get a table and
+ * --benchmark_filter=REGEX to run only some of the benchmarks.
+ */
+int main(int argc, char **argv) {
+	static char kJsonFormat[] = "--benchmark_format=json";
+	std::vector<char *> args(argv, argv + argc);
+	args.insert(args.begin() + 1, kJsonFormat);
+	int count = args.size();
+	benchmark::Initialize(&count, args.data());
+	if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+		return 1;
+	}
+	rnd_init();
+	mycrc32_init();
+	benchmark::RunSpecifiedBenchmarks();
+	return 0;
+}
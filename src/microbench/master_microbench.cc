@@ -0,0 +1,125 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "common/chunk_copies_calculator.h"
+#include "common/media_label.h"
+#include "common/slice_traits.h"
+#include "master/get_servers_for_new_chunk.h"
+#include "master/goal_config_loader.h"
+#include "master/hstring.h"
+
+namespace {
+
+struct ChunkCase {
+	const char *goal;
+	std::vector<std::pair<ChunkPartType, const char *>> parts;
+};
+
+// Chunks with one part missing or misplaced, so that the calculator has something to do
+const std::vector<ChunkCase> kChunkCases = {
+	{"1 g: A B _", {
+		{slice_traits::standard::ChunkPartType(), "A"},
+		{slice_traits::standard::ChunkPartType(), "C"}}},
+	{"1 g: $xor3 {A B B C}", {
+		{slice_traits::xors::ChunkPartType(3, 0), "A"},
+		{slice_traits::xors::ChunkPartType(3, 1), "B"},
+		{slice_traits::xors::ChunkPartType(3, 3), "C"}}},
+	{"1 g: $ec(6,3) {A A B B C C D D E}", {
+		{slice_traits::ec::ChunkPartType(6, 3, 0), "A"},
+		{slice_traits::ec::ChunkPartType(6, 3, 1), "A"},
+		{slice_traits::ec::ChunkPartType(6, 3, 2), "B"},
+		{slice_traits::ec::ChunkPartType(6, 3, 3), "B"},
+		{slice_traits::ec::ChunkPartType(6, 3, 4), "C"},
+		{slice_traits::ec::ChunkPartType(6, 3, 5), "D"},
+		{slice_traits::ec::ChunkPartType(6, 3, 6), "D"},
+		{slice_traits::ec::ChunkPartType(6, 3, 7), "E"}}},
+};
+
+} // anonymous namespace
+
+// The same work as done by the master for every chunk whose parts change
+static void BM_ChunkCopiesCalculator(benchmark::State &state) {
+	const ChunkCase &chunkCase = kChunkCases[state.range(0)];
+	Goal goal = goal_config::parseLine(chunkCase.goal).second;
+	std::vector<std::pair<ChunkPartType, MediaLabel>> parts;
+	for (const auto &part : chunkCase.parts) {
+		parts.emplace_back(part.first, MediaLabel(part.second));
+	}
+	for (auto _ : state) {
+		ChunkCopiesCalculator calculator(goal);
+		for (const auto &part : parts) {
+			calculator.addPart(part.first, part.second);
+		}
+		calculator.optimize();
+		benchmark::DoNotOptimize(calculator.countPartsToRecover());
+		benchmark::DoNotOptimize(calculator.countPartsToRemove());
+	}
+}
+BENCHMARK(BM_ChunkCopiesCalculator)->DenseRange(0, kChunkCases.size() - 1);
+
+// Argument is the number of chunkservers, each fifth of them has a different label
+static void BM_GetServersForNewChunk(benchmark::State &state) {
+	int serverCount = state.range(0);
+	std::vector<MediaLabel> labels = {MediaLabel("A"), MediaLabel("B"), MediaLabel("C"),
+			MediaLabel("D"), MediaLabel("E")};
+	// Addresses of these bytes are used as matocsserventry pointers, they are never dereferenced
+	std::vector<char> servers(serverCount);
+	Goal::Slice::Labels goalLabels = {{MediaLabel("A"), 1}, {MediaLabel("B"), 1},
+			{MediaLabel::kWildcard, 1}};
+	Goal::Slice::ConstPartProxy proxy(
+			vector_range<const Goal::Slice::DataContainer, Goal::Slice::SizeContainer::value_type>(
+			goalLabels.data(), 0, goalLabels.size()));
+	ChunkCreationHistory history;
+	for (auto _ : state) {
+		GetServersForNewChunk getter;
+		for (int i = 0; i < serverCount; ++i) {
+			getter.addServer(reinterpret_cast<matocsserventry *>(&servers[i]),
+					labels[i * labels.size() / serverCount], 1, 0);
+		}
+		getter.prepareData(history);
+		std::vector<matocsserventry *> used;
+		benchmark::DoNotOptimize(getter.chooseServersForLabels(history, proxy, 0, used));
+	}
+}
+BENCHMARK(BM_GetServersForNewChunk)->Arg(10)->Arg(100)->Arg(1000);
+
+// Argument is the length of a file name
+static void BM_HStringHash(benchmark::State &state) {
+	std::string name(state.range(0), 'x');
+	for (auto _ : state) {
+		HString hashed(name);
+		benchmark::DoNotOptimize(hashed.hash());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * name.size());
+}
+BENCHMARK(BM_HStringHash)->Arg(8)->Arg(32)->Arg(255);
+
+static void BM_HStringCompare(benchmark::State &state) {
+	HString first(std::string(state.range(0), 'x'));
+	HString second(std::string(state.range(0), 'x'));
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(first == second);
+	}
+}
+BENCHMARK(BM_HStringCompare)->Arg(8)->Arg(255);
@@ -0,0 +1,58 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+
+#include <sys/uio.h>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "mount/readdata_cache.h"
+#include "protocol/MFSCommunication.h"
+
+// Argument is the number of cached entries, each of them holding 4 blocks (16 MiB at most)
+static void BM_ReadCacheHit(benchmark::State &state) {
+	const ReadCache::Size kEntrySize = 4 * MFSBLOCKSIZE;
+	int entries = state.range(0);
+	ReadCache cache(1000000);
+	for (int i = 0; i < entries; ++i) {
+		ReadCache::Result result = cache.query(uint64_t(i) * kEntrySize, kEntrySize);
+		result.inputBuffer().resize(kEntrySize);
+	}
+	std::vector<struct iovec> iov;
+	int i = 0;
+	for (auto _ : state) {
+		uint64_t offset = uint64_t(i) * kEntrySize + MFSBLOCKSIZE;
+		ReadCache::Result result = cache.query(offset, 2 * MFSBLOCKSIZE);
+		iov.clear();
+		benchmark::DoNotOptimize(result.toIoVec(iov, offset, 2 * MFSBLOCKSIZE));
+		i = (i + 7) % entries;
+	}
+}
+BENCHMARK(BM_ReadCacheHit)->Arg(1)->Arg(16)->Arg(64);
+
+// A sequential reader, every query misses the cache and replaces the oldest entry
+static void BM_ReadCacheMiss(benchmark::State &state) {
+	ReadCache cache(0);
+	uint64_t offset = 0;
+	for (auto _ : state) {
+		ReadCache::Result result = cache.query(offset, MFSBLOCKSIZE);
+		result.inputBuffer().resize(MFSBLOCKSIZE);
+		offset += MFSBLOCKSIZE;
+	}
+}
+BENCHMARK(BM_ReadCacheMiss);
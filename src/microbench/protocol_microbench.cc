@@ -0,0 +1,83 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/platform.h"
+
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "common/chunk_type_with_address.h"
+#include "common/lizardfs_version.h"
+#include "common/slice_traits.h"
+#include "protocol/cltocs.h"
+#include "protocol/matocl.h"
+#include "protocol/packet.h"
+
+// Reply with locations of a chunk of an ec(N, 2) goal, the biggest one sent when reading
+static std::vector<ChunkTypeWithAddress> chunkLocations(int dataCount) {
+	std::vector<ChunkTypeWithAddress> locations;
+	for (int part = 0; part < dataCount + 2; ++part) {
+		locations.emplace_back(NetworkAddress(0x0A000001 + part, 9422),
+				slice_traits::ec::ChunkPartType(dataCount, 2, part), kFirstECVersion);
+	}
+	return locations;
+}
+
+static void BM_SerializeReadChunkReply(benchmark::State &state) {
+	std::vector<ChunkTypeWithAddress> locations = chunkLocations(state.range(0));
+	std::vector<uint8_t> buffer;
+	for (auto _ : state) {
+		buffer.clear();
+		matocl::fuseReadChunk::serialize(buffer, 1, 1U << 30, 0x1234, 1, locations);
+		benchmark::DoNotOptimize(buffer.data());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * buffer.size());
+}
+BENCHMARK(BM_SerializeReadChunkReply)->Arg(2)->Arg(8)->Arg(30);
+
+static void BM_DeserializeReadChunkReply(benchmark::State &state) {
+	std::vector<uint8_t> packet;
+	matocl::fuseReadChunk::serialize(packet, 1, 1U << 30, 0x1234, 1,
+			chunkLocations(state.range(0)));
+	std::vector<uint8_t> message(packet.begin() + PacketHeader::kSize, packet.end());
+	uint64_t fileLength, chunkId;
+	uint32_t chunkVersion;
+	std::vector<ChunkTypeWithAddress> locations;
+	for (auto _ : state) {
+		locations.clear();
+		matocl::fuseReadChunk::deserialize(message, fileLength, chunkId, chunkVersion, locations);
+		benchmark::DoNotOptimize(locations.data());
+	}
+	state.SetBytesProcessed(int64_t(state.iterations()) * message.size());
+}
+BENCHMARK(BM_DeserializeReadChunkReply)->Arg(2)->Arg(8)->Arg(30);
+
+// Prefix of every block sent by the mount to a chunkserver
+static void BM_WriteDataPrefix(benchmark::State &state) {
+	std::vector<uint8_t> buffer;
+	uint64_t chunkId;
+	uint32_t writeId, offset, size, crc;
+	uint16_t block;
+	for (auto _ : state) {
+		buffer.clear();
+		cltocs::writeData::serializePrefix(buffer, 0x1234, 7, 42, 0, MFSBLOCKSIZE, 0xABCD);
+		cltocs::writeData::deserializePrefix(buffer.data() + PacketHeader::kSize,
+				buffer.size() - PacketHeader::kSize, chunkId, writeId, block, offset, size, crc);
+		benchmark::DoNotOptimize(crc);
+	}
+}
+BENCHMARK(BM_WriteDataPrefix);
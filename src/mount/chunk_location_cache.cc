@@ -0,0 +1,113 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/chunk_location_cache.h"
+
+ChunkLocationCache gChunkLocationCache(0, 0);
+
+ChunkLocationCache::ChunkLocationCache(uint32_t capacity, uint32_t timeout_ms)
+		: capacity_(capacity),
+		  timeout_(std::chrono::milliseconds(timeout_ms)),
+		  epoch_(0) {
+}
+
+void ChunkLocationCache::setLimits(uint32_t capacity, uint32_t timeout_ms) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	capacity_ = capacity;
+	timeout_ = std::chrono::milliseconds(timeout_ms);
+	while (entries_.size() > capacity_) {
+		erase(entries_.find(lru_.back()));
+	}
+}
+
+bool ChunkLocationCache::enabled() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return capacity_ > 0;
+}
+
+uint32_t ChunkLocationCache::size() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+ChunkLocationCache::Location ChunkLocationCache::find(uint32_t inode, uint32_t index) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	auto it = entries_.find(Key(inode, index));
+	if (it == entries_.end()) {
+		return nullptr;
+	}
+	if (SteadyClock::now() >= it->second.expirationTime) {
+		erase(it);
+		return nullptr;
+	}
+	lru_.splice(lru_.begin(), lru_, it->second.lruPosition);
+	return it->second.location;
+}
+
+uint64_t ChunkLocationCache::epoch() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return epoch_;
+}
+
+void ChunkLocationCache::insert(uint32_t inode, uint32_t index, Location location,
+		uint64_t epoch) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (capacity_ == 0 || epoch != epoch_) {
+		return;
+	}
+	Key key(inode, index);
+	auto it = entries_.find(key);
+	if (it != entries_.end()) {
+		const ChunkLocationInfo& cached = *it->second.location;
+		if (cached.chunkId == location->chunkId && cached.version > location->version) {
+			return;
+		}
+		erase(it);
+	} else if (entries_.size() >= capacity_) {
+		erase(entries_.find(lru_.back()));
+	}
+	lru_.push_front(key);
+	Entry& entry = entries_[key];
+	entry.location = std::move(location);
+	entry.expirationTime = SteadyClock::now() + timeout_;
+	entry.lruPosition = lru_.begin();
+}
+
+void ChunkLocationCache::invalidate(uint32_t inode, uint32_t index) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	auto it = entries_.find(Key(inode, index));
+	if (it != entries_.end()) {
+		erase(it);
+	}
+}
+
+void ChunkLocationCache::invalidate(uint32_t inode) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	auto it = entries_.lower_bound(Key(inode, 0));
+	while (it != entries_.end() && it->first.first == inode) {
+		erase(it++);
+	}
+}
+
+void ChunkLocationCache::erase(EntryMap::iterator it) {
+	lru_.erase(it->second.lruPosition);
+	entries_.erase(it);
+}
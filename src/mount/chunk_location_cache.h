@@ -0,0 +1,86 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "common/time_utils.h"
+#include "mount/chunk_locator.h"
+
+/*! \brief Locations of chunks shared by all descriptors of a mount.
+ *
+ * Bounded LRU cache keyed by (inode, chunk index). Entries expire after a timeout, so changes
+ * made by other clients become visible as quickly as when every descriptor asked the master
+ * on its own. Locations received in a reply to a query started before the last invalidation
+ * are not inserted, neither are locations older (by chunk version) than the cached ones.
+ * Thread safe.
+ */
+class ChunkLocationCache {
+public:
+	typedef std::shared_ptr<const ChunkLocationInfo> Location;
+
+	ChunkLocationCache(uint32_t capacity, uint32_t timeout_ms);
+
+	/// Changes limits, capacity 0 disables the cache
+	void setLimits(uint32_t capacity, uint32_t timeout_ms);
+
+	bool enabled() const;
+	uint32_t size() const;
+
+	/// Returns the cached location or nullptr if there is no valid one
+	Location find(uint32_t inode, uint32_t index);
+
+	/// Returns a value which has to be passed to insert() for locations queried after the call
+	uint64_t epoch() const;
+
+	void insert(uint32_t inode, uint32_t index, Location location, uint64_t epoch);
+	void invalidate(uint32_t inode, uint32_t index);
+
+	/// Invalidates all chunks of a file
+	void invalidate(uint32_t inode);
+
+private:
+	typedef std::pair<uint32_t, uint32_t> Key;
+
+	struct Entry {
+		Location location;
+		SteadyTimePoint expirationTime;
+		std::list<Key>::iterator lruPosition;
+	};
+
+	typedef std::map<Key, Entry> EntryMap;
+
+	void erase(EntryMap::iterator it);
+
+	mutable std::mutex mutex_;
+	uint32_t capacity_;
+	SteadyDuration timeout_;
+	uint64_t epoch_;
+	EntryMap entries_;
+	std::list<Key> lru_; // most recently used keys first
+};
+
+extern ChunkLocationCache gChunkLocationCache;
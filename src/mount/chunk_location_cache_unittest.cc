@@ -0,0 +1,96 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/chunk_location_cache.h"
+
+#include <gtest/gtest.h>
+
+static ChunkLocationCache::Location makeLocation(uint64_t chunkId, uint32_t version) {
+	return std::make_shared<ChunkLocationInfo>(chunkId, version, 1000,
+			ChunkLocationInfo::ChunkLocations());
+}
+
+TEST(ChunkLocationCacheTests, FindAndInvalidate) {
+	ChunkLocationCache cache(100, 1000000);
+	EXPECT_EQ(nullptr, cache.find(1, 0));
+	cache.insert(1, 0, makeLocation(10, 1), cache.epoch());
+	cache.insert(1, 1, makeLocation(11, 1), cache.epoch());
+	cache.insert(2, 0, makeLocation(20, 1), cache.epoch());
+	ASSERT_NE(nullptr, cache.find(1, 1));
+	EXPECT_EQ(11U, cache.find(1, 1)->chunkId);
+	EXPECT_EQ(3U, cache.size());
+
+	cache.invalidate(1, 1);
+	EXPECT_EQ(nullptr, cache.find(1, 1));
+	EXPECT_NE(nullptr, cache.find(1, 0));
+
+	cache.invalidate(1);
+	EXPECT_EQ(nullptr, cache.find(1, 0));
+	EXPECT_NE(nullptr, cache.find(2, 0));
+	EXPECT_EQ(1U, cache.size());
+}
+
+TEST(ChunkLocationCacheTests, LeastRecentlyUsedEntriesAreEvicted) {
+	ChunkLocationCache cache(3, 1000000);
+	for (uint32_t index = 0; index < 3; ++index) {
+		cache.insert(1, index, makeLocation(index + 1, 1), cache.epoch());
+	}
+	ASSERT_NE(nullptr, cache.find(1, 0));
+	cache.insert(1, 3, makeLocation(4, 1), cache.epoch());
+	EXPECT_EQ(3U, cache.size());
+	EXPECT_NE(nullptr, cache.find(1, 0));
+	EXPECT_EQ(nullptr, cache.find(1, 1));
+	EXPECT_NE(nullptr, cache.find(1, 3));
+
+	cache.setLimits(1, 1000000);
+	EXPECT_EQ(1U, cache.size());
+	EXPECT_NE(nullptr, cache.find(1, 3));
+
+	cache.setLimits(0, 1000000);
+	EXPECT_FALSE(cache.enabled());
+	cache.insert(1, 5, makeLocation(6, 1), cache.epoch());
+	EXPECT_EQ(0U, cache.size());
+}
+
+TEST(ChunkLocationCacheTests, ExpiredEntriesAreNotReturned) {
+	ChunkLocationCache cache(10, 0);
+	cache.insert(1, 0, makeLocation(10, 1), cache.epoch());
+	EXPECT_EQ(nullptr, cache.find(1, 0));
+	EXPECT_EQ(0U, cache.size());
+}
+
+TEST(ChunkLocationCacheTests, OutdatedLocationsAreNotInserted) {
+	ChunkLocationCache cache(10, 1000000);
+
+	// a query started before an invalidation
+	uint64_t epoch = cache.epoch();
+	cache.invalidate(1);
+	cache.insert(1, 0, makeLocation(10, 1), epoch);
+	EXPECT_EQ(nullptr, cache.find(1, 0));
+
+	// an older version of a cached chunk
+	cache.insert(1, 0, makeLocation(10, 5), cache.epoch());
+	cache.insert(1, 0, makeLocation(10, 4), cache.epoch());
+	ASSERT_NE(nullptr, cache.find(1, 0));
+	EXPECT_EQ(5U, cache.find(1, 0)->version);
+
+	// a different chunk replaces the cached one
+	cache.insert(1, 0, makeLocation(12, 1), cache.epoch());
+	EXPECT_EQ(12U, cache.find(1, 0)->chunkId);
+}
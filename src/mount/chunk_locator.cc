@@ -23,25 +23,62 @@
 
 #include "protocol/MFSCommunication.h"
 #include "common/mfserr.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
+#include "mount/chunk_location_cache.h"
 #include "mount/exceptions.h"
 #include "mount/mastercomm.h"
+#include "mount/readdata.h"
 
-void ReadChunkLocator::invalidateCache(uint32_t inode, uint32_t index) {
-	std::unique_lock<std::mutex> lock(mutex_);
-	if (cache_ && inode == inode_ && index == index_) {
-		cache_ = nullptr;
+std::atomic<uint64_t> ReadChunkLocator::cacheHits(0);
+std::atomic<uint64_t> ReadChunkLocator::cacheMisses(0);
+
+static void throwReadLocatorError(uint8_t status) {
+	if (status == LIZARDFS_ERROR_ENOENT) {
+		throw UnrecoverableReadException("Chunk locator: error sent by master server", status);
+	} else {
+		throw RecoverableReadException("Chunk locator: error sent by master server", status);
 	}
 }
 
+void ReadChunkLocator::invalidateCache(uint32_t inode, uint32_t index) {
+	gChunkLocationCache.invalidate(inode, index);
+}
+
 std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunk(uint32_t inode, uint32_t index) {
-	{
-		std::unique_lock<std::mutex> lock(mutex_);
-		if (cache_ && inode == inode_ && index == index_) {
-			return cache_;
-		}
+	std::shared_ptr<const ChunkLocationInfo> location = gChunkLocationCache.find(inode, index);
+	locatedFromCache_.store((bool)location);
+	if (location) {
+		++cacheHits;
+		return location;
 	}
+	++cacheMisses;
 	LOG_AVG_TILL_END_OF_SCOPE0("ReadChunkLocator::locateChunk");
+	tracing::ScopedSpan span("mount.locate_chunk", inode);
+	uint64_t epoch = gChunkLocationCache.epoch();
+#ifndef USE_LEGACY_READ_MESSAGES
+	uint32_t prefetch = read_data_get_chunk_location_prefetch();
+	if (prefetch > 1 && gChunkLocationCache.enabled()) {
+		std::vector<ChunkLocationsEntry> chunks;
+		uint64_t fileLength;
+		uint8_t status = fs_lizreadchunks(chunks, fileLength, inode, index, prefetch);
+		if (status != LIZARDFS_ERROR_ENOTSUP) {
+			if (status != LIZARDFS_STATUS_OK) {
+				throwReadLocatorError(status);
+			}
+			for (uint32_t i = 0; i < chunks.size(); ++i) {
+				auto info = std::make_shared<const ChunkLocationInfo>(chunks[i].chunkId,
+						chunks[i].chunkVersion, fileLength, std::move(chunks[i].locations));
+				if (i == 0) {
+					location = info;
+				}
+				gChunkLocationCache.insert(inode, index + i, std::move(info), epoch);
+			}
+			return location;
+		}
+		// master doesn't support querying many chunks at once
+	}
+#endif
 	uint64_t chunkId;
 	uint32_t version;
 	uint64_t fileLength;
@@ -56,11 +93,7 @@ std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunk(uint32_t
 #endif
 
 	if (status != 0) {
-		if (status == LIZARDFS_ERROR_ENOENT) {
-			throw UnrecoverableReadException("Chunk locator: error sent by master server", status);
-		} else {
-			throw RecoverableReadException("Chunk locator: error sent by master server", status);
-		}
+		throwReadLocatorError(status);
 	}
 
 #ifdef USE_LEGACY_READ_MESSAGES
@@ -78,17 +111,14 @@ std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunk(uint32_t
 		}
 	}
 #endif
-	{
-		std::unique_lock<std::mutex> lock(mutex_);
-		inode_ = inode;
-		index_ = index;
-		cache_ = std::make_shared<ChunkLocationInfo>(chunkId, version, fileLength, locations);
-		return cache_;
-	}
+	location = std::make_shared<ChunkLocationInfo>(chunkId, version, fileLength, locations);
+	gChunkLocationCache.insert(inode, index, location, epoch);
+	return location;
 }
 
 void WriteChunkLocator::locateAndLockChunk(uint32_t inode, uint32_t index) {
 	LOG_AVG_TILL_END_OF_SCOPE0("WriteChunkLocator::locateAndLockChunk");
+	tracing::ScopedSpan span("mount.locate_write_chunk", inode);
 	sassert(inode_ == 0 || (inode_ == inode && index_ == index));
 	inode_ = inode;
 	index_ = index;
@@ -20,6 +20,7 @@
 
 #include "common/platform.h"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -59,22 +60,32 @@ struct ChunkLocationInfo {
 };
 
 // Intended to be instantiated per descriptor.
-// May cache locations of previously queried chunks.
+// Locations are shared with other descriptors using gChunkLocationCache.
 // Thread safe.
 class ReadChunkLocator {
 public:
 	ReadChunkLocator(const ReadChunkLocator&) = delete;
-	ReadChunkLocator() {}
+	ReadChunkLocator() : locatedFromCache_(false) {}
 
+	/*! \brief Returns location of a chunk.
+	 *
+	 * On a cache miss the master is asked also for read_data_get_chunk_location_prefetch()-1
+	 * following chunks of the file, which are put into the cache.
+	 */
 	std::shared_ptr<const ChunkLocationInfo> locateChunk(uint32_t inode, uint32_t index);
 	void invalidateCache(uint32_t inode, uint32_t index);
 
-private:
-	uint32_t inode_;
-	uint32_t index_;
+	/// True if the last location returned by locateChunk was taken from the cache
+	bool locatedFromCache() const {
+		return locatedFromCache_.load();
+	}
+
+	/// Counters for the .lizardfds_tweaks file.
+	static std::atomic<uint64_t> cacheHits;
+	static std::atomic<uint64_t> cacheMisses;
 
-	std::shared_ptr<const ChunkLocationInfo> cache_;
-	std::mutex mutex_;
+private:
+	std::atomic<bool> locatedFromCache_;
 };
 
 class WriteChunkLocator {
@@ -46,7 +46,9 @@ void ChunkReader::prepareReadingChunk(uint32_t inode, uint32_t index, bool force
 	++preparations;
 	inode_ = inode;
 	index_ = index;
-	locator_.invalidateCache(inode, index);
+	if (force_prepare) {
+		locator_.invalidateCache(inode, index);
+	}
 	location_ = locator_.locateChunk(inode, index);
 	chunkAlreadyRead = false;
 	if (location_->isEmptyChunk()) {
@@ -71,6 +71,11 @@ public:
 		return location_->version;
 	}
 
+	/// True if location of the current chunk was taken from the chunk location cache
+	bool isLocationCached() const {
+		return locator_.locatedFromCache();
+	}
+
 	/// Counter for the .lizardfds_tweaks file.
 	static std::atomic<uint64_t> preparations;
 
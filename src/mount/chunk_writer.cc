@@ -29,6 +29,7 @@
 #include "common/massert.h"
 #include "common/read_operation_executor.h"
 #include "common/slogger.h"
+#include "common/small_vector.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
 #include "devtools/request_log.h"
@@ -370,12 +371,13 @@ void ChunkWriter::computeParityBlock(const ChunkPartType &chunk_type, uint8_t *p
 
 	if (slice_traits::isXor(chunk_type)) {
 		assert(data_blocks[offset]);
-		std::memcpy(parity_block, data_blocks[offset], size);
-		for (int i = 1; i < data_part_count; ++i) {
-			if(data_blocks[offset + i]) {
-				blockXor(parity_block, data_blocks[offset + i], size);
+		small_vector<const uint8_t *, Goal::Slice::kMaxPartsCount> sources;
+		for (int i = 0; i < data_part_count; ++i) {
+			if (data_blocks[offset + i]) {
+				sources.push_back(data_blocks[offset + i]);
 			}
 		}
+		blockXorMany(parity_block, sources.data(), sources.size(), size);
 		return;
 	}
 
@@ -31,6 +31,7 @@
 #include "mount/fuse/mfs_meta_fuse.h"
 #include "mount/fuse/mount_config.h"
 #include "mount/g_io_limiters.h"
+#include "mount/lizard_client.h"
 #include "mount/mastercomm.h"
 #include "mount/masterproxy.h"
 #include "mount/readdata.h"
@@ -267,7 +268,7 @@ int mainloop(struct fuse_args *args,const char* mp,int mt,int fg) {
 		// initialize the global IO limiter before starting mastercomm threads
 		gGlobalIoLimiter();
 	}
-	fs_init_threads(gMountOptions.ioretries);
+	fs_init_threads(gMountOptions.ioretries, gMountOptions.masterconnections);
 	masterproxy_init();
 
 	uint32_t bindIp;
@@ -303,7 +304,13 @@ int mainloop(struct fuse_args *args,const char* mp,int mt,int fg) {
 				gMountOptions.cacheexpirationtime,
 				gMountOptions.readaheadmaxwindowsize,
 				gMountOptions.prefetchxorstripes,
-				gMountOptions.bandwidthoveruse);
+				gMountOptions.bandwidthoveruse,
+				gMountOptions.chunklocationcachesize,
+				gMountOptions.chunklocationprefetch,
+				gMountOptions.tracesampling,
+				gMountOptions.tracefile);
+		LizardClient::metadata_cache_init(gMountOptions.leasecachesize,
+				gMountOptions.leasecacheto);
 		write_data_init(gMountOptions.writecachesize,
 				gMountOptions.ioretries,
 				gMountOptions.writeworkers,
@@ -81,6 +81,13 @@ struct fuse_opt gMfsOptsStage2[] = {
 	MFS_OPT("mfschunkserverwriteto=%d", chunkserverwriteto, 0),
 	MFS_OPT("symlinkcachetimeout=%d", symlinkcachetimeout, 3600),
 	MFS_OPT("bandwidthoveruse=%lf", bandwidthoveruse, 1),
+	MFS_OPT("mfschunklocationcachesize=%u", chunklocationcachesize, 0),
+	MFS_OPT("mfschunklocationprefetch=%u", chunklocationprefetch, 0),
+	MFS_OPT("mfsleasecacheto=%u", leasecacheto, 0),
+	MFS_OPT("mfsleasecachesize=%u", leasecachesize, 0),
+	MFS_OPT("mfsmasterconnections=%u", masterconnections, 0),
+	MFS_OPT("mfstracesampling=%u", tracesampling, 0),
+	MFS_OPT("mfstracefile=%s", tracefile, 0),
 
 #if FUSE_VERSION >= 26
 	MFS_OPT("enablefilelocks=%u", filelocks, 0),
@@ -183,6 +190,13 @@ void usage(const char *progname) {
 "    -o mfsiolimits=FILE         define I/O limits configuration file\n"
 "    -o symlinkcachetimeout=N    define timeout of symlink cache in seconds (default: 3600)\n"
 "    -o bandwidthoveruse=N       define ratio of allowed bandwidth overuse when fetching data (default: 1.25)\n"
+"    -o mfschunklocationcachesize=N define size of chunk location cache in number of entries (0: no cache; default: 10000)\n"
+"    -o mfschunklocationprefetch=N define number of chunks located at once when reading a file (default: 8)\n"
+"    -o mfsleasecacheto=SEC      set timeout of attributes and entries cached with master notifications (0: no cache; default: 0)\n"
+"    -o mfsleasecachesize=N      define size of cache of attributes and entries with master notifications (default: 100000)\n"
+"    -o mfsmasterconnections=N   define number of connections to master used in parallel by different threads (default: 1)\n"
+"    -o mfstracesampling=N       trace one of every N reads and writes (0: no tracing; default: 0)\n"
+"    -o mfstracefile=PATH        define file to which spans of traced requests are appended (default: " DATA_PATH "/mount-traces.log)\n"
 #if FUSE_VERSION >= 26
 "    -o enablefilelocks=0|1      enables/disables global file locking (disabled by default)\n"
 #endif
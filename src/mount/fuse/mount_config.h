@@ -113,6 +113,13 @@ struct mfsopts_ {
 	int prefetchxorstripes;
 	unsigned symlinkcachetimeout;
 	double bandwidthoveruse;
+	unsigned chunklocationcachesize;
+	unsigned chunklocationprefetch;
+	unsigned leasecacheto;
+	unsigned leasecachesize;
+	unsigned masterconnections;
+	unsigned tracesampling;
+	char *tracefile;
 
 	mfsopts_()
 		: masterhost(NULL),
@@ -168,7 +175,14 @@ struct mfsopts_ {
 			readaheadmaxwindowsize(4096),
 			prefetchxorstripes(0),
 			symlinkcachetimeout(3600),
-			bandwidthoveruse(1.25) {
+			bandwidthoveruse(1.25),
+			chunklocationcachesize(10000),
+			chunklocationprefetch(8),
+			leasecacheto(0),
+			leasecachesize(100000),
+			masterconnections(1),
+			tracesampling(0),
+			tracefile(NULL) {
 	}
 };
 
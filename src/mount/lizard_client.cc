@@ -46,6 +46,7 @@
 #include "common/time_utils.h"
 #include "devtools/request_log.h"
 #include "mount/acl_cache.h"
+#include "mount/chunk_location_cache.h"
 #include "mount/chunk_locator.h"
 #include "mount/client_common.h"
 #include "mount/dirattrcache.h"
@@ -54,6 +55,7 @@
 #include "mount/io_limit_group.h"
 #include "mount/mastercomm.h"
 #include "mount/masterproxy.h"
+#include "mount/metadata_cache.h"
 #include "mount/oplog.h"
 #include "mount/readdata.h"
 #include "mount/special_inode.h"
@@ -61,6 +63,7 @@
 #include "mount/symlinkcache.h"
 #include "mount/tweaks.h"
 #include "mount/writedata.h"
+#include "protocol/matocl.h"
 #include "protocol/MFSCommunication.h"
 
 #include "mount/stat_defs.h" // !!! This must be last include. Do not move !!!
@@ -548,6 +551,89 @@ void access(Context ctx, Inode ino, int mask) {
 	}
 }
 
+/// Receives inodes which changed since master returned them with a lease
+class CacheInvalidationHandler : public PacketHandler {
+public:
+	bool handle(MessageBuffer buffer) override {
+		try {
+			std::vector<uint32_t> inodes;
+			matocl::fuseInvalidateCache::deserialize(buffer.data(), buffer.size(), inodes);
+			for (uint32_t inode : inodes) {
+				gMetadataCache.invalidate(inode);
+			}
+			return true;
+		} catch (IncorrectDeserializationException& ex) {
+			lzfs_pretty_syslog(LOG_ERR, "Malformed MATOCL_FUSE_INVALIDATE_CACHE: %s", ex.what());
+			return false;
+		}
+	}
+};
+
+static CacheInvalidationHandler gCacheInvalidationHandler;
+static std::mutex gCacheLeaseMutex;
+static uint32_t gCacheLeaseTime = 0;            // requested lease time, 0 - cache is not used
+static uint32_t gCacheCapacity = 0;
+static bool gCacheLeaseRequested = false;       // lease was requested on gCacheLeaseConnection
+static uint32_t gCacheLeaseConnection = 0;
+static uint32_t gCacheLeaseGranted = 0;
+
+/*! \brief Makes sure that master notifies this mount about changes of cached inodes.
+ *
+ * Has to be called before epoch of the cache is taken. Notifications sent through a lost
+ * connection never arrive, so after a reconnection the cache is cleared and master is asked
+ * again.
+ * \return true if the cache may be used
+ */
+static bool metadata_cache_lease() {
+	if (gCacheLeaseTime == 0) {
+		return false;
+	}
+	uint32_t connection = fs_get_connection_id();
+	std::unique_lock<std::mutex> lock(gCacheLeaseMutex);
+	if (gCacheLeaseRequested && gCacheLeaseConnection == connection) {
+		return gCacheLeaseGranted > 0;
+	}
+	gMetadataCache.setLimits(0, 0);
+	uint32_t granted = 0;
+	uint8_t status = fs_cache_lease(gCacheLeaseTime, granted);
+	if (status != LIZARDFS_STATUS_OK && status != LIZARDFS_ERROR_ENOTSUP) {
+		return false;
+	}
+	if (fs_get_connection_id() != connection) {
+		return false;
+	}
+	gCacheLeaseRequested = true;
+	gCacheLeaseConnection = connection;
+	gCacheLeaseGranted = granted;
+	if (granted > 0) {
+		gMetadataCache.setLimits(gCacheCapacity, 1000 * granted);
+	}
+	return granted > 0;
+}
+
+static bool metadata_cache_attributes_allowed(const uint8_t attr[35]) {
+	return (attr_get_mattr(attr) & (MATTR_NOACACHE | MATTR_NOECACHE)) == 0;
+}
+
+static bool metadata_cache_name_allowed(const char *name, uint32_t nleng) {
+	return nleng > 0 && !(name[0] == '.' && (nleng == 1 || (nleng == 2 && name[1] == '.')));
+}
+
+static void metadata_cache_invalidate(Inode inode) {
+	if (gCacheLeaseTime > 0) {
+		gMetadataCache.invalidate(inode);
+	}
+}
+
+void metadata_cache_init(uint32_t capacity, uint32_t leaseTime) {
+	gCacheCapacity = capacity;
+	gCacheLeaseTime = (capacity > 0) ? leaseTime : 0;
+	if (gCacheLeaseTime > 0) {
+		sassert(fs_register_packet_type_handler(LIZ_MATOCL_FUSE_INVALIDATE_CACHE,
+				&gCacheInvalidationHandler));
+	}
+}
+
 EntryParam lookup(Context ctx, Inode parent, const char *name) {
 	EntryParam e;
 	uint64_t maxfleng;
@@ -601,10 +687,22 @@ EntryParam lookup(Context ctx, Inode parent, const char *name) {
 		status = 0;
 		icacheflag = 1;
 //              oplog_printf(ctx, "lookup (%lu,%s) (using open dir cache): OK (%lu)",(unsigned long int)parent,name,(unsigned long int)inode);
+	} else if (metadata_cache_name_allowed(name, nleng) && metadata_cache_lease()
+			&& gMetadataCache.findEntry(parent, std::string(name, nleng), ctx.uid, ctx.gid,
+					inode, attr)) {
+		stats_inc(OP_DIRCACHE_LOOKUP);
+		status = 0;
+		icacheflag = 1;
 	} else {
+		uint64_t epoch = gMetadataCache.epoch();
 		stats_inc(OP_LOOKUP);
 		status = fs_lookup(parent,nleng,(const uint8_t*)name,ctx.uid,ctx.gid,&inode,attr);
 		status = errorconv_dbg(status);
+		if (status == 0 && metadata_cache_name_allowed(name, nleng)
+				&& metadata_cache_attributes_allowed(attr)) {
+			gMetadataCache.insertEntry(parent, std::string(name, nleng), ctx.uid, ctx.gid,
+					inode, attr, epoch);
+		}
 		icacheflag = 0;
 	}
 	if (status!=0) {
@@ -665,10 +763,17 @@ AttrReply getattr(Context ctx, Inode ino, FileInfo *fi) {
 		}
 		stats_inc(OP_DIRCACHE_GETATTR);
 		status = 0;
+	} else if (metadata_cache_lease() && gMetadataCache.findAttr(ino, ctx.uid, ctx.gid, attr)) {
+		stats_inc(OP_DIRCACHE_GETATTR);
+		status = 0;
 	} else {
+		uint64_t epoch = gMetadataCache.epoch();
 		stats_inc(OP_GETATTR);
 		status = fs_getattr(ino,ctx.uid,ctx.gid,attr);
 		status = errorconv_dbg(status);
+		if (status == 0 && metadata_cache_attributes_allowed(attr)) {
+			gMetadataCache.insertAttr(ino, ctx.uid, ctx.gid, attr, epoch);
+		}
 	}
 	if (status!=0) {
 		oplog_printf(ctx, "getattr (%lu): %s",
@@ -741,6 +846,7 @@ AttrReply setattr(Context ctx, Inode ino, struct stat *stbuf,
 			| LIZARDFS_SET_ATTR_SIZE)) == 0) { // change other flags or change nothing
 		status = fs_setattr(ino,ctx.uid,ctx.gid,0,0,0,0,0,0,0,attr);    // ext3 compatibility - change ctime during this operation (usually chown(-1,-1))
 		status = errorconv_dbg(status);
+		metadata_cache_invalidate(ino);
 		if (status!=0) {
 			oplog_printf(ctx, "setattr (%lu,0x%X,[%s:0%04o,%ld,%ld,%lu,%lu,%" PRIu64 "]): %s",
 					(unsigned long int)ino,
@@ -790,6 +896,7 @@ AttrReply setattr(Context ctx, Inode ino, struct stat *stbuf,
 			write_data_flush_inode(ino);
 		}
 		status = fs_setattr(ino,ctx.uid,ctx.gid,setmask,stbuf->st_mode&07777,stbuf->st_uid,stbuf->st_gid,stbuf->st_atime,stbuf->st_mtime,sugid_clear_mode,attr);
+		metadata_cache_invalidate(ino);
 		if (to_set & (LIZARDFS_SET_ATTR_MODE | LIZARDFS_SET_ATTR_UID | LIZARDFS_SET_ATTR_GID)) {
 			eraseAclCache(ino);
 		}
@@ -841,6 +948,7 @@ AttrReply setattr(Context ctx, Inode ino, struct stat *stbuf,
 		try {
 			bool opened = (fi != NULL);
 			status = write_data_truncate(ino, opened, ctx.uid, ctx.gid, stbuf->st_size, attr);
+			metadata_cache_invalidate(ino);
 			maxfleng = 0; // after the flush master server has valid length, don't use our length cache
 		} catch (Exception& ex) {
 			status = errorconv_dbg(ex.status());
@@ -971,6 +1079,7 @@ EntryParam mknod(Context ctx, Inode parent, const char *name, mode_t mode, dev_t
 
 	status = fs_mknod(parent,nleng,(const uint8_t*)name,type,mode&07777,ctx.umask,ctx.uid,ctx.gid,rdev,inode,attr);
 	status = errorconv_dbg(status);
+	metadata_cache_invalidate(parent);
 	if (status!=0) {
 		oplog_printf(ctx, "mknod (%lu,%s,%s:0%04o,0x%08lX): %s",
 				(unsigned long int)parent,
@@ -1033,6 +1142,7 @@ void unlink(Context ctx, Inode parent, const char *name) {
 
 	status = fs_unlink(parent,nleng,(const uint8_t*)name,ctx.uid,ctx.gid);
 	dcache_invalidate(parent);
+	metadata_cache_invalidate(parent);
 	status = errorconv_dbg(status);
 	if (status!=0) {
 		oplog_printf(ctx, "unlink (%lu,%s): %s",
@@ -1096,6 +1206,7 @@ EntryParam mkdir(Context ctx, Inode parent, const char *name, mode_t mode) {
 
 	status = fs_mkdir(parent,nleng,(const uint8_t*)name,mode,ctx.umask,ctx.uid,ctx.gid,mkdir_copy_sgid,inode,attr);
 	status = errorconv_dbg(status);
+	metadata_cache_invalidate(parent);
 	if (status!=0) {
 		oplog_printf(ctx, "mkdir (%lu,%s,d%s:0%04o): %s",
 				(unsigned long int)parent,
@@ -1155,6 +1266,7 @@ void rmdir(Context ctx, Inode parent, const char *name) {
 
 	status = fs_rmdir(parent,nleng,(const uint8_t*)name,ctx.uid,ctx.gid);
 	dcache_invalidate(parent);
+	metadata_cache_invalidate(parent);
 	status = errorconv_dbg(status);
 	if (status!=0) {
 		oplog_printf(ctx, "rmdir (%lu,%s): %s",
@@ -1210,6 +1322,7 @@ EntryParam symlink(Context ctx, const char *path, Inode parent,
 
 	status = fs_symlink(parent,nleng,(const uint8_t*)name,(const uint8_t*)path,ctx.uid,ctx.gid,&inode,attr);
 	status = errorconv_dbg(status);
+	metadata_cache_invalidate(parent);
 	if (status!=0) {
 		oplog_printf(ctx, "symlink (%s,%lu,%s): %s",
 				path,
@@ -1337,6 +1450,11 @@ void rename(Context ctx, Inode parent, const char *name,
 	status = errorconv_dbg(status);
 	dcache_invalidate(parent);
 	dcache_invalidate(newparent);
+	metadata_cache_invalidate(parent);
+	metadata_cache_invalidate(newparent);
+	if (status == 0) {
+		metadata_cache_invalidate(inode);
+	}
 	if (status!=0) {
 		oplog_printf(ctx, "rename (%lu,%s,%lu,%s): %s",
 				(unsigned long int)parent,
@@ -1406,6 +1524,8 @@ EntryParam link(Context ctx, Inode ino, Inode newparent, const char *newname) {
 
 	status = fs_link(ino,newparent,newnleng,(const uint8_t*)newname,ctx.uid,ctx.gid,&inode,attr);
 	status = errorconv_dbg(status);
+	metadata_cache_invalidate(ino);
+	metadata_cache_invalidate(newparent);
 	if (status!=0) {
 		oplog_printf(ctx, "link (%lu,%lu,%s): %s",
 				(unsigned long int)ino,
@@ -1681,6 +1801,84 @@ void remove_dir_info(FileInfo *fi) {
 
 
 
+/*! \brief Creates and opens a file, in a single round trip if master supports it.
+ *
+ * \param step - set to the name of the operation which failed
+ */
+static uint8_t create_and_open(const Context &ctx, Inode parent, const char *name,
+		uint32_t nleng, mode_t mode, uint8_t oflags, uint32_t &inode, Attributes &attr,
+		const char *&step) {
+	std::vector<CompoundOperation> operations{
+		CompoundOperation::mknod(parent, std::string(name, nleng), TYPE_FILE, mode & 07777,
+				ctx.umask, 0),
+		CompoundOperation::open(0, oflags).withInodeOf(1)
+	};
+	std::vector<CompoundResult> results;
+	step = "mknod";
+	uint8_t status = fs_compound(ctx.uid, ctx.gid, operations, results);
+	if (status == LIZARDFS_STATUS_OK) {
+		if (results.size() > 1) {
+			step = "open";
+		}
+		inode = results.front().inode;
+		memcpy(attr, results.back().attributes.data(), sizeof(Attributes));
+		return results.back().status;
+	} else if (status != LIZARDFS_ERROR_ENOTSUP) {
+		return status;
+	}
+	status = fs_mknod(parent, nleng, (const uint8_t*)name, TYPE_FILE, mode & 07777, ctx.umask,
+			ctx.uid, ctx.gid, 0, inode, attr);
+	if (status != LIZARDFS_STATUS_OK) {
+		return status;
+	}
+	step = "open";
+	return fs_opencheck(inode, ctx.uid, ctx.gid, oflags, NULL);
+}
+
+/*! \brief Opens a file and prefetches locations of its first chunks if they will be read.
+ *
+ * Locations are asked for in the same round trip, so reading a small file right after
+ * opening it doesn't need another request to the master.
+ */
+static uint8_t open_and_locate_chunks(const Context &ctx, Inode ino, uint8_t oflags,
+		Attributes &attr) {
+#ifndef USE_LEGACY_READ_MESSAGES
+	uint32_t prefetch = read_data_get_chunk_location_prefetch();
+	if ((oflags & WANT_READ) && prefetch > 1 && gChunkLocationCache.enabled()) {
+		std::vector<CompoundOperation> operations{
+			CompoundOperation::open(ino, oflags),
+			CompoundOperation::readChunks(0, 0, prefetch).withInodeOf(1)
+		};
+		std::vector<CompoundResult> results;
+		uint64_t epoch = gChunkLocationCache.epoch();
+		uint8_t status = fs_compound(ctx.uid, ctx.gid, operations, results);
+		if (status == LIZARDFS_STATUS_OK) {
+			// failure of locating chunks is not a failure of open
+			const CompoundResult &opened = results.front();
+			if (opened.status != LIZARDFS_STATUS_OK) {
+				return opened.status;
+			}
+			memcpy(attr, opened.attributes.data(), sizeof(Attributes));
+			if (results.size() > 1 && results[1].status == LIZARDFS_STATUS_OK) {
+				CompoundResult &located = results[1];
+				for (uint32_t i = 0; i < located.chunks.size(); ++i) {
+					ChunkLocationsEntry &chunk = located.chunks[i];
+					gChunkLocationCache.insert(ino, i,
+							std::make_shared<const ChunkLocationInfo>(chunk.chunkId,
+								chunk.chunkVersion, located.fileLength,
+								std::move(chunk.locations)),
+							epoch);
+				}
+			}
+			return LIZARDFS_STATUS_OK;
+		} else if (status != LIZARDFS_ERROR_ENOTSUP) {
+			return status;
+		}
+	}
+#endif
+	return fs_opencheck(ino, ctx.uid, ctx.gid, oflags, attr);
+}
+
 EntryParam create(Context ctx, Inode parent, const char *name, mode_t mode,
 		FileInfo* fi) {
 	struct EntryParam e;
@@ -1692,6 +1890,7 @@ EntryParam create(Context ctx, Inode parent, const char *name, mode_t mode,
 	uint8_t mattr;
 	uint32_t nleng;
 	int status;
+	const char *step;
 
 	finfo *fileinfo;
 
@@ -1747,25 +1946,16 @@ EntryParam create(Context ctx, Inode parent, const char *name, mode_t mode,
 		throw RequestException(EINVAL);
 	}
 
-	status = fs_mknod(parent,nleng,(const uint8_t*)name,TYPE_FILE,mode&07777,ctx.umask,ctx.uid,ctx.gid,0,inode,attr);
-	status = errorconv_dbg(status);
-	if (status!=0) {
-		oplog_printf(ctx, "create (%lu,%s,-%s:0%04o) (mknod): %s",
-				(unsigned long int)parent,
-				name,
-				modestr+1,
-				(unsigned int)mode,
-				strerr(status));
-		throw RequestException(status);
-	}
-	status = fs_opencheck(inode,ctx.uid,ctx.gid,oflags,NULL);
+	status = create_and_open(ctx,parent,name,nleng,mode,oflags,inode,attr,step);
 	status = errorconv_dbg(status);
+	metadata_cache_invalidate(parent);
 	if (status!=0) {
-		oplog_printf(ctx, "create (%lu,%s,-%s:0%04o) (open): %s",
+		oplog_printf(ctx, "create (%lu,%s,-%s:0%04o) (%s): %s",
 				(unsigned long int)parent,
 				name,
 				modestr+1,
 				(unsigned int)mode,
+				step,
 				strerr(status));
 		throw RequestException(status);
 	}
@@ -1831,7 +2021,7 @@ void open(Context ctx, Inode ino, FileInfo *fi) {
 	} else if ((fi->flags & O_ACCMODE) == O_RDWR) {
 		oflags |= WANT_READ | WANT_WRITE;
 	}
-	status = fs_opencheck(ino,ctx.uid,ctx.gid,oflags,attr);
+	status = open_and_locate_chunks(ctx,ino,oflags,attr);
 	status = errorconv_dbg(status);
 	if (status!=0) {
 		oplog_printf(ctx, "open (%lu): %s",
@@ -1886,6 +2076,7 @@ void release(Context ctx, Inode ino, FileInfo *fi) {
 		remove_file_info(fi);
 	}
 	fs_release(ino);
+	metadata_cache_invalidate(ino);
 	oplog_printf(ctx, "release (%lu): OK",
 			(unsigned long int)ino);
 }
@@ -2157,6 +2348,7 @@ void flush(Context ctx, Inode ino, FileInfo* fi) {
 	PthreadMutexWrapper lock(fileinfo->lock);
 	if (fileinfo->mode==IO_WRITE || fileinfo->mode==IO_WRITEONLY) {
 		err = write_data_flush(fileinfo->data);
+		metadata_cache_invalidate(ino);
 	}
 	lzfs_locks::FlockWrapper file_lock(lzfs_locks::kRelease,0,0,0);
 	auto use_posixlocks = fileinfo->use_posixlocks;
@@ -2203,6 +2395,7 @@ void fsync(Context ctx, Inode ino, int datasync, FileInfo* fi) {
 	PthreadMutexWrapper lock(fileinfo->lock);
 	if (fileinfo->mode==IO_WRITE || fileinfo->mode==IO_WRITEONLY) {
 		err = write_data_flush(fileinfo->data);
+		metadata_cache_invalidate(ino);
 	}
 	if (err!=0) {
 		oplog_printf(ctx, "fsync (%lu,%d): %s",
@@ -2484,6 +2677,7 @@ void setxattr(Context ctx, Inode ino, const char *name, const char *value,
 #endif
 	(void)position;
 	status = choose_xattr_handler(name)->setxattr(ctx, ino, name, nleng, value, size, mode);
+	metadata_cache_invalidate(ino);
 	status = errorconv_dbg(status);
 	if (status!=0) {
 		oplog_printf(ctx, "setxattr (%lu,%s,%" PRIu64 ",%d): %s",
@@ -2704,6 +2898,7 @@ void removexattr(Context ctx, Inode ino, const char *name) {
 		throw RequestException(EINVAL);
 	}
 	status = choose_xattr_handler(name)->removexattr(ctx, ino, name, nleng);
+	metadata_cache_invalidate(ino);
 	status = errorconv_dbg(status);
 	if (status!=0) {
 		oplog_printf(ctx, "removexattr (%lu,%s): %s",
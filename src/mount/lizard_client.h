@@ -201,6 +201,12 @@ void init(int debug_mode_, int keep_cache_, double direntry_cache_timeout_,
 		SugidClearMode sugid_clear_mode_, bool acl_enabled_, bool use_rw_lock_,
 		double acl_cache_timeout_, unsigned acl_cache_size_);
 
+/*! \brief Enables cache of attributes and directory entries invalidated by master.
+ * \param capacity Maximum number of cached attributes and entries.
+ * \param leaseTime Time (in seconds) for which entries are kept, 0 disables the cache.
+ */
+void metadata_cache_init(uint32_t capacity, uint32_t leaseTime);
+
 void remove_file_info(FileInfo *f);
 void remove_dir_info(FileInfo *f);
 
@@ -0,0 +1,106 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/// Index of the master connection used by the thread with a given packet id
+inline uint32_t masterConnectionIndex(uint32_t packetId, std::size_t connectionCount) {
+	return packetId % std::max<std::size_t>(connectionCount, 1);
+}
+
+/*! \brief Records of threads which send requests to the master, indexed by packet id.
+ *
+ * Master may answer through any connection of the session (e.g. when a lock is granted),
+ * so replies are routed by packet id only and records are looked up without any lock.
+ * Records are not removed until clear(), which must not run concurrently with other calls.
+ * Memory is not freed by the destructor, because receiving threads may still use the table
+ * while the process exits.
+ */
+template <class Record>
+class PacketIdTable {
+public:
+	static constexpr uint32_t kBlockSize = 1024;
+	static constexpr uint32_t kMaxBlocks = 1024;
+
+	PacketIdTable() : blocks_(), lastPacketId_(0) {}
+
+	/*! \brief Stores the record under the next packet id.
+	 * \return packet id of the record (ids start from 1) or 0 if the table is full.
+	 */
+	uint32_t add(Record *record) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		uint32_t packetId = lastPacketId_ + 1;
+		uint32_t block = packetId / kBlockSize;
+		if (block >= kMaxBlocks) {
+			return 0;
+		}
+		if (blocks_[block] == nullptr) {
+			blocks_[block] = new std::atomic<Record*>[kBlockSize]();
+		}
+		blocks_[block][packetId % kBlockSize] = record;
+		lastPacketId_ = packetId;
+		return packetId;
+	}
+
+	/// Returns the record with a given packet id or nullptr if there is none.
+	Record *get(uint32_t packetId) const {
+		uint32_t block = packetId / kBlockSize;
+		if (packetId == 0 || packetId > lastPacketId_ || block >= kMaxBlocks) {
+			return nullptr;
+		}
+		std::atomic<Record*> *records = blocks_[block];
+		if (records == nullptr) {
+			return nullptr;
+		}
+		return records[packetId % kBlockSize];
+	}
+
+	template <class Function>
+	void forEach(Function function) const {
+		uint32_t last = lastPacketId_;
+		for (uint32_t packetId = 1; packetId <= last; ++packetId) {
+			Record *record = get(packetId);
+			if (record) {
+				function(record);
+			}
+		}
+	}
+
+	/// Removes all records, passing each of them to \param dispose.
+	template <class Function>
+	void clear(Function dispose) {
+		forEach(dispose);
+		for (uint32_t i = 0; i < kMaxBlocks; ++i) {
+			delete[] blocks_[i].exchange(nullptr);
+		}
+		lastPacketId_ = 0;
+	}
+
+private:
+	std::atomic<std::atomic<Record*>*> blocks_[kMaxBlocks];
+	std::atomic<uint32_t> lastPacketId_;
+	std::mutex mutex_;
+};
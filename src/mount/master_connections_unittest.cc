@@ -0,0 +1,120 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/master_connections.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace {
+
+struct Record {
+	uint32_t packetId;
+	uint32_t connection;
+};
+
+} // anonymous namespace
+
+TEST(MasterConnectionsTests, ConnectionIndex) {
+	// Without additional connections everything goes through the first one
+	EXPECT_EQ(0U, masterConnectionIndex(1, 0));
+	EXPECT_EQ(0U, masterConnectionIndex(7, 1));
+
+	// Consecutive threads are spread evenly over connections
+	std::vector<int> threads(3);
+	for (uint32_t packetId = 1; packetId <= 30; ++packetId) {
+		uint32_t index = masterConnectionIndex(packetId, threads.size());
+		ASSERT_LT(index, threads.size());
+		threads[index]++;
+	}
+	EXPECT_EQ(std::vector<int>({10, 10, 10}), threads);
+}
+
+TEST(MasterConnectionsTests, RecordsAreFoundByPacketId) {
+	PacketIdTable<Record> table;
+	EXPECT_EQ(nullptr, table.get(0));
+	EXPECT_EQ(nullptr, table.get(1));
+
+	// More records than fit in one block
+	std::vector<std::unique_ptr<Record>> records;
+	for (uint32_t i = 0; i < 2 * PacketIdTable<Record>::kBlockSize + 10; ++i) {
+		records.emplace_back(new Record);
+		records.back()->packetId = table.add(records.back().get());
+		ASSERT_EQ(i + 1, records.back()->packetId);
+	}
+	for (const auto &record : records) {
+		EXPECT_EQ(record.get(), table.get(record->packetId));
+	}
+	EXPECT_EQ(nullptr, table.get(records.size() + 1));
+
+	std::size_t count = 0;
+	table.clear([&count](Record *) { ++count; });
+	EXPECT_EQ(records.size(), count);
+	EXPECT_EQ(nullptr, table.get(1));
+	EXPECT_EQ(1U, table.add(records.front().get()));
+	table.clear([](Record *) {});
+}
+
+TEST(MasterConnectionsTests, RepliesFromAnyConnectionReachTheirThreads) {
+	const uint32_t kConnections = 4;
+	const uint32_t kThreads = 8;
+	const uint32_t kRecordsPerThread = 300;
+	PacketIdTable<Record> table;
+	std::vector<std::vector<std::unique_ptr<Record>>> records(kThreads);
+
+	// Threads register while replies for already registered ones are routed
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < kThreads; ++t) {
+		threads.emplace_back([&table, &records, t, kConnections]() {
+			for (uint32_t i = 0; i < kRecordsPerThread; ++i) {
+				records[t].emplace_back(new Record);
+				Record *record = records[t].back().get();
+				record->packetId = table.add(record);
+				record->connection = masterConnectionIndex(record->packetId, kConnections);
+			}
+		});
+	}
+	std::thread router([&table]() {
+		for (uint32_t packetId = 1; packetId <= kThreads * kRecordsPerThread; ++packetId) {
+			while (table.get(packetId) == nullptr) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	router.join();
+
+	// A reply received through a connection other than the one used by the thread
+	// is routed by packet id, so it reaches the right thread anyway
+	std::vector<uint32_t> perConnection(kConnections);
+	for (const auto &threadRecords : records) {
+		for (const auto &record : threadRecords) {
+			EXPECT_EQ(record.get(), table.get(record->packetId));
+			perConnection[record->connection]++;
+		}
+	}
+	for (uint32_t count : perConnection) {
+		EXPECT_EQ(kThreads * kRecordsPerThread / kConnections, count);
+	}
+	table.clear([](Record *) {});
+}
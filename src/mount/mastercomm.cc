@@ -27,8 +27,10 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -48,7 +50,9 @@
 #include "common/mfserr.h"
 #include "common/sockets.h"
 #include "common/slogger.h"
+#include "common/tracing.h"
 #include "mount/exports.h"
+#include "mount/master_connections.h"
 #include "mount/stats.h"
 #include "protocol/cltoma.h"
 #include "protocol/matocl.h"
@@ -69,7 +73,22 @@ struct threc {
 	uint32_t receivedType;
 
 	uint32_t packetId;      // thread number
-	threc *next;
+	std::atomic<uint32_t> connection; // index of the connection used by the thread
+};
+
+/*! \brief One of the connections to the master, all of them use the same session.
+ *
+ * Each connection has its own receiving thread and each thread sends its requests through one
+ * connection, so requests of different threads don't wait for each other. The first connection
+ * creates the session and reports files kept open by the client.
+ */
+struct MasterConnection {
+	uint32_t index;
+	int fd;
+	bool disconnect;
+	time_t lastwrite;
+	pthread_t receiveThread;
+	std::mutex mutex;       // guards the fields above and writing to fd
 };
 
 typedef struct _acquired_file {
@@ -84,21 +103,19 @@ typedef struct _acquired_file {
 
 #define RECEIVE_TIMEOUT 10
 
-static threc *threchead=NULL;
+static PacketIdTable<threc> gThrecs;
 
 static acquired_file *afhead=NULL;
 
-static int fd;
-static bool disconnect;
-static time_t lastwrite;
-static int sessionlost;
+static std::vector<std::unique_ptr<MasterConnection>> gConnections;
+static std::atomic<int> sessionlost;
 
 static uint32_t maxretries;
 
-static pthread_t rpthid,npthid;
-static std::mutex fdMutex, recMutex, acquiredFileMutex;
+static pthread_t npthid;
+static std::mutex acquiredFileMutex;
 
-static uint32_t sessionid;
+static std::atomic<uint32_t> sessionid;
 static uint32_t masterversion;
 
 static char masterstrip[17];
@@ -109,8 +126,10 @@ static uint32_t srcip=0;
 static unsigned gIoRetries;
 static unsigned gReservedInodesPeriod;
 
-static uint8_t fterm;
+static std::atomic<uint8_t> fterm;
 static std::atomic<bool> gIsKilled(false);
+// changed whenever connection with master is lost, so that state kept by master may be renewed
+static std::atomic<uint32_t> gConnectionId(0);
 
 typedef std::unordered_map<PacketHeader::Type, PacketHandler*> PerTypePacketHandlers;
 static PerTypePacketHandlers perTypePacketHandlers;
@@ -123,6 +142,10 @@ void fs_getmasterlocation(uint8_t loc[14]) {
 	put32bit(&loc,masterversion);
 }
 
+uint32_t fs_get_connection_id() {
+	return gConnectionId;
+}
+
 uint32_t fs_getsrcip() {
 	return srcip;
 }
@@ -186,9 +209,16 @@ static inline const char* mfs_strerror(uint8_t status) {
 	return errtab[status];
 }
 
+static inline void setDisconnect(MasterConnection &connection, bool value) {
+	std::unique_lock<std::mutex> lock(connection.mutex);
+	connection.disconnect = value;
+}
+
+threc* fs_get_my_threc();
+
+// Marks the connection used by the calling thread
 static inline void setDisconnect(bool value) {
-	std::unique_lock<std::mutex> fdLock(fdMutex);
-	disconnect = value;
+	setDisconnect(*gConnections[fs_get_my_threc()->connection], value);
 }
 
 void fs_inc_acnt(uint32_t inode) {
@@ -231,40 +261,29 @@ void fs_dec_acnt(uint32_t inode) {
 }
 
 threc* fs_get_my_threc() {
-	pthread_t mythid = pthread_self();
-	threc *rec;
-	std::unique_lock<std::mutex> recLock(recMutex);
-	for (rec = threchead ; rec ; rec = rec->next) {
-		if (pthread_equal(rec->thid, mythid)) {
-			return rec;
-		}
+	static thread_local threc *myrec = NULL;
+	if (myrec) {
+		return myrec;
 	}
-	rec = new threc;
-	rec->thid = mythid;
+	threc *rec = new threc;
+	rec->thid = pthread_self();
 	rec->sent = false;
 	rec->status = 0;
 	rec->received = false;
 	rec->waiting = 0;
 	rec->receivedType = 0;
-	if (threchead==NULL) {
-		rec->packetId = 1;
-	} else {
-		rec->packetId = threchead->packetId + 1;
+	// replies can't come before the thread sends anything, so the record is complete by then
+	rec->packetId = gThrecs.add(rec);
+	if (rec->packetId == 0) {
+		mabort("too many threads communicating with master");
 	}
-	rec->next = threchead;
-	threchead = rec;
+	rec->connection = masterConnectionIndex(rec->packetId, gConnections.size());
+	myrec = rec;
 	return rec;
 }
 
 threc* fs_get_threc_by_id(uint32_t packetId) {
-	threc *rec;
-	std::unique_lock<std::mutex> recLock(recMutex);
-	for (rec = threchead ; rec ; rec=rec->next) {
-		if (rec->packetId==packetId) {
-			return rec;
-		}
-	}
-	return NULL;
+	return gThrecs.get(packetId);
 }
 
 uint8_t* fs_createpacket(threc *rec,uint32_t cmd,uint32_t size) {
@@ -288,18 +307,19 @@ bool fs_lizcreatepacket(threc *rec, MessageBuffer message) {
 LIZARDFS_CREATE_EXCEPTION_CLASS_MSG(LostSessionException, Exception, "session lost");
 
 static bool fs_threc_flush(threc *rec) {
-	std::unique_lock<std::mutex> fdLock(fdMutex);
+	MasterConnection &connection = *gConnections[rec->connection];
+	std::unique_lock<std::mutex> connectionLock(connection.mutex);
 	if (sessionlost) {
 		throw LostSessionException();
 	}
-	if (fd==-1) {
+	if (connection.fd==-1) {
 		return false;
 	}
 	std::unique_lock<std::mutex> lock(rec->mutex);
 	const int32_t size = rec->outputBuffer.size();
-	if (tcptowrite(fd, rec->outputBuffer.data(), size, 1000) != size) {
+	if (tcptowrite(connection.fd, rec->outputBuffer.data(), size, 1000) != size) {
 		lzfs_pretty_syslog(LOG_WARNING, "tcp send error: %s", strerr(tcpgetlasterror()));
-		disconnect = true;
+		connection.disconnect = true;
 		return false;
 	}
 	rec->received = false;
@@ -307,7 +327,7 @@ static bool fs_threc_flush(threc *rec) {
 	lock.unlock();
 	master_stats_add(MASTER_BYTESSENT, size);
 	master_stats_inc(MASTER_PACKETSSENT);
-	lastwrite = time(NULL);
+	connection.lastwrite = time(NULL);
 	return true;
 }
 
@@ -452,7 +472,8 @@ int fs_resolve(uint8_t oninit,const char *bindhostname,const char *masterhostnam
 	return 0;
 }
 
-int fs_connect(uint8_t oninit,struct connect_args_t *cargs) {
+int fs_connect(uint8_t oninit,struct connect_args_t *cargs,MasterConnection &connection) {
+	int &fd = connection.fd;
 	uint32_t i,j;
 	uint8_t *wptr,*regbuff;
 	md5ctx ctx;
@@ -724,9 +745,9 @@ int fs_connect(uint8_t oninit,struct connect_args_t *cargs) {
 		maxtrashtime = 0;
 	}
 	free(regbuff);
-	lastwrite=time(NULL);
+	connection.lastwrite=time(NULL);
 	if (oninit==0) {
-		lzfs_pretty_syslog(LOG_NOTICE,"registered to master with new session (id #%" PRIu32 ")", sessionid);
+		lzfs_pretty_syslog(LOG_NOTICE,"registered to master with new session (id #%" PRIu32 ")", sessionid.load());
 	}
 	if (cargs->clearpassword && cargs->passworddigest!=NULL) {
 		memset(cargs->passworddigest,0,16);
@@ -855,10 +876,11 @@ int fs_connect(uint8_t oninit,struct connect_args_t *cargs) {
 	return 0;
 }
 
-void fs_reconnect() {
+void fs_reconnect(MasterConnection &connection) {
 	uint32_t i;
 	uint8_t *wptr,regbuff[8+64+9];
 	const uint8_t *rptr;
+	int &fd = connection.fd;
 
 	if (sessionid==0) {
 		lzfs_pretty_syslog(LOG_WARNING,"can't register: session not created");
@@ -943,11 +965,13 @@ void fs_reconnect() {
 		fd=-1;
 		return;
 	}
-	lastwrite=time(NULL);
-	lzfs_pretty_syslog(LOG_NOTICE,"registered to master (session id #%" PRIu32 ")", sessionid);
+	connection.lastwrite=time(NULL);
+	if (connection.index == 0) {
+		lzfs_pretty_syslog(LOG_NOTICE,"registered to master (session id #%" PRIu32 ")", sessionid.load());
+	}
 }
 
-void fs_close_session(void) {
+void fs_close_session(int fd) {
 	uint8_t *wptr,regbuff[8+64+5];
 
 	if (sessionid==0) {
@@ -987,10 +1011,11 @@ void* fs_nop_thread(void *arg) {
 #endif
 	for (;;) {
 		now = time(NULL);
-		std::unique_lock<std::mutex> fdLock(fdMutex);
 		if (fterm) {
-			if (fd>=0) {
-				fs_close_session();
+			MasterConnection &connection = *gConnections[0];
+			std::unique_lock<std::mutex> connectionLock(connection.mutex);
+			if (connection.fd>=0) {
+				fs_close_session(connection.fd);
 			}
 			return NULL;
 		}
@@ -998,21 +1023,27 @@ void* fs_nop_thread(void *arg) {
 			lzfs_pretty_syslog(LOG_NOTICE, "Received SIGUSR1, killing gently...");
 			exit(LIZARDFS_EXIT_STATUS_GENTLY_KILL);
 		}
-		if (disconnect == false && fd >= 0) {
-			if (lastwrite+2<now) {  // NOP
+		for (auto &connectionPtr : gConnections) {
+			MasterConnection &connection = *connectionPtr;
+			std::unique_lock<std::mutex> connectionLock(connection.mutex);
+			if (connection.disconnect || connection.fd < 0) {
+				continue;
+			}
+			if (connection.lastwrite+2<now) {  // NOP
 				ptr = hdr;
 				put32bit(&ptr,ANTOAN_NOP);
 				put32bit(&ptr,4);
 				put32bit(&ptr,0);
-				if (tcptowrite(fd,hdr,12,1000)!=12) {
-					disconnect = true;
+				if (tcptowrite(connection.fd,hdr,12,1000)!=12) {
+					connection.disconnect = true;
 				} else {
 					master_stats_add(MASTER_BYTESSENT,12);
 					master_stats_inc(MASTER_PACKETSSENT);
 				}
-				lastwrite=now;
+				connection.lastwrite=now;
 			}
-			if (++inodeswritecnt >= gReservedInodesPeriod) {
+			// open files belong to the session, so they are reported only once
+			if (connection.index == 0 && ++inodeswritecnt >= gReservedInodesPeriod) {
 				inodeswritecnt = 0;
 				std::unique_lock<std::mutex> asLock(acquiredFileMutex);
 				inodesleng=8;
@@ -1027,8 +1058,8 @@ void* fs_nop_thread(void *arg) {
 				for (afptr=afhead ; afptr ; afptr=afptr->next) {
 					put32bit(&ptr,afptr->inode);
 				}
-				if (tcptowrite(fd,inodespacket,inodesleng,1000)!=inodesleng) {
-					disconnect = true;
+				if (tcptowrite(connection.fd,inodespacket,inodesleng,1000)!=inodesleng) {
+					connection.disconnect = true;
 				} else {
 					master_stats_add(MASTER_BYTESSENT,inodesleng);
 					master_stats_inc(MASTER_PACKETSSENT);
@@ -1036,27 +1067,26 @@ void* fs_nop_thread(void *arg) {
 				free(inodespacket);
 			}
 		}
-		fdLock.unlock();
 		sleep(1);
 	}
 }
 
-bool fs_append_from_master(MessageBuffer& buffer, uint32_t size) {
+bool fs_append_from_master(MasterConnection &connection, MessageBuffer& buffer, uint32_t size) {
 	if (size == 0) {
 		return true;
 	}
 	const uint32_t oldSize = buffer.size();
 	buffer.resize(oldSize + size);
 	uint8_t *appendPointer = buffer.data() + oldSize;
-	int r = tcptoread(fd, appendPointer, size, RECEIVE_TIMEOUT * 1000);
+	int r = tcptoread(connection.fd, appendPointer, size, RECEIVE_TIMEOUT * 1000);
 	if (r == 0) {
 		lzfs_pretty_syslog(LOG_WARNING,"master: connection lost");
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	if (r != (int)size) {
 		lzfs_pretty_syslog(LOG_WARNING,"master: tcp recv error: %s",strerr(tcpgetlasterror()));
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	master_stats_add(MASTER_BYTESRCVD, size);
@@ -1064,43 +1094,83 @@ bool fs_append_from_master(MessageBuffer& buffer, uint32_t size) {
 }
 
 template<class... Args>
-bool fs_deserialize_from_master(uint32_t& remainingBytes, Args&... destination) {
+bool fs_deserialize_from_master(MasterConnection &connection, uint32_t& remainingBytes,
+		Args&... destination) {
 	const uint32_t size = serializedSize(destination...);
 	if (size > remainingBytes) {
 		lzfs_pretty_syslog(LOG_WARNING,"master: packet too short");
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	MessageBuffer buffer;
-	if (!fs_append_from_master(buffer, size)) {
+	if (!fs_append_from_master(connection, buffer, size)) {
 		return false;
 	}
 	try {
 		deserialize(buffer, destination...);
 	} catch (IncorrectDeserializationException& e) {
 		lzfs_pretty_syslog(LOG_WARNING,"master: deserialization error: %s", e.what());
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	remainingBytes -= size;
 	return true;
 }
 
-void* fs_receive_thread(void *) {
+template<class Function>
+static void fs_for_each_threc(Function function) {
+	gThrecs.forEach(function);
+}
+
+// Registers the connection, returns false if it should be retried later
+static bool fs_connection_register(MasterConnection &connection) {
+	if (connection.index > 0) {
+		// additional connections join the session created by the first one
+		if (sessionid!=0 && !sessionlost) {
+			fs_reconnect(connection);
+		}
+		return connection.fd!=-1;
+	}
+	if (sessionid!=0) {
+		fs_reconnect(connection);         // try to register using the same session id
+	}
+	if (connection.fd==-1) {   // still not connected
+		if (sessionlost) {      // if previous session is lost then try to register as a new session
+			if (fs_connect(0,&connect_args,connection)==0) {
+				sessionlost=0;
+				// other connections still use the lost session
+				for (uint32_t i = 1; i < gConnections.size(); ++i) {
+					setDisconnect(*gConnections[i], true);
+				}
+			}
+		} else {        // if other problem occurred then try to resolve hostname and portname then try to reconnect using the same session id
+			if (fs_resolve(0,connect_args.bindhostname,connect_args.masterhostname,connect_args.masterportname)==0) {
+				fs_reconnect(connection);
+			}
+		}
+	}
+	return connection.fd!=-1;
+}
+
+void* fs_receive_thread(void *arg) {
+	MasterConnection &connection = *static_cast<MasterConnection*>(arg);
 	uint32_t initialReconnectSleep_ms = 100;
 	uint32_t reconnectSleep_ms = initialReconnectSleep_ms;
 	for (;;) {
-		std::unique_lock<std::mutex>fdLock(fdMutex);
+		std::unique_lock<std::mutex> connectionLock(connection.mutex);
 		if (fterm) {
 			return NULL;
 		}
-		if (disconnect) {
-			tcpclose(fd);
-			fd=-1;
-			disconnect = false;
-			// send to any threc status error and unlock them
-			std::unique_lock<std::mutex>recLock(recMutex);
-			for (threc *rec=threchead ; rec ; rec=rec->next) {
+		if (connection.disconnect) {
+			tcpclose(connection.fd);
+			connection.fd=-1;
+			connection.disconnect = false;
+			gConnectionId++;
+			// send to any threc waiting for this connection status error and unlock them
+			fs_for_each_threc([&connection](threc *rec) {
+				if (rec->connection != connection.index) {
+					return;
+				}
 				std::unique_lock<std::mutex> lock(rec->mutex);
 				if (rec->sent) {
 					rec->status = 1;
@@ -1109,24 +1179,10 @@ void* fs_receive_thread(void *) {
 						rec->condition.notify_one();
 					}
 				}
-			}
-		}
-		if (fd==-1 && sessionid!=0) {
-			fs_reconnect();         // try to register using the same session id
+			});
 		}
-		if (fd==-1) {   // still not connected
-			if (sessionlost) {      // if previous session is lost then try to register as a new session
-				if (fs_connect(0,&connect_args)==0) {
-					sessionlost=0;
-				}
-			} else {        // if other problem occurred then try to resolve hostname and portname then try to reconnect using the same session id
-				if (fs_resolve(0,connect_args.bindhostname,connect_args.masterhostname,connect_args.masterportname)==0) {
-					fs_reconnect();
-				}
-			}
-		}
-		if (fd==-1) {
-			fdLock.unlock();
+		if (connection.fd==-1 && !fs_connection_register(connection)) {
+			connectionLock.unlock();
 			usleep(reconnectSleep_ms * 1000);
 			// slowly increase timeout before each retry
 			if (reconnectSleep_ms < 5 * initialReconnectSleep_ms) {
@@ -1141,13 +1197,13 @@ void* fs_receive_thread(void *) {
 			// connecection succeeded -- reset timeout the initial value
 			reconnectSleep_ms = initialReconnectSleep_ms;
 		}
-		fdLock.unlock();
+		connectionLock.unlock();
 
 		PacketHeader packetHeader;
 		PacketVersion packetVersion;
 		uint32_t messageId = 0;
 		uint32_t remainingBytes = serializedSize(packetHeader);
-		if (!fs_deserialize_from_master(remainingBytes, packetHeader)) {
+		if (!fs_deserialize_from_master(connection, remainingBytes, packetHeader)) {
 			continue;
 		}
 		master_stats_inc(MASTER_PACKETSRCVD);
@@ -1159,7 +1215,7 @@ void* fs_receive_thread(void *) {
 					perTypePacketHandlers.find(packetHeader.type);
 			if (handler != perTypePacketHandlers.end()) {
 				MessageBuffer buffer;
-				if (fs_append_from_master(buffer, remainingBytes)) {
+				if (fs_append_from_master(connection, buffer, remainingBytes)) {
 					handler->second->handle(std::move(buffer));
 				}
 				continue;
@@ -1169,19 +1225,19 @@ void* fs_receive_thread(void *) {
 		if (packetHeader.isLizPacketType()) {
 			if (remainingBytes < serializedSize(packetVersion, messageId)) {
 				lzfs_pretty_syslog(LOG_WARNING,"master: packet too short: no msgid");
-				setDisconnect(true);
+				setDisconnect(connection, true);
 				continue;
 			}
-			if (!fs_deserialize_from_master(remainingBytes, packetVersion, messageId)) {
+			if (!fs_deserialize_from_master(connection, remainingBytes, packetVersion, messageId)) {
 				continue;
 			}
 		} else {
 			if (remainingBytes < serializedSize(messageId)) {
 				lzfs_pretty_syslog(LOG_WARNING,"master: packet too short: no msgid");
-				setDisconnect(true);
+				setDisconnect(connection, true);
 				continue;
 			}
-			if (!fs_deserialize_from_master(remainingBytes, messageId)) {
+			if (!fs_deserialize_from_master(connection, remainingBytes, messageId)) {
 				continue;
 			}
 		}
@@ -1196,10 +1252,12 @@ void* fs_receive_thread(void *) {
 				continue;
 			}
 		}
+		// Master may answer through any connection of the session (e.g. when a lock is
+		// granted), so the waiting thread is found by message id only
 		threc *rec = fs_get_threc_by_id(messageId);
 		if (rec == NULL) {
 			lzfs_pretty_syslog(LOG_WARNING,"master: got unexpected queryid");
-			setDisconnect(true);
+			setDisconnect(connection, true);
 			continue;
 		}
 		std::unique_lock<std::mutex> lock(rec->mutex);
@@ -1209,7 +1267,7 @@ void* fs_receive_thread(void *) {
 		} else {
 			serialize(rec->inputBuffer, messageId);
 		}
-		if (!fs_append_from_master(rec->inputBuffer, remainingBytes)) {
+		if (!fs_append_from_master(connection, rec->inputBuffer, remainingBytes)) {
 			lock.unlock();
 			continue;
 		}
@@ -1223,6 +1281,15 @@ void* fs_receive_thread(void *) {
 	}
 }
 
+static MasterConnection *fs_new_connection(uint32_t index) {
+	MasterConnection *connection = new MasterConnection;
+	connection->index = index;
+	connection->fd = -1;
+	connection->disconnect = false;
+	connection->lastwrite = 0;
+	return connection;
+}
+
 // called before fork
 int fs_init_master_connection(const char *bindhostname, const char *masterhostname,
 		const char *masterportname, uint8_t meta, const char *info, const char *subfolder,
@@ -1233,10 +1300,10 @@ int fs_init_master_connection(const char *bindhostname, const char *masterhostna
 	gIoRetries = retries;
 	gReservedInodesPeriod = reportreservedperiod;
 
-	fd = -1;
+	gConnections.clear();
+	gConnections.emplace_back(fs_new_connection(0));
 	sessionlost = bgregister;
 	sessionid = 0;
-	disconnect = false;
 
 	if (bindhostname) {
 		connect_args.bindhostname = strdup(bindhostname);
@@ -1259,43 +1326,48 @@ int fs_init_master_connection(const char *bindhostname, const char *masterhostna
 	if (bgregister) {
 		return 1;
 	}
-	return fs_connect(1,&connect_args);
+	return fs_connect(1,&connect_args,*gConnections[0]);
 }
 
 // called after fork
-void fs_init_threads(uint32_t retries) {
+void fs_init_threads(uint32_t retries, uint32_t connections) {
 	pthread_attr_t thattr;
 	maxretries = retries;
 	fterm = 0;
 
+	// additional connections register in their receiving threads
+	for (uint32_t i = gConnections.size(); i < std::max<uint32_t>(connections, 1); ++i) {
+		gConnections.emplace_back(fs_new_connection(i));
+	}
 	pthread_attr_init(&thattr);
 	pthread_attr_setstacksize(&thattr,0x100000);
-	pthread_create(&rpthid,&thattr,fs_receive_thread,NULL);
+	for (auto &connection : gConnections) {
+		pthread_create(&connection->receiveThread,&thattr,fs_receive_thread,connection.get());
+	}
 	pthread_create(&npthid,&thattr,fs_nop_thread,NULL);
 	pthread_attr_destroy(&thattr);
 }
 
 void fs_term(void) {
-	threc *tr,*trn;
 	acquired_file *af,*afn;
-	std::unique_lock<std::mutex> fdLock(fdMutex);
 	fterm = 1;
-	fdLock.unlock();
 	pthread_join(npthid,NULL);
-	pthread_join(rpthid,NULL);
-	for (tr = threchead ; tr ; tr = trn) {
-		trn = tr->next;
-		tr->outputBuffer.clear();
-		tr->inputBuffer.clear();
-		delete tr;
+	for (auto &connection : gConnections) {
+		pthread_join(connection->receiveThread,NULL);
 	}
+	gThrecs.clear([](threc *rec) {
+		delete rec;
+	});
 	for (af = afhead ; af ; af = afn) {
 		afn = af->next;
 		free(af);
 	}
-	if (fd>=0) {
-		tcpclose(fd);
+	for (auto &connection : gConnections) {
+		if (connection->fd>=0) {
+			tcpclose(connection->fd);
+		}
 	}
+	gConnections.clear();
 	if (connect_args.bindhostname) {
 		free(connect_args.bindhostname);
 	}
@@ -2000,7 +2072,12 @@ uint8_t fs_lizreadchunk(std::vector<ChunkTypeWithAddress> &chunkservers, uint64_
 	threc *rec = fs_get_my_threc();
 
 	std::vector<uint8_t> message;
-	cltoma::fuseReadChunk::serialize(message, rec->packetId, inode, chunkIndex);
+	tracing::TraceId traceId = tracing::currentTraceId();
+	if (traceId != 0 && masterversion >= kFirstTracingVersion) {
+		cltoma::fuseReadChunk::serialize(message, rec->packetId, inode, chunkIndex, traceId);
+	} else {
+		cltoma::fuseReadChunk::serialize(message, rec->packetId, inode, chunkIndex);
+	}
 	if (!fs_lizcreatepacket(rec, message)) {
 		return LIZARDFS_ERROR_IO;
 	}
@@ -2039,6 +2116,169 @@ uint8_t fs_lizreadchunk(std::vector<ChunkTypeWithAddress> &chunkservers, uint64_
 	return LIZARDFS_STATUS_OK;
 }
 
+uint8_t fs_lizreadchunks(std::vector<ChunkLocationsEntry> &chunks, uint64_t &fileLength,
+		uint32_t inode, uint32_t firstIndex, uint32_t count) {
+	threc *rec = fs_get_my_threc();
+	if (masterversion < kFirstReadChunksVersion) {
+		return LIZARDFS_ERROR_ENOTSUP;
+	}
+
+	std::vector<uint8_t> message;
+	tracing::TraceId traceId = tracing::currentTraceId();
+	if (traceId != 0 && masterversion >= kFirstTracingVersion) {
+		cltoma::fuseReadChunks::serialize(message, rec->packetId, inode, firstIndex, count,
+				traceId);
+	} else {
+		cltoma::fuseReadChunks::serialize(message, rec->packetId, inode, firstIndex, count);
+	}
+	if (!fs_lizcreatepacket(rec, message)) {
+		return LIZARDFS_ERROR_IO;
+	}
+
+	try {
+		if (!fs_lizsendandreceive(rec, LIZ_MATOCL_FUSE_READ_CHUNKS, message)) {
+			return LIZARDFS_ERROR_IO;
+		}
+		PacketVersion packetVersion;
+		deserializePacketVersionNoHeader(message, packetVersion);
+		uint32_t messageId;
+		if (packetVersion == matocl::fuseReadChunks::kStatusPacketVersion) {
+			uint8_t status;
+			matocl::fuseReadChunks::deserialize(message, messageId, status);
+			return status;
+		} else if (packetVersion == matocl::fuseReadChunks::kResponsePacketVersion) {
+			matocl::fuseReadChunks::deserialize(message, messageId, fileLength, chunks);
+		} else {
+			lzfs_pretty_syslog(LOG_NOTICE, "LIZ_MATOCL_FUSE_READ_CHUNKS - wrong packet version");
+			setDisconnect(true);
+			return LIZARDFS_ERROR_IO;
+		}
+	} catch (IncorrectDeserializationException&) {
+		setDisconnect(true);
+		return LIZARDFS_ERROR_IO;
+	}
+	if (chunks.empty()) {
+		setDisconnect(true);
+		return LIZARDFS_ERROR_IO;
+	}
+	return LIZARDFS_STATUS_OK;
+}
+
+uint8_t fs_cache_lease(uint32_t leaseTime, uint32_t &grantedLeaseTime) {
+	threc *rec = fs_get_my_threc();
+	if (masterversion < kFirstCacheLeaseVersion) {
+		return LIZARDFS_ERROR_ENOTSUP;
+	}
+
+	// Master grants leases for requests received through a connection which asked for them,
+	// so the request is sent through all connections
+	uint32_t myConnection = rec->connection;
+	uint8_t status = LIZARDFS_STATUS_OK;
+	grantedLeaseTime = leaseTime;
+	for (uint32_t i = 0; i < gConnections.size() && status == LIZARDFS_STATUS_OK; ++i) {
+		rec->connection = i;
+		std::vector<uint8_t> message;
+		cltoma::fuseCacheLease::serialize(message, rec->packetId, leaseTime);
+		if (!fs_lizcreatepacket(rec, message)) {
+			status = LIZARDFS_ERROR_IO;
+			break;
+		}
+		try {
+			if (!fs_lizsendandreceive(rec, LIZ_MATOCL_FUSE_CACHE_LEASE, message)) {
+				status = LIZARDFS_ERROR_IO;
+				break;
+			}
+			uint32_t messageId, granted;
+			matocl::fuseCacheLease::deserialize(message, messageId, granted);
+			grantedLeaseTime = std::min(grantedLeaseTime, granted);
+		} catch (IncorrectDeserializationException&) {
+			setDisconnect(true);
+			status = LIZARDFS_ERROR_IO;
+		}
+	}
+	rec->connection = myConnection;
+	return status;
+}
+
+// Version of the master which didn't accept LIZ_CLTOMA_FUSE_COMPOUND, if any
+static std::atomic<uint32_t> gCompoundRejectedVersion(0);
+
+static uint8_t fs_do_compound(threc *rec, uint32_t uid, uint32_t gid,
+		const std::vector<CompoundOperation> &operations, std::vector<CompoundResult> &results) {
+	std::vector<uint8_t> message;
+	cltoma::fuseCompound::serialize(message, rec->packetId, uid, gid, operations);
+	if (!fs_lizcreatepacket(rec, message)) {
+		return LIZARDFS_ERROR_IO;
+	}
+
+	try {
+		if (!fs_lizsendandreceive(rec, LIZ_MATOCL_FUSE_COMPOUND, message)) {
+			// Master which doesn't understand the request closes the connection each time,
+			// so after all retries single requests are used until it is upgraded
+			lzfs_pretty_syslog(LOG_NOTICE, "LIZ_CLTOMA_FUSE_COMPOUND not accepted by master,"
+					" using single requests");
+			gCompoundRejectedVersion = masterversion;
+			return LIZARDFS_ERROR_ENOTSUP;
+		}
+		PacketVersion packetVersion;
+		deserializePacketVersionNoHeader(message, packetVersion);
+		uint32_t messageId;
+		if (packetVersion == matocl::fuseCompound::kStatusPacketVersion) {
+			// the request was rejected as a whole, none of the operations was done
+			uint8_t status;
+			matocl::fuseCompound::deserialize(message, messageId, status);
+			return LIZARDFS_ERROR_ENOTSUP;
+		} else if (packetVersion == matocl::fuseCompound::kResponsePacketVersion) {
+			matocl::fuseCompound::deserialize(message, messageId, results);
+		} else {
+			lzfs_pretty_syslog(LOG_NOTICE, "LIZ_MATOCL_FUSE_COMPOUND - wrong packet version");
+			setDisconnect(true);
+			return LIZARDFS_ERROR_IO;
+		}
+	} catch (IncorrectDeserializationException&) {
+		setDisconnect(true);
+		return LIZARDFS_ERROR_IO;
+	}
+	if (results.empty() || results.size() > operations.size()
+			|| (results.size() < operations.size()
+				&& results.back().status == LIZARDFS_STATUS_OK)) {
+		setDisconnect(true);
+		return LIZARDFS_ERROR_IO;
+	}
+	return LIZARDFS_STATUS_OK;
+}
+
+uint8_t fs_compound(uint32_t uid, uint32_t gid, const std::vector<CompoundOperation> &operations,
+		std::vector<CompoundResult> &results) {
+	threc *rec = fs_get_my_threc();
+	if (masterversion < kFirstCompoundVersion || masterversion == gCompoundRejectedVersion) {
+		return LIZARDFS_ERROR_ENOTSUP;
+	}
+
+	// Files opened by the master have to be known when the session is registered again,
+	// which may happen before the reply comes, so files are counted as opened in advance
+	// (as fs_opencheck does) when their inodes are known
+	for (const CompoundOperation &op : operations) {
+		if (op.type == CompoundOperationType::kOpen && op.inodeSource == 0) {
+			fs_inc_acnt(op.inode);
+		}
+	}
+	uint8_t status = fs_do_compound(rec, uid, gid, operations, results);
+	for (uint32_t i = 0; i < operations.size(); ++i) {
+		if (operations[i].type != CompoundOperationType::kOpen) {
+			continue;
+		}
+		bool opened = status == LIZARDFS_STATUS_OK && i < results.size()
+				&& results[i].status == LIZARDFS_STATUS_OK;
+		if (operations[i].inodeSource == 0 && !opened) {
+			fs_dec_acnt(operations[i].inode);
+		} else if (operations[i].inodeSource != 0 && opened) {
+			fs_inc_acnt(results[i].inode);
+		}
+	}
+	return status;
+}
+
 uint8_t fs_writechunk(uint32_t inode,uint32_t indx,uint64_t *length,uint64_t *chunkid,uint32_t *version,const uint8_t **csdata,uint32_t *csdatasize) {
 	uint8_t *wptr;
 	const uint8_t *rptr;
@@ -2085,7 +2325,13 @@ uint8_t fs_lizwritechunk(uint32_t inode, uint32_t chunkIndex, uint32_t &lockId,
 	threc *rec = fs_get_my_threc();
 
 	std::vector<uint8_t> message;
-	cltoma::fuseWriteChunk::serialize(message, rec->packetId, inode, chunkIndex, lockId);
+	tracing::TraceId traceId = tracing::currentTraceId();
+	if (traceId != 0 && masterversion >= kFirstTracingVersion) {
+		cltoma::fuseWriteChunk::serialize(message, rec->packetId, inode, chunkIndex, lockId,
+				traceId);
+	} else {
+		cltoma::fuseWriteChunk::serialize(message, rec->packetId, inode, chunkIndex, lockId);
+	}
 	if (!fs_lizcreatepacket(rec, message)) {
 		return LIZARDFS_ERROR_IO;
 	}
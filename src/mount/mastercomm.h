@@ -27,11 +27,15 @@
 #include "common/acl_type.h"
 #include "common/attributes.h"
 #include "common/chunk_type_with_address.h"
+#include "protocol/chunk_locations_entry.h"
+#include "protocol/compound_operation.h"
 #include "protocol/packet.h"
 #include "protocol/lock_info.h"
 
 void fs_getmasterlocation(uint8_t loc[14]);
 uint32_t fs_getsrcip(void);
+/// Returns a number which changes when connection with master is lost
+uint32_t fs_get_connection_id(void);
 
 void fs_notify_sendremoved(uint32_t cnt,uint32_t *inodes);
 
@@ -61,6 +65,17 @@ void fs_release(uint32_t inode);
 uint8_t fs_readchunk(uint32_t inode,uint32_t indx,uint64_t *length,uint64_t *chunkid,uint32_t *version,const uint8_t **csdata,uint32_t *csdatasize);
 uint8_t fs_lizreadchunk(std::vector<ChunkTypeWithAddress> &serverList, uint64_t &chunkId,
 		uint32_t &chunkVersion, uint64_t &fileLength, uint32_t inode, uint32_t index);
+// Locates up to 'count' consecutive chunks starting from 'firstIndex', stopping at the end of file
+uint8_t fs_lizreadchunks(std::vector<ChunkLocationsEntry> &chunks, uint64_t &fileLength,
+		uint32_t inode, uint32_t firstIndex, uint32_t count);
+// Asks master to notify about changes of inodes returned by lookup and getattr for a given time
+uint8_t fs_cache_lease(uint32_t leaseTime, uint32_t &grantedLeaseTime);
+// Executes operations in a single round trip, stopping at the first failed one. Status of the
+// whole request is returned, statuses of executed operations are stored in 'results'.
+// LIZARDFS_ERROR_ENOTSUP means that master didn't execute the request, so the operations
+// have to be sent one by one.
+uint8_t fs_compound(uint32_t uid, uint32_t gid, const std::vector<CompoundOperation> &operations,
+		std::vector<CompoundResult> &results);
 uint8_t fs_writechunk(uint32_t inode,uint32_t indx,uint64_t *length,uint64_t *chunkid,uint32_t *version,const uint8_t **csdata,uint32_t *csdatasize);
 uint8_t fs_lizwritechunk(uint32_t inode, uint32_t chunkIndex, uint32_t &lockId,
 		uint64_t &fileLength, uint64_t &chunkId, uint32_t &chunkVersion,
@@ -102,8 +117,8 @@ int fs_init_master_connection(const char *bindhostname, const char *masterhostna
 		const char *masterportname, uint8_t meta, const char *info, const char *subfolder,
 		const uint8_t passworddigest[16], uint8_t donotrememberpassword, uint8_t bgregister,
 		unsigned retries, unsigned reportreservedperiod);
-// called after fork
-void fs_init_threads(uint32_t retries);
+// called after fork, requests of different threads are spread over 'connections' connections
+void fs_init_threads(uint32_t retries, uint32_t connections);
 void fs_term(void);
 
 class PacketHandler {
@@ -0,0 +1,174 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/metadata_cache.h"
+
+#include <cstring>
+
+MetadataCache gMetadataCache(0, 0);
+
+template <typename Key, typename Value>
+Value *MetadataCache::Table<Key, Value>::find(const Key &key, SteadyTimePoint now) {
+	auto it = items.find(key);
+	if (it == items.end()) {
+		return nullptr;
+	}
+	if (now >= it->second.expirationTime) {
+		erase(it);
+		return nullptr;
+	}
+	lru.splice(lru.begin(), lru, it->second.lruPosition);
+	return &it->second.value;
+}
+
+template <typename Key, typename Value>
+void MetadataCache::Table<Key, Value>::insert(const Key &key, const Value &value,
+		SteadyTimePoint expirationTime, uint32_t capacity) {
+	auto it = items.find(key);
+	if (it != items.end()) {
+		erase(it);
+	} else if (items.size() >= capacity) {
+		erase(items.find(lru.back()));
+	}
+	lru.push_front(key);
+	Item &item = items[key];
+	item.value = value;
+	item.expirationTime = expirationTime;
+	item.lruPosition = lru.begin();
+}
+
+template <typename Key, typename Value>
+void MetadataCache::Table<Key, Value>::erase(typename ItemMap::iterator it) {
+	lru.erase(it->second.lruPosition);
+	items.erase(it);
+}
+
+template <typename Key, typename Value>
+void MetadataCache::Table<Key, Value>::clear() {
+	items.clear();
+	lru.clear();
+}
+
+MetadataCache::MetadataCache(uint32_t capacity, uint32_t timeout_ms)
+		: capacity_(capacity),
+		  timeout_(std::chrono::milliseconds(timeout_ms)),
+		  epoch_(0) {
+}
+
+void MetadataCache::setLimits(uint32_t capacity, uint32_t timeout_ms) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	capacity_ = capacity;
+	timeout_ = std::chrono::milliseconds(timeout_ms);
+	attrs_.clear();
+	entries_.clear();
+}
+
+bool MetadataCache::enabled() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return capacity_ > 0 && timeout_.count() > 0;
+}
+
+uint32_t MetadataCache::size() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return attrs_.items.size() + entries_.items.size();
+}
+
+uint64_t MetadataCache::epoch() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return epoch_;
+}
+
+bool MetadataCache::findAttr(uint32_t inode, uint32_t uid, uint32_t gid, Attributes &attr) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	AttrValue *value = attrs_.find(inode, SteadyClock::now());
+	if (!value || value->uid != uid || value->gid != gid) {
+		return false;
+	}
+	memcpy(attr, value->attr, sizeof(Attributes));
+	return true;
+}
+
+bool MetadataCache::findEntry(uint32_t parent, const std::string &name, uint32_t uid,
+		uint32_t gid, uint32_t &inode, Attributes &attr) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	SteadyTimePoint now = SteadyClock::now();
+	EntryValue *entry = entries_.find(EntryKey(parent, name), now);
+	if (!entry || entry->uid != uid || entry->gid != gid) {
+		return false;
+	}
+	// Attributes of the inode are invalidated separately, so they may be missing
+	AttrValue *value = attrs_.find(entry->inode, now);
+	if (!value || value->uid != uid || value->gid != gid) {
+		return false;
+	}
+	inode = entry->inode;
+	memcpy(attr, value->attr, sizeof(Attributes));
+	return true;
+}
+
+void MetadataCache::insertAttr(uint32_t inode, uint32_t uid, uint32_t gid,
+		const Attributes &attr, uint64_t epoch) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (capacity_ == 0 || epoch != epoch_) {
+		return;
+	}
+	doInsertAttr(inode, uid, gid, attr, SteadyClock::now() + timeout_);
+}
+
+void MetadataCache::insertEntry(uint32_t parent, const std::string &name, uint32_t uid,
+		uint32_t gid, uint32_t inode, const Attributes &attr, uint64_t epoch) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (capacity_ == 0 || epoch != epoch_) {
+		return;
+	}
+	SteadyTimePoint expirationTime = SteadyClock::now() + timeout_;
+	doInsertAttr(inode, uid, gid, attr, expirationTime);
+	entries_.insert(EntryKey(parent, name), EntryValue{uid, gid, inode}, expirationTime,
+			capacity_);
+}
+
+void MetadataCache::invalidate(uint32_t inode) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	auto attr = attrs_.items.find(inode);
+	if (attr != attrs_.items.end()) {
+		attrs_.erase(attr);
+	}
+	auto it = entries_.items.lower_bound(EntryKey(inode, std::string()));
+	while (it != entries_.items.end() && it->first.first == inode) {
+		entries_.erase(it++);
+	}
+}
+
+void MetadataCache::clear() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	attrs_.clear();
+	entries_.clear();
+}
+
+void MetadataCache::doInsertAttr(uint32_t inode, uint32_t uid, uint32_t gid,
+		const Attributes &attr, SteadyTimePoint expirationTime) {
+	AttrValue value;
+	value.uid = uid;
+	value.gid = gid;
+	memcpy(value.attr, attr, sizeof(Attributes));
+	attrs_.insert(inode, value, expirationTime, capacity_);
+}
@@ -0,0 +1,115 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "common/attributes.h"
+#include "common/time_utils.h"
+
+/*! \brief Attributes and directory entries leased from the master.
+ *
+ * Master remembers which inodes were returned to the mount by lookup and getattr and sends
+ * their numbers back when they change, so entries may be kept much longer than the kernel
+ * is allowed to keep them. An invalidation of an inode removes its attributes and all
+ * entries of a directory with this inode. Entries found in a reply to a query started before
+ * the last invalidation are not inserted. Results depend on credentials, so uid and gid have
+ * to match for a hit. Thread safe.
+ */
+class MetadataCache {
+public:
+	MetadataCache(uint32_t capacity, uint32_t timeout_ms);
+
+	/// Changes limits, capacity or timeout 0 disables the cache
+	void setLimits(uint32_t capacity, uint32_t timeout_ms);
+
+	bool enabled() const;
+	uint32_t size() const;
+
+	/// Returns a value which has to be passed to insert functions for data queried after the call
+	uint64_t epoch() const;
+
+	bool findAttr(uint32_t inode, uint32_t uid, uint32_t gid, Attributes &attr);
+	bool findEntry(uint32_t parent, const std::string &name, uint32_t uid, uint32_t gid,
+			uint32_t &inode, Attributes &attr);
+
+	void insertAttr(uint32_t inode, uint32_t uid, uint32_t gid, const Attributes &attr,
+			uint64_t epoch);
+	void insertEntry(uint32_t parent, const std::string &name, uint32_t uid, uint32_t gid,
+			uint32_t inode, const Attributes &attr, uint64_t epoch);
+
+	/// Forgets attributes of the inode and entries of a directory with this inode
+	void invalidate(uint32_t inode);
+
+	/// Forgets everything
+	void clear();
+
+private:
+	template <typename Key, typename Value>
+	struct Table {
+		struct Item {
+			Value value;
+			SteadyTimePoint expirationTime;
+			typename std::list<Key>::iterator lruPosition;
+		};
+		typedef std::map<Key, Item> ItemMap;
+
+		Value *find(const Key &key, SteadyTimePoint now);
+		void insert(const Key &key, const Value &value, SteadyTimePoint expirationTime,
+				uint32_t capacity);
+		void erase(typename ItemMap::iterator it);
+		void clear();
+
+		ItemMap items;
+		std::list<Key> lru; // most recently used keys first
+	};
+
+	struct AttrValue {
+		uint32_t uid;
+		uint32_t gid;
+		Attributes attr;
+	};
+
+	struct EntryValue {
+		uint32_t uid;
+		uint32_t gid;
+		uint32_t inode;
+	};
+
+	typedef std::pair<uint32_t, std::string> EntryKey;
+
+	void doInsertAttr(uint32_t inode, uint32_t uid, uint32_t gid, const Attributes &attr,
+			SteadyTimePoint expirationTime);
+
+	mutable std::mutex mutex_;
+	uint32_t capacity_;
+	SteadyDuration timeout_;
+	uint64_t epoch_;
+	Table<uint32_t, AttrValue> attrs_;
+	Table<EntryKey, EntryValue> entries_;
+};
+
+extern MetadataCache gMetadataCache;
@@ -0,0 +1,99 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/metadata_cache.h"
+
+#include <unistd.h>
+#include <cstring>
+#include <gtest/gtest.h>
+
+static void makeAttr(Attributes &attr, uint8_t seed) {
+	memset(attr, seed, sizeof(Attributes));
+}
+
+TEST(MetadataCacheTests, FindAndInvalidate) {
+	MetadataCache cache(100, 1000000);
+	Attributes attr, dirAttr, found;
+	uint32_t inode;
+	makeAttr(attr, 1);
+	makeAttr(dirAttr, 2);
+	EXPECT_FALSE(cache.findAttr(10, 0, 0, found));
+	cache.insertEntry(5, "file", 0, 0, 10, attr, cache.epoch());
+	cache.insertAttr(5, 0, 0, dirAttr, cache.epoch());
+
+	ASSERT_TRUE(cache.findEntry(5, "file", 0, 0, inode, found));
+	EXPECT_EQ(10U, inode);
+	EXPECT_EQ(0, memcmp(attr, found, sizeof(Attributes)));
+	ASSERT_TRUE(cache.findAttr(10, 0, 0, found));
+	EXPECT_EQ(0, memcmp(attr, found, sizeof(Attributes)));
+	EXPECT_FALSE(cache.findEntry(5, "other", 0, 0, inode, found));
+
+	// Results for other credentials are not shared
+	EXPECT_FALSE(cache.findAttr(10, 1000, 1000, found));
+	EXPECT_FALSE(cache.findEntry(5, "file", 1000, 0, inode, found));
+
+	// Change of a file removes its attributes, so the entry is not used either
+	cache.invalidate(10);
+	EXPECT_FALSE(cache.findAttr(10, 0, 0, found));
+	EXPECT_FALSE(cache.findEntry(5, "file", 0, 0, inode, found));
+
+	// Change of a directory removes its entries
+	cache.insertEntry(5, "file", 0, 0, 10, attr, cache.epoch());
+	cache.invalidate(5);
+	EXPECT_FALSE(cache.findAttr(5, 0, 0, found));
+	EXPECT_FALSE(cache.findEntry(5, "file", 0, 0, inode, found));
+	EXPECT_TRUE(cache.findAttr(10, 0, 0, found));
+}
+
+TEST(MetadataCacheTests, InsertAfterInvalidationIsIgnored) {
+	MetadataCache cache(100, 1000000);
+	Attributes attr, found;
+	makeAttr(attr, 1);
+	uint64_t epoch = cache.epoch();
+	cache.invalidate(10);
+	cache.insertAttr(10, 0, 0, attr, epoch);
+	EXPECT_FALSE(cache.findAttr(10, 0, 0, found));
+
+	epoch = cache.epoch();
+	cache.clear();
+	cache.insertAttr(10, 0, 0, attr, epoch);
+	EXPECT_FALSE(cache.findAttr(10, 0, 0, found));
+	EXPECT_EQ(0U, cache.size());
+}
+
+TEST(MetadataCacheTests, LimitsAreRespected) {
+	MetadataCache cache(2, 1000000);
+	Attributes attr, found;
+	makeAttr(attr, 1);
+	cache.insertAttr(1, 0, 0, attr, cache.epoch());
+	cache.insertAttr(2, 0, 0, attr, cache.epoch());
+	ASSERT_TRUE(cache.findAttr(1, 0, 0, found));
+	cache.insertAttr(3, 0, 0, attr, cache.epoch());
+	EXPECT_EQ(2U, cache.size());
+	EXPECT_TRUE(cache.findAttr(1, 0, 0, found));
+	EXPECT_FALSE(cache.findAttr(2, 0, 0, found));
+
+	cache.setLimits(100, 0);
+	EXPECT_FALSE(cache.enabled());
+	cache.setLimits(100, 1);
+	EXPECT_TRUE(cache.enabled());
+	cache.insertAttr(1, 0, 0, attr, cache.epoch());
+	usleep(2000);
+	EXPECT_FALSE(cache.findAttr(1, 0, 0, found));
+}
@@ -1046,6 +1046,8 @@ int main (int argc, char **argv) {
 	auto readaheadmaxwindowsize = 4096;
 	bool prefetchFullXorStripes = true;
 	auto bandwidthOveruse = 1.25;
+	auto chunklocationcachesize = 10000;
+	auto chunklocationprefetch = 8;
 	auto chunkserverwriteto = 5000;
 	auto cacheperinodepercentage = 25;
 	parse_command_line(argc, argv, gSetup);
@@ -1087,7 +1089,7 @@ int main (int argc, char **argv) {
 	}
 	symlink_cache_init();
 	gGlobalIoLimiter();
-	fs_init_threads(gSetup.io_retries);
+	fs_init_threads(gSetup.io_retries, 1);
 	masterproxy_init();
 	gLocalIoLimiter();
 	IoLimitsConfigLoader loader;
@@ -1100,7 +1102,9 @@ int main (int argc, char **argv) {
 			cacheexpirationtime,
 			readaheadmaxwindowsize,
 			prefetchFullXorStripes,
-			bandwidthOveruse);
+			bandwidthOveruse,
+			chunklocationcachesize,
+			chunklocationprefetch);
 	write_data_init(gSetup.write_buffer_size, gSetup.io_retries, writeworkers,
 			writewindowsize, chunkserverwriteto, cacheperinodepercentage);
 	LizardClient::init(gSetup.debug, true, gSetup.direntry_cache_timeout,
@@ -32,6 +32,7 @@
 #include <condition_variable>
 #include <map>
 #include <mutex>
+#include <string>
 
 #include "common/connection_pool.h"
 #include "common/datapack.h"
@@ -41,9 +42,12 @@
 #include "common/slogger.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
+#include "common/tracing.h"
+#include "mount/chunk_location_cache.h"
 #include "mount/chunk_locator.h"
 #include "mount/chunk_reader.h"
 #include "mount/exceptions.h"
+#include "mount/global_chunkserver_stats.h"
 #include "mount/mastercomm.h"
 #include "mount/readahead_adviser.h"
 #include "mount/readdata_cache.h"
@@ -52,6 +56,11 @@
 #define USECTICK 333333
 #define REFRESHTICKS 15
 
+// Cached chunk locations are as old as the ones kept by a descriptor between forced refreshes
+#define CHUNK_LOCATION_CACHE_TIMEOUT_MS (USECTICK * REFRESHTICKS / 1000)
+
+#define DEFAULT_TRACE_FILE DATA_PATH "/mount-traces.log"
+
 #define MAPBITS 10
 #define MAPSIZE (1<<(MAPBITS))
 #define MAPMASK (MAPSIZE-1)
@@ -83,8 +92,9 @@ struct readrec {
 	}
 };
 
-static ConnectionPool gReadConnectionPool;
-static ChunkConnectorUsingPool gChunkConnector(gReadConnectionPool);
+static ConnectionPool gChunkserverConnectionPool;
+static ChunkConnectorUsingPool gChunkConnector(gChunkserverConnectionPool, 0,
+		&globalChunkserverStats);
 static std::mutex gMutex;
 static readrec *rdinodemap[MAPSIZE];
 static readrec *rdhead=NULL;
@@ -93,9 +103,11 @@ static std::atomic<uint32_t> gChunkserverConnectTimeout_ms;
 static std::atomic<uint32_t> gChunkserverWaveReadTimeout_ms;
 static std::atomic<uint32_t> gChunkserverTotalReadTimeout_ms;
 static std::atomic<bool> gPrefetchXorStripes;
+static std::atomic<uint32_t> gChunkLocationPrefetch;
 static bool readDataTerminate;
 static std::atomic<uint32_t> maxRetries;
 static double gBandwidthOveruse;
+static std::unique_ptr<tracing::Dumper> gTraceDumper;
 
 const unsigned ReadaheadAdviser::kInitWindowSize;
 const unsigned ReadaheadAdviser::kMaxWindowSize;
@@ -120,12 +132,21 @@ bool read_data_get_prefetchxorstripes() {
 	return gPrefetchXorStripes;
 }
 
+uint32_t read_data_get_chunk_location_prefetch() {
+	return gChunkLocationPrefetch;
+}
+
+ConnectionPool& read_data_get_connection_pool() {
+	return gChunkserverConnectionPool;
+}
+
 void* read_data_delayed_ops(void *arg) {
 	readrec *rrec,**rrecp;
 	readrec **rrecmap;
 	(void)arg;
 	for (;;) {
-		gReadConnectionPool.cleanup();
+		gChunkserverConnectionPool.cleanup();
+		gChunkConnector.prewarm(gChunkserverConnectTimeout_ms);
 		std::unique_lock<std::mutex> lock(gMutex);
 		if (readDataTerminate) {
 			return NULL;
@@ -180,7 +201,11 @@ void read_data_init(uint32_t retries,
 		uint32_t cache_expiration_time_ms,
 		uint32_t readahead_max_window_size_kB,
 		bool prefetchXorStripes,
-		double bandwidth_overuse) {
+		double bandwidth_overuse,
+		uint32_t chunk_location_cache_size,
+		uint32_t chunk_location_prefetch,
+		uint32_t trace_sampling_period,
+		const char *trace_file) {
 	uint32_t i;
 	pthread_attr_t thattr;
 
@@ -196,6 +221,12 @@ void read_data_init(uint32_t retries,
 	gReadaheadMaxWindowSize = readahead_max_window_size_kB * 1024;
 	gPrefetchXorStripes = prefetchXorStripes;
 	gBandwidthOveruse = bandwidth_overuse;
+	gChunkLocationPrefetch = chunk_location_prefetch;
+	gChunkLocationCache.setLimits(chunk_location_cache_size, CHUNK_LOCATION_CACHE_TIMEOUT_MS);
+	tracing::setSamplingPeriod(trace_sampling_period);
+	if (trace_sampling_period > 0) {
+		gTraceDumper.reset(new tracing::Dumper(trace_file ? trace_file : DEFAULT_TRACE_FILE));
+	}
 	gTweaks.registerVariable("PrefetchXorStripes", gPrefetchXorStripes);
 	gChunkConnector.setRoundTripTime(chunkserverRoundTripTime_ms);
 	gChunkConnector.setSourceIp(fs_getsrcip());
@@ -211,6 +242,9 @@ void read_data_init(uint32_t retries,
 	gTweaks.registerVariable("CacheExpirationTime", gCacheExpirationTime_ms);
 	gTweaks.registerVariable("ReadaheadMaxWindowSize", gReadaheadMaxWindowSize);
 	gTweaks.registerVariable("ReadChunkPrepare", ChunkReader::preparations);
+	gTweaks.registerVariable("ChunkLocationPrefetch", gChunkLocationPrefetch);
+	gTweaks.registerVariable("ChunkLocationCacheHits", ReadChunkLocator::cacheHits);
+	gTweaks.registerVariable("ChunkLocationCacheMisses", ReadChunkLocator::cacheMisses);
 	gTweaks.registerVariable("ReqExecutedTotal", ReadPlanExecutor::executions_total_);
 	gTweaks.registerVariable("ReqExecutedUsingAll", ReadPlanExecutor::executions_with_additional_operations_);
 	gTweaks.registerVariable("ReqFinishedUsingAll", ReadPlanExecutor::executions_finished_by_additional_operations_);
@@ -225,6 +259,7 @@ void read_data_term(void) {
 	}
 
 	pthread_join(delayedOpsThread,NULL);
+	gTraceDumper.reset();
 	for (rr = rdhead ; rr ; rr = rrn) {
 		rrn = rr->next;
 		delete rr;
@@ -237,6 +272,7 @@ void read_data_term(void) {
 
 void read_inode_ops(uint32_t inode) { // attributes of inode have been changed - force reconnect and clear cache
 	readrec *rrec;
+	gChunkLocationCache.invalidate(inode);
 	std::unique_lock<std::mutex> lock(gMutex);
 	for (rrec = rdinodemap[MAPINDX(inode)] ; rrec ; rrec=rrec->mapnext) {
 		if (rrec->inode == inode) {
@@ -315,6 +351,11 @@ static int read_to_buffer(readrec *rrec, uint64_t current_offset, uint64_t bytes
 			current_offset += bytes_read_from_chunk;
 			bytes_to_read -= bytes_read_from_chunk;
 			if (bytes_read_from_chunk < size_in_chunk) {
+				if (rrec->reader.isLocationCached()) {
+					// length of the file could have changed since the location was cached
+					force_prepare = true;
+					continue;
+				}
 				// end of file
 				break;
 			}
@@ -364,6 +405,8 @@ int read_data(void *rr, uint64_t offset, uint32_t size, ReadCache::Result &ret)
 	uint64_t bytes_to_read_left = std::max<uint64_t>(size, rrec->readahead_adviser.window()) - (request_offset - offset);
 	bytes_to_read_left = (bytes_to_read_left + MFSBLOCKSIZE - 1) / MFSBLOCKSIZE * MFSBLOCKSIZE;
 
+	tracing::TraceScope trace(tracing::newTraceId());
+	tracing::ScopedSpan span("mount.read", rrec->inode);
 	uint64_t bytes_read = 0;
 	int err = read_to_buffer(rrec, request_offset, bytes_to_read_left, result.inputBuffer(), &bytes_read);
 	if (err) {
@@ -22,6 +22,7 @@
 
 #include <inttypes.h>
 
+#include "common/connection_pool.h"
 #include "mount/chunk_locator.h"
 #include "mount/readdata_cache.h"
 
@@ -29,6 +30,10 @@ uint32_t read_data_get_wave_read_timeout_ms();
 uint32_t read_data_get_connect_timeout_ms();
 uint32_t read_data_get_total_read_timeout_ms();
 bool read_data_get_prefetchxorstripes();
+uint32_t read_data_get_chunk_location_prefetch();
+
+/// Pool of idle connections to chunkservers, used both for reading and writing
+ConnectionPool& read_data_get_connection_pool();
 
 void read_inode_ops(uint32_t inode);
 void* read_data_new(uint32_t inode);
@@ -43,5 +48,9 @@ void read_data_init(uint32_t retries,
 		uint32_t cache_expiration_time_ms,
 		uint32_t readahead_max_window_size_kB,
 		bool prefetchXorStripes,
-		double bandwidth_overuse);
+		double bandwidth_overuse,
+		uint32_t chunk_location_cache_size,
+		uint32_t chunk_location_prefetch,
+		uint32_t trace_sampling_period = 0,
+		const char *trace_file = nullptr);
 void read_data_term(void);
@@ -24,6 +24,8 @@
 #include "common/massert.h"
 #include "protocol/MFSCommunication.h"
 
+WriteCacheBlockPool gWriteCacheBlockPool(0);
+
 WriteCacheBlock::WriteCacheBlock(uint32_t chunkIndex, uint32_t blockIndex, Type type)
 		: chunkIndex(chunkIndex),
 		  blockIndex(blockIndex),
@@ -31,7 +33,7 @@ WriteCacheBlock::WriteCacheBlock(uint32_t chunkIndex, uint32_t blockIndex, Type
 		  to(0),
 		  type(type) {
 	sassert(blockIndex < MFSBLOCKSINCHUNK);
-	blockData = new uint8_t[MFSBLOCKSIZE];
+	blockData = gWriteCacheBlockPool.get();
 }
 
 WriteCacheBlock::WriteCacheBlock(WriteCacheBlock&& block) noexcept {
@@ -58,7 +60,7 @@ WriteCacheBlock &WriteCacheBlock::operator=(WriteCacheBlock &&block) {
 
 WriteCacheBlock::~WriteCacheBlock() {
 	if (blockData != nullptr) {
-		delete[] blockData;
+		gWriteCacheBlockPool.put(blockData);
 	}
 }
 
@@ -101,3 +103,56 @@ const uint8_t* WriteCacheBlock::data() const {
 uint8_t* WriteCacheBlock::data() {
 	return blockData + from;
 }
+
+WriteCacheBlockPool::WriteCacheBlockPool(uint32_t maxFreeBuffers)
+		: maxFreeBuffers_(maxFreeBuffers) {
+}
+
+WriteCacheBlockPool::~WriteCacheBlockPool() {
+	for (uint8_t* buffer : freeBuffers_) {
+		delete[] buffer;
+	}
+}
+
+uint8_t* WriteCacheBlockPool::get() {
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (!freeBuffers_.empty()) {
+			uint8_t* buffer = freeBuffers_.back();
+			freeBuffers_.pop_back();
+			return buffer;
+		}
+	}
+	return new uint8_t[MFSBLOCKSIZE];
+}
+
+void WriteCacheBlockPool::put(uint8_t* buffer) {
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (freeBuffers_.size() < maxFreeBuffers_) {
+			freeBuffers_.push_back(buffer);
+			return;
+		}
+	}
+	delete[] buffer;
+}
+
+void WriteCacheBlockPool::setMaxFreeBuffers(uint32_t maxFreeBuffers) {
+	std::vector<uint8_t*> excess;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		maxFreeBuffers_ = maxFreeBuffers;
+		if (freeBuffers_.size() > maxFreeBuffers_) {
+			excess.assign(freeBuffers_.begin() + maxFreeBuffers_, freeBuffers_.end());
+			freeBuffers_.resize(maxFreeBuffers_);
+		}
+	}
+	for (uint8_t* buffer : excess) {
+		delete[] buffer;
+	}
+}
+
+uint32_t WriteCacheBlockPool::freeBuffers() const {
+	std::unique_lock<std::mutex> lock(mutex_);
+	return freeBuffers_.size();
+}
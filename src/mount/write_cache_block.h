@@ -21,6 +21,8 @@
 #include "common/platform.h"
 
 #include <cstdint>
+#include <mutex>
+#include <vector>
 
 struct WriteCacheBlock {
 public:
@@ -51,3 +53,36 @@ public:
 	const uint8_t* data() const;
 	uint8_t* data();
 };
+
+/**
+ * A pool of buffers for data of WriteCacheBlock objects.
+ *
+ * Buffers of released blocks are kept for reuse, so that writing doesn't allocate and free
+ * a MFSBLOCKSIZE buffer for each block. At most \p maxFreeBuffers buffers are kept.
+ */
+class WriteCacheBlockPool {
+public:
+	explicit WriteCacheBlockPool(uint32_t maxFreeBuffers);
+	WriteCacheBlockPool(const WriteCacheBlockPool&) = delete;
+	~WriteCacheBlockPool();
+	WriteCacheBlockPool& operator=(const WriteCacheBlockPool&) = delete;
+
+	/// Returns a buffer of MFSBLOCKSIZE bytes, reusing a free one if possible
+	uint8_t* get();
+
+	/// Gives back a buffer obtained using \p get
+	void put(uint8_t* buffer);
+
+	/// Changes the number of kept buffers, freeing the ones which exceed the new limit
+	void setMaxFreeBuffers(uint32_t maxFreeBuffers);
+
+	uint32_t freeBuffers() const;
+
+private:
+	mutable std::mutex mutex_;
+	std::vector<uint8_t*> freeBuffers_;
+	uint32_t maxFreeBuffers_;
+};
+
+/// Pool used by all WriteCacheBlock objects, configured by write_data_init
+extern WriteCacheBlockPool gWriteCacheBlockPool;
@@ -0,0 +1,63 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/write_cache_block.h"
+
+#include <gtest/gtest.h>
+
+#include "protocol/MFSCommunication.h"
+
+TEST(WriteCacheBlockPoolTests, ReusesBuffers) {
+	WriteCacheBlockPool pool(2);
+	uint8_t* a = pool.get();
+	uint8_t* b = pool.get();
+	uint8_t* c = pool.get();
+	EXPECT_EQ(0U, pool.freeBuffers());
+	pool.put(a);
+	pool.put(b);
+	pool.put(c);
+	EXPECT_EQ(2U, pool.freeBuffers());
+
+	uint8_t* d = pool.get();
+	EXPECT_TRUE(d == a || d == b);
+	pool.put(d);
+
+	pool.setMaxFreeBuffers(1);
+	EXPECT_EQ(1U, pool.freeBuffers());
+	pool.setMaxFreeBuffers(0);
+	EXPECT_EQ(0U, pool.freeBuffers());
+	pool.put(pool.get());
+	EXPECT_EQ(0U, pool.freeBuffers());
+}
+
+TEST(WriteCacheBlockTests, ExpandAndMove) {
+	WriteCacheBlock block(1, 2, WriteCacheBlock::kWritableBlock);
+	const uint8_t data[] = {1, 2, 3, 4};
+	EXPECT_TRUE(block.expand(10, 14, data));
+	EXPECT_TRUE(block.expand(14, 16, data));
+	EXPECT_FALSE(block.expand(20, 24, data));
+	EXPECT_EQ(6U, block.size());
+	EXPECT_EQ(2U * MFSBLOCKSIZE + 10, block.offsetInChunk());
+
+	WriteCacheBlock moved(std::move(block));
+	EXPECT_EQ(0U, block.size());
+	EXPECT_EQ(6U, moved.size());
+	EXPECT_EQ(3, moved.data()[2]);
+	EXPECT_EQ(1, moved.data()[4]);
+}
@@ -24,6 +24,7 @@
 
 #include "common/crc.h"
 #include "common/lizardfs_version.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
 #include "mount/exceptions.h"
 #include "protocol/cltocs.h"
@@ -31,6 +32,9 @@
 
 const uint32_t kReceiveBufferSize = 1024;
 
+/// Maximum number of packets passed to the kernel in a single write
+const uint32_t kMaxPacketsPerWrite = 32;
+
 WriteExecutor::WriteExecutor(ChunkserverStats& chunkserverStats,
 		const NetworkAddress& headAddress, uint32_t chunkserver_version, int headFd,
 		uint32_t responseTimeout_ms, uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType)
@@ -42,6 +46,7 @@ WriteExecutor::WriteExecutor(ChunkserverStats& chunkserverStats,
 		  chainHead_(headAddress),
 		  chunkserver_version_(chunkserver_version),
 		  chainHeadFd_(headFd),
+		  packetsInBufferWriter_(0),
 		  receiveBuffer_(kReceiveBufferSize),
 		  unconfirmedPackets_(0),
 		  responseTimeout_(std::chrono::milliseconds(responseTimeout_ms)) {
@@ -79,6 +84,9 @@ void WriteExecutor::addInitPacket() {
 		}
 		cltocs::writeInit::serialize(buffer, chunkId_, chunkVersion_,
 		                             static_cast<legacy::ChunkPartType>(chunkType_), legacy_chain);
+	} else if (tracing::currentTraceId() != 0 && chunkserver_version_ >= kFirstTracingVersion) {
+		cltocs::writeInit::serialize(buffer, chunkId_, chunkVersion_, chunkType_, chain_,
+				tracing::currentTraceId());
 	} else {
 		cltocs::writeInit::serialize(buffer, chunkId_, chunkVersion_, chunkType_, chain_);
 	}
@@ -117,10 +125,16 @@ void WriteExecutor::sendData() {
 		if (pendingPackets_.empty()) {
 			return;
 		}
-		const Packet& packet = pendingPackets_.front();
-		bufferWriter_.addBufferToSend(packet.buffer.data(), packet.buffer.size());
-		if (packet.data != nullptr) {
-			bufferWriter_.addBufferToSend(packet.data, packet.dataSize);
+		// Headers and data of many packets are sent using one writev, data is not copied
+		for (const Packet& packet : pendingPackets_) {
+			if (packetsInBufferWriter_ == kMaxPacketsPerWrite) {
+				break;
+			}
+			bufferWriter_.addBufferToSend(packet.buffer.data(), packet.buffer.size());
+			if (packet.data != nullptr) {
+				bufferWriter_.addBufferToSend(packet.data, packet.dataSize);
+			}
+			++packetsInBufferWriter_;
 		}
 	}
 
@@ -133,7 +147,9 @@ void WriteExecutor::sendData() {
 	}
 	if (!bufferWriter_.hasDataToSend()) {
 		bufferWriter_.reset();
-		pendingPackets_.pop_front();
+		for (; packetsInBufferWriter_ > 0; --packetsInBufferWriter_) {
+			pendingPackets_.pop_front();
+		}
 	}
 }
 
@@ -112,6 +112,9 @@ private:
 	const int chainHeadFd_;
 	std::list<Packet> pendingPackets_;
 	MultiBufferWriter bufferWriter_;
+
+	/// Number of packets from the beginning of pendingPackets_ added to bufferWriter_
+	uint32_t packetsInBufferWriter_;
 	MessageReceiveBuffer receiveBuffer_;
 
 	/// Number of WRITE_STATUS messages that are expected to be received from the chunkserver
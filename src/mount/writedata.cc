@@ -48,6 +48,7 @@
 #include "common/slogger.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
+#include "common/tracing.h"
 #include "devtools/request_log.h"
 #include "mount/chunk_writer.h"
 #include "mount/exceptions.h"
@@ -229,8 +230,8 @@ static std::vector<pthread_t> write_worker_th;
 static void* jqueue;
 static std::list<DelayedQueueEntry> delayedQueue;
 
-static ConnectionPool gChunkserverConnectionPool;
-static ChunkConnectorUsingPool gChunkConnector(gChunkserverConnectionPool);
+static ChunkConnectorUsingPool gChunkConnector(read_data_get_connection_pool(), 0,
+		&globalChunkserverStats);
 
 void write_cb_release_blocks(uint32_t count, Glock&) {
 	freecacheblocks += count;
@@ -433,6 +434,8 @@ void InodeChunkWriter::processJob(inodedata* inodeData) {
 	lock.unlock();
 
 	/*  Process the job */
+	tracing::TraceScope trace(tracing::newTraceId());
+	tracing::ScopedSpan span("mount.write_chunk", inodeData_->inode);
 	ChunkWriter writer(globalChunkserverStats, gChunkConnector, inodeData_->newDataInChainPipe[0]);
 	wholeOperationTimer.reset();
 	std::unique_ptr<WriteChunkLocator> locator = std::move(inodeData_->locator);
@@ -685,6 +688,7 @@ void write_data_init(uint32_t cachesize, uint32_t retries, uint32_t workers,
 	}
 
 	freecacheblocks = cacheblockcount;
+	gWriteCacheBlockPool.setMaxFreeBuffers(cacheblockcount);
 	gCachePerInodePercentage = cachePerInodePercentage;
 
 	idhash = (inodedata**) malloc(sizeof(inodedata*) * IDHASHSIZE);
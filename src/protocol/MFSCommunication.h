@@ -468,6 +468,14 @@ enum class SugidClearMode {
 #define LIZ_MLTOMA_CLTOMA_PORT (1000U + 69)
 /// port:16
 
+// 0x42E
+#define LIZ_MATOML_METACHANGES_LOG_BATCH (1000U + 70)
+/// version==0 firstlogversion:64 metadataversion:64 entries:(N:32 [logdata:STRING]*N)
+
+// 0x42F
+#define LIZ_MLTOMA_METACHANGES_LOG_ACK (1000U + 71)
+/// version==0 lastlogversion:64
+
 // CHUNKSERVER <-> MASTER
 
 // 0x0064
@@ -690,6 +698,14 @@ enum class SugidClearMode {
 /// version==0 chunkid:64 chunktype:8 status:8
 /// version==1 chunkid:64 chunktype:16 status:8
 
+// 0x0494
+#define LIZ_MATOCS_GET_LOAD (1000U + 172U)
+/// -
+
+// 0x0495
+#define LIZ_CSTOMA_GET_LOAD (1000U + 173U)
+/// load:32
+
 // CHUNKSERVER <-> CLIENT/CHUNKSERVER
 
 // 0x00C8
@@ -708,6 +724,7 @@ enum class SugidClearMode {
 #define LIZ_CLTOCS_READ (1000U + 200U)
 /// version==0 chunkid:64 chunkversion:32 chunktype:8 offset:32 size:32
 /// version==1 chunkid:64 chunkversion:32 chunktype:16 offset:32 size:32
+/// version==2 chunkid:64 chunkversion:32 chunktype:16 offset:32 size:32 traceid:64
 
 // 0x04B1
 #define LIZ_CSTOCL_READ_STATUS (1000U + 201U)
@@ -730,6 +747,7 @@ enum class SugidClearMode {
 #define LIZ_CLTOCS_WRITE_INIT (1000U + 210U)
 /// version==0 chunkid:64 chunkversion:32 chunktype:8 chain:(N * [ip:32 port:16])
 /// version==1 chunkid:64 chunkversion:32 chunktype:16 chain:(N * [ip:32 port:16])
+/// version==2 chunkid:64 chunkversion:32 chunktype:16 chain:(N * [ip:32 port:16]) traceid:64
 
 // 0x00D3
 #define CSTOCL_WRITE_STATUS (PROTO_BASE+211)
@@ -1082,7 +1100,8 @@ enum class SugidClearMode {
 
 //0x0598
 #define LIZ_CLTOMA_FUSE_READ_CHUNK (1000U + 432U)
-/// msgid:32 inode:32 chunkindex:32
+/// version==0 msgid:32 inode:32 chunkindex:32
+/// version==1 msgid:32 inode:32 chunkindex:32 traceid:64
 
 //0x0599
 #define LIZ_MATOCL_FUSE_READ_CHUNK (1000U + 433U)
@@ -1102,6 +1121,7 @@ enum class SugidClearMode {
 // 0x059A
 #define LIZ_CLTOMA_FUSE_WRITE_CHUNK (1000U + 434U)
 /// version==0 msgid:32 inode:32 chunkindex:32 lockid:32
+/// version==1 msgid:32 inode:32 chunkindex:32 lockid:32 traceid:64
 
 // 0x059B
 #define LIZ_MATOCL_FUSE_WRITE_CHUNK (1000U + 435U)
@@ -1778,8 +1798,79 @@ enum class SugidClearMode {
 #define LIZ_MATOCL_MANAGE_LOCKS_UNLOCK (1000U + 582U)
 /// status:8
 
+// 0x62F
+#define LIZ_CLTOMA_FUSE_READ_CHUNKS (1000U + 583U)
+/// version==0 msgid:32 inode:32 firstchunkindex:32 count:32
+/// version==1 msgid:32 inode:32 firstchunkindex:32 count:32 traceid:64
+
+// 0x630
+#define LIZ_MATOCL_FUSE_READ_CHUNKS (1000U + 584U)
+/// version==0 msgid:32 status:8
+/// version==1 msgid:32 filelength:64 chunks:(N * [chunkid:64 chunkversion:32 locations:(M * [ip:32 port:16 chunktype:16])])
+
+// 0x631
+#define LIZ_CLTOMA_LIST_DEFECTIVE_DIRECTORIES (1000U + 585U)
+/// inode:32
+
+// 0x632
+#define LIZ_MATOCL_LIST_DEFECTIVE_DIRECTORIES (1000U + 586U)
+/// status:8 directories:(vector<inode:32 path:STDSTRING unavailablefiles:32 undergoalfiles:32>)
+
+// 0x633
+#define LIZ_CLTOMA_FUSE_CACHE_LEASE (1000U + 587U)
+/// msgid:32 leasetime:32
+
+// 0x634
+#define LIZ_MATOCL_FUSE_CACHE_LEASE (1000U + 588U)
+/// msgid:32 leasetime:32 (0 - leases disabled)
+
+// 0x635
+#define LIZ_MATOCL_FUSE_INVALIDATE_CACHE (1000U + 589U)
+/// inodes:(vector<inode:32>)
+
+// 0x636
+#define LIZ_CLTOMA_FUSE_COMPOUND (1000U + 590U)
+/// msgid:32 uid:32 gid:32 operations:(vector<CompoundOperation>)
+
+// 0x637
+#define LIZ_MATOCL_FUSE_COMPOUND (1000U + 591U)
+/// version==0 msgid:32 status:8
+/// version==1 msgid:32 results:(vector<CompoundResult>)
+
+// 0x638
+#define LIZ_CLTOMA_METRICS (1000U + 592U)
+/// -
+
+// 0x639
+#define LIZ_MATOCL_METRICS (1000U + 593U)
+/// metrics:STDSTRING
+
+// 0x63A
+#define LIZ_CLTOMA_METADATASERVER_REPLICATION_LAG (1000U + 594U)
+/// msgid:32
+
+// 0x63B
+#define LIZ_MATOCL_METADATASERVER_REPLICATION_LAG (1000U + 595U)
+/// msgid:32 lagversions:64 lagseconds:32
+
+// 0x63C
+#define LIZ_CLTOMA_METADATASERVER_REGISTRATION_PROGRESS (1000U + 596U)
+/// msgid:32
+
+// 0x63D
+#define LIZ_MATOCL_METADATASERVER_REGISTRATION_PROGRESS (1000U + 597U)
+/// msgid:32 registeringservers:32 pendingchunks:64
+
 // CHUNKSERVER STATS
 
+// 0x0642
+#define LIZ_CLTOCS_METRICS (1000U + 602U)
+/// -
+
+// 0x0643
+#define LIZ_CSTOCL_METRICS (1000U + 603U)
+/// metrics:STDSTRING
+
 // 0x0258
 #define CLTOCS_HDD_LIST_V2 (PROTO_BASE+600)
 /// -
@@ -0,0 +1,40 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <tuple>
+#include <vector>
+
+#include "common/chunk_type_with_address.h"
+#include "common/serialization_macros.h"
+
+// Location of a single chunk of a file, as sent in LIZ_MATOCL_FUSE_READ_CHUNKS
+SERIALIZABLE_CLASS_BEGIN(ChunkLocationsEntry)
+SERIALIZABLE_CLASS_BODY(ChunkLocationsEntry,
+		uint64_t, chunkId,
+		uint32_t, chunkVersion,
+		std::vector<ChunkTypeWithAddress>, locations)
+
+	bool operator==(const ChunkLocationsEntry& other) const {
+		return std::make_tuple(chunkId, chunkVersion, locations)
+				== std::make_tuple(other.chunkId, other.chunkVersion, other.locations);
+	}
+SERIALIZABLE_CLASS_END;
@@ -37,12 +37,17 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		uint64_t, chunkId, uint32_t, chunkVersion, ChunkPartType, chunkType,
 		uint32_t, readOffset, uint32_t, readSize)
 
+// LIZ_CLTOCS_METRICS
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltocs, metrics, LIZ_CLTOCS_METRICS, 0)
+
 namespace cltocs {
 
 namespace read {
 
 const PacketVersion kStandardAndXorChunks = 0;
 const PacketVersion kECChunks = 1;
+const PacketVersion kTracedECChunks = 2;
 
 inline void serialize(std::vector<uint8_t>& destination,
 		uint64_t chunkId, uint32_t chunkVersion, legacy::ChunkPartType chunkType,
@@ -74,12 +79,28 @@ inline void deserialize(const uint8_t* source, uint32_t sourceSize,
 			chunkId, chunkVersion, chunkType, readOffset, readSize);
 }
 
+inline void serialize(std::vector<uint8_t>& destination,
+		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
+		uint32_t readOffset, uint32_t readSize, uint64_t traceId) {
+	serializePacket(destination, LIZ_CLTOCS_READ, kTracedECChunks,
+			chunkId, chunkVersion, chunkType, readOffset, readSize, traceId);
+}
+
+inline void deserialize(const uint8_t* source, uint32_t sourceSize,
+		uint64_t& chunkId, uint32_t& chunkVersion, ChunkPartType& chunkType,
+		uint32_t& readOffset, uint32_t& readSize, uint64_t& traceId) {
+	verifyPacketVersionNoHeader(source, sourceSize, kTracedECChunks);
+	deserializeAllPacketDataNoHeader(source, sourceSize,
+			chunkId, chunkVersion, chunkType, readOffset, readSize, traceId);
+}
+
 } // namespace read
 
 namespace writeInit {
 
 const PacketVersion kStandardAndXorChunks = 0;
 const PacketVersion kECChunks = 1;
+const PacketVersion kTracedECChunks = 2;
 
 inline void serialize(std::vector<uint8_t>& destination,
 		uint64_t chunkId, uint32_t chunkVersion, legacy::ChunkPartType chunkType,
@@ -111,6 +132,21 @@ inline void deserialize(const uint8_t* source, uint32_t sourceSize,
 			chunkId, chunkVersion, chunkType, chain);
 }
 
+inline void serialize(std::vector<uint8_t>& destination,
+		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
+		const std::vector<ChunkTypeWithAddress>& chain, uint64_t traceId) {
+	serializePacket(destination, LIZ_CLTOCS_WRITE_INIT, kTracedECChunks,
+			chunkId, chunkVersion, chunkType, chain, traceId);
+}
+
+inline void deserialize(const uint8_t* source, uint32_t sourceSize,
+		uint64_t& chunkId, uint32_t& chunkVersion, ChunkPartType& chunkType,
+		std::vector<ChunkTypeWithAddress>& chain, uint64_t& traceId) {
+	verifyPacketVersionNoHeader(source, sourceSize, kTracedECChunks);
+	deserializeAllPacketDataNoHeader(source, sourceSize,
+			chunkId, chunkVersion, chunkType, chain, traceId);
+}
+
 } // namespace writeInit
 
 namespace writeData {
@@ -49,6 +49,32 @@ TEST(CltocsCommunicationTests, Read) {
 	LIZARDFS_VERIFY_INOUT_PAIR(readSize);
 }
 
+TEST(CltocsCommunicationTests, ReadTraced) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, chunkId, 0x0123456789ABCDEF, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, chunkVersion, 0x01234567, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(ChunkPartType, chunkType, xor_p_of_7, standard);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, readOffset, 2 * MFSBLOCKSIZE, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, readSize, 5 * MFSBLOCKSIZE, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, traceId, 0xFEDCBA9876543210, 0);
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(cltocs::read::serialize(buffer,
+			chunkIdIn, chunkVersionIn, chunkTypeIn, readOffsetIn, readSizeIn, traceIdIn));
+
+	verifyHeader(buffer, LIZ_CLTOCS_READ);
+	removeHeaderInPlace(buffer);
+	verifyVersion(buffer, cltocs::read::kTracedECChunks);
+	ASSERT_NO_THROW(cltocs::read::deserialize(buffer.data(), buffer.size(),
+			chunkIdOut, chunkVersionOut, chunkTypeOut, readOffsetOut, readSizeOut, traceIdOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(chunkId);
+	LIZARDFS_VERIFY_INOUT_PAIR(chunkVersion);
+	LIZARDFS_VERIFY_INOUT_PAIR(chunkType);
+	LIZARDFS_VERIFY_INOUT_PAIR(readOffset);
+	LIZARDFS_VERIFY_INOUT_PAIR(readSize);
+	LIZARDFS_VERIFY_INOUT_PAIR(traceId);
+}
+
 TEST(CltocsCommunicationTests, WriteInit) {
 	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, chunkId,  0x987654321, 0);
 	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, chunkVersion, 0x01234567, 0);
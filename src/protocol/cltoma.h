@@ -26,6 +26,7 @@
 #include "common/acl_type.h"
 #include "common/moosefs_string.h"
 #include "common/serialization_macros.h"
+#include "protocol/compound_operation.h"
 #include "protocol/lock_info.h"
 #include "protocol/MFSCommunication.h"
 #include "protocol/packet.h"
@@ -126,6 +127,17 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		cltoma, metadataserverStatus, LIZ_CLTOMA_METADATASERVER_STATUS, 0,
 		uint32_t, messageId)
 
+// LIZ_CLTOMA_METADATASERVER_REPLICATION_LAG
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, metadataserverReplicationLag, LIZ_CLTOMA_METADATASERVER_REPLICATION_LAG, 0,
+		uint32_t, messageId)
+
+// LIZ_CLTOMA_METADATASERVER_REGISTRATION_PROGRESS
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, metadataserverRegistrationProgress,
+		LIZ_CLTOMA_METADATASERVER_REGISTRATION_PROGRESS, 0,
+		uint32_t, messageId)
+
 // LIZ_CLTOMA_METADATASERVERS_LIST
 LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		cltoma, metadataserversList, LIZ_CLTOMA_METADATASERVERS_LIST, 0)
@@ -303,38 +315,109 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		lzfs_locks::Type, type,
 		uint32_t, inode)
 
+LIZARDFS_DEFINE_PACKET_VERSION(cltoma, fuseReadChunks, kUntraced, 0)
+LIZARDFS_DEFINE_PACKET_VERSION(cltoma, fuseReadChunks, kTraced, 1)
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, fuseReadChunks, LIZ_CLTOMA_FUSE_READ_CHUNKS, kUntraced,
+		uint32_t, messageId,
+		uint32_t, inode,
+		uint32_t, firstIndex,
+		uint32_t, count)
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, fuseReadChunks, LIZ_CLTOMA_FUSE_READ_CHUNKS, kTraced,
+		uint32_t, messageId,
+		uint32_t, inode,
+		uint32_t, firstIndex,
+		uint32_t, count,
+		uint64_t, traceId)
+
+// LIZ_CLTOMA_LIST_DEFECTIVE_DIRECTORIES
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, listDefectiveDirectories, LIZ_CLTOMA_LIST_DEFECTIVE_DIRECTORIES, 0,
+		uint32_t, inode)
+
+// LIZ_CLTOMA_FUSE_CACHE_LEASE
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, fuseCacheLease, LIZ_CLTOMA_FUSE_CACHE_LEASE, 0,
+		uint32_t, messageId,
+		uint32_t, leaseTime)
+
+// LIZ_CLTOMA_FUSE_COMPOUND
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, fuseCompound, LIZ_CLTOMA_FUSE_COMPOUND, 0,
+		uint32_t, messageId,
+		uint32_t, uid,
+		uint32_t, gid,
+		std::vector<CompoundOperation>, operations)
+
+// LIZ_CLTOMA_METRICS
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, metrics, LIZ_CLTOMA_METRICS, 0)
+
 namespace cltoma {
 
 namespace fuseReadChunk {
 
+const PacketVersion kUntraced = 0;
+const PacketVersion kTraced = 1;
+
 inline void serialize(std::vector<uint8_t>& destination,
 		uint32_t messageId, uint32_t inode, uint32_t chunkIndex) {
-	serializePacket(destination, LIZ_CLTOMA_FUSE_READ_CHUNK, 0, messageId, inode,
+	serializePacket(destination, LIZ_CLTOMA_FUSE_READ_CHUNK, kUntraced, messageId, inode,
 			chunkIndex);
 }
 
 inline void deserialize(const std::vector<uint8_t>& source,
 		uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex) {
-	verifyPacketVersionNoHeader(source, 0);
+	verifyPacketVersionNoHeader(source, kUntraced);
 	deserializeAllPacketDataNoHeader(source, messageId, inode, chunkIndex);
 }
 
+inline void serialize(std::vector<uint8_t>& destination,
+		uint32_t messageId, uint32_t inode, uint32_t chunkIndex, uint64_t traceId) {
+	serializePacket(destination, LIZ_CLTOMA_FUSE_READ_CHUNK, kTraced, messageId, inode,
+			chunkIndex, traceId);
+}
+
+inline void deserialize(const std::vector<uint8_t>& source,
+		uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint64_t& traceId) {
+	verifyPacketVersionNoHeader(source, kTraced);
+	deserializeAllPacketDataNoHeader(source, messageId, inode, chunkIndex, traceId);
+}
+
 } // namespace fuseReadChunk
 
 namespace fuseWriteChunk {
 
+const PacketVersion kUntraced = 0;
+const PacketVersion kTraced = 1;
+
 inline void serialize(std::vector<uint8_t>& destination,
 		uint32_t messageId, uint32_t inode, uint32_t chunkIndex, uint32_t lockId) {
-	serializePacket(destination, LIZ_CLTOMA_FUSE_WRITE_CHUNK, 0,
+	serializePacket(destination, LIZ_CLTOMA_FUSE_WRITE_CHUNK, kUntraced,
 			messageId, inode, chunkIndex, lockId);
 }
 
 inline void deserialize(const std::vector<uint8_t>& source,
 		uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId) {
-	verifyPacketVersionNoHeader(source, 0);
+	verifyPacketVersionNoHeader(source, kUntraced);
 	deserializeAllPacketDataNoHeader(source, messageId, inode, chunkIndex, lockId);
 }
 
+inline void serialize(std::vector<uint8_t>& destination,
+		uint32_t messageId, uint32_t inode, uint32_t chunkIndex, uint32_t lockId,
+		uint64_t traceId) {
+	serializePacket(destination, LIZ_CLTOMA_FUSE_WRITE_CHUNK, kTraced,
+			messageId, inode, chunkIndex, lockId, traceId);
+}
+
+inline void deserialize(const std::vector<uint8_t>& source,
+		uint32_t& messageId, uint32_t& inode, uint32_t& chunkIndex, uint32_t& lockId,
+		uint64_t& traceId) {
+	verifyPacketVersionNoHeader(source, kTraced);
+	deserializeAllPacketDataNoHeader(source, messageId, inode, chunkIndex, lockId, traceId);
+}
+
 } // namespace fuseWriteChunk
 
 namespace fuseWriteChunkEnd {
@@ -41,6 +41,28 @@ TEST(CltomaCommunicationTests, FuseReadChunk) {
 	LIZARDFS_VERIFY_INOUT_PAIR(index);
 }
 
+TEST(CltomaCommunicationTests, FuseReadChunkTraced) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId, 512, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, inode, 112, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, index, 1583, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, traceId, 0x0123456789ABCDEF, 0);
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(cltoma::fuseReadChunk::serialize(buffer,
+			messageIdIn, inodeIn, indexIn, traceIdIn));
+
+	verifyHeader(buffer, LIZ_CLTOMA_FUSE_READ_CHUNK);
+	removeHeaderInPlace(buffer);
+	verifyVersion(buffer, cltoma::fuseReadChunk::kTraced);
+	ASSERT_NO_THROW(cltoma::fuseReadChunk::deserialize(buffer,
+			messageIdOut, inodeOut, indexOut, traceIdOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(messageId);
+	LIZARDFS_VERIFY_INOUT_PAIR(inode);
+	LIZARDFS_VERIFY_INOUT_PAIR(index);
+	LIZARDFS_VERIFY_INOUT_PAIR(traceId);
+}
+
 TEST(CltomaCommunicationTests, FuseWriteChunk) {
 	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId, 512, 0);
 	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, inode, 112, 0);
@@ -172,3 +194,52 @@ TEST(CltomaCommunicationTests, FuseSetAcl) {
 	EXPECT_EQ(aclIn.extendedAcl->owningGroupMask(), aclOut.extendedAcl->owningGroupMask());
 	EXPECT_EQ(aclIn.extendedAcl->list(), aclOut.extendedAcl->list());
 }
+
+TEST(CltomaCommunicationTests, FuseCompound) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId, 123, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, uid, 789, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, gid, 1011, 0);
+	LIZARDFS_DEFINE_INOUT_VECTOR_PAIR(CompoundOperation, operations) = {
+		CompoundOperation::mknod(5, "file", TYPE_FILE, 0644, 022, 0),
+		CompoundOperation::open(0, 3).withInodeOf(1),
+		CompoundOperation::readChunks(0, 0, 4).withInodeOf(1),
+	};
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(cltoma::fuseCompound::serialize(buffer,
+			messageIdIn, uidIn, gidIn, operationsIn));
+
+	verifyHeader(buffer, LIZ_CLTOMA_FUSE_COMPOUND);
+	removeHeaderInPlace(buffer);
+	ASSERT_NO_THROW(cltoma::fuseCompound::deserialize(buffer.data(), buffer.size(),
+			messageIdOut, uidOut, gidOut, operationsOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(messageId);
+	LIZARDFS_VERIFY_INOUT_PAIR(uid);
+	LIZARDFS_VERIFY_INOUT_PAIR(gid);
+	LIZARDFS_VERIFY_INOUT_PAIR(operations);
+}
+
+TEST(CltomaCommunicationTests, FuseWriteChunkTraced) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId, 512, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, inode, 112, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, index, 1583, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, lockId, 7, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, traceId, 0x0123456789ABCDEF, 0);
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(cltoma::fuseWriteChunk::serialize(buffer,
+			messageIdIn, inodeIn, indexIn, lockIdIn, traceIdIn));
+
+	verifyHeader(buffer, LIZ_CLTOMA_FUSE_WRITE_CHUNK);
+	removeHeaderInPlace(buffer);
+	verifyVersion(buffer, cltoma::fuseWriteChunk::kTraced);
+	ASSERT_NO_THROW(cltoma::fuseWriteChunk::deserialize(buffer,
+			messageIdOut, inodeOut, indexOut, lockIdOut, traceIdOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(messageId);
+	LIZARDFS_VERIFY_INOUT_PAIR(inode);
+	LIZARDFS_VERIFY_INOUT_PAIR(index);
+	LIZARDFS_VERIFY_INOUT_PAIR(lockId);
+	LIZARDFS_VERIFY_INOUT_PAIR(traceId);
+}
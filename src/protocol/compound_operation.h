@@ -0,0 +1,149 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <array>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common/serialization_macros.h"
+#include "protocol/chunk_locations_entry.h"
+
+LIZARDFS_DEFINE_SERIALIZABLE_ENUM_CLASS(CompoundOperationType,
+		kLookup, kGetattr, kMknod, kMkdir, kOpen, kReadChunks)
+
+/*! \brief One step of LIZ_CLTOMA_FUSE_COMPOUND.
+ *
+ * Fields which are not used by the type of the operation are ignored. If inodeSource is N > 0,
+ * the inode returned by the N-th operation of the request is used instead of the inode field,
+ * so for example a file created by the first step may be opened by the second one.
+ */
+SERIALIZABLE_CLASS_BEGIN(CompoundOperation)
+SERIALIZABLE_CLASS_BODY(CompoundOperation,
+		CompoundOperationType, type,
+		uint32_t, inode,
+		uint8_t, inodeSource,
+		std::string, name,
+		uint8_t, nodeType,
+		uint16_t, mode,
+		uint16_t, umask,
+		uint32_t, rdev,
+		uint8_t, flags,
+		uint32_t, firstIndex,
+		uint32_t, count)
+
+	static CompoundOperation lookup(uint32_t parent, const std::string& name) {
+		CompoundOperation op;
+		op.type = CompoundOperationType::kLookup;
+		op.inode = parent;
+		op.name = name;
+		return op;
+	}
+
+	static CompoundOperation getattr(uint32_t inode) {
+		CompoundOperation op;
+		op.type = CompoundOperationType::kGetattr;
+		op.inode = inode;
+		return op;
+	}
+
+	static CompoundOperation mknod(uint32_t parent, const std::string& name, uint8_t nodeType,
+			uint16_t mode, uint16_t umask, uint32_t rdev) {
+		CompoundOperation op;
+		op.type = CompoundOperationType::kMknod;
+		op.inode = parent;
+		op.name = name;
+		op.nodeType = nodeType;
+		op.mode = mode;
+		op.umask = umask;
+		op.rdev = rdev;
+		return op;
+	}
+
+	static CompoundOperation mkdir(uint32_t parent, const std::string& name,
+			uint16_t mode, uint16_t umask, bool copysgid) {
+		CompoundOperation op;
+		op.type = CompoundOperationType::kMkdir;
+		op.inode = parent;
+		op.name = name;
+		op.mode = mode;
+		op.umask = umask;
+		op.flags = copysgid;
+		return op;
+	}
+
+	static CompoundOperation open(uint32_t inode, uint8_t flags) {
+		CompoundOperation op;
+		op.type = CompoundOperationType::kOpen;
+		op.inode = inode;
+		op.flags = flags;
+		return op;
+	}
+
+	static CompoundOperation readChunks(uint32_t inode, uint32_t firstIndex, uint32_t count) {
+		CompoundOperation op;
+		op.type = CompoundOperationType::kReadChunks;
+		op.inode = inode;
+		op.firstIndex = firstIndex;
+		op.count = count;
+		return op;
+	}
+
+	/// Makes the operation use the inode returned by the given (1-based) operation
+	CompoundOperation& withInodeOf(uint8_t operation) {
+		inodeSource = operation;
+		return *this;
+	}
+
+	bool operator==(const CompoundOperation& other) const {
+		return std::make_tuple(type, inode, inodeSource, name, nodeType, mode, umask, rdev,
+				flags, firstIndex, count)
+				== std::make_tuple(other.type, other.inode, other.inodeSource, other.name,
+				other.nodeType, other.mode, other.umask, other.rdev, other.flags,
+				other.firstIndex, other.count);
+	}
+SERIALIZABLE_CLASS_END;
+
+/*! \brief Result of one step of LIZ_CLTOMA_FUSE_COMPOUND.
+ *
+ * Master stops at the first failed step, which is the last one in the reply. Inode and
+ * attributes are filled by all operations except readChunks, which fills the other fields.
+ */
+SERIALIZABLE_CLASS_BEGIN(CompoundResult)
+	typedef std::array<uint8_t, 35> AttributesArray;
+
+SERIALIZABLE_CLASS_BODY(CompoundResult,
+		uint8_t, status,
+		uint32_t, inode,
+		AttributesArray, attributes,
+		uint64_t, fileLength,
+		std::vector<ChunkLocationsEntry>, chunks)
+
+	bool operator==(const CompoundResult& other) const {
+		return std::make_tuple(status, inode, attributes, fileLength, chunks)
+				== std::make_tuple(other.status, other.inode, other.attributes,
+				other.fileLength, other.chunks);
+	}
+SERIALIZABLE_CLASS_END;
+
+/// Limit of the number of operations in a single compound request
+constexpr uint32_t kMaxCompoundOperations = 64;
@@ -23,6 +23,11 @@
 #include "common/serialization_macros.h"
 #include "protocol/packet.h"
 
+// LIZ_CSTOCL_METRICS
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cstocl, metrics, LIZ_CSTOCL_METRICS, 0,
+		std::string, metrics)
+
 namespace cstocl {
 
 namespace readData {
@@ -81,3 +81,16 @@ TEST(CltocsCommunicationTests, WriteStatus) {
 	LIZARDFS_VERIFY_INOUT_PAIR(writeId);
 	LIZARDFS_VERIFY_INOUT_PAIR(status);
 }
+
+TEST(CstoclCommunicationTests, Metrics) {
+	LIZARDFS_DEFINE_INOUT_PAIR(std::string, metrics, "# TYPE a histogram\na_count 1\n", "");
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(cstocl::metrics::serialize(buffer, metricsIn));
+
+	verifyHeader(buffer, LIZ_CSTOCL_METRICS);
+	removeHeaderInPlace(buffer);
+	ASSERT_NO_THROW(cstocl::metrics::deserialize(buffer.data(), buffer.size(), metricsOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(metrics);
+}
@@ -183,6 +183,10 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		cstoma, chunkDamaged, LIZ_CSTOMA_CHUNK_DAMAGED, kECChunks,
 		std::vector<ChunkWithType>, chunks)
 
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		cstoma, getLoad, LIZ_CSTOMA_GET_LOAD, 0,
+		uint32_t, load)
+
 LIZARDFS_DEFINE_PACKET_VERSION(cstoma, chunkLost, kStandardAndXorChunks, 0)
 LIZARDFS_DEFINE_PACKET_VERSION(cstoma, chunkLost, kECChunks, 1)
 LIZARDFS_DEFINE_PACKET_SERIALIZATION(
@@ -166,3 +166,16 @@ TEST(CstomaCommunicationTests, Replicate) {
 	LIZARDFS_VERIFY_INOUT_PAIR(status);
 	LIZARDFS_VERIFY_INOUT_PAIR(chunkVersion);
 }
+
+TEST(CstomaCommunicationTests, GetLoad) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, load, 1234, 0);
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(cstoma::getLoad::serialize(buffer, loadIn));
+
+	verifyHeader(buffer, LIZ_CSTOMA_GET_LOAD);
+	removeHeaderInPlace(buffer);
+	ASSERT_NO_THROW(cstoma::getLoad::deserialize(buffer, loadOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(load);
+}
@@ -0,0 +1,30 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include "common/serialization_macros.h"
+
+/// Number of defective files found in the subtree of a directory by the loop checking files
+LIZARDFS_DEFINE_SERIALIZABLE_CLASS(DefectiveDirectoryEntry,
+		uint32_t, inode,
+		std::string, path,
+		uint32_t, unavailableFiles,
+		uint32_t, undergoalFiles);
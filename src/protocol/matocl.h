@@ -32,7 +32,10 @@
 #include "common/serialization_macros.h"
 #include "common/serialized_goal.h"
 #include "common/tape_copy_location_info.h"
+#include "protocol/chunk_locations_entry.h"
 #include "protocol/chunkserver_list_entry.h"
+#include "protocol/compound_operation.h"
+#include "protocol/defective_directory_entry.h"
 #include "protocol/lock_info.h"
 #include "protocol/MFSCommunication.h"
 #include "protocol/packet.h"
@@ -154,6 +157,21 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		uint8_t, status,
 		uint64_t, metadataVersion)
 
+// LIZ_MATOCL_METADATASERVER_REPLICATION_LAG
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, metadataserverReplicationLag, LIZ_MATOCL_METADATASERVER_REPLICATION_LAG, 0,
+		uint32_t, messageId,
+		uint64_t, lagVersions,
+		uint32_t, lagSeconds)
+
+// LIZ_MATOCL_METADATASERVER_REGISTRATION_PROGRESS
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, metadataserverRegistrationProgress,
+		LIZ_MATOCL_METADATASERVER_REGISTRATION_PROGRESS, 0,
+		uint32_t, messageId,
+		uint32_t, registeringServers,
+		uint64_t, pendingChunks)
+
 // LIZ_MATOCL_FUSE_GETGOAL
 LIZARDFS_DEFINE_PACKET_VERSION(matocl, fuseGetGoal, kStatusPacketVersion, 0)
 LIZARDFS_DEFINE_PACKET_VERSION(matocl, fuseGetGoal, kResponsePacketVersion, 1)
@@ -369,6 +387,56 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		matocl, manageLocksUnlock, LIZ_MATOCL_MANAGE_LOCKS_UNLOCK, 0,
 		uint8_t, status)
 
+LIZARDFS_DEFINE_PACKET_VERSION(matocl, fuseReadChunks, kStatusPacketVersion, 0)
+LIZARDFS_DEFINE_PACKET_VERSION(matocl, fuseReadChunks, kResponsePacketVersion, 1)
+
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseReadChunks, LIZ_MATOCL_FUSE_READ_CHUNKS, kStatusPacketVersion,
+		uint32_t, messageId,
+		uint8_t, status)
+
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseReadChunks, LIZ_MATOCL_FUSE_READ_CHUNKS, kResponsePacketVersion,
+		uint32_t, messageId,
+		uint64_t, fileLength,
+		std::vector<ChunkLocationsEntry>, chunks)
+
+// LIZ_MATOCL_LIST_DEFECTIVE_DIRECTORIES
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, listDefectiveDirectories, LIZ_MATOCL_LIST_DEFECTIVE_DIRECTORIES, 0,
+		uint8_t, status,
+		std::vector<DefectiveDirectoryEntry>, directories)
+
+// LIZ_MATOCL_FUSE_CACHE_LEASE
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseCacheLease, LIZ_MATOCL_FUSE_CACHE_LEASE, 0,
+		uint32_t, messageId,
+		uint32_t, leaseTime)
+
+// LIZ_MATOCL_FUSE_INVALIDATE_CACHE
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseInvalidateCache, LIZ_MATOCL_FUSE_INVALIDATE_CACHE, 0,
+		std::vector<uint32_t>, inodes)
+
+// LIZ_MATOCL_FUSE_COMPOUND
+LIZARDFS_DEFINE_PACKET_VERSION(matocl, fuseCompound, kStatusPacketVersion, 0)
+LIZARDFS_DEFINE_PACKET_VERSION(matocl, fuseCompound, kResponsePacketVersion, 1)
+
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseCompound, LIZ_MATOCL_FUSE_COMPOUND, kStatusPacketVersion,
+		uint32_t, messageId,
+		uint8_t, status)
+
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseCompound, LIZ_MATOCL_FUSE_COMPOUND, kResponsePacketVersion,
+		uint32_t, messageId,
+		std::vector<CompoundResult>, results)
+
+// LIZ_MATOCL_METRICS
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, metrics, LIZ_MATOCL_METRICS, 0,
+		std::string, metrics)
+
 namespace matocl {
 
 namespace fuseReadChunk {
@@ -72,6 +72,35 @@ TEST(MatoclCommunicationTests, FuseReadChunkStatus) {
 	LIZARDFS_VERIFY_INOUT_PAIR(status);
 }
 
+TEST(MatoclCommunicationTests, FuseReadChunksData) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId,  512, 0);
+	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, fileLength, 124, 0);
+	LIZARDFS_DEFINE_INOUT_VECTOR_PAIR(ChunkLocationsEntry, chunks) = {
+		ChunkLocationsEntry(87, 52, {
+			ChunkTypeWithAddress(NetworkAddress(0xC0A80001, 8080), standard, LIZARDFS_VERSHEX),
+			ChunkTypeWithAddress(NetworkAddress(0xC0A80002, 8081), xor_p_of_6, LIZARDFS_VERSHEX),
+		}),
+		ChunkLocationsEntry(0, 0, {}),
+		ChunkLocationsEntry(89, 1, {
+			ChunkTypeWithAddress(NetworkAddress(0xC0A80004, 8084), xor_5_of_7, LIZARDFS_VERSHEX),
+		}),
+	};
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(matocl::fuseReadChunks::serialize(buffer,
+			messageIdIn, fileLengthIn, chunksIn));
+
+	verifyHeader(buffer, LIZ_MATOCL_FUSE_READ_CHUNKS);
+	removeHeaderInPlace(buffer);
+	verifyVersion(buffer, matocl::fuseReadChunks::kResponsePacketVersion);
+	ASSERT_NO_THROW(matocl::fuseReadChunks::deserialize(buffer,
+			messageIdOut, fileLengthOut, chunksOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(messageId);
+	LIZARDFS_VERIFY_INOUT_PAIR(fileLength);
+	LIZARDFS_VERIFY_INOUT_PAIR(chunks);
+}
+
 TEST(MatoclCommunicationTests, FuseWriteChunkData) {
 	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId,    512, 0);
 	LIZARDFS_DEFINE_INOUT_PAIR(uint64_t, chunkId,      87,  0);
@@ -240,3 +269,47 @@ TEST(MatoclCommunicationTests, FuseSetAcl) {
 	LIZARDFS_VERIFY_INOUT_PAIR(messageId);
 	LIZARDFS_VERIFY_INOUT_PAIR(status);
 }
+
+TEST(MatoclCommunicationTests, FuseCompound) {
+	LIZARDFS_DEFINE_INOUT_PAIR(uint32_t, messageId, 123, 0);
+	LIZARDFS_DEFINE_INOUT_VECTOR_PAIR(CompoundResult, results);
+	CompoundResult created;
+	created.inode = 17;
+	created.attributes.fill(0x5A);
+	CompoundResult located;
+	located.inode = 17;
+	located.fileLength = 124;
+	located.chunks = {
+		ChunkLocationsEntry(87, 52, {
+			ChunkTypeWithAddress(NetworkAddress(0xC0A80001, 8080), standard, LIZARDFS_VERSHEX),
+		}),
+	};
+	CompoundResult failed;
+	failed.status = LIZARDFS_ERROR_EACCES;
+	resultsIn = {created, located, failed};
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(matocl::fuseCompound::serialize(buffer, messageIdIn, resultsIn));
+
+	verifyHeader(buffer, LIZ_MATOCL_FUSE_COMPOUND);
+	removeHeaderInPlace(buffer);
+	verifyVersion(buffer, matocl::fuseCompound::kResponsePacketVersion);
+	ASSERT_NO_THROW(matocl::fuseCompound::deserialize(buffer.data(), buffer.size(),
+			messageIdOut, resultsOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(messageId);
+	LIZARDFS_VERIFY_INOUT_PAIR(results);
+}
+
+TEST(MatoclCommunicationTests, Metrics) {
+	LIZARDFS_DEFINE_INOUT_PAIR(std::string, metrics, "# TYPE a counter\na 1\n", "");
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(matocl::metrics::serialize(buffer, metricsIn));
+
+	verifyHeader(buffer, LIZ_MATOCL_METRICS);
+	removeHeaderInPlace(buffer);
+	ASSERT_NO_THROW(matocl::metrics::deserialize(buffer.data(), buffer.size(), metricsOut));
+
+	LIZARDFS_VERIFY_INOUT_PAIR(metrics);
+}
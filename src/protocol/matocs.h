@@ -133,6 +133,9 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		ChunkPartType, chunkType,
 		std::vector<ChunkTypeWithAddress>, sources)
 
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matocs, getLoad, LIZ_MATOCS_GET_LOAD, 0)
+
 namespace matocs {
 namespace replicateChunk {
 
@@ -20,6 +20,9 @@
 
 #include "common/platform.h"
 
+#include <string>
+#include <vector>
+
 #include "protocol/packet.h"
 #include "common/serialization_macros.h"
 
@@ -43,3 +46,11 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 
 LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		matoml, endSession, LIZ_MATOML_END_SESSION, 0)
+
+// Consecutive changelog entries, starting from firstVersion.
+// metadataVersion is the version of metadata in the master when the packet was sent.
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		matoml, metachangesLogBatch, LIZ_MATOML_METACHANGES_LOG_BATCH, 0,
+		uint64_t, firstVersion,
+		uint64_t, metadataVersion,
+		std::vector<std::string>, entries)
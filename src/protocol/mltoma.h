@@ -38,3 +38,7 @@ LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 LIZARDFS_DEFINE_PACKET_SERIALIZATION(
 		mltoma, matoclport, LIZ_MLTOMA_CLTOMA_PORT, 0,
 		uint16_t, port)
+
+LIZARDFS_DEFINE_PACKET_SERIALIZATION(
+		mltoma, metachangesLogAck, LIZ_MLTOMA_METACHANGES_LOG_ACK, 0,
+		uint64_t, version)
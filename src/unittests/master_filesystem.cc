@@ -0,0 +1,127 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "unittests/master_filesystem.h"
+
+#include <fstream>
+
+#include "common/main.h"
+#include "master/changelog.h"
+#include "master/datacachemgr.h"
+#include "master/chunks.h"
+#include "master/filesystem.h"
+#include "master/filesystem_checksum.h"
+#include "master/filesystem_operations.h"
+#include "master/filesystem_store.h"
+#include "master/hstring_memstorage.h"
+#include "master/restore.h"
+#include "protocol/MFSCommunication.h"
+
+static uint32_t gTime = 1;
+
+// Stubs of the main module, which can't be linked with unit tests
+const std::vector<std::string>& main_get_extra_arguments() {
+	static std::vector<std::string> arguments;
+	return arguments;
+}
+bool main_has_extra_argument(std::string, CaseSensitivity) { return false; }
+void main_destructregister(void (*)(void)) {}
+void main_canexitregister(int (*)(void)) {}
+void main_wantexitregister(void (*)(void)) {}
+void main_reloadregister(void (*)(void)) {}
+void main_pollregister(void (*)(std::vector<pollfd>&), void (*)(const std::vector<pollfd>&)) {}
+void main_eachloopregister(void (*)(void)) {}
+void *main_timeregister(int, uint64_t, uint64_t, void (*)(void)) { return nullptr; }
+void *main_timeregister_ms(uint64_t, void (*)(void)) { return nullptr; }
+void main_make_next_poll_nonblocking() {}
+void main_timeunregister(void*) {}
+int main_timechange(void*, int, uint64_t, uint64_t) { return 0; }
+int main_timechange_ms(void*, uint64_t) { return 0; }
+uint32_t main_time(void) { return gTime; }
+uint64_t main_utime(void) { return gTime * 1000000ULL; }
+uint8_t main_want_to_terminate(void) { return LIZARDFS_STATUS_OK; }
+void main_want_to_reload(void) {}
+
+namespace unittests {
+
+MasterFilesystem::MasterFilesystem()
+		: directory_("/tmp", "master_filesystem"),
+		  changelogPath_(directory_.name() + "/changelog.mfs"),
+		  changelogRead_(0),
+		  creationTime_(gTime) {
+	hstorage::Storage::reset(new hstorage::MemStorage());
+	dcm_init();
+	changelog_init(changelogPath_, 0, 50);
+	fs_strinit();
+	chunk_strinit();
+	fs_new();
+}
+
+MasterFilesystem::~MasterFilesystem() {
+	fs_unload();
+	changelog_rotate();
+	hstorage::Storage::reset();
+}
+
+void MasterFilesystem::reset() {
+	uint32_t ts = gTime;
+	gTime = creationTime_;
+	fs_unload();
+	fs_strinit();
+	chunk_strinit();
+	fs_new();
+	gTime = ts;
+}
+
+void MasterFilesystem::setTime(uint32_t ts) {
+	gTime = ts;
+}
+
+int MasterFilesystem::apply(const std::vector<std::string> &lines) {
+	for (const auto &line : lines) {
+		size_t versionLength;
+		uint64_t version = std::stoull(line, &versionLength);
+		int status = restore("test", version, line.c_str() + versionLength,
+				RestoreRigor::kDontIgnoreAnyErrors);
+		if (status != LIZARDFS_STATUS_OK) {
+			return status;
+		}
+	}
+	return LIZARDFS_STATUS_OK;
+}
+
+std::vector<std::string> MasterFilesystem::changelog() {
+	changelog_flush();
+	std::vector<std::string> lines;
+	std::ifstream file(changelogPath_);
+	std::string line;
+	for (size_t i = 0; std::getline(file, line); ++i) {
+		if (i >= changelogRead_) {
+			lines.push_back(line);
+		}
+	}
+	changelogRead_ += lines.size();
+	return lines;
+}
+
+uint64_t MasterFilesystem::checksum() {
+	return fs_checksum(ChecksumMode::kForceRecalculate);
+}
+
+} // namespace unittests
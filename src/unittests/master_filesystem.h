@@ -0,0 +1,75 @@
+/*
+   Copyright 2016 Skytechnology sp. z o.o.
+
+   This file is part of LizardFS.
+
+   LizardFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   LizardFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with LizardFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "unittests/TemporaryDirectory.h"
+
+namespace unittests {
+
+/*! \brief In-memory filesystem of the master, for testing filesystem code.
+ *
+ * The constructor creates an empty filesystem (just the root directory) as
+ * a new master does, the destructor unloads it. Changelog entries emitted by
+ * the master are written to a temporary file and can be read with changelog().
+ *
+ * There is no main loop in unit tests, so functions of the main module are
+ * replaced with stubs. main_time() returns the value set by setTime().
+ * Only one object of this class may exist at a time.
+ */
+class MasterFilesystem {
+public:
+	MasterFilesystem();
+	~MasterFilesystem();
+
+	/*! \brief Removes the current filesystem and creates an empty one.
+	 *
+	 * The new filesystem is identical to the one created by the constructor.
+	 */
+	void reset();
+
+	/*! \brief Sets the value returned by main_time(). */
+	static void setTime(uint32_t ts);
+
+	/*! \brief Applies changelog lines ("version: ts|ENTRY") as a shadow master does.
+	 *
+	 * Each line has to increase metadata version by exactly one.
+	 * \return status of the first line which failed or LIZARDFS_STATUS_OK.
+	 */
+	static int apply(const std::vector<std::string> &lines);
+
+	/*! \brief Returns changelog lines emitted since the previous call. */
+	std::vector<std::string> changelog();
+
+	/*! \brief Returns checksum of the whole metadata, recalculated from scratch. */
+	static uint64_t checksum();
+
+private:
+	TemporaryDirectory directory_;
+	std::string changelogPath_;
+	size_t changelogRead_;
+	uint32_t creationTime_;
+};
+
+} // namespace unittests